@@ -0,0 +1,78 @@
+// Tests that a $group over an index-covered $match reads the index keys directly, and returns the
+// same results as it does over documents.
+
+// For getPlanStage and planHasStage.
+load("jstests/libs/analyze_plan.js");
+
+(function() {
+    "use strict";
+
+    var coll = db.covered_group;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 500; i++) {
+        bulk.insert({_id: i, a: i % 13, b: i % 7, c: "x" + i});
+    }
+    bulk.insert({_id: 500, a: 2.5, b: 3.5});
+    bulk.insert({_id: 501, a: 21, b: NumberLong(4)});
+    bulk.insert({_id: 502, a: "str", b: 1});
+    assert.writeOK(bulk.execute());
+
+    function sortResults(results) {
+        return results.sort(function(x, y) {
+            var left = tojson(x);
+            var right = tojson(y);
+            return left < right ? -1 : (left > right ? 1 : 0);
+        });
+    }
+
+    var match = {$match: {a: {$gte: 0}}};
+    var pipelines = [
+        [match, {$group: {_id: "$a", n: {$sum: 1}}}],
+        [
+          match,
+          {
+            $group: {
+                _id: "$a",
+                total: {$sum: "$b"},
+                min: {$min: "$b"},
+                max: {$max: "$b"},
+                avg: {$avg: "$b"}
+            }
+          }
+        ],
+        [match, {$group: {_id: {b: "$b", a: "$a"}, n: {$sum: 1}}}],
+        [match, {$group: {_id: null, n: {$sum: 1}, max: {$max: "$a"}}}],
+        [match, {$group: {_id: {$add: ["$b", 1]}, n: {$sum: 1}}}],
+        [match, {$project: {_id: 0, b: 1, a: 1}}],
+    ];
+
+    // Results without an index to cover the pipelines.
+    var expected = pipelines.map(function(pipeline) {
+        return sortResults(coll.aggregate(pipeline).toArray());
+    });
+
+    assert.commandWorked(coll.ensureIndex({a: 1, b: 1}));
+
+    // The index scan returns its keys without a projection stage.
+    var explain = coll.explain().aggregate(pipelines[0]);
+    var winningPlan = explain.stages[0].$cursor.queryPlanner.winningPlan;
+    assert(planHasStage(winningPlan, "IXSCAN"), tojson(explain));
+    assert(!planHasStage(winningPlan, "PROJECTION"), tojson(explain));
+    assert(!planHasStage(winningPlan, "FETCH"), tojson(explain));
+
+    pipelines.forEach(function(pipeline, i) {
+        var results = coll.aggregate(pipeline, {cursor: {batchSize: 2}}).toArray();
+        assert.eq(expected[i], sortResults(results), tojson(pipeline));
+    });
+
+    // A $limit absorbed by the cursor applies to the index keys too.
+    var results = coll.aggregate([match, {$limit: 100}, {$group: {_id: "$a", n: {$sum: 1}}}])
+                      .toArray();
+    var total = 0;
+    results.forEach(function(result) {
+        total += result.n;
+    });
+    assert.eq(100, total, tojson(results));
+}());
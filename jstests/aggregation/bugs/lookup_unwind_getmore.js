@@ -17,8 +17,13 @@
     assert.neq(null, conn, "mongod failed to start up");
     const testDB = conn.getDB("test");
 
+    // Force a nested loop join, which keeps a cursor on the 'dest' collection open while unwinding.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalLookupHashJoinMaxForeignDocs: 0}));
+
     testDB.source.drop();
     testDB.dest.drop();
+    assert.commandWorked(testDB.dest.createIndex({foreign: 1}));
 
     assert.writeOK(testDB.source.insert({local: 1}));
 
@@ -0,0 +1,28 @@
+// A $match on a dotted path after the first stage needs the whole top-level field. A projection of
+// just the path, for the cursor or for what shards send to the merger, would drop the scalars of an
+// array the path goes through.
+(function() {
+    "use strict";
+
+    var coll = db.match_dotted_path_deps;
+    coll.drop();
+
+    assert.writeOK(coll.insert({_id: 0, a: [5, 6], b: [1, 2]}));
+    assert.writeOK(coll.insert({_id: 1, a: [6, 5], b: [{c: 1}]}));
+
+    function matchingIds(match) {
+        var res = coll.aggregate([
+                          {$limit: 10},
+                          {$match: match},
+                          {$group: {_id: null, ids: {$push: '$_id'}}}
+                      ]).toArray();
+        return res.length ? res[0].ids.sort() : [];
+    }
+
+    // Positional paths into arrays of scalars.
+    assert.eq([0], matchingIds({'a.0': 5}));
+    assert.eq([1], matchingIds({'a.1': 5}));
+
+    // No element of [1, 2] has a 'c', so 'b.c' is null for document 0.
+    assert.eq([0], matchingIds({'b.c': null}));
+}());
@@ -350,11 +350,6 @@ load("jstests/aggregation/extras/utils.js");
     assert(sharded.adminCommand({shardCollection: "test.lookUp", key: {_id: 'hashed'}}));
     runTest(sharded.getDB('test').lookUp, sharded.getDB('test').from);
 
-    // An error is thrown if the from collection is sharded.
-    assert(sharded.adminCommand({shardCollection: "test.from", key: {_id: 1}}));
-    assertErrorCode(
-        sharded.getDB('test').lookUp,
-            [{$lookup: {localField: "a", foreignField: "b", from: "from", as: "same"}}],
-        28769);
+    // A sharded from collection is covered by jstests/sharding/lookup_sharded_from.js.
     sharded.stop();
 }());
@@ -0,0 +1,59 @@
+// Tests that $group returns the same results when spilling to partitions or to sorted runs, and
+// that the profiler records its groups and spills.
+(function() {
+    'use strict';
+
+    var conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, 'mongod was unable to start up');
+    var testDB = conn.getDB('test');
+    var coll = testDB.group_spill_stats;
+    coll.drop();
+
+    for (var i = 0; i < 1000; i++) {
+        assert.writeOK(coll.insert({a: i % 100, b: i % 3}));
+    }
+
+    // Spill after a few groups.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalDocumentSourceGroupMaxMemoryBytes: 1000}));
+
+    var pipeline = [{$group: {_id: '$a', count: {$sum: 1}, b: {$addToSet: '$b'}}}];
+    var expected = [];
+    for (var i = 0; i < 100; i++) {
+        expected.push({_id: i, count: 10, b: [0, 1, 2]});
+    }
+
+    function runGroup() {
+        var results = coll.aggregate(pipeline, {allowDiskUse: true}).toArray();
+        results.forEach(function(result) {
+            result.b.sort();
+        });
+        return results.sort(function(x, y) {
+            return x._id - y._id;
+        });
+    }
+
+    [16, 0].forEach(function(partitions) {
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalDocumentSourceGroupSpillPartitions: partitions}));
+
+        assert.commandWorked(testDB.setProfilingLevel(2));
+        assert.eq(expected, runGroup());
+        assert.commandWorked(testDB.setProfilingLevel(0));
+
+        var profile = testDB.system.profile.find({'command.aggregate': coll.getName()})
+                          .sort({$natural: -1})
+                          .limit(1)
+                          .next();
+        assert.eq(100, profile.nGroups, tojson(profile));
+        assert.gt(profile.groupSpills, 0, tojson(profile));
+        assert.gt(profile.groupSpilledBytes, 0, tojson(profile));
+        testDB.system.profile.drop();
+    });
+
+    // Without allowDiskUse, exceeding the memory limit is an error.
+    assert.commandFailedWithCode(
+        testDB.runCommand({aggregate: coll.getName(), pipeline: pipeline}), 16945);
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,63 @@
+// Tests that foreground index builds generating keys on several threads build the same indexes as
+// builds generating keys on the scanning thread, and that errors from key generation fail them.
+(function() {
+    'use strict';
+
+    var conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, 'mongod was unable to start up');
+    var testDB = conn.getDB('test');
+    var coll = testDB.index_build_parallel_keys;
+    coll.drop();
+
+    var numDocs = 5000;
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < numDocs; i++) {
+        bulk.insert({_id: i, a: i % 97, b: [i, i + 1], c: 'word' + (i % 10), d: i});
+    }
+    assert.writeOK(bulk.execute());
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalIndexBuildParallelMinRecords: 100}));
+
+    function buildIndexes(threads) {
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalIndexBuildKeyGenerationThreads: threads}));
+        assert.commandWorked(coll.dropIndexes());
+
+        assert.commandWorked(coll.createIndex({a: 1, d: -1}));
+        assert.commandWorked(coll.createIndex({b: 1}));
+        assert.commandWorked(coll.createIndex({c: 'text'}));
+        assert.commandWorked(coll.createIndex({d: 1}, {partialFilterExpression: {a: {$lt: 10}}}));
+        assert.commandWorked(coll.createIndex({d: 1, a: 1}, {unique: true}));
+
+        var counts = {
+            a: coll.find({a: {$gte: 50}}).hint({a: 1, d: -1}).itcount(),
+            b: coll.find({b: {$gte: 100}}).hint({b: 1}).itcount(),
+            c: coll.find({$text: {$search: 'word3'}}).itcount(),
+            d: coll.find({a: {$lt: 10}, d: {$gte: 0}}).hint({d: 1}).itcount(),
+            unique: coll.find({d: {$gte: 0}}).hint({d: 1, a: 1}).itcount(),
+        };
+        assert.commandWorked(coll.validate(true));
+        return counts;
+    }
+
+    var serial = buildIndexes(0);
+    var parallel = buildIndexes(4);
+    assert.eq(serial, parallel);
+    assert.eq(numDocs, parallel.unique, tojson(parallel));
+    assert.eq(numDocs / 10, parallel.c, tojson(parallel));
+
+    // Duplicate keys are still detected when the keys come from different threads.
+    assert.writeOK(coll.insert({_id: numDocs, d: 0}));
+    assert.commandFailedWithCode(coll.createIndex({d: 1}, {unique: true}), ErrorCodes.DuplicateKey);
+
+    // So are documents that fail key generation.
+    assert.writeOK(coll.insert({_id: numDocs + 1, x: [1, 2], y: [1, 2]}));
+    assert.commandFailed(coll.createIndex({x: 1, y: 1}));
+    assert.eq(0,
+              coll.getIndexes().filter(function(index) {
+                  return index.name === 'x_1_y_1';
+              }).length);
+
+    MongoRunner.stopMongod(conn);
+}());
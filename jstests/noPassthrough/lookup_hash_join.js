@@ -0,0 +1,107 @@
+// Tests that $lookup produces the same results with a nested loop join and a hash join, whether
+// the hash table fits in memory or is spilled to disk, and that explain reports the strategy.
+(function() {
+    'use strict';
+
+    var conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, 'mongod was unable to start up');
+    var testDB = conn.getDB('test');
+
+    function setParameter(name, value) {
+        var cmd = {setParameter: 1};
+        cmd[name] = value;
+        assert.commandWorked(testDB.adminCommand(cmd));
+    }
+
+    var local = testDB.local;
+    var foreign = testDB.foreign;
+    local.drop();
+    foreign.drop();
+
+    // Join keys cover numeric types comparing equal, arrays, embedded documents, nulls and missing
+    // fields, which 'undefined' stands for, on both sides.
+    var keys = [1, NumberLong(1), 2.0, 'a', [1, 2], {x: 1}, null, undefined, [], [[1, 2]]];
+    for (var i = 0; i < 200; i++) {
+        var key = keys[i % keys.length];
+        var localDoc = {_id: i, seq: i};
+        var foreignDoc = {_id: i, pad: new Array(64).join('x')};
+        if (key !== undefined) {
+            localDoc.a = key;
+            foreignDoc.b = key;
+        }
+        assert.writeOK(local.insert(localDoc));
+        assert.writeOK(foreign.insert(foreignDoc));
+    }
+
+    var lookup = {$lookup: {from: 'foreign', localField: 'a', foreignField: 'b', as: 'matches'}};
+    var pipelines = [
+        [{$sort: {seq: 1}}, lookup],
+        [{$sort: {seq: 1}}, lookup, {$unwind: '$matches'}],
+        [
+          {$sort: {seq: 1}},
+          lookup,
+          {$unwind: {path: '$matches', preserveNullAndEmptyArrays: true}}
+        ],
+    ];
+
+    // Neither strategy promises an order for the matches of one input document, so order results
+    // by input document and then by match.
+    function matchId(doc) {
+        return doc.matches && doc.matches._id !== undefined ? doc.matches._id : -1;
+    }
+    function canonicalize(results) {
+        results.forEach(function(doc) {
+            if (Array.isArray(doc.matches)) {
+                doc.matches.sort(function(a, b) {
+                    return a._id - b._id;
+                });
+            }
+        });
+        return results.sort(function(a, b) {
+            return a.seq - b.seq || matchId(a) - matchId(b);
+        });
+    }
+
+    function explainStrategy(pipeline) {
+        var explain = local.aggregate(pipeline, {explain: true});
+        var stages = explain.stages;
+        for (var i = 0; i < stages.length; i++) {
+            if (stages[i].$lookup) {
+                return stages[i].$lookup.strategy;
+            }
+        }
+        assert(false, 'no $lookup stage in explain: ' + tojson(explain));
+    }
+
+    // Make a nested loop join the chosen strategy to produce the expected results.
+    assert.commandWorked(foreign.createIndex({b: 1}));
+    setParameter('internalLookupHashJoinMaxForeignDocs', 0);
+    var expected = pipelines.map(function(pipeline) {
+        assert.eq('nestedLoop', explainStrategy(pipeline));
+        return canonicalize(local.aggregate(pipeline).toArray());
+    });
+
+    function checkHashJoin(options) {
+        pipelines.forEach(function(pipeline, i) {
+            assert.eq('hashJoin', explainStrategy(pipeline));
+            assert.eq(expected[i], canonicalize(local.aggregate(pipeline, options).toArray()));
+        });
+    }
+
+    // A hash join is chosen when the foreign collection is small.
+    setParameter('internalLookupHashJoinMaxForeignDocs', 1000);
+    checkHashJoin({});
+
+    // A hash join is chosen when the foreign collection has no index on the foreign field.
+    assert.commandWorked(foreign.dropIndex({b: 1}));
+    setParameter('internalLookupHashJoinMaxForeignDocs', 0);
+    checkHashJoin({});
+
+    // When the hash table exceeds its memory limit, the join either falls back to a nested loop or
+    // spills to disk.
+    setParameter('internalLookupHashJoinMaxMemoryBytes', 1024);
+    checkHashJoin({});
+    checkHashJoin({allowDiskUse: true});
+
+    MongoRunner.stopMongod(conn);
+}());
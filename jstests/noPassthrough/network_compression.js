@@ -0,0 +1,41 @@
+// Checks that the shell and mongod negotiate wire protocol compression at isMaster, and that
+// db.serverStatus() reports the bytes passed through the negotiated compressor.
+
+(function() {
+    'use strict';
+
+    var mongo = MongoRunner.runMongod({networkMessageCompressors: "snappy,zlib"});
+    assert.neq(null, mongo, 'mongod failed to start with network compression enabled');
+
+    // Connections which don't offer compression are unaffected.
+    var testDB = mongo.getDB('test');
+    assert.writeOK(testDB.coll.insert({x: 1}));
+    var stats = assert.commandWorked(testDB.serverStatus()).network.compression;
+    assert.eq(0, stats.snappy.decompressor.bytesIn, tojson(stats));
+
+    // A shell offering zlib negotiates it, although the server prefers snappy.
+    var exitCode = runMongoProgram('mongo',
+                                   '--port',
+                                   mongo.port,
+                                   '--networkMessageCompressors',
+                                   'zlib',
+                                   '--eval',
+                                   'for (var i = 0; i < 10; i++) {' +
+                                       '    assert.writeOK(db.getSiblingDB("test").coll.insert(' +
+                                       '        {i: i, s: "a".repeat(1000)}));' +
+                                       '}' +
+                                       'assert.eq(11, db.getSiblingDB("test").coll.count());');
+    assert.eq(0, exitCode, 'shell with network compression failed');
+
+    stats = assert.commandWorked(testDB.serverStatus()).network.compression;
+    assert.gt(stats.zlib.decompressor.bytesIn, 0, tojson(stats));
+    assert.gt(stats.zlib.compressor.bytesIn, 0, tojson(stats));
+    assert.eq(0, stats.snappy.decompressor.bytesIn, tojson(stats));
+
+    // isMaster replies with the compressors which were negotiated.
+    var res = assert.commandWorked(
+        testDB.runCommand({isMaster: 1, compression: ['zlib', 'lz4', 'snappy']}));
+    assert.eq(['zlib', 'snappy'], res.compression, tojson(res));
+
+    MongoRunner.stopMongod(mongo);
+}());
@@ -0,0 +1,76 @@
+// Tests that mongod saves its plan caches to local.plan_cache when
+// internalQueryCachePersistIntervalSecs is set, restores them after a restart, and keeps the plans
+// that survive an index drop.
+(function() {
+    "use strict";
+
+    var options = {setParameter: "internalQueryCachePersistIntervalSecs=1"};
+    var conn = MongoRunner.runMongod(options);
+    assert.neq(null, conn, "mongod failed to start");
+
+    var testDB = conn.getDB("test");
+    var coll = testDB.plan_cache_persist;
+    coll.drop();
+
+    for (var i = 0; i < 200; i++) {
+        assert.writeOK(coll.insert({a: i % 10, b: i % 20, c: i}));
+    }
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    assert.commandWorked(coll.ensureIndex({b: 1}));
+    assert.commandWorked(coll.ensureIndex({c: 1}));
+
+    // Two candidate indexes make the query shape cacheable.
+    var query = {a: 1, b: 1};
+    assert.eq(10, coll.find(query).itcount());
+
+    function shapes(coll) {
+        return assert.commandWorked(coll.runCommand("planCacheListQueryShapes")).shapes;
+    }
+    assert.eq(1, shapes(coll).length, tojson(shapes(coll)));
+
+    var metrics = assert.commandWorked(testDB.serverStatus()).metrics.query.planCache;
+    assert.gte(metrics.misses, 1, tojson(metrics));
+
+    // A second run of the same shape uses the cached plan.
+    assert.eq(10, coll.find(query).itcount());
+    assert.gt(assert.commandWorked(testDB.serverStatus()).metrics.query.planCache.hits,
+              metrics.hits);
+
+    // Dropping an index the cached plan does not use keeps the plan.
+    var plans = assert.commandWorked(coll.runCommand("planCacheListPlans", {query: query})).plans;
+    assert.eq(1, plans.length, tojson(plans));
+    assert.commandWorked(coll.dropIndex({c: 1}));
+    assert.eq(1, shapes(coll).length, tojson(shapes(coll)));
+
+    var saved = conn.getDB("local").plan_cache;
+    assert.soon(function() {
+        var doc = saved.findOne({_id: coll.getFullName()});
+        return doc !== null && doc.entries.length === 1;
+    }, "plan cache was not saved");
+
+    // The saved plans are restored when mongod restarts.
+    MongoRunner.stopMongod(conn);
+    conn = MongoRunner.runMongod(
+        {restart: true, dbpath: conn.dbpath, port: conn.port, setParameter: options.setParameter});
+    assert.neq(null, conn, "mongod failed to restart");
+
+    testDB = conn.getDB("test");
+    coll = testDB.plan_cache_persist;
+    assert.soon(function() {
+        return shapes(coll).length === 1;
+    }, "plan cache was not restored");
+    metrics = assert.commandWorked(testDB.serverStatus()).metrics.query.planCache;
+    assert.gte(metrics.warmStartEntries, 1, tojson(metrics));
+
+    var hits = metrics.hits;
+    assert.eq(10, coll.find(query).itcount());
+    assert.gt(assert.commandWorked(testDB.serverStatus()).metrics.query.planCache.hits, hits);
+
+    // Saved plans of dropped collections are forgotten.
+    coll.drop();
+    assert.soon(function() {
+        return conn.getDB("local").plan_cache.count({_id: coll.getFullName()}) === 0;
+    }, "saved plan cache of a dropped collection was not removed");
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,53 @@
+// Checks that mongod services many connections with the asio service executor, and that
+// db.serverStatus() reports the flow of requests through it.
+
+(function() {
+    'use strict';
+
+    // The asio service executor is not available on Windows.
+    if (_isWindows()) {
+        return;
+    }
+
+    var mongo = MongoRunner.runMongod({serviceExecutor: "asio", serviceExecutorThreads: 2});
+    assert.neq(null, mongo, 'mongod failed to start with the asio service executor');
+
+    var testDB = mongo.getDB('test');
+    var serverStatus = assert.commandWorked(testDB.serverStatus());
+    assert.eq('asio', serverStatus.serviceExecutor.executor, tojson(serverStatus.serviceExecutor));
+
+    // Open more connections than there are worker threads, and keep all of them alive while
+    // interleaving requests on them.
+    var conns = [];
+    for (var i = 0; i < 20; i++) {
+        conns.push(new Mongo(mongo.host));
+    }
+
+    for (var round = 0; round < 5; round++) {
+        conns.forEach(function(conn, i) {
+            assert.writeOK(conn.getDB('test').coll.insert({conn: i, round: round}));
+        });
+    }
+    assert.eq(100, testDB.coll.count());
+
+    // Parallel shells exercise connections being serviced concurrently.
+    var shells = [];
+    for (var i = 0; i < 4; i++) {
+        shells.push(startParallelShell(
+            'for (var i = 0; i < 100; i++) { db.getSiblingDB("test").coll.findOne(); }',
+            mongo.port));
+    }
+    shells.forEach(function(join) {
+        join();
+    });
+
+    serverStatus = assert.commandWorked(testDB.serverStatus());
+    var stats = serverStatus.serviceExecutor;
+    assert.gte(stats.completed, 500, tojson(stats));
+    assert.gte(stats.waiting, conns.length, tojson(stats));
+
+    // This request is being serviced while serverStatus runs.
+    assert.gte(stats.inProgress, 1, tojson(stats));
+
+    MongoRunner.stopMongod(mongo);
+}());
@@ -0,0 +1,90 @@
+// Tests that a filtered collection scan over a large enough collection applies its filter on several
+// threads through an EXCHANGE stage, and returns the same results as a serial scan.
+
+// For getPlanStage.
+load("jstests/libs/analyze_plan.js");
+
+(function() {
+    "use strict";
+
+    var coll = db.parallel_collscan_filter;
+    coll.drop();
+
+    var numDocs = 10000;
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < numDocs; i++) {
+        bulk.insert({_id: i, a: i % 7, b: "x" + i});
+    }
+    assert.writeOK(bulk.execute());
+
+    function setParams(workers, minRecords) {
+        assert.commandWorked(db.adminCommand({
+            setParameter: 1,
+            internalQueryExecParallelCollScanWorkers: workers,
+            internalQueryExecParallelCollScanMinRecords: minRecords
+        }));
+    }
+
+    var original = assert.commandWorked(db.adminCommand({
+        getParameter: 1,
+        internalQueryExecParallelCollScanWorkers: 1,
+        internalQueryExecParallelCollScanMinRecords: 1
+    }));
+
+    try {
+        var query = {a: {$in: [1, 4]}, b: /5$/};
+        var pipeline = [{$match: query}, {$group: {_id: "$a", n: {$sum: 1}}}, {$sort: {_id: 1}}];
+
+        // Serial results.
+        setParams(1, 100);
+        var serialFind = coll.find(query).toArray();
+        var serialCount = coll.count(query);
+        var serialAgg = coll.aggregate(pipeline).toArray();
+        var explain = coll.find(query).explain("executionStats");
+        assert(!planHasStage(explain.queryPlanner.winningPlan, "EXCHANGE"), tojson(explain));
+
+        // Parallel results, in the same order.
+        setParams(4, 100);
+        assert.eq(serialFind, coll.find(query).toArray());
+        assert.eq(serialCount, coll.count(query));
+        assert.eq(serialAgg, coll.aggregate(pipeline).toArray());
+
+        explain = coll.find(query).explain("executionStats");
+        var exchange = getPlanStage(explain.executionStats.executionStages, "EXCHANGE");
+        assert.neq(null, exchange, tojson(explain));
+        assert.eq("COLLSCAN", exchange.inputStage.stage, tojson(exchange));
+        assert.eq(4, exchange.numWorkers, tojson(exchange));
+        assert.eq(4, exchange.workers.length, tojson(exchange));
+
+        var docsTested = 0;
+        var docsPassed = 0;
+        exchange.workers.forEach(function(worker) {
+            assert.gt(worker.docsTested, 0, tojson(exchange));
+            docsTested += worker.docsTested;
+            docsPassed += worker.docsPassed;
+        });
+        assert.eq(numDocs, docsTested, tojson(exchange));
+        assert.eq(serialFind.length, docsPassed, tojson(exchange));
+        assert.eq(serialFind.length, exchange.nReturned, tojson(exchange));
+
+        // Collections below the threshold, $where and unfiltered scans stay serial.
+        setParams(4, numDocs + 1);
+        explain = coll.find(query).explain();
+        assert(!planHasStage(explain.queryPlanner.winningPlan, "EXCHANGE"), tojson(explain));
+
+        setParams(4, 100);
+        explain = coll.find({$where: "this.a == 1"}).explain();
+        assert(!planHasStage(explain.queryPlanner.winningPlan, "EXCHANGE"), tojson(explain));
+
+        explain = coll.find().explain();
+        assert(!planHasStage(explain.queryPlanner.winningPlan, "EXCHANGE"), tojson(explain));
+    } finally {
+        assert.commandWorked(db.adminCommand({
+            setParameter: 1,
+            internalQueryExecParallelCollScanWorkers:
+                original.internalQueryExecParallelCollScanWorkers,
+            internalQueryExecParallelCollScanMinRecords:
+                original.internalQueryExecParallelCollScanMinRecords
+        }));
+    }
+}());
@@ -27,6 +27,10 @@ function testSecondaryMetrics(secondary, opCount, offset) {
 
     assert(ss.metrics.repl.apply.batches.num > 0, "no batches");
     assert(ss.metrics.repl.apply.batches.totalMillis >= 0, "missing batch time");
+    assert(ss.metrics.repl.apply.prepare.num > 0, "no batches prepared");
+    assert(ss.metrics.repl.apply.prepare.totalMillis >= 0, "missing batch preparation time");
+    assert(ss.metrics.repl.apply.partition.num > 0, "no batches partitioned");
+    assert(ss.metrics.repl.apply.writeOplog.num > 0, "no batches written to the oplog");
     assert.eq(ss.metrics.repl.apply.ops, opCount + offset, "wrong number of applied ops");
 }
 
@@ -0,0 +1,106 @@
+// Tests $lookup from a sharded collection, which the primary shard of the database answers by
+// sending batches of join keys to the shards owning the matching documents.
+(function() {
+    "use strict";
+
+    // For assertErrorCode.
+    load("jstests/aggregation/extras/utils.js");
+
+    var st = new ShardingTest({shards: 2, mongos: 1});
+    var testDB = st.s.getDB(jsTest.name());
+    var dbName = testDB.getName();
+
+    assert.commandWorked(st.s.adminCommand({enableSharding: dbName}));
+    st.ensurePrimaryShard(dbName, 'shard0000');
+
+    var from = testDB.from;
+    assert.commandWorked(st.s.adminCommand({shardCollection: from.getFullName(), key: {b: 1}}));
+    assert.commandWorked(st.s.adminCommand({split: from.getFullName(), middle: {b: 50}}));
+    assert.commandWorked(st.s.adminCommand(
+        {moveChunk: from.getFullName(), find: {b: 50}, to: 'shard0001'}));
+
+    var bulk = from.initializeUnorderedBulkOp();
+    for (var i = 0; i < 100; i++) {
+        bulk.insert({_id: i, b: i % 80});
+    }
+    bulk.insert({_id: 100, b: null});
+    bulk.insert({_id: 101});
+    bulk.insert({_id: 102, b: [1, 60]});
+    assert.writeOK(bulk.execute());
+
+    // An orphaned document must not be joined.
+    assert.writeOK(st.shard0.getDB(dbName).from.insert({_id: 1000, b: 60}));
+
+    function compareId(a, b) {
+        return a._id < b._id ? -1 : (a._id > b._id ? 1 : 0);
+    }
+
+    // The result of $lookup for each local document must be what a query for it would return.
+    function checkLookup(local) {
+        var results =
+            local.aggregate([
+                     {$lookup: {localField: "a", foreignField: "b", from: "from", as: "same"}}
+                 ]).toArray();
+        assert.eq(local.count(), results.length);
+
+        results.forEach(function(result) {
+            var query = result.hasOwnProperty("a") ? {b: {$eq: result.a}} : {b: {$eq: null}};
+            var expected = from.find(query).toArray().sort(compareId);
+            assert.eq(expected, result.same.sort(compareId), tojson(result));
+        });
+    }
+
+    function loadLocal(local) {
+        var bulk = local.initializeUnorderedBulkOp();
+        for (var i = 0; i < 150; i++) {
+            bulk.insert({_id: i, a: i % 90});
+        }
+        bulk.insert({_id: 150, a: null});
+        bulk.insert({_id: 151});
+        bulk.insert({_id: 152, a: [1, 2]});
+        bulk.insert({_id: 153, a: 60});
+        assert.writeOK(bulk.execute());
+    }
+
+    // Use several small batches of join keys per $lookup.
+    [st.shard0, st.shard1].forEach(function(shard) {
+        assert.commandWorked(
+            shard.adminCommand({setParameter: 1, internalLookupShardedBatchSize: 7}));
+    });
+
+    jsTest.log("$lookup from an unsharded collection into a sharded one");
+    var unshardedLocal = testDB.unshardedLocal;
+    loadLocal(unshardedLocal);
+    checkLookup(unshardedLocal);
+
+    jsTest.log("$lookup from a sharded collection into a sharded one");
+    var shardedLocal = testDB.shardedLocal;
+    assert.commandWorked(
+        st.s.adminCommand({shardCollection: shardedLocal.getFullName(), key: {_id: 'hashed'}}));
+    loadLocal(shardedLocal);
+    checkLookup(shardedLocal);
+
+    // The $unwind absorbed into $lookup produces one document per match.
+    var unwound = shardedLocal.aggregate([
+        {$match: {a: 60}},
+        {$lookup: {localField: "a", foreignField: "b", from: "from", as: "same"}},
+        {$unwind: "$same"}
+    ]).toArray();
+    assert.eq(shardedLocal.count({a: 60}) * from.count({b: 60}), unwound.length,
+              tojson(unwound));
+
+    // Documents are only indexed by the values along the foreign field, so a positional path
+    // can't be joined against a sharded collection.
+    assertErrorCode(unshardedLocal,
+                    [{$lookup: {localField: "a", foreignField: "b.0", from: "from", as: "same"}}],
+                    40501);
+
+    // The documents the shards return for one batch of join keys are bounded in memory.
+    assert.commandWorked(
+        st.shard0.adminCommand({setParameter: 1, internalLookupHashJoinMaxMemoryBytes: 100}));
+    assertErrorCode(unshardedLocal,
+                    [{$lookup: {localField: "a", foreignField: "b", from: "from", as: "same"}}],
+                    ErrorCodes.ExceededMemoryLimit);
+
+    st.stop();
+}());
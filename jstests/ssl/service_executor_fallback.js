@@ -0,0 +1,20 @@
+// Checks that mongod services SSL connections with the synchronous service executor when the asio
+// one is requested, and that db.serverStatus() reports the executor actually in use.
+
+(function() {
+    'use strict';
+
+    var mongo = MongoRunner.runMongod({
+        serviceExecutor: "asio",
+        sslMode: "requireSSL",
+        sslPEMKeyFile: "jstests/libs/server.pem",
+        sslCAFile: "jstests/libs/ca.pem"
+    });
+    assert.neq(null, mongo, 'mongod failed to start with SSL and the asio service executor');
+
+    var serverStatus = assert.commandWorked(mongo.getDB('test').serverStatus());
+    assert.eq(
+        'synchronous', serverStatus.serviceExecutor.executor, tojson(serverStatus.serviceExecutor));
+
+    MongoRunner.stopMongod(mongo);
+}());
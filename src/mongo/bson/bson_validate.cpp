@@ -28,13 +28,14 @@
  */
 
 #include <cstring>
-#include <deque>
 #include <limits>
+#include <vector>
 
 #include "mongo/base/data_view.h"
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/bits.h"
 #include "mongo/platform/decimal128.h"
 
 namespace mongo {
@@ -71,10 +72,13 @@ public:
     }
 
     Status readCString(StringData* out) {
-        const void* x = memchr(_buffer + _position, 0, _maxLength - _position);
-        if (!x)
-            return makeError("no end of c-string", _idElem);
-        uint64_t len = static_cast<uint64_t>(static_cast<const char*>(x) - (_buffer + _position));
+        uint64_t len;
+        if (!findShortCStringLength(&len)) {
+            const void* x = memchr(_buffer + _position, 0, _maxLength - _position);
+            if (!x)
+                return makeError("no end of c-string", _idElem);
+            len = static_cast<uint64_t>(static_cast<const char*>(x) - (_buffer + _position));
+        }
 
         StringData data(_buffer + _position, len);
         _position += len + 1;
@@ -121,6 +125,28 @@ public:
         return _position;
     }
 
+    /**
+     * Finds the terminating NUL of a c-string shorter than 8 bytes, as most field names are, by
+     * testing the 8 bytes at the current position at once. This avoids a call to memchr, which
+     * is faster for long strings but costs more than the scan itself for short ones. Returns
+     * false if fewer than 8 bytes remain or none of them is NUL.
+     */
+    bool findShortCStringLength(uint64_t* len) const {
+        if (_maxLength - _position < sizeof(uint64_t))
+            return false;
+
+        const uint64_t word = ConstDataView(_buffer).read<LittleEndian<uint64_t>>(_position);
+
+        // Sets the high bit of every zero byte. Bytes after the first zero byte may also get it
+        // set through the borrow, but the lowest set bit always belongs to the first zero byte.
+        const uint64_t zeroBytes = (word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL;
+        if (!zeroBytes)
+            return false;
+
+        *len = countTrailingZeros64(zeroBytes) / 8;
+        return true;
+    }
+
     const char* getBasePtr() const {
         return _buffer;
     }
@@ -170,9 +196,63 @@ private:
 };
 
 /**
+ * Stack of the objects being validated. The frames of all but very deeply nested documents are
+ * held inline, so validation doesn't allocate.
+ */
+class ValidationFrameStack {
+public:
+    /**
+     * Returns the new top frame. Pointers to frames are invalidated by push() and pop().
+     */
+    ValidationObjectFrame* push() {
+        ValidationObjectFrame* frame;
+        if (_size < kInlineFrames) {
+            frame = &_inlineFrames[_size];
+        } else {
+            _overflowFrames.emplace_back();
+            frame = &_overflowFrames.back();
+        }
+        _size++;
+
+        *frame = ValidationObjectFrame();
+        return frame;
+    }
+
+    void pop() {
+        if (_size > kInlineFrames)
+            _overflowFrames.pop_back();
+        _size--;
+    }
+
+    ValidationObjectFrame* top() {
+        return _size > kInlineFrames ? &_overflowFrames.back() : &_inlineFrames[_size - 1];
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+private:
+    static const size_t kInlineFrames = 32;
+
+    ValidationObjectFrame _inlineFrames[kInlineFrames];
+    std::vector<ValidationObjectFrame> _overflowFrames;
+    size_t _size = 0;
+};
+
+/**
+ * Fills 'name' with the field name of the element, unless it is the EOO ending an object.
+ *
  * WARNING: only pass in a non-EOO idElem if it has been fully validated already!
  */
-Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState, BSONElement idElem) {
+Status validateElementInfo(Buffer* buffer,
+                           ValidationState::State* nextState,
+                           StringData* name,
+                           BSONElement idElem) {
     Status status = Status::OK();
 
     signed char type;
@@ -184,8 +264,7 @@ Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState, BS
         return Status::OK();
     }
 
-    StringData name;
-    status = buffer->readCString(&name);
+    status = buffer->readCString(name);
     if (!status.isOK())
         return status;
 
@@ -284,7 +363,7 @@ Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState, BS
 }
 
 Status validateBSONIterative(Buffer* buffer) {
-    std::deque<ValidationObjectFrame> frames;
+    ValidationFrameStack frames;
     ValidationObjectFrame* curr = NULL;
     ValidationState::State state = ValidationState::BeginObj;
 
@@ -294,8 +373,7 @@ Status validateBSONIterative(Buffer* buffer) {
     while (state != ValidationState::Done) {
         switch (state) {
             case ValidationState::BeginObj:
-                frames.push_back(ValidationObjectFrame());
-                curr = &frames.back();
+                curr = frames.push();
                 curr->setStartPosition(buffer->position());
                 curr->setIsCodeWithScope(false);
                 if (!buffer->readNumber<int>(&curr->expectedSize)) {
@@ -314,14 +392,14 @@ Status validateBSONIterative(Buffer* buffer) {
 
                 const uint64_t elemStartPos = buffer->position();
                 ValidationState::State nextState = state;
-                Status status = validateElementInfo(buffer, &nextState, idElem);
+                StringData name;
+                Status status = validateElementInfo(buffer, &nextState, &name, idElem);
                 if (!status.isOK())
                     return status;
 
-                // we've already validated that fieldname is safe to access as long as we aren't
-                // at the end of the object, since EOO doesn't have a fieldname.
+                // EOO doesn't have a fieldname.
                 if (nextState != ValidationState::EndObj && idElem.eoo() && atTopLevel) {
-                    if (strcmp(buffer->getBasePtr() + elemStartPos + 1 /*type*/, "_id") == 0) {
+                    if (name == "_id") {
                         idElemStartPos = elemStartPos;
                     }
                 }
@@ -334,11 +412,11 @@ Status validateBSONIterative(Buffer* buffer) {
                 if (actualLength != curr->expectedSize) {
                     return makeError("bson length doesn't match what we found", idElem);
                 }
-                frames.pop_back();
+                frames.pop();
                 if (frames.empty()) {
                     state = ValidationState::Done;
                 } else {
-                    curr = &frames.back();
+                    curr = frames.top();
                     if (curr->isCodeWithScope())
                         state = ValidationState::EndCodeWScope;
                     else
@@ -347,8 +425,7 @@ Status validateBSONIterative(Buffer* buffer) {
                 break;
             }
             case ValidationState::BeginCodeWScope: {
-                frames.push_back(ValidationObjectFrame());
-                curr = &frames.back();
+                curr = frames.push();
                 curr->setStartPosition(buffer->position());
                 curr->setIsCodeWithScope(true);
                 if (!buffer->readNumber<int>(&curr->expectedSize))
@@ -365,10 +442,10 @@ Status validateBSONIterative(Buffer* buffer) {
                     return makeError("bson length for CodeWScope doesn't match what we found",
                                      idElem);
                 }
-                frames.pop_back();
+                frames.pop();
                 if (frames.empty())
                     return makeError("unnested CodeWScope", idElem);
-                curr = &frames.back();
+                curr = frames.top();
                 state = ValidationState::WithinObj;
                 break;
             }
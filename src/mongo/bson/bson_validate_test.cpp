@@ -310,6 +310,41 @@ TEST(BSONValidateFast, StringHasSomething) {
     ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize()));
 }
 
+TEST(BSONValidateFast, FieldNamesOfEveryLength) {
+    // Covers names found within the first 8 bytes, names longer than that, and names ending
+    // within 8 bytes of the end of the buffer.
+    for (size_t len = 0; len < 20; len++) {
+        const std::string name(len, 'a');
+        const BSONObj x = BSON(name << 1 << "b" << BSON(name << true));
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+
+        // Truncating the buffer in the middle of the last field name leaves it unterminated.
+        const BSONObj y = BSON(name << 1 << "bbbbbbbbbbbb" << 2);
+        ASSERT_NOT_OK(validateBSON(y.objdata(), y.objsize() - 8));
+    }
+}
+
+TEST(BSONValidateFast, DeeplyNested) {
+    // Nests deeper than the frames held inline by the validator.
+    BSONObj x = BSON("leaf" << 1);
+    for (int i = 0; i < 100; i++) {
+        x = BSON("_id" << i << "a" << x << "b" << BSON_ARRAY(x.firstElement()));
+    }
+    ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+    ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() - 1));
+
+    // Corrupt the length of the innermost object.
+    BSONObj inner = x;
+    for (int i = 0; i < 100; i++) {
+        inner = inner["a"].Obj();
+    }
+    DataView(const_cast<char*>(inner.objdata())).write<LittleEndian<int>>(inner.objsize() + 1);
+    const Status status = validateBSON(x.objdata(), x.objsize());
+    ASSERT_NOT_OK(status);
+    ASSERT_EQUALS(status.reason(),
+                  "bson length doesn't match what we found in object with _id: 99");
+}
+
 TEST(BSONValidateBool, BoolValuesAreValidated) {
     BSONObjBuilder bob;
     bob.append("x", false);
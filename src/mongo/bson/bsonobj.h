@@ -179,6 +179,11 @@ public:
         return _ownedBuffer.get() != 0;
     }
 
+    /** The buffer this BSONObj owns, which is empty if it isn't owned. */
+    const SharedBuffer& sharedBuffer() const {
+        return _ownedBuffer;
+    }
+
     /** assure the data buffer is under the control of this BSONObj and not a remote buffer
         @see isOwned()
     */
@@ -41,6 +41,7 @@
 #include "mongo/db/index_legacy.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/service_context.h"
 #include "mongo/util/clock_source.h"
 #include "mongo/util/debug_util.h"
@@ -195,8 +196,19 @@ void CollectionInfoCache::droppedIndex(OperationContext* txn, StringData indexNa
     // Requires exclusive collection lock.
     invariant(txn->lockState()->isCollectionLockedForMode(_collection->ns().ns(), MODE_X));
 
+    // Plans that did not use the dropped index are still valid, so keep them rather than making
+    // every query shape plan again. Plans that used it are rejected by warmStart().
+    std::vector<BSONObj> cachedPlans;
+    if (internalQueryCachePersistIntervalSecs > 0) {
+        cachedPlans = _planCache->getWarmStartEntries();
+    }
+
     rebuildIndexData(txn);
     _indexUsageTracker.unregisterIndex(indexName);
+
+    if (!cachedPlans.empty()) {
+        _planCache->warmStart(cachedPlans);
+    }
 }
 
 void CollectionInfoCache::rebuildIndexData(OperationContext* txn) {
@@ -30,6 +30,7 @@
 
 #include "mongo/db/catalog/cursor_manager.h"
 
+#include "mongo/base/counter.h"
 #include "mongo/base/data_cursor.h"
 #include "mongo/base/init.h"
 #include "mongo/db/audit.h"
@@ -39,13 +40,16 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/startup_test.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -84,6 +88,14 @@ public:
         _run(0xFFFFFFFF, 0xFFFFFFFF);
     }
 } idWorkTest;
+
+// Only waits are counted, so that uncontended acquisitions don't share a cache line.
+Counter64 cursorManagerLockWaits;
+Counter64 cursorManagerLockWaitMicros;
+ServerStatusMetricField<Counter64> dCursorManagerLockWaits("cursor.manager.lockWaits",
+                                                           &cursorManagerLockWaits);
+ServerStatusMetricField<Counter64> dCursorManagerLockWaitMicros("cursor.manager.lockWaitMicros",
+                                                                &cursorManagerLockWaitMicros);
 }
 
 class GlobalCursorIdCache {
@@ -313,9 +325,34 @@ bool CursorManager::eraseCursorGlobal(OperationContext* txn, CursorId id) {
 // --------------------------
 
 
+/**
+ * Locks the mutex of a partition, counting the time spent waiting when it is contended.
+ */
+class CursorManager::PartitionLock {
+    MONGO_DISALLOW_COPYING(PartitionLock);
+
+public:
+    explicit PartitionLock(const Partition& partition)
+        : _lk(partition.mutex, stdx::try_to_lock) {
+        if (!_lk.owns_lock()) {
+            Timer timer;
+            _lk.lock();
+            cursorManagerLockWaits.increment();
+            cursorManagerLockWaitMicros.increment(timer.micros());
+        }
+    }
+
+private:
+    stdx::unique_lock<stdx::mutex> _lk;
+};
+
 CursorManager::CursorManager(StringData ns) : _nss(ns) {
     _collectionCacheRuntimeId = globalCursorIdCache->created(_nss.ns());
-    _random.reset(new PseudoRandom(globalCursorIdCache->nextSeed()));
+
+    PseudoRandom seeds(globalCursorIdCache->nextSeed());
+    for (auto&& partition : _partitions) {
+        partition.random.reset(new PseudoRandom(seeds.nextInt64()));
+    }
 }
 
 CursorManager::~CursorManager() {
@@ -323,68 +360,87 @@ CursorManager::~CursorManager() {
     globalCursorIdCache->destroyed(_collectionCacheRuntimeId, _nss.ns());
 }
 
+CursorManager::Partition& CursorManager::_partitionForCursor(CursorId id) {
+    return _partitions[static_cast<uint64_t>(id) & (kNumPartitions - 1)];
+}
+
+CursorManager::Partition& CursorManager::_partitionForPointer(const void* ptr) {
+    // Fibonacci hashing, since the low bits of heap addresses are mostly the same.
+    const uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) *
+        0x9E3779B97F4A7C15ULL;
+    return _partitions[(hash >> 32) & (kNumPartitions - 1)];
+}
+
 void CursorManager::invalidateAll(bool collectionGoingAway, const std::string& reason) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
     fassert(28819, !BackgroundOperation::inProgForNs(_nss));
 
-    for (ExecSet::iterator it = _nonCachedExecutors.begin(); it != _nonCachedExecutors.end();
-         ++it) {
-        // we kill the executor, but it deletes itself
-        PlanExecutor* exec = *it;
-        exec->kill(reason);
-        invariant(exec->collection() == NULL);
-    }
-    _nonCachedExecutors.clear();
+    for (auto&& partition : _partitions) {
+        PartitionLock lk(partition);
 
-    if (collectionGoingAway) {
-        // we're going to wipe out the world
-        for (CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
-            ClientCursor* cc = i->second;
+        for (ExecSet::iterator it = partition.nonCachedExecutors.begin();
+             it != partition.nonCachedExecutors.end();
+             ++it) {
+            // we kill the executor, but it deletes itself
+            PlanExecutor* exec = *it;
+            exec->kill(reason);
+            invariant(exec->collection() == NULL);
+        }
+        partition.nonCachedExecutors.clear();
 
-            cc->kill();
+        if (collectionGoingAway) {
+            // we're going to wipe out the world
+            for (CursorMap::const_iterator i = partition.cursors.begin();
+                 i != partition.cursors.end();
+                 ++i) {
+                ClientCursor* cc = i->second;
 
-            invariant(cc->getExecutor() == NULL || cc->getExecutor()->collection() == NULL);
+                cc->kill();
 
-            // If the CC is pinned, somebody is actively using it and we do not delete it.
-            // Instead we notify the holder that we killed it.  The holder will then delete the
-            // CC.
-            //
-            // If the CC is not pinned, there is nobody actively holding it.  We can safely
-            // delete it.
-            if (!cc->isPinned()) {
-                delete cc;
+                invariant(cc->getExecutor() == NULL || cc->getExecutor()->collection() == NULL);
+
+                // If the CC is pinned, somebody is actively using it and we do not delete it.
+                // Instead we notify the holder that we killed it.  The holder will then delete
+                // the CC.
+                //
+                // If the CC is not pinned, there is nobody actively holding it.  We can safely
+                // delete it.
+                if (!cc->isPinned()) {
+                    delete cc;
+                }
             }
-        }
-    } else {
-        CursorMap newMap;
-
-        // collection will still be around, just all PlanExecutors are invalid
-        for (CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
-            ClientCursor* cc = i->second;
-
-            // Note that a valid ClientCursor state is "no cursor no executor."  This is because
-            // the set of active cursor IDs in ClientCursor is used as representation of query
-            // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
-            if (NULL == cc->getExecutor()) {
-                newMap.insert(*i);
-                continue;
+        } else {
+            CursorMap newMap;
+
+            // collection will still be around, just all PlanExecutors are invalid
+            for (CursorMap::const_iterator i = partition.cursors.begin();
+                 i != partition.cursors.end();
+                 ++i) {
+                ClientCursor* cc = i->second;
+
+                // Note that a valid ClientCursor state is "no cursor no executor."  This is
+                // because the set of active cursor IDs in ClientCursor is used as representation
+                // of query state.  See sharding_block.h.  TODO(greg,hk): Move this out.
+                if (NULL == cc->getExecutor()) {
+                    newMap.insert(*i);
+                    continue;
+                }
+
+                if (cc->isPinned() || cc->isAggCursor()) {
+                    // Pinned cursors need to stay alive, so we leave them around.  Aggregation
+                    // cursors also can stay alive (since they don't have their lifetime bound to
+                    // the underlying collection).  However, if they have an associated executor,
+                    // we need to kill it, because it's now invalid.
+                    if (cc->getExecutor())
+                        cc->getExecutor()->kill(reason);
+                    newMap.insert(*i);
+                } else {
+                    cc->kill();
+                    delete cc;
+                }
             }
 
-            if (cc->isPinned() || cc->isAggCursor()) {
-                // Pinned cursors need to stay alive, so we leave them around.  Aggregation
-                // cursors also can stay alive (since they don't have their lifetime bound to
-                // the underlying collection).  However, if they have an associated executor, we
-                // need to kill it, because it's now invalid.
-                if (cc->getExecutor())
-                    cc->getExecutor()->kill(reason);
-                newMap.insert(*i);
-            } else {
-                cc->kill();
-                delete cc;
-            }
+            partition.cursors = newMap;
         }
-
-        _cursors = newMap;
     }
 }
 
@@ -397,36 +453,53 @@ void CursorManager::invalidateDocument(OperationContext* txn,
         return;
     }
 
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-
-    for (ExecSet::iterator it = _nonCachedExecutors.begin(); it != _nonCachedExecutors.end();
-         ++it) {
-        PlanExecutor* exec = *it;
-        exec->invalidate(txn, dl, type);
-    }
+    // Executors which can't hold 'dl', such as tailable cursors waiting for new documents, are
+    // skipped.
+    for (auto&& partition : _partitions) {
+        PartitionLock lk(partition);
+
+        for (ExecSet::iterator it = partition.nonCachedExecutors.begin();
+             it != partition.nonCachedExecutors.end();
+             ++it) {
+            PlanExecutor* exec = *it;
+            if (exec->mayHoldRecordId(dl)) {
+                exec->invalidate(txn, dl, type);
+            }
+        }
 
-    for (CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
-        PlanExecutor* exec = i->second->getExecutor();
-        if (exec) {
-            exec->invalidate(txn, dl, type);
+        for (CursorMap::const_iterator i = partition.cursors.begin(); i != partition.cursors.end();
+             ++i) {
+            PlanExecutor* exec = i->second->getExecutor();
+            if (exec && exec->mayHoldRecordId(dl)) {
+                exec->invalidate(txn, dl, type);
+            }
         }
     }
 }
 
 std::size_t CursorManager::timeoutCursors(int millisSinceLastCall) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-
     vector<ClientCursor*> toDelete;
 
-    for (CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
-        ClientCursor* cc = i->second;
-        if (cc->shouldTimeout(millisSinceLastCall))
-            toDelete.push_back(cc);
+    for (auto&& partition : _partitions) {
+        PartitionLock lk(partition);
+        const size_t firstInPartition = toDelete.size();
+
+        for (CursorMap::const_iterator i = partition.cursors.begin(); i != partition.cursors.end();
+             ++i) {
+            ClientCursor* cc = i->second;
+            if (cc->shouldTimeout(millisSinceLastCall))
+                toDelete.push_back(cc);
+        }
+
+        for (size_t i = firstInPartition; i < toDelete.size(); ++i) {
+            _deregisterCursor_inlock(&partition, toDelete[i]);
+        }
     }
 
+    // The cursors are no longer registered, so they can be deleted outside of the partition
+    // locks.
     for (vector<ClientCursor*>::const_iterator i = toDelete.begin(); i != toDelete.end(); ++i) {
         ClientCursor* cc = *i;
-        _deregisterCursor_inlock(cc);
         cc->kill();
         delete cc;
     }
@@ -435,20 +508,23 @@ std::size_t CursorManager::timeoutCursors(int millisSinceLastCall) {
 }
 
 void CursorManager::registerExecutor(PlanExecutor* exec) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-    const std::pair<ExecSet::iterator, bool> result = _nonCachedExecutors.insert(exec);
+    Partition& partition = _partitionForPointer(exec);
+    PartitionLock lk(partition);
+    const std::pair<ExecSet::iterator, bool> result = partition.nonCachedExecutors.insert(exec);
     invariant(result.second);  // make sure this was inserted
 }
 
 void CursorManager::deregisterExecutor(PlanExecutor* exec) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-    _nonCachedExecutors.erase(exec);
+    Partition& partition = _partitionForPointer(exec);
+    PartitionLock lk(partition);
+    partition.nonCachedExecutors.erase(exec);
 }
 
 ClientCursor* CursorManager::find(CursorId id, bool pin) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-    CursorMap::const_iterator it = _cursors.find(id);
-    if (it == _cursors.end())
+    Partition& partition = _partitionForCursor(id);
+    PartitionLock lk(partition);
+    CursorMap::const_iterator it = partition.cursors.find(id);
+    if (it == partition.cursors.end())
         return NULL;
 
     ClientCursor* cursor = it->second;
@@ -461,7 +537,7 @@ ClientCursor* CursorManager::find(CursorId id, bool pin) {
 }
 
 void CursorManager::unpin(ClientCursor* cursor) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
+    PartitionLock lk(_partitionForCursor(cursor->cursorid()));
 
     invariant(cursor->isPinned());
     cursor->unsetPinned();
@@ -472,24 +548,33 @@ bool CursorManager::ownsCursorId(CursorId cursorId) const {
 }
 
 void CursorManager::getCursorIds(std::set<CursorId>* openCursors) const {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
+    for (auto&& partition : _partitions) {
+        PartitionLock lk(partition);
 
-    for (CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
-        ClientCursor* cc = i->second;
-        openCursors->insert(cc->cursorid());
+        for (CursorMap::const_iterator i = partition.cursors.begin(); i != partition.cursors.end();
+             ++i) {
+            ClientCursor* cc = i->second;
+            openCursors->insert(cc->cursorid());
+        }
     }
 }
 
 size_t CursorManager::numCursors() const {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-    return _cursors.size();
+    size_t num = 0;
+    for (auto&& partition : _partitions) {
+        PartitionLock lk(partition);
+        num += partition.cursors.size();
+    }
+    return num;
 }
 
-CursorId CursorManager::_allocateCursorId_inlock() {
+CursorId CursorManager::_allocateCursorId_inlock(Partition* partition, size_t partitionIndex) {
     for (int i = 0; i < 10000; i++) {
-        unsigned mypart = static_cast<unsigned>(_random->nextInt32());
+        // The low bits of the id name its partition.
+        unsigned mypart = static_cast<unsigned>(partition->random->nextInt32());
+        mypart = (mypart & ~static_cast<unsigned>(kNumPartitions - 1)) | partitionIndex;
         CursorId id = cursorIdFromParts(_collectionCacheRuntimeId, mypart);
-        if (_cursors.count(id) == 0)
+        if (partition->cursors.count(id) == 0)
             return id;
     }
     fassertFailed(17360);
@@ -497,22 +582,25 @@ CursorId CursorManager::_allocateCursorId_inlock() {
 
 CursorId CursorManager::registerCursor(ClientCursor* cc) {
     invariant(cc);
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-    CursorId id = _allocateCursorId_inlock();
-    _cursors[id] = cc;
+    Partition& partition = _partitionForPointer(cc);
+    PartitionLock lk(partition);
+    CursorId id = _allocateCursorId_inlock(&partition, &partition - _partitions.data());
+    partition.cursors[id] = cc;
     return id;
 }
 
 void CursorManager::deregisterCursor(ClientCursor* cc) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
-    _deregisterCursor_inlock(cc);
+    Partition& partition = _partitionForCursor(cc->cursorid());
+    PartitionLock lk(partition);
+    _deregisterCursor_inlock(&partition, cc);
 }
 
 Status CursorManager::eraseCursor(OperationContext* txn, CursorId id, bool shouldAudit) {
-    stdx::lock_guard<SimpleMutex> lk(_mutex);
+    Partition& partition = _partitionForCursor(id);
+    PartitionLock lk(partition);
 
-    CursorMap::iterator it = _cursors.find(id);
-    if (it == _cursors.end()) {
+    CursorMap::iterator it = partition.cursors.find(id);
+    if (it == partition.cursors.end()) {
         if (shouldAudit) {
             audit::logKillCursorsAuthzCheck(txn->getClient(), _nss, id, ErrorCodes::CursorNotFound);
         }
@@ -534,14 +622,14 @@ Status CursorManager::eraseCursor(OperationContext* txn, CursorId id, bool shoul
     }
 
     cursor->kill();
-    _deregisterCursor_inlock(cursor);
+    _deregisterCursor_inlock(&partition, cursor);
     delete cursor;
     return Status::OK();
 }
 
-void CursorManager::_deregisterCursor_inlock(ClientCursor* cc) {
+void CursorManager::_deregisterCursor_inlock(Partition* partition, ClientCursor* cc) {
     invariant(cc);
     CursorId id = cc->cursorid();
-    _cursors.erase(id);
+    partition->cursors.erase(id);
 }
 }
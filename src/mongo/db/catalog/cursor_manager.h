@@ -31,12 +31,14 @@
 #pragma once
 
 
+#include <array>
+
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/record_id.h"
 #include "mongo/platform/unordered_set.h"
-#include "mongo/util/concurrency/mutex.h"
+#include "mongo/stdx/mutex.h"
 
 namespace mongo {
 
@@ -44,6 +46,16 @@ class OperationContext;
 class PseudoRandom;
 class PlanExecutor;
 
+/**
+ * Keeps track of the ClientCursors and the yielding PlanExecutors of one collection, or of the
+ * global cursor manager.
+ *
+ * Cursors and executors are spread over a fixed number of partitions, each with its own mutex,
+ * so that concurrent operations on different cursors rarely wait for each other. A cursor lives
+ * in the partition named by the low bits of its id, and an executor in the partition chosen by
+ * hashing its address. Operations on all cursors, such as invalidation, visit the partitions one
+ * at a time.
+ */
 class CursorManager {
 public:
     CursorManager(StringData ns);
@@ -143,19 +155,34 @@ public:
     static std::size_t timeoutCursorsGlobal(OperationContext* txn, int millisSinceLastCall);
 
 private:
-    CursorId _allocateCursorId_inlock();
-    void _deregisterCursor_inlock(ClientCursor* cc);
+    // Must be a power of two, since the low bits of a cursor id select its partition.
+    static const size_t kNumPartitions = 16;
 
-    NamespaceString _nss;
-    unsigned _collectionCacheRuntimeId;
-    std::unique_ptr<PseudoRandom> _random;
+    typedef unordered_set<PlanExecutor*> ExecSet;
+    typedef std::map<CursorId, ClientCursor*> CursorMap;
 
-    mutable SimpleMutex _mutex;
+    struct Partition {
+        mutable stdx::mutex mutex;
 
-    typedef unordered_set<PlanExecutor*> ExecSet;
-    ExecSet _nonCachedExecutors;
+        // Cursor ids are drawn from a separate generator in each partition, so that registering
+        // a cursor only locks its own partition.
+        std::unique_ptr<PseudoRandom> random;
 
-    typedef std::map<CursorId, ClientCursor*> CursorMap;
-    CursorMap _cursors;
+        ExecSet nonCachedExecutors;
+        CursorMap cursors;
+    };
+
+    class PartitionLock;
+
+    Partition& _partitionForCursor(CursorId id);
+    Partition& _partitionForPointer(const void* ptr);
+
+    CursorId _allocateCursorId_inlock(Partition* partition, size_t partitionIndex);
+    void _deregisterCursor_inlock(Partition* partition, ClientCursor* cc);
+
+    NamespaceString _nss;
+    unsigned _collectionCacheRuntimeId;
+
+    std::array<Partition, kNumPartitions> _partitions;
 };
 }
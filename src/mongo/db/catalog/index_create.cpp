@@ -49,11 +49,15 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/quick_exit.h"
 
 namespace mongo {
@@ -87,6 +91,13 @@ public:
 
 } exportedMaxIndexBuildMemoryUsageParameter;
 
+// Number of threads generating keys for a foreground index build. With 0 or 1, keys are generated
+// on the thread scanning the collection.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildKeyGenerationThreads, int, 4);
+
+// Collections with fewer records than this have their keys generated on the scanning thread.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildParallelMinRecords, long long, 10000);
+
 
 /**
  * On rollback sets MultiIndexBlock::_needToCleanup to true.
@@ -104,6 +115,163 @@ private:
     MultiIndexBlock* const _indexer;
 };
 
+/**
+ * Generates the keys for a foreground index build on a pool of worker threads.
+ *
+ * The collection scan stays on the operation's thread, since the cursor and recovery unit belong
+ * to its OperationContext. It hands out batches of documents covering consecutive RecordId ranges
+ * to the workers in turn. Each worker inserts into a BulkBuilder of its own per index, and those
+ * are merged into the indexes' BulkBuilders by finish(). A worker's queue holds only a couple of
+ * batches, so the scan never gets far ahead of key generation and its ProgressMeter stays
+ * accurate.
+ */
+class MultiIndexBlock::ParallelKeyGenerator {
+    MONGO_DISALLOW_COPYING(ParallelKeyGenerator);
+
+public:
+    ParallelKeyGenerator(MultiIndexBlock* indexer, size_t numWorkers) : _indexer(indexer) {
+        const size_t maxMemoryUsageBytes =
+            _indexer->_eachIndexBuildMaxMemoryUsageBytes / numWorkers;
+
+        for (size_t i = 0; i < numWorkers; i++) {
+            std::unique_ptr<Worker> worker(new Worker());
+            for (auto&& index : _indexer->_indexes) {
+                worker->bulks.push_back(index.real->initiateBulk(maxMemoryUsageBytes));
+            }
+            _workers.push_back(std::move(worker));
+        }
+
+        for (size_t i = 0; i < numWorkers; i++) {
+            Worker* worker = _workers[i].get();
+            worker->thread = stdx::thread([this, worker, i] {
+                setThreadName(std::string(str::stream() << "indexKeyGenerator-" << i));
+                runWorker(worker);
+            });
+        }
+    }
+
+    ~ParallelKeyGenerator() {
+        stopWorkers();
+    }
+
+    void add(const BSONObj& doc, const RecordId& loc) {
+        if (!_batch) {
+            _batch = std::make_shared<Batch>();
+            _batch->reserve(kBatchSize);
+        }
+
+        _batch->push_back(std::make_pair(doc.getOwned(), loc));
+        if (_batch->size() == kBatchSize) {
+            flushBatch();
+        }
+    }
+
+    /**
+     * Waits for the workers to generate the keys for every document added and merges their
+     * BulkBuilders into the indexes' BulkBuilders.
+     */
+    Status finish() {
+        flushBatch();
+        stopWorkers();
+
+        for (auto&& worker : _workers) {
+            if (!worker->status.isOK()) {
+                return worker->status;
+            }
+        }
+
+        for (auto&& worker : _workers) {
+            for (size_t i = 0; i < _indexer->_indexes.size(); i++) {
+                _indexer->_indexes[i].bulk->merge(std::move(worker->bulks[i]));
+            }
+        }
+        return Status::OK();
+    }
+
+private:
+    typedef std::vector<std::pair<BSONObj, RecordId>> Batch;
+
+    static const size_t kBatchSize = 1000;
+    static const size_t kMaxQueuedBatches = 2;
+
+    struct Worker {
+        Worker() : queue(kMaxQueuedBatches) {}
+
+        // A null batch tells the worker to stop.
+        BlockingQueue<std::shared_ptr<Batch>> queue;
+        std::vector<std::unique_ptr<IndexAccessMethod::BulkBuilder>> bulks;  // one per index
+        Status status = Status::OK();
+        stdx::thread thread;
+    };
+
+    void flushBatch() {
+        if (!_batch) {
+            return;
+        }
+
+        _workers[_nextWorker]->queue.push(std::move(_batch));
+        _batch.reset();
+        _nextWorker = (_nextWorker + 1) % _workers.size();
+    }
+
+    void stopWorkers() {
+        if (_stopped) {
+            return;
+        }
+        _stopped = true;
+
+        // Workers keep draining their queues after an error, so these can't block for long.
+        for (auto&& worker : _workers) {
+            worker->queue.pushEvenIfFull(nullptr);
+        }
+        for (auto&& worker : _workers) {
+            worker->thread.join();
+        }
+    }
+
+    void runWorker(Worker* worker) {
+        while (std::shared_ptr<Batch> batch = worker->queue.blockingPop()) {
+            if (!worker->status.isOK()) {
+                continue;
+            }
+
+            try {
+                for (auto&& doc : *batch) {
+                    worker->status = insert(worker, doc.first, doc.second);
+                    if (!worker->status.isOK()) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                worker->status = exceptionToStatus();
+            }
+        }
+    }
+
+    Status insert(Worker* worker, const BSONObj& doc, const RecordId& loc) {
+        for (size_t i = 0; i < _indexer->_indexes.size(); i++) {
+            const IndexToBuild& index = _indexer->_indexes[i];
+            if (index.filterExpression && !index.filterExpression->matchesBSON(doc)) {
+                continue;
+            }
+
+            // BulkBuilder::insert() only generates keys and sorts them, so it doesn't use the
+            // OperationContext, which belongs to the scanning thread.
+            Status status = worker->bulks[i]->insert(nullptr, doc, loc, index.options, nullptr);
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+        return Status::OK();
+    }
+
+    MultiIndexBlock* const _indexer;
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::shared_ptr<Batch> _batch;
+    size_t _nextWorker = 0;
+    bool _stopped = false;
+};
+
 /**
  * On rollback in init(), cleans up _indexes so that ~MultiIndexBlock doesn't try to clean
  * up _indexes manually (since the changes were already rolled back).
@@ -128,6 +296,7 @@ MultiIndexBlock::MultiIndexBlock(OperationContext* txn, Collection* collection)
       _buildInBackground(false),
       _allowInterruption(false),
       _ignoreUnique(false),
+      _eachIndexBuildMaxMemoryUsageBytes(0),
       _needToCleanup(true) {}
 
 MultiIndexBlock::~MultiIndexBlock() {
@@ -201,6 +370,7 @@ Status MultiIndexBlock::init(const std::vector<BSONObj>& indexSpecs) {
         eachIndexBuildMaxMemoryUsageBytes =
             std::size_t(maxIndexBuildMemoryUsageMegabytes) * 1024 * 1024 / indexSpecs.size();
     }
+    _eachIndexBuildMaxMemoryUsageBytes = eachIndexBuildMaxMemoryUsageBytes;
 
     for (size_t i = 0; i < indexSpecs.size(); i++) {
         BSONObj info = indexSpecs[i];
@@ -285,6 +455,14 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
         exec->setYieldPolicy(PlanExecutor::WRITE_CONFLICT_RETRY_ONLY);
     }
 
+    std::unique_ptr<ParallelKeyGenerator> keyGenerator;
+    const int keyGenerationThreads = internalIndexBuildKeyGenerationThreads.load();
+    if (keyGenerationThreads > 1 && !_buildInBackground &&
+        numRecords >= internalIndexBuildParallelMinRecords.load()) {
+        keyGenerator.reset(new ParallelKeyGenerator(this, keyGenerationThreads));
+        log() << "generating index keys on " << keyGenerationThreads << " threads";
+    }
+
     Snapshotted<BSONObj> objToIndex;
     RecordId loc;
     PlanExecutor::ExecState state;
@@ -306,22 +484,27 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
             // Done before insert so we can retry document if it WCEs.
             progress->setTotalWhileRunning(_collection->numRecords(_txn));
 
-            WriteUnitOfWork wunit(_txn);
-            Status ret = insert(objToIndex.value(), loc);
-            if (_buildInBackground)
-                exec->saveState();
-            if (ret.isOK()) {
-                wunit.commit();
-            } else if (dupsOut && ret.code() == ErrorCodes::DuplicateKey) {
-                // If dupsOut is non-null, we should only fail the specific insert that
-                // led to a DuplicateKey rather than the whole index build.
-                dupsOut->insert(loc);
+            if (keyGenerator) {
+                // Bulk builders don't write to storage, so there is nothing to roll back.
+                keyGenerator->add(objToIndex.value(), loc);
             } else {
-                // Fail the index build hard.
-                return ret;
+                WriteUnitOfWork wunit(_txn);
+                Status ret = insert(objToIndex.value(), loc);
+                if (_buildInBackground)
+                    exec->saveState();
+                if (ret.isOK()) {
+                    wunit.commit();
+                } else if (dupsOut && ret.code() == ErrorCodes::DuplicateKey) {
+                    // If dupsOut is non-null, we should only fail the specific insert that
+                    // led to a DuplicateKey rather than the whole index build.
+                    dupsOut->insert(loc);
+                } else {
+                    // Fail the index build hard.
+                    return ret;
+                }
+                if (_buildInBackground)
+                    exec->restoreState();  // Handles any WCEs internally.
             }
-            if (_buildInBackground)
-                exec->restoreState();  // Handles any WCEs internally.
 
             // Go to the next document
             progress->hit();
@@ -345,6 +528,12 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
                 WorkingSetCommon::toStatusString(objToIndex.value()),
             state == PlanExecutor::IS_EOF);
 
+    if (keyGenerator) {
+        Status status = keyGenerator->finish();
+        if (!status.isOK())
+            return status;
+    }
+
     progress->finished();
 
     Status ret = doneInserting(dupsOut);
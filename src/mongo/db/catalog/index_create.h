@@ -127,6 +127,9 @@ public:
      * the set rather than failing the build. Documents added to this set are not indexed, so
      * callers MUST either fail this index build or delete the documents from the collection.
      *
+     * Foreground builds of large collections generate keys on a pool of worker threads, sized by
+     * the internalIndexBuildKeyGenerationThreads server parameter.
+     *
      * Can throw an exception if interrupted.
      *
      * Should not be called inside of a WriteUnitOfWork.
@@ -190,6 +193,7 @@ public:
 private:
     class SetNeedToCleanupOnRollback;
     class CleanupIndexesVectorOnRollback;
+    class ParallelKeyGenerator;
 
     struct IndexToBuild {
 #if defined(_MSC_VER) && _MSC_VER < 1900  // MVSC++ <= 2013 can't generate default move operations
@@ -232,6 +236,9 @@ private:
     bool _allowInterruption;
     bool _ignoreUnique;
 
+    // Memory each bulk builder may use before spilling, shared by its key generation threads.
+    std::size_t _eachIndexBuildMaxMemoryUsageBytes;
+
     bool _needToCleanup;
 };
 
@@ -90,6 +90,22 @@ public:
      */
     static void destroy();
 
+    /**
+     * Detaches the Client object stored in TLS for the current thread and returns it to the
+     * caller. The current thread must have a Client.
+     *
+     * Used by service executors which multiplex many connections onto a small number of threads,
+     * together with setCurrent(), to move a connection's Client between the threads which service
+     * its requests.
+     */
+    static ServiceContext::UniqueClient releaseCurrent();
+
+    /**
+     * Attaches "client" to the current thread, which must not already have a Client, and sets the
+     * thread name to the client's description.
+     */
+    static void setCurrent(ServiceContext::UniqueClient client);
+
     std::string clientAddress(bool includePort = false) const;
     const std::string& desc() const {
         return _desc;
@@ -165,8 +181,9 @@ private:
     // Description for the client (e.g. conn8)
     const std::string _desc;
 
-    // OS id of the thread, which owns this client
-    const stdx::thread::id _threadId;
+    // OS id of the thread, which owns this client. Only changes when the client is moved to a
+    // different thread through setCurrent().
+    stdx::thread::id _threadId;
 
     // > 0 for things "conn", 0 otherwise
     const ConnectionId _connectionId;
@@ -44,12 +44,14 @@
 #include "mongo/db/commands/server_status_internal.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/hostname_canonicalization_worker.h"
 #include "mongo/util/net/listen.h"
+#include "mongo/util/net/message_compressor_registry.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
@@ -282,11 +284,31 @@ public:
     BSONObj generateSection(OperationContext* txn, const BSONElement& configElement) const {
         BSONObjBuilder b;
         networkCounter.append(b);
+
+        BSONObjBuilder compressionBuilder(b.subobjStart("compression"));
+        MessageCompressorRegistry::get().appendStats(&compressionBuilder);
+        compressionBuilder.doneFast();
+
         return b.obj();
     }
 
 } network;
 
+class ServiceExecutor : public ServerStatusSection {
+public:
+    ServiceExecutor() : ServerStatusSection("serviceExecutor") {}
+    virtual bool includeByDefault() const {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* txn, const BSONElement& configElement) const {
+        BSONObjBuilder b;
+        serviceExecutorCounter.append(b);
+        return b.obj();
+    }
+
+} serviceExecutor;
+
 #ifdef MONGO_CONFIG_SSL
 class Security : public ServerStatusSection {
 public:
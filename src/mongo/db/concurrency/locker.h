@@ -33,6 +33,7 @@
 
 #include "mongo/db/concurrency/lock_manager.h"
 #include "mongo/db/concurrency/lock_stats.h"
+#include "mongo/util/concurrency/ticketholder.h"
 
 namespace mongo {
 
@@ -69,6 +70,18 @@ public:
      */
     static void setGlobalThrottling(class TicketHolder* reading, class TicketHolder* writing);
 
+    /**
+     * Sets the priority with which this locker waits for a ticket when it takes the global lock
+     * under throttling. Defaults to TicketHolder::Priority::kNormal.
+     */
+    void setAdmissionPriority(TicketHolder::Priority priority) {
+        _admissionPriority = priority;
+    }
+
+    TicketHolder::Priority getAdmissionPriority() const {
+        return _admissionPriority;
+    }
+
     /**
      * State for reporting the number of active and queued reader and writer clients.
      */
@@ -324,6 +337,32 @@ public:
 
 protected:
     Locker() {}
+
+private:
+    TicketHolder::Priority _admissionPriority = TicketHolder::Priority::kNormal;
+};
+
+/**
+ * Sets the admission priority of an operation's locker for the lifetime of this object, and then
+ * restores the previous one. Tickets are only acquired with the global lock, so this should be
+ * in place before the operation takes its first lock.
+ */
+class ScopedAdmissionPriority {
+    MONGO_DISALLOW_COPYING(ScopedAdmissionPriority);
+
+public:
+    ScopedAdmissionPriority(Locker* locker, TicketHolder::Priority priority)
+        : _locker(locker), _previous(locker->getAdmissionPriority()) {
+        _locker->setAdmissionPriority(priority);
+    }
+
+    ~ScopedAdmissionPriority() {
+        _locker->setAdmissionPriority(_previous);
+    }
+
+private:
+    Locker* const _locker;
+    const TicketHolder::Priority _previous;
 };
 
 }  // namespace mongo
@@ -348,6 +348,11 @@ void CurOp::reportState(BSONObjBuilder* builder) {
     }
 
     builder->append("numYields", _numYields);
+
+    if (_debug.spilledBytes >= 0) {
+        builder->append("spilledBytes", _debug.spilledBytes);
+        builder->append("spilledUncompressedBytes", _debug.spilledUncompressedBytes);
+    }
 }
 
 void CurOp::setMaxTimeMicros(uint64_t maxTimeMicros) {
@@ -511,6 +516,11 @@ string OpDebug::report(const CurOp& curop, const SingleThreadedLockStats& lockSt
     OPDEBUG_TOSTRING_HELP_BOOL(hasSortStage);
     OPDEBUG_TOSTRING_HELP_BOOL(fromMultiPlanner);
     OPDEBUG_TOSTRING_HELP_BOOL(replanned);
+    OPDEBUG_TOSTRING_HELP(nGroups);
+    OPDEBUG_TOSTRING_HELP(groupSpills);
+    OPDEBUG_TOSTRING_HELP(groupSpilledBytes);
+    OPDEBUG_TOSTRING_HELP(spilledBytes);
+    OPDEBUG_TOSTRING_HELP(spilledUncompressedBytes);
     OPDEBUG_TOSTRING_HELP(nmoved);
     OPDEBUG_TOSTRING_HELP(nMatched);
     OPDEBUG_TOSTRING_HELP(nModified);
@@ -629,6 +639,11 @@ void OpDebug::append(const CurOp& curop,
     OPDEBUG_APPEND_BOOL(hasSortStage);
     OPDEBUG_APPEND_BOOL(fromMultiPlanner);
     OPDEBUG_APPEND_BOOL(replanned);
+    OPDEBUG_APPEND_NUMBER(nGroups);
+    OPDEBUG_APPEND_NUMBER(groupSpills);
+    OPDEBUG_APPEND_NUMBER(groupSpilledBytes);
+    OPDEBUG_APPEND_NUMBER(spilledBytes);
+    OPDEBUG_APPEND_NUMBER(spilledUncompressedBytes);
     OPDEBUG_APPEND_BOOL(moved);
     OPDEBUG_APPEND_NUMBER(nmoved);
     OPDEBUG_APPEND_NUMBER(nMatched);
@@ -662,4 +677,12 @@ void OpDebug::append(const CurOp& curop,
     execStats.append(b, "execStats");
 }
 
+void OpDebug::addSpilledBytes(long long bytes, long long uncompressedBytes) {
+    if (bytes == 0)
+        return;
+
+    spilledBytes = std::max(spilledBytes, 0LL) + bytes;
+    spilledUncompressedBytes = std::max(spilledUncompressedBytes, 0LL) + uncompressedBytes;
+}
+
 }  // namespace mongo
@@ -143,6 +143,12 @@ public:
                 const SingleThreadedLockStats& lockStats,
                 BSONObjBuilder& builder) const;
 
+    /**
+     * Adds to the bytes this operation has written to temporary files, as stored on disk and
+     * before compression.
+     */
+    void addSpilledBytes(long long bytes, long long uncompressedBytes);
+
     // -------------------
 
     // basic options
@@ -178,6 +184,16 @@ public:
     // True if a replan was triggered during the execution of this operation.
     bool replanned{false};
 
+    // Totals over the $group stages of an aggregation, once they have returned all their groups.
+    long long nGroups{-1};            // groups returned
+    long long groupSpills{-1};        // times groups were written to disk to free memory
+    long long groupSpilledBytes{-1};  // bytes written to disk
+
+    // Totals over the sorts, $group and $lookup stages and index builds of this operation that
+    // wrote to temporary files.
+    long long spilledBytes{-1};              // bytes stored on disk
+    long long spilledUncompressedBytes{-1};  // the same data before compression
+
     long long nMatched{-1};   // number of records that match the query
     long long nModified{-1};  // number of records written (no no-ops)
     long long nmoved{-1};     // updates resulted in a move (moves are expensive)
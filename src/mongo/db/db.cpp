@@ -40,6 +40,7 @@
 #include <signal.h>
 #include <string>
 
+#include "mongo/base/checked_cast.h"
 #include "mongo/base/init.h"
 #include "mongo/base/initializer.h"
 #include "mongo/base/status.h"
@@ -76,6 +77,7 @@
 #include "mongo/db/mongod_options.h"
 #include "mongo/db/op_observer.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/plan_cache_persister.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repair_database.h"
@@ -222,6 +224,25 @@ public:
     virtual void close() {
         Client::destroy();
     }
+
+    virtual bool canSuspend() const {
+        return true;
+    }
+
+    virtual std::unique_ptr<ConnectionState> suspend() {
+        return stdx::make_unique<ClientState>(Client::releaseCurrent());
+    }
+
+    virtual void resume(std::unique_ptr<ConnectionState> state) {
+        Client::setCurrent(std::move(checked_cast<ClientState*>(state.get())->client));
+    }
+
+private:
+    struct ClientState : public ConnectionState {
+        explicit ClientState(ServiceContext::UniqueClient client) : client(std::move(client)) {}
+
+        ServiceContext::UniqueClient client;
+    };
 };
 
 void logStartup(OperationContext* txn) {
@@ -581,6 +602,8 @@ void _initAndListen(int listenPort) {
     MessageServer::Options options;
     options.port = listenPort;
     options.ipList = serverGlobalParams.bind_ip;
+    options.serviceExecutor = serverGlobalParams.serviceExecutor;
+    options.serviceExecutorThreads = serverGlobalParams.serviceExecutorThreads;
 
     auto handler = std::make_shared<MyMessageHandler>();
     MessageServer* server = createServer(options, std::move(handler));
@@ -793,6 +816,8 @@ void _initAndListen(int listenPort) {
 
     startClientCursorMonitor();
 
+    startPlanCachePersister();
+
     PeriodicTask::startRunningPeriodicTasks();
 
     HostnameCanonicalizationWorker::start(getGlobalServiceContext());
@@ -202,6 +202,7 @@ Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
     _children.clear();
 
     _specificStats.replanned = true;
+    planCacheReplans.increment();
 
     // Use the query planning module to plan the whole query.
     std::vector<QuerySolution*> rawSolutions;
@@ -30,6 +30,8 @@
 
 #include "mongo/db/exec/collection_scan.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/filter.h"
@@ -66,6 +68,13 @@ CollectionScan::CollectionScan(OperationContext* txn,
       _wsidForFetch(_workingSet->allocate()) {
     // Explain reports the direction of the collection scan.
     _specificStats.direction = params.direction;
+
+    // Tailable scans return each document as soon as it is inserted, so they don't wait for a
+    // block to fill.
+    if (_params.batchMatchSize > 1 && !_params.tailable) {
+        _batchMatcher = BatchMatcher::make(_filter);
+        _blockSize = _params.batchMatchSize;
+    }
 }
 
 PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
@@ -84,11 +93,22 @@ PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
         return PlanStage::DEAD;
     }
 
+    if (_outputPos < _output.size()) {
+        *out = _output[_outputPos++];
+        ++_commonStats.advanced;
+        return PlanStage::ADVANCED;
+    }
+
     if ((0 != _params.maxScan) && (_specificStats.docsTested >= _params.maxScan)) {
         _commonStats.isEOF = true;
     }
 
     if (_commonStats.isEOF) {
+        if (!_block.empty()) {
+            filterBlock();
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
         return PlanStage::IS_EOF;
     }
 
@@ -170,6 +190,11 @@ PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
             _commonStats.isEOF = true;
         }
 
+        if (!_block.empty()) {
+            // Filter the last block on the next call.
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
         return PlanStage::IS_EOF;
     }
 
@@ -181,9 +206,43 @@ PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
     member->obj = {getOpCtx()->recoveryUnit()->getSnapshotId(), record->data.releaseToBson()};
     _workingSet->transitionToLocAndObj(id);
 
+    if (_batchMatcher) {
+        ++_specificStats.docsTested;
+        member->makeObjOwnedIfNeeded();
+        _block.push_back(id);
+        if (_block.size() >= _blockSize) {
+            filterBlock();
+        }
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
     return returnIfMatches(member, id, out);
 }
 
+void CollectionScan::filterBlock() {
+    _output.clear();
+    _outputPos = 0;
+
+    std::vector<BSONObj> docs;
+    docs.reserve(_block.size());
+    for (WorkingSetID id : _block) {
+        docs.push_back(_workingSet->get(id)->obj.value());
+    }
+
+    std::vector<char> passes(_block.size());
+    _batchMatcher->matches(docs.data(), docs.size(), passes.data());
+
+    for (size_t i = 0; i < _block.size(); ++i) {
+        if (passes[i]) {
+            _output.push_back(_block[i]);
+        } else {
+            _workingSet->free(_block[i]);
+        }
+    }
+    _block.clear();
+}
+
 PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                       WorkingSetID memberID,
                                                       WorkingSetID* out) {
@@ -201,12 +260,26 @@ PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
 }
 
 bool CollectionScan::isEOF() {
-    return _commonStats.isEOF || _isDead;
+    return (_commonStats.isEOF && _block.empty() && _outputPos == _output.size()) || _isDead;
 }
 
 void CollectionScan::doInvalidate(OperationContext* txn,
                                   const RecordId& id,
                                   InvalidationType type) {
+    // Documents waiting to be returned keep their contents but lose their RecordId, as in SORT.
+    // Documents waiting for the filter keep their RecordId unless it is deleted: the filter is
+    // applied to the version that was read, as if the block had been filtered before the yield.
+    auto invalidate = [&](WorkingSetID memberId) {
+        WorkingSetMember* member = _workingSet->get(memberId);
+        if (member->hasLoc() && member->loc == id) {
+            WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _params.collection);
+        }
+    };
+    if (INVALIDATION_DELETION == type) {
+        std::for_each(_block.begin(), _block.end(), invalidate);
+    }
+    std::for_each(_output.begin() + _outputPos, _output.end(), invalidate);
+
     // We don't care about mutations since we apply any filters to the result when we (possibly)
     // return it.
     if (INVALIDATION_DELETION != type) {
@@ -227,6 +300,21 @@ void CollectionScan::doInvalidate(OperationContext* txn,
     }
 }
 
+bool CollectionScan::doMayHoldRecordId(const RecordId& dl) const {
+    // An open cursor may be positioned on any record. Without one, only the last record returned
+    // and the documents still buffered are held, as for a tailable scan waiting at EOF.
+    if (_cursor || dl == _lastSeenId) {
+        return true;
+    }
+
+    auto holds = [&](WorkingSetID memberId) {
+        const WorkingSetMember* member = _workingSet->get(memberId);
+        return member->hasLoc() && member->loc == dl;
+    };
+    return std::any_of(_block.begin(), _block.end(), holds) ||
+        std::any_of(_output.begin() + _outputPos, _output.end(), holds);
+}
+
 void CollectionScan::doSaveState() {
     if (_cursor) {
         _cursor->save();
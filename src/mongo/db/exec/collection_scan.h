@@ -29,9 +29,11 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/batch_matcher.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
 
@@ -45,6 +47,9 @@ class OperationContext;
  * Scans over a collection, starting at the RecordId provided in params and continuing until
  * there are no more records in the collection.
  *
+ * If the filter has comparisons that a BatchMatcher evaluates by column, the scan reads blocks of
+ * params.batchMatchSize documents and filters each block at once.
+ *
  * Preconditions: Valid RecordId.
  */
 class CollectionScan final : public PlanStage {
@@ -58,6 +63,7 @@ public:
     bool isEOF() final;
 
     void doInvalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) final;
+    bool doMayHoldRecordId(const RecordId& dl) const final;
     void doSaveState() final;
     void doRestoreState() final;
     void doDetachFromOperationContext() final;
@@ -80,6 +86,12 @@ private:
      */
     StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID, WorkingSetID* out);
 
+    /**
+     * Evaluates the filter over '_block', then moves the matching documents to '_output' and
+     * frees the rest.
+     */
+    void filterBlock();
+
     // WorkingSet is not owned by us.
     WorkingSet* _workingSet;
 
@@ -99,6 +111,18 @@ private:
     // should remain in the INVALID state.
     const WorkingSetID _wsidForFetch;
 
+    // Evaluates the filter over blocks of documents, if it can be, and the size of a block.
+    std::unique_ptr<BatchMatcher> _batchMatcher;
+    size_t _blockSize = 0;
+
+    // Documents read that the filter has not been applied to yet. They are owned, since the
+    // cursor moves on before the block is filtered.
+    std::vector<WorkingSetID> _block;
+
+    // Matching documents waiting to be returned, and the position of the next one.
+    std::vector<WorkingSetID> _output;
+    size_t _outputPos = 0;
+
     // Stats
     CollectionScanStats _specificStats;
 };
@@ -41,7 +41,12 @@ struct CollectionScanParams {
     };
 
     CollectionScanParams()
-        : collection(NULL), start(RecordId()), direction(FORWARD), tailable(false), maxScan(0) {}
+        : collection(NULL),
+          start(RecordId()),
+          direction(FORWARD),
+          tailable(false),
+          maxScan(0),
+          batchMatchSize(0) {}
 
     // What collection?
     // not owned
@@ -58,6 +63,11 @@ struct CollectionScanParams {
 
     // If non-zero, how many documents will we look at?
     size_t maxScan;
+
+    // If greater than one, how many documents to read before applying the filter to all of them
+    // at once. Only meant for plans that don't write and want more than a block of results: a
+    // buffered document that changes at a yield loses its RecordId.
+    size_t batchMatchSize;
 };
 
 }  // namespace mongo
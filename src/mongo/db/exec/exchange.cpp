@@ -0,0 +1,297 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/exchange.h"
+
+#include <algorithm>
+
+#include "mongo/base/status.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+using std::unique_ptr;
+using stdx::make_unique;
+
+namespace {
+// Fewer documents than this per worker aren't worth the cost of handing them to another thread.
+const size_t kMinDocsPerWorker = 64;
+
+/**
+ * Returns the threads shared by all exchange stages. It is never shut down, since plans may still
+ * be running when the process exits.
+ */
+ThreadPool* exchangeWorkerPool() {
+    static ThreadPool* pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "ExchangeWorkers";
+        options.threadNamePrefix = "exchange-";
+        options.minThreads = 0;
+        options.maxThreads = std::max(1U, ProcessInfo().getNumCores());
+        auto pool = new ThreadPool(options);
+        pool->startup();
+        return pool;
+    }();
+    return pool;
+}
+}  // namespace
+
+// static
+const char* ExchangeStage::kStageType = "EXCHANGE";
+
+// static
+const size_t ExchangeStage::kBatchSize = 4096;
+
+// static
+const size_t ExchangeStage::kBatchMaxBytes = 16 * 1024 * 1024;
+
+ExchangeStage::ExchangeStage(OperationContext* opCtx,
+                             WorkingSet* ws,
+                             const Collection* collection,
+                             const MatchExpression* filter,
+                             size_t numWorkers,
+                             PlanStage* child)
+    : PlanStage(kStageType, opCtx),
+      _ws(ws),
+      _collection(collection),
+      _filter(filter),
+      _numWorkers(std::max(size_t(1), numWorkers)) {
+    invariant(_filter);
+    _batchMatcher = BatchMatcher::make(_filter);
+    _children.emplace_back(child);
+    _specificStats.workers.resize(_numWorkers);
+}
+
+bool ExchangeStage::isEOF() {
+    return _childEOF && _batch.empty() && _outputPos == _output.size();
+}
+
+PlanStage::StageState ExchangeStage::work(WorkingSetID* out) {
+    ++_commonStats.works;
+
+    // Adds the amount of time taken by work() to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    if (_outputPos < _output.size()) {
+        *out = _output[_outputPos++];
+        ++_commonStats.advanced;
+        return PlanStage::ADVANCED;
+    }
+
+    if (_childEOF) {
+        if (_batch.empty()) {
+            return PlanStage::IS_EOF;
+        }
+        filterBatch();
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    StageState status = child()->work(&id);
+
+    if (PlanStage::ADVANCED == status) {
+        // The record may point into the storage engine's cursor, which moves on before the
+        // batch is filtered.
+        WorkingSetMember* member = _ws->get(id);
+        member->makeObjOwnedIfNeeded();
+        _batch.push_back(id);
+        _batchBytes += member->obj.value().objsize();
+        if (_batch.size() >= kBatchSize || _batchBytes >= kBatchMaxBytes) {
+            filterBatch();
+        }
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::IS_EOF == status) {
+        _childEOF = true;
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+        *out = id;
+        // If a stage fails, it may create a status WSM to indicate why it failed, in which case
+        // 'id' is valid. If ID is invalid, we create our own error message.
+        if (WorkingSet::INVALID_ID == id) {
+            mongoutils::str::stream ss;
+            ss << "exchange stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+        return status;
+    } else if (PlanStage::NEED_TIME == status) {
+        ++_commonStats.needTime;
+    } else if (PlanStage::NEED_YIELD == status) {
+        ++_commonStats.needYield;
+        *out = id;
+    }
+
+    return status;
+}
+
+void ExchangeStage::filterBatch() {
+    _output.clear();
+    _outputPos = 0;
+    _passes.assign(_batch.size(), false);
+    ++_specificStats.batches;
+
+    const size_t maxSlices = (_batch.size() + kMinDocsPerWorker - 1) / kMinDocsPerWorker;
+    const size_t numSlices = std::max(size_t(1), std::min(_numWorkers, maxSlices));
+    const size_t sliceSize = (_batch.size() + numSlices - 1) / numSlices;
+
+    stdx::mutex mutex;
+    stdx::condition_variable done;
+    size_t remaining = 0;
+    std::vector<Status> errors(numSlices, Status::OK());
+
+    auto runSlice = [&](size_t worker) {
+        try {
+            const size_t begin = worker * sliceSize;
+            filterSlice(worker, begin, std::min(begin + sliceSize, _batch.size()));
+        } catch (...) {
+            errors[worker] = exceptionToStatus();
+        }
+    };
+
+    for (size_t worker = 1; worker < numSlices; ++worker) {
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            ++remaining;
+        }
+        Status scheduled = exchangeWorkerPool()->schedule([&, worker] {
+            runSlice(worker);
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (--remaining == 0) {
+                done.notify_one();
+            }
+        });
+        if (!scheduled.isOK()) {
+            // The pool is shutting down; do the work here instead.
+            {
+                stdx::lock_guard<stdx::mutex> lk(mutex);
+                --remaining;
+            }
+            runSlice(worker);
+        }
+    }
+
+    // This thread is worker 0.
+    runSlice(0);
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        done.wait(lk, [&] { return remaining == 0; });
+    }
+
+    for (auto&& error : errors) {
+        uassertStatusOK(error);
+    }
+
+    for (size_t i = 0; i < _batch.size(); ++i) {
+        if (_passes[i]) {
+            _output.push_back(_batch[i]);
+        } else {
+            _ws->free(_batch[i]);
+        }
+    }
+    _batch.clear();
+    _batchBytes = 0;
+}
+
+void ExchangeStage::filterSlice(size_t worker, size_t begin, size_t end) {
+    Timer timer;
+    if (_batchMatcher) {
+        std::vector<BSONObj> docs;
+        docs.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            docs.push_back(_ws->get(_batch[i])->obj.value());
+        }
+        _batchMatcher->matches(docs.data(), docs.size(), &_passes[begin]);
+    } else {
+        for (size_t i = begin; i < end; ++i) {
+            const WorkingSetMember* member = _ws->get(_batch[i]);
+            _passes[i] = _filter->matchesBSON(member->obj.value());
+        }
+    }
+
+    long long docsPassed = 0;
+    for (size_t i = begin; i < end; ++i) {
+        docsPassed += _passes[i];
+    }
+
+    ExchangeWorkerStats& stats = _specificStats.workers[worker];
+    stats.docsTested += end - begin;
+    stats.docsPassed += docsPassed;
+    stats.executionTimeMicros += timer.micros();
+}
+
+void ExchangeStage::doInvalidate(OperationContext* txn,
+                                 const RecordId& dl,
+                                 InvalidationType type) {
+    // Documents waiting to be returned keep their contents but lose their RecordId, as in SORT.
+    // Documents waiting for the filter keep their RecordId unless it is deleted: the filter is
+    // applied to the version that was read, as if the batch had been filtered before the yield.
+    auto invalidate = [&](WorkingSetID id) {
+        WorkingSetMember* member = _ws->get(id);
+        if (member->hasLoc() && member->loc == dl) {
+            WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+        }
+    };
+    if (INVALIDATION_DELETION == type) {
+        std::for_each(_batch.begin(), _batch.end(), invalidate);
+    }
+    std::for_each(_output.begin() + _outputPos, _output.end(), invalidate);
+}
+
+unique_ptr<PlanStageStats> ExchangeStage::getStats() {
+    _commonStats.isEOF = isEOF();
+
+    BSONObjBuilder bob;
+    _filter->toBSON(&bob);
+    _commonStats.filter = bob.obj();
+
+    unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_EXCHANGE);
+    ret->specific = make_unique<ExchangeStats>(_specificStats);
+    ret->children.emplace_back(child()->getStats());
+    return ret;
+}
+
+const SpecificStats* ExchangeStage::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
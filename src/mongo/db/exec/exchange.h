@@ -0,0 +1,128 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/batch_matcher.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+class Collection;
+
+/**
+ * Applies 'filter' to the documents produced by its child, spreading the evaluation of each batch
+ * of documents over 'numWorkers' threads, and returns the matching documents in the order the
+ * child produced them.
+ *
+ * The child, typically an unfiltered COLLSCAN, runs on the thread that owns the plan, since
+ * RecordStore cursors and the locks protecting them belong to one OperationContext. Only the
+ * predicate evaluation moves to the workers, which all share 'filter'. The planner only chooses
+ * this stage for filters made of matchers that keep no mutable state, so not for $where or geo.
+ *
+ * Plans that update or delete don't use this stage: a buffered document that changes at a yield
+ * loses its RecordId, and the write stage would skip it.
+ */
+class ExchangeStage final : public PlanStage {
+public:
+    ExchangeStage(OperationContext* opCtx,
+                  WorkingSet* ws,
+                  const Collection* collection,
+                  const MatchExpression* filter,
+                  size_t numWorkers,
+                  PlanStage* child);
+
+    bool isEOF() final;
+    StageState work(WorkingSetID* out) final;
+
+    void doInvalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) final;
+
+    StageType stageType() const final {
+        return STAGE_EXCHANGE;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kStageType;
+
+    // Number of documents gathered from the child before they are handed out to the workers.
+    static const size_t kBatchSize;
+
+    // A batch is also handed out once its documents take this many bytes, since they are owned
+    // copies.
+    static const size_t kBatchMaxBytes;
+
+private:
+    /**
+     * Evaluates the filter against '_batch' on all of the workers, then moves the matching
+     * documents to '_output' and frees the rest.
+     */
+    void filterBatch();
+
+    /**
+     * Evaluates the filter against the documents of '_batch' in [begin, end), recording the
+     * results in '_passes' and the work done in the stats of 'worker'.
+     */
+    void filterSlice(size_t worker, size_t begin, size_t end);
+
+    WorkingSet* _ws;
+
+    // Not owned by us.
+    const Collection* _collection;
+
+    // Not owned by us.
+    const MatchExpression* _filter;
+
+    // Evaluates the filter over a whole slice at once, if it can.
+    std::unique_ptr<BatchMatcher> _batchMatcher;
+
+    const size_t _numWorkers;
+
+    // Documents read from the child that the filter has not been applied to yet, and their size.
+    std::vector<WorkingSetID> _batch;
+    size_t _batchBytes = 0;
+
+    // Whether each document of '_batch' matched. A std::vector<bool> would let workers writing
+    // neighbouring elements race.
+    std::vector<char> _passes;
+
+    // Matching documents waiting to be returned, and the position of the next one.
+    std::vector<WorkingSetID> _output;
+    size_t _outputPos = 0;
+
+    bool _childEOF = false;
+
+    ExchangeStats _specificStats;
+};
+
+}  // namespace mongo
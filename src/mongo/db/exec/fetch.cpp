@@ -193,6 +193,14 @@ void FetchStage::doInvalidate(OperationContext* txn, const RecordId& dl, Invalid
     }
 }
 
+bool FetchStage::doMayHoldRecordId(const RecordId& dl) const {
+    if (WorkingSet::INVALID_ID == _idRetrying) {
+        return false;
+    }
+    const WorkingSetMember* member = _ws->get(_idRetrying);
+    return member->hasLoc() && member->loc == dl;
+}
+
 PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
                                                   WorkingSetID memberID,
                                                   WorkingSetID* out) {
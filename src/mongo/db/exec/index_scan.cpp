@@ -275,6 +275,10 @@ void IndexScan::doInvalidate(OperationContext* txn, const RecordId& dl, Invalida
     }
 }
 
+bool IndexScan::doMayHoldRecordId(const RecordId& dl) const {
+    return _returned.count(dl) > 0;
+}
+
 std::unique_ptr<PlanStageStats> IndexScan::getStats() {
     // WARNING: this could be called even if the collection was dropped.  Do not access any
     // catalog information here.
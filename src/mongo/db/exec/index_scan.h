@@ -102,6 +102,7 @@ public:
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
     void doInvalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) final;
+    bool doMayHoldRecordId(const RecordId& dl) const final;
 
     StageType stageType() const final {
         return STAGE_IXSCAN;
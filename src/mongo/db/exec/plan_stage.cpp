@@ -61,6 +61,19 @@ void PlanStage::invalidate(OperationContext* txn, const RecordId& dl, Invalidati
     doInvalidate(txn, dl, type);
 }
 
+bool PlanStage::mayHoldRecordId(const RecordId& dl) const {
+    if (doMayHoldRecordId(dl)) {
+        return true;
+    }
+
+    for (auto&& child : _children) {
+        if (child->mayHoldRecordId(dl)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void PlanStage::detachFromOperationContext() {
     invariant(_opCtx);
     _opCtx = nullptr;
@@ -260,6 +260,15 @@ public:
      */
     void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
 
+    /**
+     * Returns false if invalidating 'dl' would change nothing in this stage or its children, so
+     * the caller may skip invalidate(). Stages which don't override doMayHoldRecordId() are
+     * assumed to hold every RecordId.
+     *
+     * Has the same calling restrictions as invalidate().
+     */
+    bool mayHoldRecordId(const RecordId& dl) const;
+
     /**
      * Retrieve a list of this stage's children. This stage keeps ownership of
      * its children.
@@ -352,6 +361,13 @@ protected:
      */
     virtual void doInvalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) {}
 
+    /**
+     * Returns whether the stage itself, not counting its children, may hold 'dl'.
+     */
+    virtual bool doMayHoldRecordId(const RecordId& dl) const {
+        return true;
+    }
+
     OperationContext* getOpCtx() const {
         return _opCtx;
     }
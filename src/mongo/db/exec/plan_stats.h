@@ -312,6 +312,32 @@ struct EnsureSortedStats : public SpecificStats {
     long long nDropped;
 };
 
+struct ExchangeWorkerStats {
+    ExchangeWorkerStats() : docsTested(0), docsPassed(0), executionTimeMicros(0) {}
+
+    // Documents this worker applied the filter to, and how many of them matched.
+    long long docsTested;
+    long long docsPassed;
+
+    // Time this worker spent evaluating the filter.
+    long long executionTimeMicros;
+};
+
+struct ExchangeStats : public SpecificStats {
+    ExchangeStats() : batches(0) {}
+
+    SpecificStats* clone() const final {
+        ExchangeStats* specific = new ExchangeStats(*this);
+        return specific;
+    }
+
+    // The number of batches of documents handed out to the workers.
+    long long batches;
+
+    // One entry per worker. Worker 0 is the thread running the plan.
+    std::vector<ExchangeWorkerStats> workers;
+};
+
 struct FetchStats : public SpecificStats {
     FetchStats() : alreadyHasObj(0), forcedFetches(0), docsExamined(0) {}
 
@@ -85,6 +85,11 @@ public:
     bool isEOF() final;
     StageState work(WorkingSetID* out) final;
 
+    // Holds no RecordIds between calls to work().
+    bool doMayHoldRecordId(const RecordId& dl) const final {
+        return false;
+    }
+
     StageType stageType() const final {
         return STAGE_PROJECTION;
     }
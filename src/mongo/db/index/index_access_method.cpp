@@ -32,6 +32,7 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
 #include <vector>
 #include <utility>
 
@@ -57,6 +58,11 @@ using std::vector;
 
 MONGO_EXPORT_SERVER_PARAMETER(failIndexKeyTooLong, bool, true);
 
+// Number of threads each bulk builder may use to sort and write runs while keys are still being
+// added. With 0, runs are spilled on the index build thread. Spilling in the background splits
+// the memory limit between the runs in flight, so it trades more, smaller runs for overlap.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildSorterSpillThreads, int, 0);
+
 //
 // Comparison for external sorter interface
 //
@@ -88,12 +94,65 @@ private:
     const int _version;
 };
 
+/**
+ * Compares v1 keys encoded as KeyStrings, which sort in the woCompare() order of the keys. Only
+ * used for storage engines whose bulk builders take KeyStrings, none of which has v0 indexes.
+ */
+class KeyStringExternalSortComparison {
+public:
+    typedef std::pair<KeyString::Value, RecordId> Data;
+
+    int operator()(const Data& l, const Data& r) const {
+        int x = l.first.compare(r.first);
+        if (x) {
+            return x;
+        }
+        return l.second.compare(r.second);
+    }
+};
+
+namespace {
+
+/**
+ * Finishes 'sorter' and the sorters merged into it and returns an iterator over all their keys.
+ */
+template <typename SorterType, typename Comparator>
+typename SorterType::Iterator* doneSorting(SorterType* sorter,
+                                           const std::vector<std::unique_ptr<SorterType>>& merged,
+                                           const Comparator& comparator) {
+    if (merged.empty()) {
+        return sorter->done();
+    }
+
+    std::vector<std::shared_ptr<typename SorterType::Iterator>> iters;
+    iters.emplace_back(sorter->done());
+    for (auto&& other : merged) {
+        iters.emplace_back(other->done());
+    }
+    return SorterType::Iterator::merge(iters, SortOptions(), comparator);
+}
+
+template <typename SorterType>
+void addSpilledBytes(const SorterType& sorter,
+                     const std::vector<std::unique_ptr<SorterType>>& merged,
+                     long long* spilledBytes,
+                     long long* spilledUncompressedBytes) {
+    *spilledBytes += sorter.spilledBytes();
+    *spilledUncompressedBytes += sorter.spilledUncompressedBytes();
+    for (auto&& other : merged) {
+        *spilledBytes += other->spilledBytes();
+        *spilledUncompressedBytes += other->spilledUncompressedBytes();
+    }
+}
+
+}  // namespace
+
 IndexAccessMethod::IndexAccessMethod(IndexCatalogEntry* btreeState, SortedDataInterface* btree)
     : _btreeState(btreeState), _descriptor(btreeState->descriptor()), _newInterface(btree) {
     verify(0 == _descriptor->version() || 1 == _descriptor->version());
 }
 
-bool IndexAccessMethod::ignoreKeyTooLong(OperationContext* txn) {
+bool IndexAccessMethod::ignoreKeyTooLong(OperationContext* txn) const {
     // Ignore this error if we're on a secondary or if the user requested it
     return !txn->isPrimaryFor(_btreeState->ns()) || !failIndexKeyTooLong;
 }
@@ -347,13 +406,24 @@ std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk(
 IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
                                             const IndexDescriptor* descriptor,
                                             size_t maxMemoryUsageBytes)
-    : _sorter(Sorter::make(
-          SortOptions()
-              .TempDir(storageGlobalParams.dbpath + "/_tmp")
-              .ExtSortAllowed()
-              .MaxMemoryUsageBytes(maxMemoryUsageBytes),
-          BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version()))),
-      _real(index) {}
+    : _real(index), _ordering(Ordering::make(descriptor->keyPattern())) {
+    const SortOptions options =
+        SortOptions()
+            .TempDir(storageGlobalParams.dbpath + "/_tmp")
+            .ExtSortAllowed()
+            .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+            .SpillThreads(std::max(0, internalIndexBuildSorterSpillThreads.load()));
+
+    if (index->_newInterface->bulkBuildsFromKeyStrings()) {
+        invariant(descriptor->version() == 1);
+        _keyStringSorter.reset(
+            KeyStringSorter::make(options, KeyStringExternalSortComparison()));
+    } else {
+        _bsonSorter.reset(BSONSorter::make(
+            options,
+            BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version())));
+    }
+}
 
 Status IndexAccessMethod::BulkBuilder::insert(OperationContext* txn,
                                               const BSONObj& obj,
@@ -366,17 +436,55 @@ Status IndexAccessMethod::BulkBuilder::insert(OperationContext* txn,
     _isMultiKey = _isMultiKey || (keys.size() > 1);
 
     for (BSONObjSet::iterator it = keys.begin(); it != keys.end(); ++it) {
-        _sorter->add(*it, loc);
+        if (_keyStringSorter) {
+            // The index's bulk builder only sees the KeyStrings, so key sizes are checked here.
+            Status status = _real->_newInterface->checkKeySizeForBulkBuild(*it);
+            if (!status.isOK()) {
+                if (status.code() != ErrorCodes::KeyTooLong) {
+                    return status;
+                }
+                if (_keyTooLongStatus.isOK()) {
+                    _keyTooLongStatus = status;
+                }
+                continue;
+            }
+
+            _keyStringSorter->add(KeyString::Value(KeyString(*it, _ordering)), loc);
+        } else {
+            _bsonSorter->add(*it, loc);
+        }
         _keysInserted++;
-    }
 
-    if (NULL != numInserted) {
-        *numInserted += keys.size();
+        if (NULL != numInserted) {
+            ++*numInserted;
+        }
     }
 
     return Status::OK();
 }
 
+void IndexAccessMethod::BulkBuilder::merge(std::unique_ptr<BulkBuilder> other) {
+    invariant(other->_real == _real);
+
+    if (_keyStringSorter) {
+        _mergedKeyStringSorters.push_back(std::move(other->_keyStringSorter));
+        _mergedKeyStringSorters.insert(
+            _mergedKeyStringSorters.end(),
+            std::make_move_iterator(other->_mergedKeyStringSorters.begin()),
+            std::make_move_iterator(other->_mergedKeyStringSorters.end()));
+    } else {
+        _mergedBSONSorters.push_back(std::move(other->_bsonSorter));
+        _mergedBSONSorters.insert(_mergedBSONSorters.end(),
+                                  std::make_move_iterator(other->_mergedBSONSorters.begin()),
+                                  std::make_move_iterator(other->_mergedBSONSorters.end()));
+    }
+    _keysInserted += other->_keysInserted;
+    _isMultiKey = _isMultiKey || other->_isMultiKey;
+    if (_keyTooLongStatus.isOK()) {
+        _keyTooLongStatus = other->_keyTooLongStatus;
+    }
+}
+
 
 Status IndexAccessMethod::commitBulk(OperationContext* txn,
                                      std::unique_ptr<BulkBuilder> bulk,
@@ -385,9 +493,36 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
                                      set<RecordId>* dupsToDrop) {
     Timer timer;
 
-    std::unique_ptr<BulkBuilder::Sorter::Iterator> i(bulk->_sorter->done());
+    // Overlong keys were left out of the sort. Is that OK?
+    if (!bulk->_keyTooLongStatus.isOK() && !ignoreKeyTooLong(txn)) {
+        return bulk->_keyTooLongStatus;
+    }
+
+    std::unique_ptr<BulkBuilder::KeyStringSorter::Iterator> keyStrings;
+    std::unique_ptr<BulkBuilder::BSONSorter::Iterator> bsonKeys;
+    long long spilledBytes = 0;
+    long long spilledUncompressedBytes = 0;
+    if (bulk->_keyStringSorter) {
+        keyStrings.reset(doneSorting(bulk->_keyStringSorter.get(),
+                                     bulk->_mergedKeyStringSorters,
+                                     KeyStringExternalSortComparison()));
+        addSpilledBytes(*bulk->_keyStringSorter,
+                        bulk->_mergedKeyStringSorters,
+                        &spilledBytes,
+                        &spilledUncompressedBytes);
+    } else {
+        bsonKeys.reset(doneSorting(
+            bulk->_bsonSorter.get(),
+            bulk->_mergedBSONSorters,
+            BtreeExternalSortComparison(_descriptor->keyPattern(), _descriptor->version())));
+        addSpilledBytes(*bulk->_bsonSorter,
+                        bulk->_mergedBSONSorters,
+                        &spilledBytes,
+                        &spilledUncompressedBytes);
+    }
 
     stdx::unique_lock<Client> lk(*txn->getClient());
+    CurOp::get(txn)->debug().addSpilledBytes(spilledBytes, spilledUncompressedBytes);
     ProgressMeterHolder pm(*txn->setMessage_inlock("Index Bulk Build: (2/3) btree bottom up",
                                                    "Index: (2/3) BTree Bottom Up Progress",
                                                    bulk->_keysInserted,
@@ -408,7 +543,7 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
     }
     MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn, "setting index multikey flag", "");
 
-    while (i->more()) {
+    while (keyStrings ? keyStrings->more() : bsonKeys->more()) {
         if (mayInterrupt) {
             txn->checkForInterrupt();
         }
@@ -421,8 +556,17 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
         txn->recoveryUnit()->setRollbackWritesDisabled();
 
         // Get the next datum and add it to the builder.
-        BulkBuilder::Sorter::Data d = i->next();
-        Status status = builder->addKey(d.first, d.second);
+        RecordId loc;
+        Status status = Status::OK();
+        if (keyStrings) {
+            BulkBuilder::KeyStringSorter::Data d = keyStrings->next();
+            loc = d.second;
+            status = builder->addKeyString(d.first, d.second);
+        } else {
+            BulkBuilder::BSONSorter::Data d = bsonKeys->next();
+            loc = d.second;
+            status = builder->addKey(d.first, d.second);
+        }
 
         if (!status.isOK()) {
             // Overlong key that's OK to skip?
@@ -435,7 +579,7 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
                 invariant(!dupsAllowed);  // shouldn't be getting DupKey errors if dupsAllowed.
 
                 if (dupsToDrop) {
-                    dupsToDrop->insert(d.second);
+                    dupsToDrop->insert(loc);
                     continue;
                 }
             }
@@ -467,3 +611,6 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
 
 #include "mongo/db/sorter/sorter.cpp"
 MONGO_CREATE_SORTER(mongo::BSONObj, mongo::RecordId, mongo::BtreeExternalSortComparison);
+MONGO_CREATE_SORTER(mongo::KeyString::Value,
+                    mongo::RecordId,
+                    mongo::KeyStringExternalSortComparison);
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -36,6 +37,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/sorter/sorter.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/db/storage/sorted_data_interface.h"
 
 namespace mongo {
@@ -190,6 +192,9 @@ public:
     public:
         /**
          * Insert into the BulkBuilder as-if inserting into an IndexAccessMethod.
+         *
+         * Keys that are too long are left out. commitBulk() then fails unless that error is
+         * ignored, so 'txn' isn't used and may be null.
          */
         Status insert(OperationContext* txn,
                       const BSONObj& obj,
@@ -197,19 +202,37 @@ public:
                       const InsertDeleteOptions& options,
                       int64_t* numInserted);
 
+        /**
+         * Takes over the keys inserted into 'other', which must be a BulkBuilder for the same
+         * index. They are merged with the keys inserted into this BulkBuilder by commitBulk().
+         */
+        void merge(std::unique_ptr<BulkBuilder> other);
+
     private:
         friend class IndexAccessMethod;
 
-        using Sorter = mongo::Sorter<BSONObj, RecordId>;
+        // Keys are sorted as KeyStrings if the index's bulk builder takes them that way, so most
+        // comparisons are a memcmp of their encodings. Otherwise they are sorted as BSON.
+        using KeyStringSorter = mongo::Sorter<KeyString::Value, RecordId>;
+        using BSONSorter = mongo::Sorter<BSONObj, RecordId>;
 
         BulkBuilder(const IndexAccessMethod* index,
                     const IndexDescriptor* descriptor,
                     size_t maxMemoryUsageBytes);
 
-        std::unique_ptr<Sorter> _sorter;
+        // Exactly one of _keyStringSorter and _bsonSorter is set.
+        std::unique_ptr<KeyStringSorter> _keyStringSorter;
+        std::vector<std::unique_ptr<KeyStringSorter>> _mergedKeyStringSorters;
+        std::unique_ptr<BSONSorter> _bsonSorter;
+        std::vector<std::unique_ptr<BSONSorter>> _mergedBSONSorters;
         const IndexAccessMethod* _real;
+        const Ordering _ordering;
         int64_t _keysInserted = 0;
         bool _isMultiKey = false;
+
+        // The first key that was too long and left out, if any. Whether that fails the build
+        // depends on the OperationContext, which insert() may not have, so commitBulk() decides.
+        Status _keyTooLongStatus = Status::OK();
     };
 
     /**
@@ -257,7 +280,7 @@ public:
 
 protected:
     // Determines whether it's OK to ignore ErrorCodes::KeyTooLong for this OperationContext
-    bool ignoreKeyTooLong(OperationContext* txn);
+    bool ignoreKeyTooLong(OperationContext* txn) const;
 
     IndexCatalogEntry* _btreeState;  // owned by IndexCatalogEntry
     const IndexDescriptor* _descriptor;
@@ -0,0 +1,248 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/batch_matcher.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+// Longs of a larger magnitude may not convert to a double exactly.
+const long long kMaxExactLong = 1LL << 53;
+
+// A column bit is kept per field in a 64-bit mask.
+const size_t kMaxColumns = 64;
+
+// How comparisons to a number treat the value of a field.
+enum ValueKind : char {
+    // The value is a number, read into the column.
+    kNumber,
+    // The value is missing or not a number, so no comparison to a number matches it.
+    kNoMatch,
+    // The value must be compared by the MatchExpression itself.
+    kUnknown,
+};
+
+ValueKind readNumber(const BSONElement& elt, double* out) {
+    switch (elt.type()) {
+        case NumberInt:
+            *out = elt._numberInt();
+            return kNumber;
+        case NumberLong: {
+            const long long value = elt._numberLong();
+            if (value > kMaxExactLong || value < -kMaxExactLong) {
+                return kUnknown;
+            }
+            *out = static_cast<double>(value);
+            return kNumber;
+        }
+        case NumberDouble: {
+            const double value = elt._numberDouble();
+            if (std::isnan(value)) {
+                return kUnknown;
+            }
+            *out = value;
+            return kNumber;
+        }
+        case NumberDecimal:
+        case Array:
+            return kUnknown;
+        default:
+            return kNoMatch;
+    }
+}
+
+/**
+ * Returns true if 'expression' compares a top-level field to a number that a double holds
+ * exactly, storing the number in 'value'.
+ */
+bool isColumnComparison(const MatchExpression* expression, double* value) {
+    switch (expression->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+            break;
+        default:
+            return false;
+    }
+
+    const StringData path = expression->path();
+    if (path.empty() || path.find('.') != std::string::npos) {
+        return false;
+    }
+
+    const BSONElement& rhs = static_cast<const ComparisonMatchExpression*>(expression)->getData();
+    return kNumber == readNumber(rhs, value);
+}
+
+template <typename Compare>
+void compareColumn(const double* values,
+                   const char* kinds,
+                   size_t count,
+                   Compare compare,
+                   char* passes) {
+    for (size_t i = 0; i < count; ++i) {
+        passes[i] &= (kinds[i] == kNumber) & compare(values[i]);
+    }
+}
+}  // namespace
+
+// static
+std::unique_ptr<BatchMatcher> BatchMatcher::make(const MatchExpression* expression) {
+    if (!expression) {
+        return nullptr;
+    }
+
+    std::unique_ptr<BatchMatcher> matcher(new BatchMatcher(expression));
+    if (matcher->_comparisons.empty()) {
+        return nullptr;
+    }
+    return matcher;
+}
+
+BatchMatcher::BatchMatcher(const MatchExpression* expression) : _expression(expression) {
+    std::vector<const MatchExpression*> conjuncts;
+    if (MatchExpression::AND == expression->matchType()) {
+        for (size_t i = 0; i < expression->numChildren(); ++i) {
+            conjuncts.push_back(expression->getChild(i));
+        }
+    } else {
+        conjuncts.push_back(expression);
+    }
+
+    for (const MatchExpression* conjunct : conjuncts) {
+        double value;
+        if (!isColumnComparison(conjunct, &value)) {
+            _residual.push_back(conjunct);
+            continue;
+        }
+
+        const StringData path = conjunct->path();
+        auto column = std::find(_columns.begin(), _columns.end(), path);
+        if (column == _columns.end()) {
+            if (_columns.size() == kMaxColumns) {
+                _residual.push_back(conjunct);
+                continue;
+            }
+            column = _columns.insert(_columns.end(), path.toString());
+        }
+        _comparisons.push_back({static_cast<size_t>(column - _columns.begin()),
+                                conjunct->matchType(),
+                                value});
+    }
+}
+
+void BatchMatcher::matches(const BSONObj* docs, size_t count, char* passes) const {
+    const size_t numColumns = _columns.size();
+    std::vector<double> values(numColumns * count);
+    std::vector<char> kinds(numColumns * count, kNoMatch);
+    std::vector<char> unknown(count, false);
+
+    // Read the fields of each document into the columns. As with matchesBSON(), only the first
+    // occurrence of a field counts.
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t seen = 0;
+        size_t numSeen = 0;
+        BSONObjIterator it(docs[i]);
+        while (numSeen < numColumns && it.more()) {
+            const BSONElement elt = it.next();
+            const StringData fieldName = elt.fieldNameStringData();
+            for (size_t c = 0; c < numColumns; ++c) {
+                const uint64_t bit = uint64_t(1) << c;
+                if (!(seen & bit) && fieldName == _columns[c]) {
+                    seen |= bit;
+                    ++numSeen;
+                    const size_t pos = c * count + i;
+                    kinds[pos] = readNumber(elt, &values[pos]);
+                    if (kUnknown == kinds[pos]) {
+                        unknown[i] = true;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Evaluate the comparisons a column at a time.
+    std::fill(passes, passes + count, 1);
+    for (auto&& comparison : _comparisons) {
+        const double* columnValues = &values[comparison.column * count];
+        const char* columnKinds = &kinds[comparison.column * count];
+        const double rhs = comparison.value;
+
+        switch (comparison.matchType) {
+            case MatchExpression::EQ:
+                compareColumn(
+                    columnValues, columnKinds, count, [rhs](double v) { return v == rhs; }, passes);
+                break;
+            case MatchExpression::LT:
+                compareColumn(
+                    columnValues, columnKinds, count, [rhs](double v) { return v < rhs; }, passes);
+                break;
+            case MatchExpression::LTE:
+                compareColumn(
+                    columnValues, columnKinds, count, [rhs](double v) { return v <= rhs; }, passes);
+                break;
+            case MatchExpression::GT:
+                compareColumn(
+                    columnValues, columnKinds, count, [rhs](double v) { return v > rhs; }, passes);
+                break;
+            case MatchExpression::GTE:
+                compareColumn(
+                    columnValues, columnKinds, count, [rhs](double v) { return v >= rhs; }, passes);
+                break;
+            default:
+                MONGO_UNREACHABLE;
+        }
+    }
+
+    // Finish off the documents the columns could not decide.
+    for (size_t i = 0; i < count; ++i) {
+        if (unknown[i]) {
+            passes[i] = _expression->matchesBSON(docs[i]);
+        } else if (passes[i]) {
+            for (const MatchExpression* residual : _residual) {
+                if (!residual->matchesBSON(docs[i])) {
+                    passes[i] = false;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+}  // namespace mongo
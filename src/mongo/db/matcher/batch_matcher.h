@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+/**
+ * Evaluates a MatchExpression over a block of documents at a time.
+ *
+ * The comparisons of the expression ($eq, $lt, $lte, $gt and $gte) between a top-level field and
+ * a number are evaluated column by column: the fields are first read out of every document of the
+ * block into arrays of doubles, and each comparison is then a loop over one of these arrays.
+ * Documents that pass them are tested against the rest of the expression with matchesBSON().
+ *
+ * A document whose field can't be compared as a double, such as an array, NaN or a long too large
+ * to convert exactly, is tested against the whole expression with matchesBSON() instead.
+ */
+class BatchMatcher {
+    MONGO_DISALLOW_COPYING(BatchMatcher);
+
+public:
+    /**
+     * Returns a matcher for 'expression', which must outlive it, or nullptr if 'expression' is not
+     * a comparison or a conjunction holding at least one comparison that can be evaluated by
+     * column.
+     */
+    static std::unique_ptr<BatchMatcher> make(const MatchExpression* expression);
+
+    /**
+     * Sets 'passes[i]' to whether 'docs[i]' matches the expression, for each of the 'count'
+     * documents. Safe to call concurrently.
+     */
+    void matches(const BSONObj* docs, size_t count, char* passes) const;
+
+private:
+    // A comparison between the field of a column and a number.
+    struct Comparison {
+        size_t column;
+        MatchExpression::MatchType matchType;
+        double value;
+    };
+
+    explicit BatchMatcher(const MatchExpression* expression);
+
+    const MatchExpression* const _expression;
+
+    // The names of the fields read into columns.
+    std::vector<std::string> _columns;
+
+    std::vector<Comparison> _comparisons;
+
+    // The parts of the conjunction that are not evaluated by column.
+    std::vector<const MatchExpression*> _residual;
+};
+
+}  // namespace mongo
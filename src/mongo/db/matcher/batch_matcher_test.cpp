@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/batch_matcher.h"
+
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using std::unique_ptr;
+
+unique_ptr<MatchExpression> parse(const BSONObj& query) {
+    StatusWithMatchExpression result = MatchExpressionParser::parse(query);
+    ASSERT_OK(result.getStatus());
+    return std::move(result.getValue());
+}
+
+/**
+ * Documents whose fields exercise the cases a column can't decide on its own.
+ */
+std::vector<BSONObj> makeDocs() {
+    std::vector<BSONObj> docs;
+    for (int i = -5; i <= 5; i++) {
+        docs.push_back(BSON("a" << i << "b" << i * 1.5));
+        docs.push_back(BSON("a" << static_cast<long long>(i) << "b" << i % 3));
+        docs.push_back(BSON("b" << i << "a" << i / 2.0 << "c"
+                                << "str"));
+    }
+    docs.push_back(BSONObj());
+    docs.push_back(BSON("a" << BSONNULL << "b" << 1));
+    docs.push_back(BSON("a"
+                        << "3"
+                        << "b" << 2));
+    docs.push_back(BSON("a" << BSON_ARRAY(1 << 4) << "b" << 2));
+    docs.push_back(BSON("a" << BSON_ARRAY(BSON_ARRAY(3)) << "b" << 2));
+    docs.push_back(BSON("a" << BSON("x" << 3) << "b" << 2));
+    docs.push_back(BSON("a" << std::numeric_limits<double>::quiet_NaN() << "b" << 2));
+    docs.push_back(BSON("a" << std::numeric_limits<double>::infinity() << "b" << 2));
+    docs.push_back(BSON("a" << ((1LL << 53) + 1) << "b" << 2));
+    docs.push_back(BSON("a" << -(1LL << 60) << "b" << 2));
+    docs.push_back(BSON("a" << 3 << "a" << 100 << "b" << 2));
+    docs.push_back(BSON("a" << MINKEY << "b" << MAXKEY));
+    docs.push_back(BSON("a" << Decimal128("3") << "b" << 2));
+    docs.push_back(BSON("a" << -0.0 << "b" << 0));
+    return docs;
+}
+
+/**
+ * Checks that the batch matcher of 'query' agrees with matchesBSON() on every document.
+ */
+void assertMatchesLikeMatchExpression(const BSONObj& query) {
+    unique_ptr<MatchExpression> expression = parse(query);
+    unique_ptr<BatchMatcher> matcher = BatchMatcher::make(expression.get());
+    ASSERT(matcher) << query;
+
+    const std::vector<BSONObj> docs = makeDocs();
+    std::vector<char> passes(docs.size(), -1);
+    matcher->matches(docs.data(), docs.size(), passes.data());
+
+    for (size_t i = 0; i < docs.size(); i++) {
+        ASSERT_EQUALS(expression->matchesBSON(docs[i]), static_cast<bool>(passes[i]))
+            << query << " on " << docs[i];
+    }
+}
+
+TEST(BatchMatcherTest, SingleComparisons) {
+    assertMatchesLikeMatchExpression(fromjson("{a: 3}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: {$lt: 3}}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: {$lte: 3}}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: {$gt: 1.5}}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: {$gte: -2}}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: 0}"));
+    assertMatchesLikeMatchExpression(BSON("a" << BSON("$gte" << 2LL)));
+    assertMatchesLikeMatchExpression(
+        BSON("a" << BSON("$lt" << std::numeric_limits<double>::infinity())));
+}
+
+TEST(BatchMatcherTest, Conjunctions) {
+    assertMatchesLikeMatchExpression(fromjson("{a: {$gt: -3, $lt: 3}}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: {$gte: 0}, b: {$lte: 1}}"));
+    assertMatchesLikeMatchExpression(fromjson("{$and: [{a: {$gt: -1}}, {b: 2}]}"));
+}
+
+TEST(BatchMatcherTest, ConjunctionsWithResidualPredicates) {
+    assertMatchesLikeMatchExpression(fromjson("{a: {$gt: 0}, c: 'str'}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: {$gte: 0}, b: {$exists: true}}"));
+    assertMatchesLikeMatchExpression(fromjson("{a: {$lt: 4}, $or: [{b: 2}, {c: {$exists: 1}}]}"));
+    assertMatchesLikeMatchExpression(fromjson("{b: {$lte: 2}, 'a.x': 3}"));
+    assertMatchesLikeMatchExpression(fromjson("{b: 2, a: {$in: [1, 3]}}"));
+}
+
+TEST(BatchMatcherTest, NothingToEvaluateByColumn) {
+    const BSONObj queries[] = {fromjson("{}"),
+                               fromjson("{a: 'str'}"),
+                               fromjson("{'a.x': 3}"),
+                               fromjson("{a: {$in: [1, 2]}}"),
+                               fromjson("{$or: [{a: 1}, {b: 2}]}"),
+                               fromjson("{a: {$not: {$lt: 3}}}"),
+                               BSON("a" << std::numeric_limits<double>::quiet_NaN()),
+                               BSON("a" << ((1LL << 53) + 1))};
+    for (auto&& query : queries) {
+        unique_ptr<MatchExpression> expression = parse(query);
+        ASSERT_FALSE(BatchMatcher::make(expression.get())) << query;
+    }
+}
+
+}  // namespace
+}  // namespace mongo
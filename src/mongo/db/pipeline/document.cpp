@@ -42,11 +42,20 @@ using boost::intrusive_ptr;
 using std::string;
 using std::vector;
 
-Position DocumentStorage::findField(StringData requested) const {
+Position DocumentStorage::findField(StringData requested, unsigned hash) const {
+    const Position pos = findLoadedField(requested, hash);
+    if (pos.found() || !_bsonNext)
+        return pos;
+
+    // Loading fields doesn't change what the document holds, so it is allowed on a const one.
+    return const_cast<DocumentStorage*>(this)->loadFieldsUntil(requested);
+}
+
+Position DocumentStorage::findLoadedField(StringData requested, unsigned hash) const {
     int reqSize = requested.size();  // get size calculation out of the way if needed
 
     if (_numFields >= HASH_TAB_MIN) {  // hash lookup
-        const unsigned bucket = bucketForKey(requested);
+        const unsigned bucket = bucketForHash(hash);
 
         Position pos = _hashTab[bucket];
         while (pos.found()) {
@@ -59,7 +68,7 @@ Position DocumentStorage::findField(StringData requested) const {
             pos = elem.nextCollision;
         }
     } else {  // linear scan
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance()) {
             if (it->nameLen == reqSize && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
                 return it.position();
             }
@@ -70,7 +79,7 @@ Position DocumentStorage::findField(StringData requested) const {
     return Position();
 }
 
-Value& DocumentStorage::appendField(StringData name) {
+Value& DocumentStorage::appendField(StringData name, unsigned hash) {
     Position pos = getNextPosition();
     const int nameSize = name.size();
 
@@ -102,7 +111,7 @@ Value& DocumentStorage::appendField(StringData name) {
     _numFields++;
 
     if (_numFields > HASH_TAB_MIN) {
-        addFieldToHashTable(pos);
+        addFieldToHashTable(pos, hash);
     } else if (_numFields == HASH_TAB_MIN) {
         // adds all fields to hash table (including the one we just added)
         rehash();
@@ -111,12 +120,91 @@ Value& DocumentStorage::appendField(StringData name) {
     return getField(pos).val;
 }
 
+Position DocumentStorage::loadFieldsUntil(StringData name) {
+    // Find the field before loading any, so that looking up a missing field loads nothing.
+    const char* requested = _bsonNext;
+    while (requested != _bsonEnd) {
+        const BSONElement elem(requested);
+        if (elem.fieldNameStringData() == name)
+            break;
+        requested += elem.size();
+    }
+
+    if (requested == _bsonEnd)
+        return Position();
+
+    // Fields are loaded in order so that they get the same Positions as in a fully loaded document.
+    while (true) {
+        const bool isRequested = _bsonNext == requested;
+        const Position pos = loadNextField();
+        if (isRequested)
+            return pos;
+    }
+}
+
+Position DocumentStorage::loadNextField() {
+    const BSONElement elem(_bsonNext);
+    const StringData name = elem.fieldNameStringData();
+    const Position pos = getNextPosition();
+
+    Value val = lazyValue(elem, _bsonBuffer);
+    appendField(name, _numFields >= HASH_TAB_MIN ? HashedFieldName::hashKey(name) : 0) =
+        std::move(val);
+
+    _bsonNext += elem.size();
+    if (_bsonNext == _bsonEnd) {
+        // Nested documents that are still loading keep their own reference to the buffer.
+        _bsonBuffer = SharedBuffer();
+        _bsonSize = 0;
+        _bsonNext = NULL;
+        _bsonEnd = NULL;
+    }
+
+    return pos;
+}
+
+Value DocumentStorage::lazyValue(const BSONElement& elem, const SharedBuffer& buffer) {
+    switch (elem.type()) {
+        case Object: {
+            if (elem.embeddedObject().isEmpty())
+                return Value(Document());
+
+            intrusive_ptr<DocumentStorage> storage(new DocumentStorage());
+            storage->initLazy(elem.embeddedObject(), buffer);
+            return Value(Document(storage.get()));
+        }
+
+        case Array: {
+            vector<Value> values;
+            BSONForEach(sub, elem.embeddedObject()) {
+                values.push_back(lazyValue(sub, buffer));
+            }
+            return Value(std::move(values));
+        }
+
+        default:
+            return Value(elem);
+    }
+}
+
+void DocumentStorage::initLazy(const BSONObj& bson, const SharedBuffer& buffer) {
+    fassert(40503, !_buffer && !_bsonNext && buffer.get());
+
+    if (bson.isEmpty())
+        return;
+
+    _bsonBuffer = buffer;
+    _bsonSize = bson.objsize();
+    _bsonNext = bson.objdata() + sizeof(int);
+    _bsonEnd = bson.objdata() + bson.objsize() - 1;
+}
+
 // Call after adding field to _fields and increasing _numFields
-void DocumentStorage::addFieldToHashTable(Position pos) {
+void DocumentStorage::addFieldToHashTable(Position pos, unsigned hash) {
     ValueElement& elem = getField(pos);
     elem.nextCollision = Position();
 
-    const unsigned bucket = bucketForKey(elem.nameSD());
+    const unsigned bucket = bucketForHash(hash);
 
     Position* posPtr = &_hashTab[bucket];
     while (posPtr->found()) {
@@ -196,9 +284,13 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
     out->_metaFields = _metaFields;
     out->_textScore = _textScore;
     out->_randVal = _randVal;
+    out->_bsonBuffer = _bsonBuffer;
+    out->_bsonSize = _bsonSize;
+    out->_bsonNext = _bsonNext;
+    out->_bsonEnd = _bsonEnd;
 
     // Tell values that they have been memcpyed (updates ref counts)
-    for (DocumentStorageIterator it = out->iteratorAll(); !it.atEnd(); it.advance()) {
+    for (DocumentStorageIterator it = out->loadedIteratorAll(); !it.atEnd(); it.advance()) {
         it->val.memcpyed();
     }
 
@@ -208,7 +300,7 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
 DocumentStorage::~DocumentStorage() {
     std::unique_ptr<char[]> deleteBufferAtScopeEnd(_buffer);
 
-    for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+    for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance()) {
         it->val.~Value();  // explicit destructor call
     }
 }
@@ -258,6 +350,27 @@ BSONObj Document::toBsonWithMetaData() const {
 }
 
 Document Document::fromBsonWithMetaData(const BSONObj& bson) {
+    // The metadata must be known before any field is looked up, so only documents without any are
+    // loaded lazily. This only looks at the field names.
+    bool hasMetaData = false;
+    BSONForEach(elem, bson) {
+        const StringData fieldName = elem.fieldNameStringData();
+        if (fieldName == metaFieldTextScore || fieldName == metaFieldRandVal) {
+            hasMetaData = true;
+            break;
+        }
+    }
+
+    if (!hasMetaData) {
+        if (bson.isEmpty())
+            return Document();
+
+        const BSONObj owned = bson.getOwned();
+        intrusive_ptr<DocumentStorage> storage(new DocumentStorage());
+        storage->initLazy(owned, owned.sharedBuffer());
+        return Document(storage.get());
+    }
+
     MutableDocument md;
 
     BSONObjIterator it(bson);
@@ -353,7 +466,11 @@ size_t Document::getApproximateSize() const {
     size_t size = sizeof(DocumentStorage);
     size += storage().allocatedBytes();
 
-    for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+    // A lazily loaded document holds on to all of its BSON until every field is loaded, on top of
+    // the Values loaded from it so far.
+    size += storage().lazyBsonBytes();
+
+    for (DocumentStorageIterator it = storage().loadedIterator(); !it.atEnd(); it.advance()) {
         size += it->val.getApproximateSize();
         size -= sizeof(Value);  // already accounted for above
     }
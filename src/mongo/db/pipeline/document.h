@@ -62,6 +62,9 @@ class Position;
  *  pass and return by Value. Note that the data in a Document is
  *  immutable, but you can replace a Document instance with assignment.
  *
+ *  The thread-safety rules of Value apply, including the exception for
+ *  Documents that are still being loaded from BSON.
+ *
  *  See Also: Value class in Value.h
  */
 class Document {
@@ -94,6 +97,14 @@ public:
         return storage().getField(key);
     }
 
+    /// Like getField(StringData), but without hashing key again. See HashedFieldName.
+    const Value operator[](const HashedFieldName& key) const {
+        return getField(key);
+    }
+    const Value getField(const HashedFieldName& key) const {
+        return storage().getField(key);
+    }
+
     /// Look up a field by Position. See positionOf and getNestedField.
     const Value operator[](Position pos) const {
         return getField(pos);
@@ -178,6 +189,10 @@ public:
      * Like Document(BSONObj) but treats top-level fields with special names as metadata.
      * Special field names are available as static constants on this class with names starting
      * with metaField.
+     *
+     * Unless there is metadata, the fields are converted to Values only as they are looked up.
+     * The Document keeps an owned copy of bson for that, which is bson itself if already owned.
+     * Until every field is loaded, the Document and its copies must stay on one thread at a time.
      */
     static Document fromBsonWithMetaData(const BSONObj& bson);
 
@@ -190,6 +205,9 @@ public:
     Position positionOf(StringData fieldName) const {
         return storage().findField(fieldName);
     }
+    Position positionOf(const HashedFieldName& fieldName) const {
+        return storage().findField(fieldName);
+    }
 
     /** Clone a document.
      *
@@ -236,6 +254,7 @@ public:
     }
 
 private:
+    friend class DocumentStorage;
     friend class FieldIterator;
     friend class ValueStorage;
     friend class MutableDocument;
@@ -384,6 +403,9 @@ public:
     void addField(StringData fieldName, const Value& val) {
         storage().appendField(fieldName) = val;
     }
+    void addField(const HashedFieldName& fieldName, const Value& val) {
+        storage().appendField(fieldName) = val;
+    }
 
     /** Update field by key. If there is no field with that key, add one.
      *
@@ -34,6 +34,7 @@
 #include <bitset>
 
 #include "mongo/util/intrusive_counter.h"
+#include "mongo/util/shared_buffer.h"
 #include "mongo/db/pipeline/value.h"
 
 namespace mongo {
@@ -56,6 +57,11 @@ public:
         return !(*this == rhs);
     }
 
+    /// Fields added to a document later have greater Positions in it.
+    bool operator<(Position rhs) const {
+        return this->index < rhs.index;
+    }
+
     // For debugging and ASSERT_EQUALS in tests.
     template <typename OStream>
     friend OStream& operator<<(OStream& stream, Position p) {
@@ -69,6 +75,32 @@ private:
     friend class DocumentStorageIterator;
 };
 
+/** A field name together with its hash, for names that are looked up in or added to many
+ *  documents. Lookups through it don't hash the name again.
+ */
+class HashedFieldName {
+public:
+    explicit HashedFieldName(std::string name) : _name(std::move(name)), _hash(hashKey(_name)) {}
+
+    const std::string& name() const {
+        return _name;
+    }
+    unsigned hash() const {
+        return _hash;
+    }
+
+    static unsigned hashKey(StringData name) {
+        // TODO consider FNV-1a once we have a better benchmark corpus
+        unsigned out;
+        MurmurHash3_x86_32(name.rawData(), name.size(), 0, &out);
+        return out;
+    }
+
+private:
+    std::string _name;
+    unsigned _hash;
+};
+
 #pragma pack(1)
 /** This is how values are stored in the DocumentStorage buffer
  *  Internal class. Consumers shouldn't care about this.
@@ -179,7 +211,15 @@ private:
     bool _includeMissing;
 };
 
-/// Storage class used by both Document and MutableDocument
+/** Storage class used by both Document and MutableDocument
+ *
+ *  A DocumentStorage can also be loaded lazily from a BSON buffer (see initLazy). Its fields are
+ *  then converted to Values in BSON order, only as far as the fields looked up so far, so fields
+ *  always have the same Positions as if they had been loaded all at once. Iterating over the
+ *  fields or adding one loads all of them first. Loading changes the storage behind const
+ *  methods, so a Document that is still being loaded must not be read by several threads at once,
+ *  even through different copies. Nested documents have their own storage and BSON copy.
+ */
 class DocumentStorage : public RefCountable {
 public:
     // Note: default constructor should zero-init to support emptyDoc()
@@ -190,7 +230,10 @@ public:
           _numFields(0),
           _hashTabMask(0),
           _metaFields(),
-          _textScore(0) {}
+          _textScore(0),
+          _bsonSize(0),
+          _bsonNext(NULL),
+          _bsonEnd(NULL) {}
     ~DocumentStorage();
 
     enum MetaType : char {
@@ -219,7 +262,13 @@ public:
     }
 
     /// Returns the position of the named field (may be missing) or Position()
-    Position findField(StringData name) const;
+    Position findField(StringData name) const {
+        // Only documents with a hash table need the hash of the name.
+        return findField(name, _numFields >= HASH_TAB_MIN ? HashedFieldName::hashKey(name) : 0);
+    }
+    Position findField(const HashedFieldName& name) const {
+        return findField(name.name(), name.hash());
+    }
 
     // Document uses these
     const ValueElement& getField(Position pos) const {
@@ -232,6 +281,12 @@ public:
             return Value();
         return getField(pos).val;
     }
+    Value getField(const HashedFieldName& name) const {
+        Position pos = findField(name);
+        if (!pos.found())
+            return Value();
+        return getField(pos).val;
+    }
 
     // MutableDocument uses these
     ValueElement& getField(Position pos) {
@@ -246,23 +301,57 @@ public:
     }
 
     /// Adds a new field with missing Value at the end of the document
-    Value& appendField(StringData name);
+    Value& appendField(StringData name) {
+        loadLazyFields();
+        // Only fields added to an existing hash table need the hash of their name.
+        return appendField(name, _numFields >= HASH_TAB_MIN ? HashedFieldName::hashKey(name) : 0);
+    }
+    Value& appendField(const HashedFieldName& name) {
+        loadLazyFields();
+        return appendField(name.name(), name.hash());
+    }
 
     /** Preallocates space for fields. Use this to attempt to prevent buffer growth.
      *  This is only valid to call before anything is added to the document.
      */
     void reserveFields(size_t expectedFields);
 
+    /** Makes this document load the fields of bson as they are looked up, rather than now.
+     *  bson must lie within buffer, which the document keeps until every field is loaded. Nested
+     *  documents are loaded lazily from the same buffer.
+     *  This is only valid to call before anything is added to the document.
+     */
+    void initLazy(const BSONObj& bson, const SharedBuffer& buffer);
+
+    /// Loads all fields of a lazily loaded document that haven't been looked up yet.
+    void loadLazyFields() const {
+        if (MONGO_unlikely(_bsonNext != NULL))
+            const_cast<DocumentStorage*>(this)->loadAllFields();
+    }
+
+    /// Size of the BSON a lazily loaded document still loads from, 0 once every field is loaded.
+    /// A nested document shares, and so keeps alive, the buffer of the document it is in.
+    size_t lazyBsonBytes() const {
+        return _bsonSize;
+    }
+
     /// This skips missing values
     DocumentStorageIterator iterator() const {
+        loadLazyFields();
         return DocumentStorageIterator(_firstElement, end(), false);
     }
 
     /// This includes missing values
     DocumentStorageIterator iteratorAll() const {
+        loadLazyFields();
         return DocumentStorageIterator(_firstElement, end(), true);
     }
 
+    /// Like iterator(), but only over the fields loaded so far. Doesn't load any.
+    DocumentStorageIterator loadedIterator() const {
+        return DocumentStorageIterator(_firstElement, end(), false);
+    }
+
     /// Shallow copy of this. Caller owns memory.
     boost::intrusive_ptr<DocumentStorage> clone() const;
 
@@ -314,8 +403,42 @@ private:
     /// Allocates space in _buffer. Copies existing data if there is any.
     void alloc(unsigned newSize);
 
+    /// Only uses hash if the new field is added to the hash table
+    Value& appendField(StringData name, unsigned hash);
+
+    /// Only uses hash if the document has a hash table
+    Position findField(StringData name, unsigned hash) const;
+
+    /// Like findField, but only looks at the fields loaded so far.
+    Position findLoadedField(StringData name, unsigned hash) const;
+
+    /// Like iteratorAll(), but only over the fields loaded so far. Used while loading them.
+    DocumentStorageIterator loadedIteratorAll() const {
+        return DocumentStorageIterator(_firstElement, end(), true);
+    }
+
+    /** Loads fields of a lazily loaded document up to and including the first one called name.
+     *  Loads nothing and returns Position() if there is no such field.
+     */
+    Position loadFieldsUntil(StringData name);
+
+    /// Loads the next field of a lazily loaded document and returns its Position
+    Position loadNextField();
+
+    void loadAllFields() {
+        while (_bsonNext)
+            loadNextField();
+    }
+
+    /// Converts an element of a lazily loaded document. Embedded documents are loaded lazily too,
+    /// from buffer, which holds elem.
+    static Value lazyValue(const BSONElement& elem, const SharedBuffer& buffer);
+
     /// Call after adding field to _buffer and increasing _numFields
-    void addFieldToHashTable(Position pos);
+    void addFieldToHashTable(Position pos) {
+        addFieldToHashTable(pos, HashedFieldName::hashKey(getField(pos).nameSD()));
+    }
+    void addFieldToHashTable(Position pos, unsigned hash);
 
     // assumes _hashTabMask is (power of two) - 1
     unsigned hashTabBuckets() const {
@@ -335,21 +458,14 @@ private:
         memset(_hashTab, -1, hashTabBytes());
     }
 
-    static unsigned hashKey(StringData name) {
-        // TODO consider FNV-1a once we have a better benchmark corpus
-        unsigned out;
-        MurmurHash3_x86_32(name.rawData(), name.size(), 0, &out);
-        return out;
-    }
-
-    unsigned bucketForKey(StringData name) const {
-        return hashKey(name) & _hashTabMask;
+    unsigned bucketForHash(unsigned hash) const {
+        return hash & _hashTabMask;
     }
 
     /// Adds all fields to the hash table
     void rehash() {
         hashTabInit();
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance())
+        for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance())
             addFieldToHashTable(it.position());
     }
 
@@ -386,6 +502,13 @@ private:
     std::bitset<MetaType::NUM_FIELDS> _metaFields;
     double _textScore;
     double _randVal;
+
+    // Only set while the document is loaded lazily. _bsonNext is the next BSON element to load
+    // and _bsonEnd the EOO byte ending the BSON. Both are NULL once all fields are loaded.
+    SharedBuffer _bsonBuffer;
+    size_t _bsonSize;
+    const char* _bsonNext;
+    const char* _bsonEnd;
     // When adding a field, make sure to update clone() method
 };
 }
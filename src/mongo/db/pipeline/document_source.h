@@ -301,6 +301,23 @@ public:
         virtual CollectionIndexUsageMap getIndexStats(OperationContext* opCtx,
                                                       const NamespaceString& ns) = 0;
 
+        /**
+         * Returns whether 'ns' is sharded according to the cluster's metadata, which unlike
+         * isSharded() does not depend on this shard owning any of its chunks. False when this
+         * node is not part of a sharded cluster. Throws if mongos reported that the pipeline
+         * reads sharded collections but this node has no sharding state to target them with.
+         */
+        virtual bool isShardedInCluster(const NamespaceString& ns) = 0;
+
+        /**
+         * Runs 'query' on the shards owning the chunks of the sharded collection 'ns' that it
+         * targets, and returns all of the matching documents. Throws ExceededMemoryLimit if they
+         * take more than 'maxMemoryBytes'.
+         */
+        virtual std::vector<BSONObj> findSharded(const NamespaceString& ns,
+                                                 const BSONObj& query,
+                                                 size_t maxMemoryBytes) = 0;
+
         // Add new methods as needed.
     };
 
@@ -392,6 +409,18 @@ public:
     /// returns -1 for no limit
     long long getLimit() const;
 
+    /**
+     * Returns the next batch of results as index keys, swapping them into 'keys' and setting
+     * 'keyPattern' to the key pattern of their index. A PlanExecutor built with
+     * QueryPlannerParams::RETURN_INDEX_KEYS returns these instead of the documents of a covered
+     * projection. The keys have empty field names and hold the projected fields in key pattern
+     * order, along with any other fields of the index.
+     *
+     * Returns false if the next results are documents, or if the cursor is exhausted. The caller
+     * should then use getNext(). Interleaving both methods returns the results in order.
+     */
+    bool getNextIndexKeyBatch(std::vector<BSONObj>* keys, BSONObj* keyPattern);
+
 private:
     DocumentSourceCursor(const std::string& ns,
                          const std::shared_ptr<PlanExecutor>& exec,
@@ -399,8 +428,30 @@ private:
 
     void loadBatch();
 
+    /**
+     * Sets the key pattern of the index keys that follow, and which of its fields are projected.
+     */
+    void setIndexKeyPattern(const BSONObj& keyPattern);
+
+    /**
+     * Builds the document that the covered projection would have built from 'key'.
+     */
+    Document indexKeyToDocument(const BSONObj& key) const;
+
+    /**
+     * Moves the pending batch of index keys to '_currentBatch' as documents.
+     */
+    void flushIndexKeyBatch();
+
     std::deque<Document> _currentBatch;
 
+    // Results of a covered projection that have not been converted to documents yet. Keys are
+    // only pending while '_currentBatch' is empty. '_indexKeyFieldNames' holds the name of each
+    // projected field of '_indexKeyPattern', and is empty for the others.
+    std::vector<BSONObj> _indexKeyBatch;
+    BSONObj _indexKeyPattern;
+    std::vector<StringData> _indexKeyFieldNames;
+
     // BSONObj members must outlive _projection and cursor.
     BSONObj _query;
     BSONObj _sort;
@@ -466,6 +517,21 @@ public:
     boost::intrusive_ptr<DocumentSource> getShardSource() final;
     boost::intrusive_ptr<DocumentSource> getMergeSource() final;
 
+    /**
+     * Counters added to the operation's slow query log and profiler entry once all groups are
+     * output. Aggregate explain doesn't execute the pipeline, so it doesn't report them.
+     */
+    struct Stats {
+        long long groups = 0;                    // Groups returned.
+        long long spills = 0;                    // Times the groups map was written to disk.
+        long long spilledBytes = 0;              // Bytes written to disk.
+        long long spilledUncompressedBytes = 0;  // The same data before compression.
+    };
+
+    const Stats& getStats() const {
+        return _stats;
+    }
+
 private:
     explicit DocumentSourceGroup(const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
@@ -475,6 +541,30 @@ private:
     // Only used by spill. Would be function-local if that were legal in C++03.
     class SpillSTLComparator;
 
+    /**
+     * Spills the groups map into the on-disk partitions of a grace-hash spill, each group going to
+     * the partition its key hashes to. Unlike spill(), this needs no sort and never compares keys.
+     */
+    void spillToPartitions();
+
+    /**
+     * Aggregates the groups spilled to the next partition, which hold every group for the keys
+     * hashing to that partition, so its results can be output like those of an unspilled $group.
+     * Partitions still too large for memory are sorted and merged as if partitioning was off.
+     */
+    void aggregateNextPartition();
+
+    /**
+     * Prepares to output the aggregated groups, merging 'sortedFiles' if any were spilled.
+     */
+    void startOutput(std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> sortedFiles);
+
+    /**
+     * Called once the current groups are all output. Moves on to the next spilled partition, if
+     * any, and otherwise disposes of this source.
+     */
+    void doneWithGroups();
+
     /*
       Before returning anything, this source must fetch everything from
       the underlying source and group it.  populate() is used to do that
@@ -494,6 +584,12 @@ private:
      */
     Value computeId(Variables* vars);
 
+    /**
+     * Returns true if the group key and accumulator arguments can be read from the index keys
+     * returned by a DocumentSourceCursor in place of its documents.
+     */
+    bool canGroupIndexKeys() const;
+
     /**
      * Converts the internal representation of the group key to the _id shape specified by the
      * user.
@@ -524,10 +620,18 @@ private:
 
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
+    /**
+     * Returns the accumulator states of 'accums' to be spilled, or merges them back in.
+     */
+    Value serializeAccumulators(const Accumulators& accums) const;
+    void mergeAccumulators(const Value& states, Accumulators* accums) const;
+
     bool _doingMerge;
     bool _spilled;
     const bool _extSortAllowed;
     const int _maxMemoryUsageBytes;
+    const size_t _numSpillPartitions;  // Partitions of a grace-hash spill; at most 1 to sort.
+    Stats _stats;
     std::unique_ptr<Variables> _variables;
     std::vector<std::string> _idFieldNames;  // used when id is a document
     std::vector<boost::intrusive_ptr<Expression>> _idExpressions;
@@ -540,6 +644,11 @@ private:
     std::pair<Value, Value> _firstPartOfNextGroup;
     Value _currentId;
     Accumulators _currentAccumulators;
+
+    // only used by a grace-hash spill
+    std::vector<std::unique_ptr<SortedFileWriter<Value, Value>>> _partitionWriters;
+    std::vector<std::unique_ptr<Sorter<Value, Value>::Iterator>> _partitions;
+    size_t _nextPartition = 0;
 };
 
 /**
@@ -577,6 +686,7 @@ public:
     Value serialize(bool explain = false) const final;
     boost::intrusive_ptr<DocumentSource> optimize() final;
     void setSource(DocumentSource* Source) final;
+    GetDepsReturn getDependencies(DepsTracker* deps) const final;
 
     /**
       Create a filter.
@@ -785,6 +895,14 @@ public:
         return _raw;
     }
 
+    /**
+     * Returns whether the top-level field 'fieldName' of the output is the same as that of the
+     * input, including when the input doesn't have it.
+     */
+    bool passesThroughField(const std::string& fieldName) const {
+        return pEO->passesThroughField(fieldName);
+    }
+
 private:
     DocumentSourceProject(const boost::intrusive_ptr<ExpressionContext>& pExpCtx,
                           const boost::intrusive_ptr<ExpressionObject>& exprObj);
@@ -1286,6 +1404,14 @@ public:
         collections->push_back(_fromNs);
     }
 
+    /**
+     * Returns whether an $unwind of the results was coalesced into this stage. Otherwise it outputs
+     * exactly one document for each input document.
+     */
+    bool isUnwinding() const {
+        return _handlingUnwind;
+    }
+
     static boost::intrusive_ptr<DocumentSource> createFromBson(
         BSONElement elem, const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
@@ -1302,12 +1428,84 @@ private:
     }
 
     /**
-     * Builds the required query and executes it.
+     * How documents from the foreign collection are matched with the input documents. A nested
+     * loop join queries the foreign collection once per input document. A hash join scans the
+     * foreign collection once, indexing its documents by join key in memory, or in sorted runs on
+     * disk when that would exceed internalLookupHashJoinMaxMemoryBytes. A sharded batch join
+     * collects the join keys of a batch of input documents and fetches the foreign documents
+     * matching any of them from the shards in one query, indexing them like a hash join.
      */
-    std::unique_ptr<DBClientCursor> doQuery(const Document& docToLookUp) const;
+    enum class JoinStrategy { kUndecided, kNestedLoop, kHashJoin, kShardedBatch };
+
+    typedef boost::unordered_map<Value, std::vector<BSONObj>, Value::Hash> HashTable;
+    typedef Sorter<Value, Value> JoinSorter;
+
+    /**
+     * Executes 'query' against the foreign collection.
+     */
+    std::unique_ptr<DBClientCursor> doQuery(BSONObj query) const;
 
     boost::optional<Document> unwindResult();
+    boost::optional<Document> unwindHashJoinResult();
     BSONObj queryForInput(const Document& input) const;
+    BSONObj queryForLocalValue(Value localFieldVal) const;
+    Value localJoinKey(const Document& input) const;
+
+    /**
+     * Uses a sharded batch join when the foreign collection is sharded. Otherwise prefers a hash
+     * join when the foreign collection has no index on the foreign field, or holds at most
+     * internalLookupHashJoinMaxForeignDocs documents.
+     */
+    JoinStrategy chooseJoinStrategy() const;
+
+    /**
+     * Returns whether the foreign field path has a positional component such as "a.0".
+     */
+    bool hasPositionalForeignField() const;
+
+    /**
+     * Builds the hash table, spilling to disk or falling back to a nested loop join if it does
+     * not fit in memory.
+     */
+    void prepareHashJoin();
+
+    /**
+     * Loads the foreign collection into '_hashTable'. Returns false if it would use more than
+     * 'maxMemoryBytes'.
+     */
+    bool buildHashTable(size_t maxMemoryBytes);
+
+    /**
+     * Sort-merge join of the whole input against the foreign collection with both sides in
+     * Sorter runs, leaving the input documents and their matches in '_spilledInputs' and
+     * '_spilledMatches', in input order.
+     */
+    void joinWithSpilling(size_t maxMemoryBytes);
+
+    /**
+     * Returns the distinct values a query on the foreign field can match in 'foreignDoc', which
+     * includes null if 'nullMatcher' matches it.
+     */
+    std::vector<Value> foreignJoinKeys(const BSONObj& foreignDoc,
+                                       const MatchExpression& nullMatcher) const;
+
+    /**
+     * Returns those 'candidates' matching the query generated for 'localFieldVal'.
+     */
+    std::vector<Value> matchCandidates(const Value& localFieldVal,
+                                       const std::vector<BSONObj>& candidates) const;
+
+    /**
+     * Reads the next batch of input documents into '_inputBatch' and loads the documents of the
+     * sharded foreign collection matching any of their join keys into '_hashTable'.
+     */
+    void loadShardedBatch();
+
+    /**
+     * Returns the next input document of a hash join or sharded batch join, filling 'matches'
+     * with its results.
+     */
+    boost::optional<Document> getNextHashJoinInput(std::vector<Value>* matches);
 
     NamespaceString _fromNs;
     FieldPath _as;
@@ -1320,5 +1518,15 @@ private:
     std::unique_ptr<DBClientCursor> _cursor;
     long long _cursorIndex = 0;
     boost::optional<Document> _input;
+
+    JoinStrategy _strategy = JoinStrategy::kUndecided;
+    HashTable _hashTable;
+    bool _spilled = false;
+    std::unique_ptr<JoinSorter::Iterator> _spilledInputs;
+    std::unique_ptr<JoinSorter::Iterator> _spilledMatches;
+    // Input documents whose matches are in '_hashTable' for a sharded batch join.
+    std::deque<Document> _inputBatch;
+    // Results for '_input' still to be unwound when handling an $unwind with a hash join.
+    std::vector<Value> _matches;
 };
 }
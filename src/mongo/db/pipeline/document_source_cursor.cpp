@@ -59,7 +59,10 @@ boost::optional<Document> DocumentSourceCursor::getNext() {
     pExpCtx->checkForInterrupt();
 
     if (_currentBatch.empty()) {
-        loadBatch();
+        if (_indexKeyBatch.empty()) {
+            loadBatch();
+        }
+        flushIndexKeyBatch();
 
         if (_currentBatch.empty())  // exhausted the cursor
             return boost::none;
@@ -75,6 +78,55 @@ void DocumentSourceCursor::dispose() {
     // will be called when an agg cursor is killed which would cause a deadlock.
     _exec.reset();
     _currentBatch.clear();
+    _indexKeyBatch.clear();
+}
+
+bool DocumentSourceCursor::getNextIndexKeyBatch(std::vector<BSONObj>* keys, BSONObj* keyPattern) {
+    pExpCtx->checkForInterrupt();
+
+    if (_currentBatch.empty() && _indexKeyBatch.empty()) {
+        loadBatch();
+    }
+
+    if (_indexKeyBatch.empty()) {
+        return false;
+    }
+
+    keys->swap(_indexKeyBatch);
+    _indexKeyBatch.clear();
+    *keyPattern = _indexKeyPattern;
+    return true;
+}
+
+void DocumentSourceCursor::setIndexKeyPattern(const BSONObj& keyPattern) {
+    _indexKeyPattern = keyPattern.getOwned();
+    _indexKeyFieldNames.clear();
+
+    BSONForEach(elt, _indexKeyPattern) {
+        const StringData fieldName = elt.fieldNameStringData();
+        _indexKeyFieldNames.push_back(_projection[fieldName].trueValue() ? fieldName
+                                                                         : StringData());
+    }
+}
+
+Document DocumentSourceCursor::indexKeyToDocument(const BSONObj& key) const {
+    MutableDocument out(_indexKeyFieldNames.size());
+    size_t keyIndex = 0;
+
+    BSONForEach(elt, key) {
+        if (!_indexKeyFieldNames[keyIndex].empty()) {
+            out.addField(_indexKeyFieldNames[keyIndex], Value(elt));
+        }
+        ++keyIndex;
+    }
+    return out.freeze();
+}
+
+void DocumentSourceCursor::flushIndexKeyBatch() {
+    for (const BSONObj& key : _indexKeyBatch) {
+        _currentBatch.push_back(indexKeyToDocument(key));
+    }
+    _indexKeyBatch.clear();
 }
 
 void DocumentSourceCursor::loadBatch() {
@@ -92,12 +144,35 @@ void DocumentSourceCursor::loadBatch() {
 
     int memUsageBytes = 0;
     BSONObj obj;
+    BSONObj keyPattern;
     PlanExecutor::ExecState state;
-    while ((state = _exec->getNext(&obj, NULL)) == PlanExecutor::ADVANCED) {
-        if (_dependencies) {
-            _currentBatch.push_back(_dependencies->extractFields(obj));
+    while ((state = _exec->getNextIndexKey(&obj, &keyPattern)) == PlanExecutor::ADVANCED) {
+        if (!keyPattern.isEmpty()) {
+            // A covered projection left to us by the query system. Consumers that read index keys
+            // take them as they are, others get the documents the projection would have built.
+            if (!_indexKeyPattern.binaryEqual(keyPattern)) {
+                flushIndexKeyBatch();
+                setIndexKeyPattern(keyPattern);
+            }
+
+            if (_currentBatch.empty()) {
+                _indexKeyBatch.push_back(obj.getOwned());
+                memUsageBytes += obj.objsize();
+            } else {
+                _currentBatch.push_back(indexKeyToDocument(obj));
+                memUsageBytes += _currentBatch.back().getApproximateSize();
+            }
         } else {
-            _currentBatch.push_back(Document::fromBsonWithMetaData(obj));
+            // Keep the results in order.
+            flushIndexKeyBatch();
+
+            if (_dependencies) {
+                _currentBatch.push_back(_dependencies->extractFields(obj));
+            } else {
+                // Loaded lazily, so the documents must stay on the thread running the pipeline.
+                _currentBatch.push_back(Document::fromBsonWithMetaData(obj));
+            }
+            memUsageBytes += _currentBatch.back().getApproximateSize();
         }
 
         if (_limit) {
@@ -107,8 +182,6 @@ void DocumentSourceCursor::loadBatch() {
             verify(_docsAddedToBatches < _limit->getLimit());
         }
 
-        memUsageBytes += _currentBatch.back().getApproximateSize();
-
         if (memUsageBytes > FindCommon::kMaxBytesToReturnToClientAtOnce) {
             // End this batch and prepare PlanExecutor for yielding.
             _exec->saveState();
@@ -28,7 +28,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 
+#include "mongo/db/curop.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
@@ -36,6 +38,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
@@ -44,6 +47,13 @@ using std::shared_ptr;
 using std::pair;
 using std::vector;
 
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupMaxMemoryBytes, int, 100 * 1024 * 1024);
+
+// When a $group exceeds its memory limit, its groups are spilled into this many partitions by hash
+// of the group key, to be aggregated a partition at a time. With 0 or 1, the groups are instead
+// spilled in sorted runs to be merged.
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupSpillPartitions, int, 16);
+
 REGISTER_DOCUMENT_SOURCE(group, DocumentSourceGroup::createFromBson);
 
 const char* DocumentSourceGroup::getSourceName() const {
@@ -69,35 +79,17 @@ boost::optional<Document> DocumentSourceGroup::getNext() {
         while (_currentId == _firstPartOfNextGroup.first) {
             // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
             // At loop exit, it is the first value to be processed in the next group.
-
-            switch (numAccumulators) {  // mirrors switch in spill()
-                case 0:                 // no Accumulators so no Values
-                    break;
-
-                case 1:  // single accumulators serialize as a single Value
-                    _currentAccumulators[0]->process(_firstPartOfNextGroup.second,
-                                                     /*merging=*/true);
-                    break;
-
-                default: {  // multiple accumulators serialize as an array
-                    const vector<Value>& accumulatorStates =
-                        _firstPartOfNextGroup.second.getArray();
-                    for (size_t i = 0; i < numAccumulators; i++) {
-                        _currentAccumulators[i]->process(accumulatorStates[i],
-                                                         /*merging=*/true);
-                    }
-                    break;
-                }
-            }
+            mergeAccumulators(_firstPartOfNextGroup.second, &_currentAccumulators);
 
             if (!_sorterIterator->more()) {
-                dispose();
+                doneWithGroups();
                 break;
             }
 
             _firstPartOfNextGroup = _sorterIterator->next();
         }
 
+        _stats.groups++;
         return makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
 
     } else {
@@ -108,16 +100,36 @@ boost::optional<Document> DocumentSourceGroup::getNext() {
             makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->inShard);
 
         if (++groupsIterator == groups.end())
-            dispose();
+            doneWithGroups();
 
+        _stats.groups++;
         return out;
     }
 }
 
+void DocumentSourceGroup::doneWithGroups() {
+    if (_nextPartition < _partitions.size()) {
+        aggregateNextPartition();
+        return;
+    }
+
+    if (pExpCtx->opCtx) {
+        OpDebug& debug = CurOp::get(pExpCtx->opCtx)->debug();
+        debug.nGroups = std::max(debug.nGroups, 0LL) + _stats.groups;
+        debug.groupSpills = std::max(debug.groupSpills, 0LL) + _stats.spills;
+        debug.groupSpilledBytes = std::max(debug.groupSpilledBytes, 0LL) + _stats.spilledBytes;
+        debug.addSpilledBytes(_stats.spilledBytes, _stats.spilledUncompressedBytes);
+    }
+
+    dispose();
+}
+
 void DocumentSourceGroup::dispose() {
     // free our resources
     GroupsMap().swap(groups);
     _sorterIterator.reset();
+    _partitionWriters.clear();
+    _partitions.clear();
 
     // make us look done
     groupsIterator = groups.end();
@@ -203,7 +215,8 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _doingMerge(false),
       _spilled(false),
       _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter),
-      _maxMemoryUsageBytes(100 * 1024 * 1024) {}
+      _maxMemoryUsageBytes(internalDocumentSourceGroupMaxMemoryBytes.load()),
+      _numSpillPartitions(std::max(0, internalDocumentSourceGroupSpillPartitions.load())) {}
 
 void DocumentSourceGroup::addAccumulator(const std::string& fieldName,
                                          Accumulator::Factory accumulatorFactory,
@@ -303,6 +316,89 @@ public:
         return Value::compare(lhs.first, rhs.first);
     }
 };
+
+/**
+ * Stores the name of the top-level field that 'expression' reads in 'fieldName', or an empty
+ * string if 'expression' is a constant. Returns false if it is neither, in which case it can't be
+ * evaluated against an index key.
+ */
+bool indexKeyFieldName(const intrusive_ptr<Expression>& expression, std::string* fieldName) {
+    if (dynamic_cast<ExpressionConstant*>(expression.get())) {
+        fieldName->clear();
+        return true;
+    }
+
+    auto fieldPath = dynamic_cast<ExpressionFieldPath*>(expression.get());
+    if (fieldPath && fieldPath->isRootFieldPath() &&
+        fieldPath->getFieldPath().getPathLength() == 2) {
+        *fieldName = fieldPath->getFieldPath().getFieldName(1);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Where an expression's value is found in an index key: the position of its field in the key, or
+ * -1 for a constant.
+ */
+struct IndexKeyInput {
+    int position;
+    Value constant;
+
+    Value get(const vector<BSONElement>& keyElements) const {
+        return position < 0 ? constant : Value(keyElements[position]);
+    }
+};
+
+/**
+ * Maps each of 'expressions', which must all pass indexKeyFieldName(), onto the keys of the index
+ * with 'keyPattern'.
+ */
+vector<IndexKeyInput> mapToIndexKey(const vector<intrusive_ptr<Expression>>& expressions,
+                                    const BSONObj& keyPattern) {
+    vector<IndexKeyInput> inputs;
+    for (auto&& expression : expressions) {
+        std::string fieldName;
+        invariant(indexKeyFieldName(expression, &fieldName));
+
+        IndexKeyInput input{-1, Value()};
+        if (fieldName.empty()) {
+            input.constant = static_cast<ExpressionConstant*>(expression.get())->getValue();
+        } else {
+            int position = 0;
+            BSONForEach(elt, keyPattern) {
+                if (elt.fieldNameStringData() == fieldName) {
+                    input.position = position;
+                    break;
+                }
+                ++position;
+            }
+
+            // The covered projection includes every field that the $group depends on.
+            massert(40502,
+                    str::stream() << "index key " << keyPattern << " is missing $group field "
+                                  << fieldName,
+                    input.position >= 0);
+        }
+        inputs.push_back(input);
+    }
+    return inputs;
+}
+}  // namespace
+
+bool DocumentSourceGroup::canGroupIndexKeys() const {
+    std::string fieldName;
+    for (auto&& expression : _idExpressions) {
+        if (!indexKeyFieldName(expression, &fieldName)) {
+            return false;
+        }
+    }
+    for (auto&& expression : vpExpression) {
+        if (!indexKeyFieldName(expression, &fieldName)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void DocumentSourceGroup::populate() {
@@ -313,22 +409,24 @@ void DocumentSourceGroup::populate() {
     vector<shared_ptr<Sorter<Value, Value>::Iterator>> sortedFiles;
     int memoryUsageBytes = 0;
 
-    // This loop consumes all input from pSource and buckets it based on pIdExpression.
-    while (boost::optional<Document> input = pSource->getNext()) {
+    // The arguments for each accumulator of the input being processed.
+    vector<Value> arguments(numAccumulators);
+
+    // Adds 'arguments' to the group for 'id', spilling first if the groups use too much memory.
+    auto processInput = [&](Value id) {
         if (memoryUsageBytes > _maxMemoryUsageBytes) {
             uassert(16945,
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _extSortAllowed);
-            sortedFiles.push_back(spill());
+            if (_numSpillPartitions > 1) {
+                spillToPartitions();
+            } else {
+                sortedFiles.push_back(spill());
+            }
             memoryUsageBytes = 0;
         }
 
-        _variables->setRoot(*input);
-
-        /* get the _id value */
-        Value id = computeId(_variables.get());
-
         /* treat missing values the same as NULL SERVER-4674 */
         if (id.missing())
             id = Value(BSONNULL);
@@ -359,13 +457,10 @@ void DocumentSourceGroup::populate() {
         /* tickle all the accumulators for the group we found */
         dassert(numAccumulators == group.size());
         for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
+            group[i]->process(arguments[i], _doingMerge);
             memoryUsageBytes += group[i]->memUsageForSorter();
         }
 
-        // We are done with the ROOT document so release it.
-        _variables->clearRoot();
-
         DEV {
             // In debug mode, spill every time we have a duplicate id to stress merge logic.
             if (!inserted  // is a dup
@@ -379,8 +474,101 @@ void DocumentSourceGroup::populate() {
                 sortedFiles.push_back(spill());
             }
         }
+    };
+
+    // If every expression is a constant or a top-level field, the index keys of a covered
+    // projection are grouped as they are, without building a Document for each of them.
+    DocumentSourceCursor* cursor =
+        canGroupIndexKeys() ? dynamic_cast<DocumentSourceCursor*>(pSource) : nullptr;
+    vector<BSONObj> keys;
+    BSONObj keyPattern;
+    BSONObj mappedKeyPattern;
+    vector<IndexKeyInput> idInputs;
+    vector<IndexKeyInput> argumentInputs;
+    vector<BSONElement> keyElements;
+
+    // This loop consumes all input from pSource and buckets it based on pIdExpression.
+    for (;;) {
+        if (cursor && cursor->getNextIndexKeyBatch(&keys, &keyPattern)) {
+            if (!keyPattern.binaryEqual(mappedKeyPattern)) {
+                mappedKeyPattern = keyPattern;
+                idInputs = mapToIndexKey(_idExpressions, keyPattern);
+                argumentInputs = mapToIndexKey(vpExpression, keyPattern);
+            }
+
+            for (const BSONObj& key : keys) {
+                keyElements.clear();
+                BSONForEach(elt, key) {
+                    keyElements.push_back(elt);
+                }
+
+                // Mirrors computeId().
+                Value id;
+                if (idInputs.size() == 1) {
+                    id = idInputs[0].get(keyElements);
+                } else {
+                    vector<Value> vals;
+                    vals.reserve(idInputs.size());
+                    for (auto&& input : idInputs) {
+                        vals.push_back(input.get(keyElements));
+                    }
+                    id = Value(std::move(vals));
+                }
+
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    arguments[i] = argumentInputs[i].get(keyElements);
+                }
+                processInput(std::move(id));
+            }
+            continue;
+        }
+
+        boost::optional<Document> input = pSource->getNext();
+        if (!input) {
+            break;
+        }
+
+        _variables->setRoot(*input);
+
+        /* get the _id value */
+        Value id = computeId(_variables.get());
+
+        for (size_t i = 0; i < numAccumulators; i++) {
+            arguments[i] = vpExpression[i]->evaluate(_variables.get());
+        }
+
+        // We are done with the ROOT document so release it.
+        _variables->clearRoot();
+
+        processInput(std::move(id));
+    }
+
+    populated = true;
+
+    if (!_partitionWriters.empty()) {
+        // Groups still in memory may have parts in the partitions, so they are spilled too.
+        if (!groups.empty()) {
+            spillToPartitions();
+        }
+
+        for (auto&& writer : _partitionWriters) {
+            if (writer) {
+                _partitions.emplace_back(writer->done());
+                _stats.spilledBytes += writer->bytesWritten();
+                _stats.spilledUncompressedBytes += writer->uncompressedBytesWritten();
+            }
+        }
+        _partitionWriters.clear();
+
+        aggregateNextPartition();
+        return;
     }
 
+    startOutput(std::move(sortedFiles));
+}
+
+void DocumentSourceGroup::startOutput(
+    vector<shared_ptr<Sorter<Value, Value>::Iterator>> sortedFiles) {
     // These blocks do any final steps necessary to prepare to output results.
     if (!sortedFiles.empty()) {
         _spilled = true;
@@ -394,10 +582,13 @@ void DocumentSourceGroup::populate() {
         _sorterIterator.reset(
             Sorter<Value, Value>::Iterator::merge(sortedFiles, SortOptions(), SorterComparator()));
 
-        // prepare current to accumulate data
-        _currentAccumulators.reserve(numAccumulators);
-        for (size_t i = 0; i < numAccumulators; i++) {
-            _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+        // prepare current to accumulate data, unless a previous partition already did
+        if (_currentAccumulators.empty()) {
+            const size_t numAccumulators = vpAccumulatorFactory.size();
+            _currentAccumulators.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+            }
         }
 
         verify(_sorterIterator->more());  // we put data in, we should get something out.
@@ -406,8 +597,109 @@ void DocumentSourceGroup::populate() {
         // start the group iterator
         groupsIterator = groups.begin();
     }
+}
 
-    populated = true;
+void DocumentSourceGroup::spillToPartitions() {
+    if (_partitionWriters.empty()) {
+        _partitionWriters.resize(_numSpillPartitions);
+    }
+
+    const Value::Hash hasher;
+    for (GroupsMap::const_iterator it = groups.begin(), end = groups.end(); it != end; ++it) {
+        auto& writer = _partitionWriters[hasher(it->first) % _numSpillPartitions];
+        if (!writer) {
+            writer.reset(
+                new SortedFileWriter<Value, Value>(SortOptions().TempDir(pExpCtx->tempDir)));
+        }
+        writer->addAlreadySorted(it->first, serializeAccumulators(it->second));
+    }
+
+    groups.clear();
+    _stats.spills++;
+}
+
+void DocumentSourceGroup::aggregateNextPartition() {
+    const size_t numAccumulators = vpAccumulatorFactory.size();
+    std::unique_ptr<Sorter<Value, Value>::Iterator> partition =
+        std::move(_partitions[_nextPartition++]);
+
+    // Forget the output state of the previous partition.
+    _spilled = false;
+    _sorterIterator.reset();
+    groups.clear();
+
+    // pushed to on spill()
+    vector<shared_ptr<Sorter<Value, Value>::Iterator>> sortedFiles;
+    int memoryUsageBytes = 0;
+
+    while (partition->more()) {
+        if (memoryUsageBytes > _maxMemoryUsageBytes) {
+            sortedFiles.push_back(spill());
+            memoryUsageBytes = 0;
+        }
+
+        const Sorter<Value, Value>::Data spilledGroup = partition->next();
+
+        const size_t oldSize = groups.size();
+        Accumulators& group = groups[spilledGroup.first];
+        if (groups.size() != oldSize) {
+            memoryUsageBytes += spilledGroup.first.getApproximateSize();
+
+            group.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group.push_back(vpAccumulatorFactory[i]());
+            }
+        } else {
+            for (size_t i = 0; i < numAccumulators; i++) {
+                memoryUsageBytes -= group[i]->memUsageForSorter();
+            }
+        }
+
+        mergeAccumulators(spilledGroup.second, &group);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            memoryUsageBytes += group[i]->memUsageForSorter();
+        }
+    }
+
+    startOutput(std::move(sortedFiles));
+}
+
+Value DocumentSourceGroup::serializeAccumulators(const Accumulators& accums) const {
+    switch (accums.size()) {
+        case 0:  // no values, essentially a distinct
+            return Value();
+
+        case 1:  // just one value, use optimized serialization as single Value
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (size_t i = 0; i < accums.size(); i++) {
+                states.push_back(accums[i]->getValue(/*toBeMerged=*/true));
+            }
+            return Value(std::move(states));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeAccumulators(const Value& states, Accumulators* accums) const {
+    switch (accums->size()) {  // mirrors switch in serializeAccumulators()
+        case 0:                // no Accumulators so no Values
+            break;
+
+        case 1:  // single accumulators serialize as a single Value
+            (*accums)[0]->process(states, /*merging=*/true);
+            break;
+
+        default: {  // multiple accumulators serialize as an array
+            const vector<Value>& accumulatorStates = states.getArray();
+            for (size_t i = 0; i < accums->size(); i++) {
+                (*accums)[i]->process(accumulatorStates[i], /*merging=*/true);
+            }
+            break;
+        }
+    }
 }
 
 class DocumentSourceGroup::SpillSTLComparator {
@@ -427,34 +719,17 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
 
     SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-    switch (vpAccumulatorFactory.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                             // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
-            }
-            break;
-
-        case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
-            }
-            break;
-
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
-                }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
-            }
-            break;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        writer.addAlreadySorted(ptrs[i]->first, serializeAccumulators(ptrs[i]->second));
     }
 
     groups.clear();
 
-    return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
+    shared_ptr<Sorter<Value, Value>::Iterator> iterator(writer.done());
+    _stats.spills++;
+    _stats.spilledBytes += writer.bytesWritten();
+    _stats.spilledUncompressedBytes += writer.uncompressedBytesWritten();
+    return iterator;
 }
 
 void DocumentSourceGroup::parseIdExpression(BSONElement groupField,
@@ -30,9 +30,13 @@
 
 #include "document_source.h"
 
+#include <algorithm>
+
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -49,6 +53,40 @@ MONGO_EXPORT_STARTUP_SERVER_PARAMETER(internalAggregationLookupBatchSize,
                                       int,
                                       LiteParsedQuery::kDefaultBatchSize);
 
+// A hash join is used whenever the foreign collection has no index on the foreign field, or when
+// the foreign collection holds at most this many documents.
+MONGO_EXPORT_SERVER_PARAMETER(internalLookupHashJoinMaxForeignDocs, long long, 100 * 1000);
+
+// Memory the hash table of a $lookup hash join may use before it is spilled to disk, if allowed,
+// or abandoned for a nested loop join. Also the most memory the documents a $lookup from a sharded
+// collection reads for one batch of join keys may take.
+MONGO_EXPORT_SERVER_PARAMETER(internalLookupHashJoinMaxMemoryBytes, long long, 100 * 1024 * 1024);
+
+// Number of input documents whose join keys a $lookup from a sharded collection sends to the shards
+// in one query.
+MONGO_EXPORT_SERVER_PARAMETER(internalLookupShardedBatchSize, int, 100);
+
+namespace {
+/**
+ * Orders the Sorter keys of a spilled hash join, which are [join key, position] pairs.
+ */
+class JoinKeyComparator {
+public:
+    typedef std::pair<Value, Value> Data;
+    int operator()(const Data& lhs, const Data& rhs) const {
+        return Value::compare(lhs.first, rhs.first);
+    }
+};
+
+bool valueLessThan(const Value& lhs, const Value& rhs) {
+    return Value::compare(lhs, rhs) < 0;
+}
+
+bool valueEquals(const Value& lhs, const Value& rhs) {
+    return Value::compare(lhs, rhs) == 0;
+}
+}  // namespace
+
 DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
                                            std::string as,
                                            std::string localField,
@@ -92,9 +130,7 @@ const char* DocumentSourceLookUp::getSourceName() const {
     return "$lookup";
 }
 
-std::unique_ptr<DBClientCursor> DocumentSourceLookUp::doQuery(const Document& docToLookUp) const {
-    auto query = DocumentSourceLookUp::queryForInput(docToLookUp);
-
+std::unique_ptr<DBClientCursor> DocumentSourceLookUp::doQuery(BSONObj query) const {
     // Defaults for everything except batch size.
     const int nToReturn = 0;
     const int nToSkip = 0;
@@ -114,7 +150,27 @@ std::unique_ptr<DBClientCursor> DocumentSourceLookUp::doQuery(const Document& do
 boost::optional<Document> DocumentSourceLookUp::getNext() {
     pExpCtx->checkForInterrupt();
 
-    uassert(4567, "from collection cannot be sharded", !_mongod->isSharded(_fromNs));
+    if (_strategy == JoinStrategy::kUndecided) {
+        _strategy = chooseJoinStrategy();
+        if (_strategy == JoinStrategy::kHashJoin) {
+            prepareHashJoin();
+        }
+    }
+
+    if (_strategy != JoinStrategy::kNestedLoop) {
+        if (_handlingUnwind) {
+            return unwindHashJoinResult();
+        }
+
+        std::vector<Value> matches;
+        boost::optional<Document> input = getNextHashJoinInput(&matches);
+        if (!input)
+            return {};
+
+        MutableDocument output(std::move(*input));
+        output.setNestedField(_as, Value(std::move(matches)));
+        return output.freeze();
+    }
 
     if (_handlingUnwind) {
         return unwindResult();
@@ -123,7 +179,7 @@ boost::optional<Document> DocumentSourceLookUp::getNext() {
     boost::optional<Document> input = pSource->getNext();
     if (!input)
         return {};
-    auto cursor = doQuery(*input);
+    auto cursor = doQuery(queryForInput(*input));
 
     std::vector<Value> results;
     int objsize = 0;
@@ -143,6 +199,323 @@ boost::optional<Document> DocumentSourceLookUp::getNext() {
     return output.freeze();
 }
 
+DocumentSourceLookUp::JoinStrategy DocumentSourceLookUp::chooseJoinStrategy() const {
+    if (_mongod->isShardedInCluster(_fromNs)) {
+        // The documents matching each batch of join keys are indexed the same way as for a hash
+        // join, which can't find the values along positional paths.
+        uassert(40501,
+                str::stream() << "$lookup from the sharded collection " << _fromNs.ns()
+                              << " cannot use the positional foreignField "
+                              << _foreignFieldFieldName,
+                !hasPositionalForeignField());
+        return JoinStrategy::kShardedBatch;
+    }
+
+    bool hasUsableIndex = false;
+    for (auto&& indexSpec : _mongod->directClient()->getIndexSpecs(_fromNs.ns())) {
+        // A partial index cannot answer every equality query on its leading field.
+        if (indexSpec.hasField("partialFilterExpression")) {
+            continue;
+        }
+
+        BSONElement firstKeyField = indexSpec["key"].Obj().firstElement();
+        if (firstKeyField.fieldNameStringData() == _foreignFieldFieldName &&
+            (firstKeyField.isNumber() ||
+             (firstKeyField.type() == String && firstKeyField.valueStringData() == "hashed"))) {
+            hasUsableIndex = true;
+            break;
+        }
+    }
+
+    if (hasUsableIndex &&
+        _mongod->directClient()->count(_fromNs.ns()) >
+            static_cast<unsigned long long>(internalLookupHashJoinMaxForeignDocs.load())) {
+        return JoinStrategy::kNestedLoop;
+    }
+
+    // Values along a path with a positional component such as "a.0" are not all found by
+    // BSONObj::getFieldsDotted(), which builds the hash table.
+    if (hasPositionalForeignField()) {
+        return JoinStrategy::kNestedLoop;
+    }
+    return JoinStrategy::kHashJoin;
+}
+
+bool DocumentSourceLookUp::hasPositionalForeignField() const {
+    for (size_t i = 0; i < _foreignField.getPathLength(); ++i) {
+        const std::string& fieldName = _foreignField.getFieldName(i);
+        if (std::all_of(fieldName.begin(), fieldName.end(), ::isdigit)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DocumentSourceLookUp::prepareHashJoin() {
+    const size_t maxMemoryBytes = internalLookupHashJoinMaxMemoryBytes.load();
+    if (buildHashTable(maxMemoryBytes)) {
+        return;
+    }
+    _hashTable.clear();
+
+    if (pExpCtx->extSortAllowed && !pExpCtx->inRouter) {
+        joinWithSpilling(maxMemoryBytes);
+        _spilled = true;
+        return;
+    }
+
+    // Without permission to use the disk, query the foreign collection for each input document
+    // instead, which needs no more memory than the matches for one document.
+    _strategy = JoinStrategy::kNestedLoop;
+}
+
+bool DocumentSourceLookUp::buildHashTable(size_t maxMemoryBytes) {
+    const BSONObj nullQuery = queryForLocalValue(Value(BSONNULL));
+    const auto nullMatcher = uassertStatusOK(MatchExpressionParser::parse(nullQuery));
+
+    size_t memoryUsageBytes = 0;
+    auto cursor = doQuery(BSONObj());
+    while (cursor->more()) {
+        pExpCtx->checkForInterrupt();
+
+        BSONObj foreignDoc = cursor->nextSafe().getOwned();
+        memoryUsageBytes += foreignDoc.objsize();
+        for (auto&& key : foreignJoinKeys(foreignDoc, *nullMatcher)) {
+            memoryUsageBytes += key.getApproximateSize() + sizeof(BSONObj);
+            _hashTable[std::move(key)].push_back(foreignDoc);
+        }
+
+        if (memoryUsageBytes > maxMemoryBytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DocumentSourceLookUp::joinWithSpilling(size_t maxMemoryBytes) {
+    const SortOptions opts = SortOptions()
+                                 .MaxMemoryUsageBytes(maxMemoryBytes)
+                                 .ExtSortAllowed()
+                                 .TempDir(pExpCtx->tempDir);
+
+    // Foreign documents keyed by [join key, position in the collection scan], so that documents
+    // sharing a join key come out of the Sorter in their natural order.
+    std::unique_ptr<JoinSorter> foreignSorter(JoinSorter::make(opts, JoinKeyComparator()));
+    {
+        const BSONObj nullQuery = queryForLocalValue(Value(BSONNULL));
+        const auto nullMatcher = uassertStatusOK(MatchExpressionParser::parse(nullQuery));
+
+        long long position = 0;
+        auto cursor = doQuery(BSONObj());
+        while (cursor->more()) {
+            pExpCtx->checkForInterrupt();
+
+            BSONObj foreignDoc = cursor->nextSafe();
+            const Value foreignDocValue(foreignDoc);
+            for (auto&& key : foreignJoinKeys(foreignDoc, *nullMatcher)) {
+                foreignSorter->add(Value(std::vector<Value>{key, Value(position)}),
+                                   foreignDocValue);
+            }
+            ++position;
+        }
+    }
+
+    long long spilledBytes = 0;
+    long long spilledUncompressedBytes = 0;
+
+    // Input documents are written out in arrival order, and their join keys are sorted as
+    // [join key, position in the input].
+    std::unique_ptr<JoinSorter> probeSorter(JoinSorter::make(opts, JoinKeyComparator()));
+    {
+        SortedFileWriter<Value, Value> inputWriter(opts);
+        long long position = 0;
+        while (boost::optional<Document> input = pSource->getNext()) {
+            probeSorter->add(Value(std::vector<Value>{localJoinKey(*input), Value(position)}),
+                             Value());
+            inputWriter.addAlreadySorted(Value(position), Value(std::move(*input)));
+            ++position;
+        }
+        _spilledInputs.reset(inputWriter.done());
+        spilledBytes += inputWriter.bytesWritten();
+        spilledUncompressedBytes += inputWriter.uncompressedBytesWritten();
+    }
+
+    // Merge the sorted sides, recording the matches for each input position. Only the foreign
+    // documents sharing one join key are held in memory at a time.
+    std::unique_ptr<JoinSorter> matchSorter(JoinSorter::make(opts, JoinKeyComparator()));
+    {
+        std::unique_ptr<JoinSorter::Iterator> foreign(foreignSorter->done());
+        std::unique_ptr<JoinSorter::Iterator> probes(probeSorter->done());
+
+        boost::optional<JoinSorter::Data> nextForeign;
+        if (foreign->more()) {
+            nextForeign = foreign->next();
+        }
+
+        boost::optional<Value> candidatesKey;
+        std::vector<BSONObj> candidates;
+        while (probes->more()) {
+            pExpCtx->checkForInterrupt();
+
+            const JoinSorter::Data probe = probes->next();
+            const Value& key = probe.first[0];
+            if (!candidatesKey || !valueEquals(*candidatesKey, key)) {
+                candidatesKey = key;
+                candidates.clear();
+
+                while (nextForeign && valueLessThan(nextForeign->first[0], key)) {
+                    nextForeign = foreign->more() ? foreign->next()
+                                                  : boost::optional<JoinSorter::Data>();
+                }
+                while (nextForeign && valueEquals(nextForeign->first[0], key)) {
+                    candidates.push_back(nextForeign->second.getDocument().toBson());
+                    nextForeign = foreign->more() ? foreign->next()
+                                                  : boost::optional<JoinSorter::Data>();
+                }
+            }
+            matchSorter->add(probe.first[1], Value(matchCandidates(key, candidates)));
+        }
+    }
+    _spilledMatches.reset(matchSorter->done());
+
+    if (pExpCtx->opCtx) {
+        for (auto&& sorter : {foreignSorter.get(), probeSorter.get(), matchSorter.get()}) {
+            spilledBytes += sorter->spilledBytes();
+            spilledUncompressedBytes += sorter->spilledUncompressedBytes();
+        }
+        CurOp::get(pExpCtx->opCtx)->debug().addSpilledBytes(spilledBytes, spilledUncompressedBytes);
+    }
+}
+
+std::vector<Value> DocumentSourceLookUp::foreignJoinKeys(const BSONObj& foreignDoc,
+                                                         const MatchExpression& nullMatcher) const {
+    // An equality query matches both the arrays along the path and their elements.
+    BSONElementSet elements;
+    foreignDoc.getFieldsDotted(_foreignFieldFieldName, elements, true);
+    foreignDoc.getFieldsDotted(_foreignFieldFieldName, elements, false);
+
+    std::vector<Value> keys;
+    keys.reserve(elements.size() + 1);
+    for (auto&& element : elements) {
+        keys.push_back(Value(element));
+    }
+
+    // A null query also matches documents where the path is missing, which have no element.
+    if (nullMatcher.matchesBSON(foreignDoc)) {
+        keys.push_back(Value(BSONNULL));
+    }
+
+    std::sort(keys.begin(), keys.end(), valueLessThan);
+    keys.erase(std::unique(keys.begin(), keys.end(), valueEquals), keys.end());
+    return keys;
+}
+
+std::vector<Value> DocumentSourceLookUp::matchCandidates(
+    const Value& localFieldVal, const std::vector<BSONObj>& candidates) const {
+    // Join keys only narrow down the candidates; the query a nested loop join would issue decides
+    // which of them match.
+    const BSONObj query = queryForLocalValue(localFieldVal);
+    const auto matcher = uassertStatusOK(MatchExpressionParser::parse(query));
+
+    std::vector<Value> results;
+    int objsize = 0;
+    for (auto&& candidate : candidates) {
+        if (!matcher->matchesBSON(candidate)) {
+            continue;
+        }
+
+        objsize += candidate.objsize();
+        uassert(4568,
+                str::stream() << "Total size of documents in " << _fromNs.coll() << " matching "
+                              << query << " exceeds maximum document size",
+                objsize <= BSONObjMaxInternalSize);
+        results.push_back(Value(candidate));
+    }
+    return results;
+}
+
+void DocumentSourceLookUp::loadShardedBatch() {
+    _hashTable.clear();
+
+    const size_t batchSize = std::max(1, internalLookupShardedBatchSize.load());
+    std::vector<Value> keys;
+    while (_inputBatch.size() < batchSize) {
+        boost::optional<Document> input = pSource->getNext();
+        if (!input) {
+            break;
+        }
+        keys.push_back(localJoinKey(*input));
+        _inputBatch.push_back(std::move(*input));
+    }
+
+    if (keys.empty()) {
+        return;
+    }
+
+    std::sort(keys.begin(), keys.end(), valueLessThan);
+    keys.erase(std::unique(keys.begin(), keys.end(), valueEquals), keys.end());
+
+    // { _foreignFieldFieldName : { "$in" : [ keys ] } } matches every document the query for any
+    // one of the keys would, and is targeted to the shards owning them when the foreign field is
+    // the shard key. matchCandidates() then applies the query for each input document.
+    BSONObjBuilder query;
+    BSONObjBuilder subObj(query.subobjStart(_foreignFieldFieldName));
+    subObj << "$in" << Value(std::move(keys));
+    subObj.doneFast();
+
+    const BSONObj nullQuery = queryForLocalValue(Value(BSONNULL));
+    const auto nullMatcher = uassertStatusOK(MatchExpressionParser::parse(nullQuery));
+    // The candidates are indexed like a hash join's table, so they share its memory limit.
+    const size_t maxMemoryBytes = internalLookupHashJoinMaxMemoryBytes.load();
+    for (auto&& foreignDoc : _mongod->findSharded(_fromNs, query.obj(), maxMemoryBytes)) {
+        for (auto&& key : foreignJoinKeys(foreignDoc, *nullMatcher)) {
+            _hashTable[std::move(key)].push_back(foreignDoc);
+        }
+    }
+}
+
+boost::optional<Document> DocumentSourceLookUp::getNextHashJoinInput(std::vector<Value>* matches) {
+    if (_spilled) {
+        if (!_spilledInputs->more()) {
+            return {};
+        }
+
+        JoinSorter::Data input = _spilledInputs->next();
+        invariant(_spilledMatches->more());
+        JoinSorter::Data inputMatches = _spilledMatches->next();
+        invariant(valueEquals(input.first, inputMatches.first));
+
+        *matches = inputMatches.second.getArray();
+        return input.second.getDocument();
+    }
+
+    boost::optional<Document> input;
+    if (_strategy == JoinStrategy::kShardedBatch) {
+        if (_inputBatch.empty()) {
+            loadShardedBatch();
+        }
+        if (_inputBatch.empty()) {
+            return {};
+        }
+        input = std::move(_inputBatch.front());
+        _inputBatch.pop_front();
+    } else {
+        input = pSource->getNext();
+        if (!input) {
+            return {};
+        }
+    }
+
+    const Value key = localJoinKey(*input);
+    auto it = _hashTable.find(key);
+    if (it == _hashTable.end()) {
+        *matches = matchCandidates(key, {});
+    } else {
+        *matches = matchCandidates(key, it->second);
+    }
+    return input;
+}
+
 bool DocumentSourceLookUp::coalesce(const intrusive_ptr<DocumentSource>& pNextSource) {
     if (_handlingUnwind) {
         return false;
@@ -159,15 +532,26 @@ bool DocumentSourceLookUp::coalesce(const intrusive_ptr<DocumentSource>& pNextSo
 
 void DocumentSourceLookUp::dispose() {
     _cursor.reset();
+    _hashTable.clear();
+    _inputBatch.clear();
+    _spilledInputs.reset();
+    _spilledMatches.reset();
     pSource->dispose();
 }
 
-BSONObj DocumentSourceLookUp::queryForInput(const Document& input) const {
+Value DocumentSourceLookUp::localJoinKey(const Document& input) const {
     Value localFieldVal = input.getNestedField(_localField);
     if (localFieldVal.missing()) {
         localFieldVal = Value(BSONNULL);
     }
+    return localFieldVal;
+}
+
+BSONObj DocumentSourceLookUp::queryForInput(const Document& input) const {
+    return queryForLocalValue(localJoinKey(input));
+}
 
+BSONObj DocumentSourceLookUp::queryForLocalValue(Value localFieldVal) const {
     // { _foreignFieldFiedlName : { "$eq" : localFieldValue } }
     BSONObjBuilder query;
     BSONObjBuilder subObj(query.subobjStart(_foreignFieldFieldName));
@@ -188,7 +572,7 @@ boost::optional<Document> DocumentSourceLookUp::unwindResult() {
             return {};
 
         _cursorIndex = 0;
-        _cursor = doQuery(*_input);
+        _cursor = doQuery(queryForInput(*_input));
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_cursor->more()) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -218,6 +602,40 @@ boost::optional<Document> DocumentSourceLookUp::unwindResult() {
     return output.freeze();
 }
 
+boost::optional<Document> DocumentSourceLookUp::unwindHashJoinResult() {
+    const boost::optional<FieldPath> indexPath(_unwindSrc->indexPath());
+
+    // Loop until we get a document that has at least one match, as in unwindResult().
+    while (static_cast<size_t>(_cursorIndex) >= _matches.size()) {
+        _input = getNextHashJoinInput(&_matches);
+        if (!_input)
+            return {};
+
+        _cursorIndex = 0;
+        if (_unwindSrc->preserveNullAndEmptyArrays() && _matches.empty()) {
+            MutableDocument output(std::move(*_input));
+            output.setNestedField(_as, Value());
+            if (indexPath) {
+                output.setNestedField(*indexPath, Value(BSONNULL));
+            }
+            return output.freeze();
+        }
+    }
+    invariant(bool(_input));
+
+    // Move input document into output if this is the last or only result, otherwise perform a copy.
+    const bool isLastMatch = static_cast<size_t>(_cursorIndex) + 1 == _matches.size();
+    MutableDocument output(isLastMatch ? std::move(*_input) : *_input);
+    output.setNestedField(_as, std::move(_matches[_cursorIndex]));
+
+    if (indexPath) {
+        output.setNestedField(*indexPath, Value(_cursorIndex));
+    }
+
+    _cursorIndex++;
+    return output.freeze();
+}
+
 void DocumentSourceLookUp::serializeToArray(std::vector<Value>& array, bool explain) const {
     MutableDocument output(
         DOC(getSourceName() << DOC("from" << _fromNs.coll() << "as" << _as.getPath(false)
@@ -230,6 +648,18 @@ void DocumentSourceLookUp::serializeToArray(std::vector<Value>& array, bool expl
                       << _unwindSrc->preserveNullAndEmptyArrays() << "includeArrayIndex"
                       << (indexPath ? Value((*indexPath).getPath(false)) : Value())));
     }
+    if (explain && _mongod) {
+        const JoinStrategy strategy =
+            _strategy == JoinStrategy::kUndecided ? chooseJoinStrategy() : _strategy;
+        output[getSourceName()]["strategy"] = Value(strategy == JoinStrategy::kShardedBatch
+                                                        ? "shardedBatch"
+                                                        : strategy == JoinStrategy::kHashJoin
+                                                            ? "hashJoin"
+                                                            : "nestedLoop");
+        if (_spilled) {
+            output[getSourceName()]["spilled"] = Value(true);
+        }
+    }
     array.push_back(Value(output.freeze()));
     if (_handlingUnwind && !explain) {
         _unwindSrc->serializeToArray(array);
@@ -279,3 +709,6 @@ boost::intrusive_ptr<DocumentSource> DocumentSourceLookUp::createFromBson(
         std::move(fromNs), std::move(as), std::move(localField), std::move(foreignField), pExpCtx);
 }
 }
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -308,6 +308,32 @@ BSONObj DocumentSourceMatch::redactSafePortion() const {
     return redactSafePortionTopLevel(getQuery()).toBson();
 }
 
+namespace {
+void addQueryDependencies(const BSONObj& query, DepsTracker* deps) {
+    BSONForEach(e, query) {
+        const StringData fieldName = e.fieldNameStringData();
+        if (fieldName == "$and" || fieldName == "$or" || fieldName == "$nor") {
+            BSONForEach(clause, e.Obj()) {
+                addQueryDependencies(clause.Obj(), deps);
+            }
+        } else if (fieldName.startsWith("$")) {
+            // $where, and any other top-level operator, may look at the whole document.
+            deps->needWholeDocument = true;
+        } else {
+            // Operators on a field, such as $elemMatch, only look inside that field. A dotted path
+            // needs the whole top-level field, since a projection of the path would drop the
+            // scalars of an array it goes through, which 'a.0' or {'a.b': null} can match.
+            deps->fields.insert(fieldName.substr(0, fieldName.find('.')).toString());
+        }
+    }
+}
+}  // namespace
+
+DocumentSource::GetDepsReturn DocumentSourceMatch::getDependencies(DepsTracker* deps) const {
+    addQueryDependencies(getQuery(), deps);
+    return SEE_NEXT;
+}
+
 void DocumentSourceMatch::setSource(DocumentSource* source) {
     uassert(17313, "$match with $text is only allowed as the first pipeline stage", !_isTextQuery);
 
@@ -131,6 +131,7 @@ Document DocumentSourceMergeCursors::nextSafeFrom(DBClientCursor* cursor) {
                   str::stream() << "Received error in response from " << cursor->originalHost()
                                 << ": " << next);
     }
+    // Loaded lazily, so the document must stay on the thread running the pipeline.
     return Document::fromBsonWithMetaData(next);
 }
 
@@ -31,6 +31,7 @@
 #include "mongo/db/pipeline/document_source.h"
 
 
+#include "mongo/db/curop.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
@@ -255,6 +256,11 @@ void DocumentSourceSort::loadingDone() {
         _sorter.reset(MySorter::make(makeSortOptions(), Comparator(*this)));
     }
     _output.reset(_sorter->done());
+    if (pExpCtx->opCtx) {
+        CurOp::get(pExpCtx->opCtx)
+            ->debug()
+            .addSpilledBytes(_sorter->spilledBytes(), _sorter->spilledUncompressedBytes());
+    }
     _sorter.reset();
     populated = true;
 }
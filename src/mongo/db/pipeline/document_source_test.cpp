@@ -33,6 +33,7 @@
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/service_context_noop.h"
 #include "mongo/stdx/memory.h"
@@ -299,13 +300,14 @@ public:
     Base() : _tempDir("DocumentSourceGroupTest") {}
 
 protected:
-    void createGroup(const BSONObj& spec, bool inShard = false) {
+    void createGroup(const BSONObj& spec, bool inShard = false, bool extSortAllowed = false) {
         BSONObj namedSpec = BSON("$group" << spec);
         BSONElement specElement = namedSpec.firstElement();
 
         intrusive_ptr<ExpressionContext> expressionContext =
             new ExpressionContext(_opCtx.get(), NamespaceString(ns));
         expressionContext->inShard = inShard;
+        expressionContext->extSortAllowed = extSortAllowed;
         // Won't spill to disk properly if it needs to.
         expressionContext->tempDir = _tempDir.path();
 
@@ -885,6 +887,58 @@ public:
     }
 };
 
+/** Groups spilled to disk are merged into the same results, whether partitioned or sorted. */
+class SpillToDisk : public Base {
+public:
+    void run() {
+        runWithSpillPartitions(16);
+        runWithSpillPartitions(0);
+        setParameter("internalDocumentSourceGroupMaxMemoryBytes", "104857600");
+        setParameter("internalDocumentSourceGroupSpillPartitions", "16");
+    }
+
+private:
+    void setParameter(const string& name, const string& value) {
+        const ServerParameter::Map& parameters = ServerParameterSet::getGlobal()->getMap();
+        ServerParameter::Map::const_iterator parameter = parameters.find(name);
+        ASSERT(parameter != parameters.end());
+        ASSERT_OK(parameter->second->setFromString(value));
+    }
+
+    void runWithSpillPartitions(int partitions) {
+        // Small enough that partitions are also too large for memory, and sorted.
+        setParameter("internalDocumentSourceGroupMaxMemoryBytes", "1000");
+        setParameter("internalDocumentSourceGroupSpillPartitions", std::to_string(partitions));
+
+        createGroup(fromjson("{_id:'$a',count:{$sum:1},b:{$addToSet:'$b'}}"), false, true);
+        std::deque<Document> inputData;
+        for (int i = 0; i < 1000; i++) {
+            inputData.push_back(DOC("a" << i % 100 << "b" << i % 3));
+        }
+        auto source = DocumentSourceMock::create(inputData);
+        group()->setSource(source.get());
+
+        IdMap resultSet;
+        while (boost::optional<Document> current = group()->getNext()) {
+            Value id = current->getField("_id");
+            ASSERT(resultSet.find(id) == resultSet.end());
+            resultSet[id] = *current;
+        }
+        assertExhausted(group());
+
+        ASSERT_EQUALS(100U, resultSet.size());
+        for (IdMap::const_iterator i = resultSet.begin(); i != resultSet.end(); ++i) {
+            ASSERT_EQUALS(10, i->second["count"].getInt());
+            ASSERT_EQUALS(3U, i->second["b"].getArrayLength());
+        }
+
+        const auto& stats = static_cast<DocumentSourceGroup*>(group())->getStats();
+        ASSERT_EQUALS(100, stats.groups);
+        ASSERT_GT(stats.spills, 0);
+        ASSERT_GT(stats.spilledBytes, 0);
+    }
+};
+
 }  // namespace DocumentSourceGroup
 
 namespace DocumentSourceProject {
@@ -2708,6 +2762,7 @@ public:
         add<DocumentSourceGroup::Dependencies>();
         add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
         add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
+        add<DocumentSourceGroup::SpillToDisk>();
 
         add<DocumentSourceProject::Inclusion>();
         add<DocumentSourceProject::Optimize>();
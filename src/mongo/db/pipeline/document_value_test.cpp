@@ -117,6 +117,111 @@ public:
     }
 };
 
+/** Look up, iterate and modify Documents whose fields are loaded from BSON as they are accessed. */
+class LazyFromBson {
+public:
+    void run() {
+        BSONObjBuilder bob;
+        for (int i = 0; i < 10; ++i) {
+            bob.append(string("f") + char('0' + i), i);
+        }
+        bob.append("sub", BSON("x" << 1 << "y" << BSON_ARRAY(BSON("z" << 2) << 3)));
+        const BSONObj obj = bob.obj();
+        const Document eager = fromBson(obj);
+
+        // Fields get the same Positions as in a fully converted document, in field order.
+        Document lazy = Document::fromBsonWithMetaData(obj);
+        const Position f7 = lazy.positionOf("f7");
+        ASSERT_EQUALS(eager.positionOf("f7"), f7);
+        ASSERT_LESS_THAN(lazy.positionOf("f2"), f7);
+        ASSERT_EQUALS(7, lazy[f7].getInt());
+        ASSERT(lazy["missing"].missing());
+        ASSERT_EQUALS(2, lazy.getNestedField(FieldPath("sub.y")).getArray()[0]["z"].getInt());
+        ASSERT_EQUALS(eager, lazy);
+        ASSERT_EQUALS(obj, toBson(lazy));
+
+        // Writes see every field, and don't change the document they were copied from.
+        lazy = Document::fromBsonWithMetaData(obj);
+        MutableDocument md(lazy);
+        md.setField(lazy.positionOf("f3"), Value(30));
+        md.addField("added", Value(true));
+        const Document modified = md.freeze();
+        ASSERT_EQUALS(30, modified["f3"].getInt());
+        ASSERT_EQUALS(eager.size() + 1, modified.size());
+        ASSERT_EQUALS("added", getNthField(modified, eager.size()).first.toString());
+        ASSERT_EQUALS(3, lazy["f3"].getInt());
+        ASSERT_EQUALS(eager, lazy);
+
+        // The document keeps its own copy of BSON it doesn't own.
+        BSONObj copy = obj.copy();
+        lazy = Document::fromBsonWithMetaData(BSONObj(copy.objdata()));
+        copy = BSONObj();
+        ASSERT_EQUALS(eager, lazy);
+        assertRoundTrips(lazy);
+
+        // Nested documents, including those in arrays, keep the buffer they load from alive.
+        copy = obj.copy();
+        const Value sub = Document::fromBsonWithMetaData(copy)["sub"];
+        lazy = Document();
+        copy = BSONObj();
+        ASSERT_EQUALS(eager["sub"], sub);
+
+        ASSERT(Document::fromBsonWithMetaData(BSONObj()).empty());
+    }
+};
+
+/** The approximate size of a lazily loaded Document counts the BSON it holds on to. */
+class LazyFromBsonApproximateSize {
+public:
+    void run() {
+        const string big(100 * 1024, 'x');
+        const BSONObj obj = BSON("big" << big << "sub" << BSON("x" << 1));
+
+        // Loading a field doesn't make the buffer the document holds any smaller.
+        Document lazy = Document::fromBsonWithMetaData(obj);
+        const size_t unloadedSize = lazy.getApproximateSize();
+        ASSERT_GREATER_THAN_OR_EQUALS(unloadedSize, size_t(obj.objsize()));
+        ASSERT_EQUALS(big, lazy["big"].getString());
+        ASSERT_GREATER_THAN_OR_EQUALS(lazy.getApproximateSize(), unloadedSize);
+
+        // A nested document shares the enclosing buffer, but is sized by its own BSON only.
+        const Value sub = Document::fromBsonWithMetaData(obj)["sub"];
+        ASSERT_LESS_THAN(sub.getApproximateSize(), size_t(1024));
+        ASSERT_EQUALS(1, sub["x"].getInt());
+    }
+};
+
+/** Add and get Document fields by HashedFieldName, with and without a hash table. */
+class HashedFieldNames {
+public:
+    void run() {
+        const char* names[] = {"a", "b", "c", "d", "e", "f", "g", "h", "i", "j"};
+        for (size_t numFields = 1; numFields <= 10; ++numFields) {
+            MutableDocument md;
+            for (size_t i = 0; i < numFields; ++i) {
+                if (i % 2)
+                    md.addField(HashedFieldName(names[i]), Value(int(i)));
+                else
+                    md.addField(names[i], Value(int(i)));
+            }
+            Document document = md.freeze();
+
+            for (size_t i = 0; i < 10; ++i) {
+                const HashedFieldName name(names[i]);
+                ASSERT_EQUALS(document.positionOf(names[i]), document.positionOf(name));
+                if (i < numFields) {
+                    ASSERT_EQUALS(int(i), document[name].getInt());
+                    ASSERT_EQUALS(int(i), document[names[i]].getInt());
+                } else {
+                    ASSERT(document[name].missing());
+                    ASSERT(!document.positionOf(name).found());
+                }
+            }
+            assertRoundTrips(document);
+        }
+    }
+};
+
 /** Get Document values. */
 class GetValue {
 public:
@@ -1672,6 +1777,9 @@ public:
         add<Document::Create>();
         add<Document::CreateFromBsonObj>();
         add<Document::AddField>();
+        add<Document::LazyFromBson>();
+        add<Document::LazyFromBsonApproximateSize>();
+        add<Document::HashedFieldNames>();
         add<Document::GetValue>();
         add<Document::SetField>();
         add<Document::Compare>();
@@ -1230,45 +1230,66 @@ void ExpressionObject::addDependencies(DepsTracker* deps, vector<string>* path)
     }
 }
 
+namespace {
+const HashedFieldName idFieldName("_id");
+}  // namespace
+
 void ExpressionObject::addToDocument(MutableDocument& out,
                                      const Document& currentDoc,
                                      Variables* vars) const {
-    FieldMap::const_iterator end = _expressions.end();
+    // Rather than looking each field of currentDoc up in _expressions, look each field of this
+    // expression up in currentDoc, by its precomputed hash. Sorting the Positions found puts the
+    // fields back in the order currentDoc has them. The index of a field in _order identifies it,
+    // and _order.size() stands for _id.
+    std::vector<std::pair<Position, size_t>> inputFields;
+    inputFields.reserve(_order.size() + 1);
+
+    bool haveIdExpression = false;
+    for (size_t i = 0; i < _order.size(); i++) {
+        const Position pos = currentDoc.positionOf(_order[i].name);
+        if (pos.found() && !currentDoc[pos].missing())
+            inputFields.push_back(std::make_pair(pos, i));
+        haveIdExpression = haveIdExpression || _order[i].name.name() == "_id";
+    }
+
+    if (!_excludeId && _atRoot && !haveIdExpression) {
+        // _id from the root doc is always included (until exclusion is supported)
+        const Position pos = currentDoc.positionOf(idFieldName);
+        if (pos.found() && !currentDoc[pos].missing())
+            inputFields.push_back(std::make_pair(pos, _order.size()));
+    }
+
+    std::sort(inputFields.begin(), inputFields.end());
 
     // This is used to mark fields we've done so that we can add the ones we haven't
-    set<string> doneFields;
-
-    FieldIterator fields(currentDoc);
-    while (fields.more()) {
-        Document::FieldPair field(fields.next());
-
-        // TODO don't make a new string here
-        const string fieldName = field.first.toString();
-        FieldMap::const_iterator exprIter = _expressions.find(fieldName);
-
-        // This field is not supposed to be in the output (unless it is _id)
-        if (exprIter == end) {
-            if (!_excludeId && _atRoot && field.first == "_id") {
-                // _id from the root doc is always included (until exclusion is supported)
-                // not updating doneFields since "_id" isn't in _expressions
-                out.addField(field.first, field.second);
-            }
+    std::vector<bool> doneFields(_order.size());
+    size_t numDone = 0;
+
+    for (const auto& inputField : inputFields) {
+        const Value fieldValue = currentDoc[inputField.first];
+
+        if (inputField.second == _order.size()) {
+            // not updating doneFields since "_id" isn't in _expressions
+            out.addField(idFieldName, fieldValue);
             continue;
         }
 
+        const HashedFieldName& fieldName = _order[inputField.second].name;
+
         // make sure we don't add this field again
-        doneFields.insert(exprIter->first);
+        doneFields[inputField.second] = true;
+        numDone++;
 
-        Expression* expr = exprIter->second.get();
+        Expression* expr = _order[inputField.second].expr->get();
 
         if (!expr) {
             // This means pull the matching field from the input document
-            out.addField(field.first, field.second);
+            out.addField(fieldName, fieldValue);
             continue;
         }
 
         ExpressionObject* exprObj = dynamic_cast<ExpressionObject*>(expr);
-        BSONType valueType = field.second.getType();
+        BSONType valueType = fieldValue.getType();
         if ((valueType != Object && valueType != Array) || !exprObj) {
             // This expression replace the whole field
 
@@ -1284,7 +1305,7 @@ void ExpressionObject::addToDocument(MutableDocument& out,
                force the appearance of non-existent fields.
                */
             if (!pValue.missing())
-                out.addField(field.first, pValue);
+                out.addField(fieldName, pValue);
 
             continue;
         }
@@ -1296,8 +1317,8 @@ void ExpressionObject::addToDocument(MutableDocument& out,
         */
         if (valueType == Object) {
             MutableDocument sub(exprObj->getSizeHint());
-            exprObj->addToDocument(sub, field.second.getDocument(), vars);
-            out.addField(field.first, sub.freezeToValue());
+            exprObj->addToDocument(sub, fieldValue.getDocument(), vars);
+            out.addField(fieldName, sub.freezeToValue());
         } else if (valueType == Array) {
             /*
                 If it's an array, we have to do the same thing,
@@ -1305,7 +1326,7 @@ void ExpressionObject::addToDocument(MutableDocument& out,
                 of results to the current document.
             */
             vector<Value> result;
-            const vector<Value>& input = field.second.getArray();
+            const vector<Value>& input = fieldValue.getArray();
             for (size_t i = 0; i < input.size(); i++) {
                 // can't look for a subfield in a non-object value.
                 if (input[i].getType() != Object)
@@ -1316,29 +1337,29 @@ void ExpressionObject::addToDocument(MutableDocument& out,
                 result.push_back(doc.freezeToValue());
             }
 
-            out.addField(field.first, Value(std::move(result)));
+            out.addField(fieldName, Value(std::move(result)));
         } else {
             verify(false);
         }
     }
 
-    if (doneFields.size() == _expressions.size())
+    if (numDone == _order.size())
         return;
 
     /* add any remaining fields we haven't already taken care of */
-    for (vector<string>::const_iterator i(_order.begin()); i != _order.end(); ++i) {
-        FieldMap::const_iterator it = _expressions.find(*i);
-        string fieldName(it->first);
-
+    for (size_t i = 0; i < _order.size(); i++) {
         /* if we've already dealt with this field, above, do nothing */
-        if (doneFields.count(fieldName))
+        if (doneFields[i])
             continue;
 
+        const HashedFieldName& fieldName = _order[i].name;
+        const Expression* expr = _order[i].expr->get();
+
         // this is a missing inclusion field
-        if (!it->second)
+        if (!expr)
             continue;
 
-        Value pValue(it->second->evaluateInternal(vars));
+        Value pValue(expr->evaluateInternal(vars));
 
         /*
           Don't add non-existent values (note:  different from NULL or Undefined);
@@ -1349,7 +1370,7 @@ void ExpressionObject::addToDocument(MutableDocument& out,
             continue;
 
         // don't add field if nothing was found in the subobject
-        if (dynamic_cast<ExpressionObject*>(it->second.get()) && pValue.getDocument().empty())
+        if (dynamic_cast<const ExpressionObject*>(expr) && pValue.getDocument().empty())
             continue;
 
         out.addField(fieldName, pValue);
@@ -1384,7 +1405,7 @@ void ExpressionObject::addField(const FieldPath& fieldPath,
     intrusive_ptr<ExpressionObject> subObj = dynamic_cast<ExpressionObject*>(expr.get());
 
     if (!haveExpr) {
-        _order.push_back(fieldPart);
+        _order.push_back({HashedFieldName(fieldPart), &expr});
     } else {  // we already have an expression or inclusion for this field
         if (fieldPath.getPathLength() == 1) {
             // This expression is for right here
@@ -1398,11 +1419,9 @@ void ExpressionObject::addField(const FieldPath& fieldPath,
 
             // Copy everything from the newSubObj to the existing subObj
             // This is for cases like { $project:{ 'b.c':1, b:{ a:1 } } }
-            for (vector<string>::const_iterator it(newSubObj->_order.begin());
-                 it != newSubObj->_order.end();
-                 ++it) {
+            for (const auto& field : newSubObj->_order) {
                 // asserts if any fields are dupes
-                subObj->addField(*it, newSubObj->_expressions[*it]);
+                subObj->addField(field.name.name(), *field.expr);
             }
             return;
         } else {
@@ -1431,15 +1450,22 @@ void ExpressionObject::includePath(const string& theFieldPath) {
     addField(theFieldPath, NULL);
 }
 
+bool ExpressionObject::passesThroughField(const string& fieldName) const {
+    FieldMap::const_iterator it = _expressions.find(fieldName);
+    if (it != _expressions.end())
+        return !it->second;  // NULL expression means inclusion
+
+    return _atRoot && !_excludeId && fieldName == "_id";
+}
+
 Value ExpressionObject::serialize(bool explain) const {
     MutableDocument valBuilder;
     if (_excludeId)
         valBuilder["_id"] = Value(false);
 
-    for (vector<string>::const_iterator it(_order.begin()); it != _order.end(); ++it) {
-        string fieldName = *it;
-        verify(_expressions.find(fieldName) != _expressions.end());
-        intrusive_ptr<Expression> expr = _expressions.find(fieldName)->second;
+    for (const auto& field : _order) {
+        string fieldName = field.name.name();
+        const intrusive_ptr<Expression>& expr = *field.expr;
 
         if (!expr) {
             // this is inclusion, not an expression
@@ -1483,7 +1509,11 @@ intrusive_ptr<ExpressionFieldPath> ExpressionFieldPath::parse(const string& raw,
 
 
 ExpressionFieldPath::ExpressionFieldPath(const string& theFieldPath, Variables::Id variable)
-    : _fieldPath(theFieldPath), _variable(variable) {}
+    : _fieldPath(theFieldPath), _variable(variable) {
+    _fieldNames.reserve(_fieldPath.getPathLength());
+    for (size_t i = 0; i < _fieldPath.getPathLength(); i++)
+        _fieldNames.push_back(HashedFieldName(_fieldPath.getFieldName(i)));
+}
 
 intrusive_ptr<Expression> ExpressionFieldPath::optimize() {
     /* nothing can be done for these */
@@ -1523,10 +1553,10 @@ Value ExpressionFieldPath::evaluatePath(size_t index, const Document& input) con
 
     /* if we've hit the end of the path, stop */
     if (index == _fieldPath.getPathLength() - 1)
-        return input[_fieldPath.getFieldName(index)];
+        return input[_fieldNames[index]];
 
     // Try to dive deeper
-    const Value val = input[_fieldPath.getFieldName(index)];
+    const Value val = input[_fieldNames[index]];
     switch (val.getType()) {
         case Object:
             return evaluatePath(index + 1, val.getDocument());
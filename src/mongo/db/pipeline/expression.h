@@ -749,6 +749,14 @@ public:
         return _fieldPath;
     }
 
+    /**
+     * Returns true if this reads a field of the ROOT document, rather than the whole document or
+     * another variable.
+     */
+    bool isRootFieldPath() const {
+        return _variable == Variables::ROOT_ID && _fieldPath.getPathLength() > 1;
+    }
+
 private:
     ExpressionFieldPath(const std::string& fieldPath, Variables::Id variable);
 
@@ -772,6 +780,9 @@ private:
 
     const FieldPath _fieldPath;
     const Variables::Id _variable;
+
+    // The names in _fieldPath, hashed once rather than for each Document they are looked up in.
+    std::vector<HashedFieldName> _fieldNames;
 };
 
 
@@ -1057,6 +1068,12 @@ public:
         _excludeId = b;
     }
 
+    /**
+     * Returns whether the field 'fieldName' is included from the input document unchanged, which
+     * is also true of _id at the root unless it is excluded or computed.
+     */
+    bool passesThroughField(const std::string& fieldName) const;
+
 private:
     explicit ExpressionObject(bool atRoot);
 
@@ -1065,8 +1082,14 @@ private:
     typedef std::map<std::string, boost::intrusive_ptr<Expression>> FieldMap;
     FieldMap _expressions;
 
-    // this is used to maintain order for generated fields not in the source document
-    std::vector<std::string> _order;
+    // this is used to maintain order for generated fields not in the source document. The names
+    // are hashed once, for looking them up in and adding them to each Document. Each field points
+    // at its entry in _expressions, which std::map never moves, so evaluating doesn't look it up.
+    struct OrderedField {
+        HashedFieldName name;
+        const boost::intrusive_ptr<Expression>* expr;
+    };
+    std::vector<OrderedField> _order;
 
     bool _excludeId;
     bool _atRoot;
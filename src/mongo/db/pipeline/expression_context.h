@@ -53,6 +53,9 @@ public:
 
     bool inShard = false;
     bool inRouter = false;
+    // Set by mongos when a collection read by a stage such as $lookup, rather than the one being
+    // aggregated, is sharded.
+    bool readsShardedCollections = false;
     bool extSortAllowed = false;
     bool bypassDocumentValidation = false;
 
@@ -2116,6 +2116,36 @@ public:
     }
 };
 
+/** Result order based on source document field order, in a source document with enough fields to
+ * be looked up by hash, and with _id not in the first position. */
+class SourceOrderManyFields : public ExpectedResultBase {
+public:
+    virtual BSONObj source() {
+        return BSON("z" << 1 << "b" << 2 << "_id" << 0 << "y" << 3 << "a" << 4 << "x" << 5);
+    }
+    void prepareExpression() {
+        expression()->includePath("a");
+        expression()->addField(mongo::FieldPath("c"), ExpressionConstant::create(Value(6)));
+        expression()->addField(mongo::FieldPath("y"), ExpressionConstant::create(Value(7)));
+        expression()->includePath("z");
+    }
+    BSONObj expected() {
+        return BSON("z" << 1 << "_id" << 0 << "y" << 7 << "a" << 4 << "c" << 6);
+    }
+    BSONArray expectedDependencies() {
+        return BSON_ARRAY("_id"
+                          << "a"
+                          << "z");
+    }
+    BSONObj expectedBsonRepresentation() {
+        return BSON("a" << true << "c" << BSON("$const" << 6) << "y" << BSON("$const" << 7) << "z"
+                        << true);
+    }
+    bool expectedIsSimple() {
+        return false;
+    }
+};
+
 /** Include a nested field. */
 class IncludeNested : public ExpectedResultBase {
 public:
@@ -4438,6 +4468,7 @@ public:
         add<Object::IncludeId>();
         add<Object::ExcludeId>();
         add<Object::SourceOrder>();
+        add<Object::SourceOrderManyFields>();
         add<Object::IncludeNested>();
         add<Object::IncludeTwoNested>();
         add<Object::IncludeTwoParentNested>();
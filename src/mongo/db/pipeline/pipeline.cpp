@@ -58,6 +58,7 @@ const char Pipeline::commandName[] = "aggregate";
 const char Pipeline::pipelineName[] = "pipeline";
 const char Pipeline::explainName[] = "explain";
 const char Pipeline::fromRouterName[] = "fromRouter";
+const char Pipeline::readsShardedCollectionsName[] = "readsShardedCollections";
 const char Pipeline::serverPipelineName[] = "serverPipeline";
 const char Pipeline::mongosPipelineName[] = "mongosPipeline";
 
@@ -119,6 +120,12 @@ intrusive_ptr<Pipeline> Pipeline::parseCommand(string& errmsg,
             continue;
         }
 
+        /* the router found a sharded collection among those read by stages such as $lookup */
+        if (!strcmp(pFieldName, readsShardedCollectionsName)) {
+            pCtx->readsShardedCollections = cmdElement.trueValue();
+            continue;
+        }
+
         if (str::equals(pFieldName, "allowDiskUse")) {
             uassert(16949,
                     str::stream() << "allowDiskUse must be a bool, not a "
@@ -175,8 +182,9 @@ intrusive_ptr<Pipeline> Pipeline::parseCommand(string& errmsg,
 
     // The order in which optimizations are applied can have significant impact on the
     // efficiency of the final pipeline. Be Careful!
+    Optimizations::Local::moveMatchBeforeProject(pPipeline.get());
     Optimizations::Local::moveMatchBeforeSort(pPipeline.get());
-    Optimizations::Local::moveSkipAndLimitBeforeProject(pPipeline.get());
+    Optimizations::Local::moveSkipAndLimitBeforeOneToOneStages(pPipeline.get());
     Optimizations::Local::moveLimitBeforeSkip(pPipeline.get());
     Optimizations::Local::coalesceAdjacent(pPipeline.get());
     Optimizations::Local::optimizeEachDocumentSource(pPipeline.get());
@@ -205,15 +213,51 @@ void Pipeline::Optimizations::Local::moveMatchBeforeSort(Pipeline* pipeline) {
     }
 }
 
-void Pipeline::Optimizations::Local::moveSkipAndLimitBeforeProject(Pipeline* pipeline) {
+void Pipeline::Optimizations::Local::moveMatchBeforeProject(Pipeline* pipeline) {
+    SourceContainer& sources = pipeline->sources;
+    if (sources.empty())
+        return;
+
+    for (int i = sources.size() - 1; i >= 1 /* not looking at 0 */; i--) {
+        auto match = dynamic_cast<DocumentSourceMatch*>(sources[i].get());
+        auto project = dynamic_cast<DocumentSourceProject*>(sources[i - 1].get());
+        if (!match || !project || match->isTextQuery())
+            continue;
+
+        DepsTracker deps;
+        match->getDependencies(&deps);
+        if (deps.needWholeDocument)
+            continue;
+
+        bool passesThrough = true;
+        for (const string& field : deps.fields) {
+            // A project either passes a top-level field through whole or changes it.
+            if (!project->passesThroughField(field.substr(0, field.find('.')))) {
+                passesThrough = false;
+                break;
+            }
+        }
+        if (!passesThrough)
+            continue;
+
+        swap(sources[i], sources[i - 1]);
+
+        // Start at back again, in case the match can also move before an earlier $project.
+        i = sources.size();  // decremented before next pass
+    }
+}
+
+void Pipeline::Optimizations::Local::moveSkipAndLimitBeforeOneToOneStages(Pipeline* pipeline) {
     SourceContainer& sources = pipeline->sources;
     if (sources.empty())
         return;
 
     for (int i = sources.size() - 1; i >= 1 /* not looking at 0 */; i--) {
-        // This optimization only applies when a $project comes before a $skip or $limit.
+        // This optimization only applies when a $project, or a $lookup that doesn't unwind its
+        // results, comes before a $skip or $limit.
         auto project = dynamic_cast<DocumentSourceProject*>(sources[i - 1].get());
-        if (!project)
+        auto lookUp = dynamic_cast<DocumentSourceLookUp*>(sources[i - 1].get());
+        if (!project && !(lookUp && !lookUp->isUnwinding()))
             continue;
 
         auto skip = dynamic_cast<DocumentSourceSkip*>(sources[i].get());
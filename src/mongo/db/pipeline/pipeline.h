@@ -202,6 +202,7 @@ private:
     static const char pipelineName[];
     static const char explainName[];
     static const char fromRouterName[];
+    static const char readsShardedCollectionsName[];
     static const char serverPipelineName[];
     static const char mongosPipelineName[];
 
@@ -32,7 +32,10 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include <set>
+
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/client/read_preference.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/document_validation.h"
@@ -55,9 +58,18 @@
 #include "mongo/db/storage/sorted_data_interface.h"
 #include "mongo/db/s/sharded_connection_info.h"
 #include "mongo/db/s/sharding_state.h"
+#include "mongo/executor/task_executor_pool.h"
+#include "mongo/s/catalog/catalog_cache.h"
+#include "mongo/s/chunk_manager.h"
 #include "mongo/s/chunk_version.h"
+#include "mongo/s/client/shard_registry.h"
+#include "mongo/s/config.h"
+#include "mongo/s/grid.h"
+#include "mongo/s/query/async_results_merger.h"
+#include "mongo/s/query/cluster_client_cursor_params.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -67,6 +79,10 @@ using std::string;
 using std::unique_ptr;
 
 namespace {
+// Attempts of a query against a sharded $lookup foreign collection before giving up on establishing
+// the shard version.
+const size_t kMaxStaleConfigRetries = 10;
+
 class MongodImplementation final : public DocumentSourceNeedsMongod::MongodInterface {
 public:
     MongodImplementation(const intrusive_ptr<ExpressionContext>& ctx)
@@ -116,7 +132,156 @@ public:
         return collection->infoCache()->getIndexUsageStats();
     }
 
+    bool isShardedInCluster(const NamespaceString& ns) final {
+        if (!ShardingState::get(_ctx->opCtx)->enabled()) {
+            // Reading the local collection would silently miss the documents on other shards.
+            uassert(40505,
+                    str::stream() << "cannot read the sharded collection " << ns.ns()
+                                  << " because sharding state is not initialized on this node",
+                    !_ctx->readsShardedCollections);
+            return false;
+        }
+
+        auto dbConfig = grid.catalogCache()->getDatabase(_ctx->opCtx, ns.db().toString());
+        if (dbConfig.getStatus() == ErrorCodes::NamespaceNotFound) {
+            return false;
+        }
+        uassertStatusOK(dbConfig.getStatus());
+        return dbConfig.getValue()->isSharded(ns.ns());
+    }
+
+    std::vector<BSONObj> findSharded(const NamespaceString& ns,
+                                     const BSONObj& query,
+                                     size_t maxMemoryBytes) final {
+        OperationContext* txn = _ctx->opCtx;
+        auto dbConfig = uassertStatusOK(grid.catalogCache()->getDatabase(txn, ns.db().toString()));
+
+        std::shared_ptr<ChunkManager> chunkManager;
+        std::shared_ptr<Shard> primary;
+        dbConfig->getChunkManagerOrPrimary(txn, ns.ns(), chunkManager, primary);
+
+        // Re-target the query until the shards accept our shard version, as mongos does for a
+        // find.
+        for (size_t retries = 1; retries <= kMaxStaleConfigRetries; ++retries) {
+            std::vector<BSONObj> results;
+            Status status = findWithoutRetrying(
+                ns, query, chunkManager.get(), std::move(primary), maxMemoryBytes, &results);
+            if (status.isOK()) {
+                return results;
+            }
+
+            if (!ErrorCodes::isStaleShardingError(status.code()) &&
+                status != ErrorCodes::ShardNotFound) {
+                uassertStatusOK(status);
+            }
+
+            LOG(1) << "Received error status for $lookup query " << query << " on " << ns.ns()
+                   << ", attempt " << retries << " of " << kMaxStaleConfigRetries << ": "
+                   << status;
+
+            const bool staleEpoch = (status == ErrorCodes::StaleEpoch);
+            if (staleEpoch && !dbConfig->reload(txn)) {
+                // The database was dropped.
+                return {};
+            }
+            chunkManager = dbConfig->getChunkManagerIfExists(txn, ns.ns(), true, staleEpoch);
+            if (!chunkManager) {
+                dbConfig->getChunkManagerOrPrimary(txn, ns.ns(), chunkManager, primary);
+            }
+        }
+
+        uasserted(ErrorCodes::StaleShardVersion,
+                  str::stream() << "Retried " << kMaxStaleConfigRetries
+                                << " times without successfully establishing shard version.");
+    }
+
 private:
+    /**
+     * Sends 'query' as a find command to every shard it targets, and collects the results from
+     * all of them into 'results', failing with ExceededMemoryLimit once they take more than
+     * 'maxMemoryBytes'. Exactly one of 'chunkManager' and 'primary' is set, as returned by
+     * DBConfig::getChunkManagerOrPrimary().
+     */
+    Status findWithoutRetrying(const NamespaceString& ns,
+                               const BSONObj& query,
+                               ChunkManager* chunkManager,
+                               std::shared_ptr<Shard> primary,
+                               size_t maxMemoryBytes,
+                               std::vector<BSONObj>* results) {
+        OperationContext* txn = _ctx->opCtx;
+        auto shardRegistry = grid.shardRegistry();
+
+        std::vector<std::shared_ptr<Shard>> shards;
+        if (primary) {
+            shards.emplace_back(std::move(primary));
+        } else {
+            invariant(chunkManager);
+
+            std::set<ShardId> shardIds;
+            chunkManager->getShardIdsForQuery(txn, query, &shardIds);
+            for (auto&& id : shardIds) {
+                auto shard = shardRegistry->getShard(txn, id);
+                if (!shard) {
+                    return {ErrorCodes::ShardNotFound,
+                            str::stream() << "Shard with id: " << id << " is not found."};
+                }
+                shards.emplace_back(std::move(shard));
+            }
+        }
+
+        ClusterClientCursorParams params(ns, ReadPreferenceSetting(ReadPreference::PrimaryOnly));
+        for (auto&& shard : shards) {
+            BSONObjBuilder cmdBuilder;
+            cmdBuilder.append("find", ns.coll());
+            cmdBuilder.append("filter", query);
+
+            const ChunkVersion version = chunkManager
+                ? chunkManager->getVersion(shard->getId())
+                : ChunkVersion::UNSHARDED();
+            version.appendForCommands(&cmdBuilder);
+
+            params.remotes.emplace_back(shard->getId(), cmdBuilder.obj());
+        }
+
+        auto executor = shardRegistry->getExecutorPool()->getArbitraryExecutor();
+        AsyncResultsMerger arm(executor, std::move(params));
+        ON_BLOCK_EXIT([&] {
+            auto killEvent = arm.kill();
+            if (killEvent) {
+                executor->waitForEvent(killEvent);
+            }
+        });
+
+        size_t memoryBytes = 0;
+        while (true) {
+            while (!arm.ready()) {
+                auto nextEvent = arm.nextEvent();
+                if (!nextEvent.isOK()) {
+                    return nextEvent.getStatus();
+                }
+                executor->waitForEvent(nextEvent.getValue());
+            }
+
+            auto next = arm.nextReady();
+            if (!next.isOK()) {
+                return next.getStatus();
+            }
+            if (!next.getValue()) {
+                return Status::OK();
+            }
+            results->push_back(next.getValue()->getOwned());
+            memoryBytes += results->back().objsize();
+            if (memoryBytes > maxMemoryBytes) {
+                return {ErrorCodes::ExceededMemoryLimit,
+                        str::stream() << "$lookup from the sharded collection " << ns.ns()
+                                      << " exceeded its memory limit of " << maxMemoryBytes
+                                      << " bytes for one batch of input documents. Lower "
+                                         "internalLookupShardedBatchSize."};
+            }
+            _ctx->checkForInterrupt();
+        }
+    }
+
     intrusive_ptr<ExpressionContext> _ctx;
     DBDirectClient _client;
 };
@@ -336,9 +501,12 @@ StatusWith<std::unique_ptr<PlanExecutor>> PipelineD::prepareExecutor(
 
     // The only way to get a text score is to let the query system handle the projection. In all
     // other cases, unless the query system can do an index-covered projection and avoid going to
-    // the raw record at all, it is faster to have ParsedDeps filter the fields we need.
+    // the raw record at all, it is faster to have ParsedDeps filter the fields we need. A covered
+    // projection is then left to the DocumentSourceCursor, which can hand the index keys straight
+    // to a $group.
     if (!deps.needTextScore) {
-        plannerOpts |= QueryPlannerParams::NO_UNCOVERED_PROJECTIONS;
+        plannerOpts |= QueryPlannerParams::NO_UNCOVERED_PROJECTIONS |
+            QueryPlannerParams::RETURN_INDEX_KEYS;
     }
 
     BSONObj emptyProjection;
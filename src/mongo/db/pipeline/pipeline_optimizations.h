@@ -53,12 +53,22 @@ public:
     static void moveMatchBeforeSort(Pipeline* pipeline);
 
     /**
-     * Moves skip and limit before any adjacent project phases.
+     * Moves matches before any adjacent project phases that pass every field the match reads
+     * through unchanged.
      *
-     * While this is performance-neutral on its own, it enables other optimizations
-     * such as combining sort and limit.
+     * Such a match accepts the same documents before the project as after it. This lets the
+     * match move on before a sort, and a limit after the project reach the sort.
      */
-    static void moveSkipAndLimitBeforeProject(Pipeline* pipeline);
+    static void moveMatchBeforeProject(Pipeline* pipeline);
+
+    /**
+     * Moves skip and limit before any adjacent project or lookup phases.
+     *
+     * Both output one document per input document, in the same order, so this doesn't
+     * change the result. While this is performance-neutral on its own, it enables other
+     * optimizations such as combining sort and limit into a top-k sort.
+     */
+    static void moveSkipAndLimitBeforeOneToOneStages(Pipeline* pipeline);
 
     /**
      * Moves limits before any adjacent skip phases.
@@ -136,6 +136,88 @@ class SortMatchProjSkipLimBecomesMatchTopKSortSkipProj : public Base {
     }
 };
 
+class MoveMatchBeforeProjectOfItsFields : public Base {
+    string inputPipeJson() override {
+        return "[{$project: {a: 1}}, {$match: {$or: [{a: 1}, {'a.b': 2}], _id: 3}}]";
+    }
+
+    string outputPipeJson() override {
+        return "[{$match: {$or: [{a: 1}, {'a.b': 2}], _id: 3}}, {$project: {a: true}}]";
+    }
+};
+
+class DoNotMoveMatchBeforeProjectOfComputedField : public Base {
+    string inputPipeJson() override {
+        return "[{$project: {a: {$add: ['$b', 1]}}}, {$match: {a: 1}}]";
+    }
+
+    string outputPipeJson() override {
+        return "[{$project: {a: {$add: ['$b', {$const: 1}]}}}, {$match: {a: 1}}]";
+    }
+};
+
+class DoNotMoveMatchBeforeProjectExcludingId : public Base {
+    string inputPipeJson() override {
+        return "[{$project: {_id: 0, a: 1}}, {$match: {_id: 1}}]";
+    }
+
+    string outputPipeJson() override {
+        return "[{$project: {_id: false, a: true}}, {$match: {_id: 1}}]";
+    }
+};
+
+class SortProjMatchLimBecomesMatchTopKSortProj : public Base {
+    string inputPipeJson() override {
+        return "[{$sort: {a: 1}}"
+               ",{$project : {a: 1}}"
+               ",{$match: {a: 1}}"
+               ",{$limit: 5}"
+               "]";
+    }
+
+    string outputPipeJson() override {
+        return "[{$match: {a: 1}}"
+               ",{$sort: {sortKey: {a: 1}, limit: 5}}"
+               ",{$project: {a: true}}"
+               "]";
+    }
+};
+
+class MoveSkipAndLimitBeforeLookup : public Base {
+    string inputPipeJson() override {
+        return "[{$lookup: {from : 'coll2', as : 'same', localField: 'left', foreignField: "
+               "'right'}}"
+               ",{$skip: 2}"
+               ",{$limit: 3}"
+               "]";
+    }
+
+    string outputPipeJson() override {
+        return "[{$limit: 5}"
+               ",{$skip: 2}"
+               ",{$lookup: {from : 'coll2', as : 'same', localField: 'left', foreignField: "
+               "'right'}}"
+               "]";
+    }
+};
+
+class DoNotMoveLimitBeforeUnwindingLookup : public Base {
+    string inputPipeJson() override {
+        return "[{$lookup: {from : 'coll2', as : 'same', localField: 'left', foreignField: "
+               "'right'}}"
+               ",{$unwind: {path: '$same'}}"
+               ",{$limit: 3}"
+               "]";
+    }
+
+    string outputPipeJson() override {
+        return "[{$lookup: {from : 'coll2', as : 'same', localField: 'left', foreignField: "
+               "'right', unwinding: {preserveNullAndEmptyArrays: false}}}"
+               ",{$limit: 3}"
+               "]";
+    }
+};
+
 class RemoveSkipZero : public Base {
     string inputPipeJson() override {
         return "[{$skip: 0}]";
@@ -389,6 +471,30 @@ class JustNeedsNonId : public Base {
     }
 };
 
+class MatchNeedsOnlyItsFields : public Base {
+    string inputPipeJson() {
+        return "[{$limit:1}, {$match: {a: 1}}, {$group: {_id: '$b'}}]";
+    }
+    string shardPipeJson() {
+        return "[{$limit:1}, {$project: {_id: false, a: true, b: true}}]";
+    }
+    string mergePipeJson() {
+        return "[{$limit:1}, {$match: {a: 1}}, {$group: {_id: '$b'}}]";
+    }
+};
+
+class MatchOnDottedPathsNeedsTopLevelFields : public Base {
+    string inputPipeJson() {
+        return "[{$limit:1}, {$match: {'a.0': 5, 'b.c': null}}, {$group: {_id: '$d'}}]";
+    }
+    string shardPipeJson() {
+        return "[{$limit:1}, {$project: {_id: false, a: true, b: true, d: true}}]";
+    }
+    string mergePipeJson() {
+        return "[{$limit:1}, {$match: {'a.0': 5, 'b.c': null}}, {$group: {_id: '$d'}}]";
+    }
+};
+
 class NothingNeeded : public Base {
     string inputPipeJson() {
         return "[{$limit:1}"
@@ -606,6 +712,12 @@ public:
     All() : Suite("pipeline") {}
     void setupTests() {
         add<Optimizations::Local::RemoveSkipZero>();
+        add<Optimizations::Local::MoveMatchBeforeProjectOfItsFields>();
+        add<Optimizations::Local::DoNotMoveMatchBeforeProjectOfComputedField>();
+        add<Optimizations::Local::DoNotMoveMatchBeforeProjectExcludingId>();
+        add<Optimizations::Local::SortProjMatchLimBecomesMatchTopKSortProj>();
+        add<Optimizations::Local::MoveSkipAndLimitBeforeLookup>();
+        add<Optimizations::Local::DoNotMoveLimitBeforeUnwindingLookup>();
         add<Optimizations::Local::MoveLimitBeforeProject>();
         add<Optimizations::Local::MoveSkipBeforeProject>();
         add<Optimizations::Local::MoveMulitipleSkipsAndLimitsBeforeProject>();
@@ -632,6 +744,9 @@ public:
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::NeedWholeDoc>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::JustNeedsId>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::JustNeedsNonId>();
+        add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::MatchNeedsOnlyItsFields>();
+        add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::
+                MatchOnDottedPathsNeedsTopLevelFields>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::NothingNeeded>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::JustNeedsMetadata>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::ShardAlreadyExhaustive>();
@@ -54,6 +54,11 @@ class BSONElement;
  *  concurrently. There are no restrictions on how threads access Value
  *  instances exclusively owned by them, even if they reference the same
  *  storage as Value in other threads.
+ *
+ *  The exception is a Value holding a Document that is still being loaded
+ *  from BSON (see Document::fromBsonWithMetaData). Reading its fields
+ *  changes the storage shared by every copy, so all of its copies must be
+ *  used by one thread at a time until it is fully loaded.
  */
 class Value {
 public:
@@ -0,0 +1,226 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/plan_cache_persister.h"
+
+#include <list>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+namespace {
+
+// One document per collection: {_id: <namespace>, entries: <PlanCache::getWarmStartEntries()>}.
+// The local database is not replicated, so each node keeps the plans it chose itself.
+const char kPlanCacheNamespace[] = "local.plan_cache";
+
+// Room left in a document for its _id and array overhead.
+const int kDocumentSlackBytes = 16 * 1024;
+
+Counter64 planCachePersistPasses;
+Counter64 planCachePersistedEntries;
+
+ServerStatusMetricField<Counter64> planCacheHitsDisplay("query.planCache.hits", &planCacheHits);
+ServerStatusMetricField<Counter64> planCacheMissesDisplay("query.planCache.misses",
+                                                          &planCacheMisses);
+ServerStatusMetricField<Counter64> planCacheReplansDisplay("query.planCache.replans",
+                                                           &planCacheReplans);
+ServerStatusMetricField<Counter64> planCacheWarmStartEntriesDisplay(
+    "query.planCache.warmStartEntries", &planCacheWarmStartEntries);
+ServerStatusMetricField<Counter64> planCachePersistPassesDisplay("query.planCache.persist.passes",
+                                                                 &planCachePersistPasses);
+ServerStatusMetricField<Counter64> planCachePersistedEntriesDisplay(
+    "query.planCache.persist.entries", &planCachePersistedEntries);
+
+class PlanCachePersister : public BackgroundJob {
+public:
+    std::string name() const final {
+        return "PlanCachePersister";
+    }
+
+    void run() final {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        try {
+            OperationContextImpl txn;
+            restorePlanCaches(&txn);
+        } catch (const DBException& ex) {
+            warning() << "Failed to restore saved plan caches: " << ex.toString();
+        }
+
+        while (!inShutdown()) {
+            sleepsecs(internalQueryCachePersistIntervalSecs);
+            if (inShutdown()) {
+                break;
+            }
+
+            try {
+                OperationContextImpl txn;
+                persistPlanCaches(&txn);
+            } catch (const DBException& ex) {
+                warning() << "Failed to save plan caches: " << ex.toString();
+            }
+        }
+    }
+
+private:
+    /**
+     * Warm starts the plan cache of every collection saved in kPlanCacheNamespace.
+     */
+    void restorePlanCaches(OperationContext* txn) {
+        DBDirectClient client(txn);
+        std::unique_ptr<DBClientCursor> cursor = client.query(kPlanCacheNamespace, BSONObj());
+        size_t restored = 0;
+        while (cursor && cursor->more()) {
+            BSONObj doc = cursor->nextSafe().getOwned();
+            if (doc["_id"].type() != String || doc["entries"].type() != Array) {
+                continue;
+            }
+
+            std::vector<BSONObj> entries;
+            for (auto&& entry : doc["entries"].Obj()) {
+                if (entry.type() == Object) {
+                    entries.push_back(entry.Obj());
+                }
+            }
+
+            AutoGetCollectionForRead ctx(txn, NamespaceString(doc["_id"].valueStringData()));
+            Collection* collection = ctx.getCollection();
+            if (!collection) {
+                continue;
+            }
+            restored += collection->infoCache()->getPlanCache()->warmStart(entries);
+        }
+
+        log() << "Restored " << restored << " saved plan cache entries";
+    }
+
+    /**
+     * Saves the plan cache of every collection with cached plans to kPlanCacheNamespace, and
+     * forgets the collections that no longer exist.
+     */
+    void persistPlanCaches(OperationContext* txn) {
+        std::set<std::string> dbNames;
+        dbHolder().getAllShortNames(dbNames);
+
+        // Take the entries from each cache under the collection lock, then write them without it.
+        std::vector<std::pair<std::string, std::vector<BSONObj>>> caches;
+        BSONArrayBuilder allNamespaces;
+        for (auto&& dbName : dbNames) {
+            ScopedTransaction transaction(txn, MODE_IS);
+            Lock::DBLock dbLock(txn->lockState(), dbName, MODE_IS);
+            Database* db = dbHolder().get(txn, dbName);
+            if (!db) {
+                continue;
+            }
+
+            std::list<std::string> namespaces;
+            db->getDatabaseCatalogEntry()->getCollectionNamespaces(&namespaces);
+            for (auto&& ns : namespaces) {
+                Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IS);
+                Collection* collection = db->getCollection(ns);
+                if (!collection) {
+                    continue;
+                }
+
+                allNamespaces.append(ns);
+                auto entries = collection->infoCache()->getPlanCache()->getWarmStartEntries();
+                if (!entries.empty()) {
+                    caches.emplace_back(ns, std::move(entries));
+                }
+            }
+        }
+
+        planCachePersistPasses.increment();
+
+        DBDirectClient client(txn);
+        for (auto&& cache : caches) {
+            // A cache that was just cleared, for instance by an index build, keeps the plans that
+            // were saved for it earlier.
+            BSONObjBuilder doc;
+            doc.append("_id", cache.first);
+            BSONArrayBuilder entriesBuilder(doc.subarrayStart("entries"));
+            for (auto&& entry : cache.second) {
+                if (entriesBuilder.len() + entry.objsize() >
+                    BSONObjMaxUserSize - kDocumentSlackBytes) {
+                    break;
+                }
+                entriesBuilder.append(entry);
+                planCachePersistedEntries.increment();
+            }
+            entriesBuilder.doneFast();
+
+            client.update(kPlanCacheNamespace, QUERY("_id" << cache.first), doc.obj(), true);
+        }
+
+        client.remove(kPlanCacheNamespace,
+                      BSON("_id" << BSON("$nin" << allNamespaces.arr())));
+    }
+};
+
+// The global PlanCachePersister object is intentionally leaked, like the TTLMonitor.
+PlanCachePersister* planCachePersister = nullptr;
+
+}  // namespace
+
+void startPlanCachePersister() {
+    if (internalQueryCachePersistIntervalSecs <= 0) {
+        return;
+    }
+    planCachePersister = new PlanCachePersister();
+    planCachePersister->go();
+}
+
+}  // namespace mongo
@@ -322,6 +322,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainCommon::EXEC_STATS) {
             bob->appendNumber("nDropped", spec->nDropped);
         }
+    } else if (STAGE_EXCHANGE == stats.stageType) {
+        ExchangeStats* spec = static_cast<ExchangeStats*>(stats.specific.get());
+
+        bob->appendNumber("numWorkers", spec->workers.size());
+        if (verbosity >= ExplainCommon::EXEC_STATS) {
+            bob->appendNumber("batches", spec->batches);
+            BSONArrayBuilder workersBob(bob->subarrayStart("workers"));
+            for (auto&& worker : spec->workers) {
+                BSONObjBuilder workerBob(workersBob.subobjStart());
+                workerBob.appendNumber("docsTested", worker.docsTested);
+                workerBob.appendNumber("docsPassed", worker.docsPassed);
+                workerBob.appendNumber("executionTimeMicros", worker.executionTimeMicros);
+            }
+        }
     } else if (STAGE_FETCH == stats.stageType) {
         FetchStats* spec = static_cast<FetchStats*>(stats.specific.get());
         if (verbosity >= ExplainCommon::EXEC_STATS) {
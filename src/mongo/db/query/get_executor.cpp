@@ -42,6 +42,7 @@
 #include "mongo/db/exec/count.h"
 #include "mongo/db/exec/delete.h"
 #include "mongo/db/exec/eof.h"
+#include "mongo/db/exec/exchange.h"
 #include "mongo/db/exec/group.h"
 #include "mongo/db/exec/idhack.h"
 #include "mongo/db/exec/multi_plan.h"
@@ -170,6 +171,30 @@ void fillOutPlannerParams(OperationContext* txn,
         }
     }
 
+    // A collection scan may read ahead of its parent to filter many documents at once, unless the
+    // plan writes or wants fewer documents than it would read ahead. UPDATE and DELETE skip a
+    // document that lost its RecordId while buffered.
+    const LiteParsedQuery& parsed = canonicalQuery->getParsed();
+    const bool isWrite = plannerParams->options & QueryPlannerParams::PRIVATE_IS_WRITE;
+    const auto wantsFewerThan = [&parsed](long long n) {
+        return (parsed.getLimit() && *parsed.getLimit() < n) ||
+            (parsed.getNToReturn() && *parsed.getNToReturn() < n);
+    };
+
+    // Spread the filter of a scan over a large collection across several threads.
+    const int collscanWorkers = internalQueryExecParallelCollScanWorkers.load();
+    if (collscanWorkers > 1 && !isWrite &&
+        !wantsFewerThan(static_cast<long long>(ExchangeStage::kBatchSize)) &&
+        collection->numRecords(txn) >= internalQueryExecParallelCollScanMinRecords.load()) {
+        plannerParams->collscanParallelism = collscanWorkers;
+    }
+
+    // Filter the documents of a collection scan a block at a time.
+    const int batchMatchSize = internalQueryExecBatchMatchSize.load();
+    if (batchMatchSize > 1 && !isWrite && !wantsFewerThan(batchMatchSize)) {
+        plannerParams->collscanBatchMatchSize = batchMatchSize;
+    }
+
     // If the caller wants a shard filter, make sure we're actually sharded.
     if (plannerParams->options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
         std::shared_ptr<CollectionMetadata> collMetadata =
@@ -306,8 +331,15 @@ Status prepareExecution(OperationContext* opCtx,
 
     // Try to look up a cached solution for the query.
     CachedSolution* rawCS;
-    if (PlanCache::shouldCacheQuery(*canonicalQuery) &&
-        collection->infoCache()->getPlanCache()->get(*canonicalQuery, &rawCS).isOK()) {
+    const bool shouldCache = PlanCache::shouldCacheQuery(*canonicalQuery);
+    const bool cacheHit =
+        shouldCache && collection->infoCache()->getPlanCache()->get(*canonicalQuery, &rawCS).isOK();
+    if (shouldCache && !cacheHit) {
+        planCacheMisses.increment();
+    }
+    if (cacheHit) {
+        planCacheHits.increment();
+
         // We have a CachedSolution.  Have the planner turn it into a QuerySolution.
         unique_ptr<CachedSolution> cs(rawCS);
         QuerySolution* qs;
@@ -715,9 +747,9 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorDelete(OperationContext* txn,
 
     PlanStage* rawRoot;
     QuerySolution* rawQuerySolution;
-    const size_t defaultPlannerOptions = 0;
+    const size_t plannerOptions = QueryPlannerParams::PRIVATE_IS_WRITE;
     Status status = prepareExecution(
-        txn, collection, ws.get(), cq.get(), defaultPlannerOptions, &rawRoot, &rawQuerySolution);
+        txn, collection, ws.get(), cq.get(), plannerOptions, &rawRoot, &rawQuerySolution);
     if (!status.isOK()) {
         return status;
     }
@@ -859,9 +891,9 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorUpdate(OperationContext* txn,
 
     PlanStage* rawRoot;
     QuerySolution* rawQuerySolution;
-    const size_t defaultPlannerOptions = 0;
+    const size_t plannerOptions = QueryPlannerParams::PRIVATE_IS_WRITE;
     Status status = prepareExecution(
-        txn, collection, ws.get(), cq.get(), defaultPlannerOptions, &rawRoot, &rawQuerySolution);
+        txn, collection, ws.get(), cq.get(), plannerOptions, &rawRoot, &rawQuerySolution);
     if (!status.isOK()) {
         return status;
     }
@@ -0,0 +1,328 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/rwlock.h"
+
+namespace mongo {
+
+/**
+ * A thread safe key-value store holding at most a fixed number of entries, for caches which are
+ * read far more often than they are written.
+ *
+ * Entries are spread over a number of partitions by the hash of their key. Each partition has its
+ * own reader-writer lock, so operations on different partitions never wait on each other, and
+ * lookups in the same partition only take the lock in shared mode.
+ *
+ * Recency is approximated with the CLOCK algorithm rather than kept exactly: a lookup sets the
+ * "referenced" bit of its entry instead of moving the entry to the front of a list, and eviction
+ * sweeps a partition's entries in insertion order, clearing referenced bits until it finds an
+ * entry that was not used since the last sweep.
+ *
+ * The keys of generic type K map to values of type V*. The V* pointers are owned by the store.
+ */
+template <class K, class V, class Hash = std::hash<K>>
+class PartitionedClockKeyValue {
+    MONGO_DISALLOW_COPYING(PartitionedClockKeyValue);
+
+public:
+    static const size_t kDefaultNumPartitions = 16;
+
+    PartitionedClockKeyValue(size_t maxSize, size_t numPartitions = kDefaultNumPartitions)
+        : _maxSize(maxSize),
+          _numPartitions(numPartitions),
+          _partitions(new Partition[numPartitions]) {
+        invariant(numPartitions > 0);
+    }
+
+    /**
+     * Adds an (K, V*) pair to the store, taking ownership of 'entry'. If 'key' already exists in
+     * the store, 'entry' replaces what is already there.
+     *
+     * If the store is full, an entry which was not used recently is evicted, preferably from the
+     * partition of 'key', and returned to the caller. The new entry is only evicted right away if
+     * the store can't hold any entries.
+     */
+    std::unique_ptr<V> add(const K& key, V* entry) {
+        std::unique_ptr<V> owned(entry);
+        if (_maxSize == 0) {
+            return owned;
+        }
+
+        const size_t home = partitionIndex(key);
+        std::unique_ptr<V> evicted;
+        {
+            Partition& partition = _partitions[home];
+            SimpleRWLock::Exclusive lk(partition.lock);
+            auto it = partition.map.find(key);
+            if (it != partition.map.end()) {
+                it->second.value = std::move(owned);
+                it->second.referenced.store(1);
+                return evicted;
+            }
+
+            // New entries go just behind the clock hand, so that they survive a full sweep.
+            auto pos = partition.clock.insert(partition.hand, key);
+            partition.map.emplace(std::piecewise_construct,
+                                  std::forward_as_tuple(key),
+                                  std::forward_as_tuple(owned.release(), pos));
+
+            if (static_cast<size_t>(_size.addAndFetch(1)) <= _maxSize) {
+                return evicted;
+            }
+            if (partition.evictOne(&key, &evicted)) {
+                _size.subtractAndFetch(1);
+                return evicted;
+            }
+        }
+
+        // The partition of 'key' holds no other entry, so make room in another one. Only one
+        // partition lock is held at a time.
+        for (size_t i = 1; i < _numPartitions; ++i) {
+            Partition& partition = _partitions[(home + i) % _numPartitions];
+            SimpleRWLock::Exclusive lk(partition.lock);
+            if (partition.evictOne(nullptr, &evicted)) {
+                _size.subtractAndFetch(1);
+                break;
+            }
+        }
+        return evicted;
+    }
+
+    /**
+     * Calls 'func' with a const reference to the value associated with 'key', while the
+     * partition of 'key' is locked in shared mode, and marks the entry as recently used.
+     *
+     * Returns NoSuchKey if there is no such entry, without calling 'func'.
+     */
+    template <typename Func>
+    Status get(const K& key, Func&& func) const {
+        const Partition& partition = _partitions[partitionIndex(key)];
+        SimpleRWLock::Shared lk(partition.lock);
+        auto it = partition.map.find(key);
+        if (it == partition.map.end()) {
+            return Status(ErrorCodes::NoSuchKey, "no such key in partitioned key-value store");
+        }
+
+        // Avoid writing to the cache line of an entry which is already marked.
+        if (!it->second.referenced.load()) {
+            it->second.referenced.store(1);
+        }
+        func(static_cast<const V&>(*it->second.value));
+        return Status::OK();
+    }
+
+    /**
+     * Calls 'func' with a pointer to the value associated with 'key', while the partition of
+     * 'key' is locked in exclusive mode. 'func' may modify the value, but must not keep the
+     * pointer.
+     *
+     * Returns NoSuchKey if there is no such entry, without calling 'func'.
+     */
+    template <typename Func>
+    Status update(const K& key, Func&& func) {
+        Partition& partition = _partitions[partitionIndex(key)];
+        SimpleRWLock::Exclusive lk(partition.lock);
+        auto it = partition.map.find(key);
+        if (it == partition.map.end()) {
+            return Status(ErrorCodes::NoSuchKey, "no such key in partitioned key-value store");
+        }
+        func(it->second.value.get());
+        return Status::OK();
+    }
+
+    /**
+     * Removes the entry keyed by 'key'.
+     */
+    Status remove(const K& key) {
+        Partition& partition = _partitions[partitionIndex(key)];
+        SimpleRWLock::Exclusive lk(partition.lock);
+        auto it = partition.map.find(key);
+        if (it == partition.map.end()) {
+            return Status(ErrorCodes::NoSuchKey, "no such key in partitioned key-value store");
+        }
+        partition.erase(it);
+        _size.subtractAndFetch(1);
+        return Status::OK();
+    }
+
+    /**
+     * Deletes all entries. Entries added by other threads while the store is being cleared may
+     * remain.
+     */
+    void clear() {
+        for (size_t i = 0; i < _numPartitions; ++i) {
+            Partition& partition = _partitions[i];
+            SimpleRWLock::Exclusive lk(partition.lock);
+            _size.subtractAndFetch(partition.map.size());
+            partition.map.clear();
+            partition.clock.clear();
+            partition.hand = partition.clock.end();
+        }
+    }
+
+    /**
+     * Returns true if 'key' has an entry. Does not mark the entry as recently used.
+     */
+    bool hasKey(const K& key) const {
+        const Partition& partition = _partitions[partitionIndex(key)];
+        SimpleRWLock::Shared lk(partition.lock);
+        return partition.map.find(key) != partition.map.end();
+    }
+
+    /**
+     * Returns the number of entries currently in the store.
+     */
+    size_t size() const {
+        return _size.load();
+    }
+
+    /**
+     * Calls 'func(key, value, referenced)' for every entry, one partition at a time, with the
+     * partition locked in shared mode. 'referenced' tells whether the entry was used since the
+     * clock hand last passed it. Does not mark the entries as recently used.
+     */
+    template <typename Func>
+    void forEach(Func&& func) const {
+        for (size_t i = 0; i < _numPartitions; ++i) {
+            const Partition& partition = _partitions[i];
+            SimpleRWLock::Shared lk(partition.lock);
+            for (auto&& keyAndSlot : partition.map) {
+                func(keyAndSlot.first,
+                     static_cast<const V&>(*keyAndSlot.second.value),
+                     keyAndSlot.second.referenced.load() != 0);
+            }
+        }
+    }
+
+private:
+    typedef std::list<K> Clock;
+
+    struct Slot {
+        Slot(V* v, typename Clock::iterator p) : value(v), pos(p) {}
+
+        std::unique_ptr<V> value;
+
+        // The position of this entry's key on the clock.
+        typename Clock::iterator pos;
+
+        // Set to 1 by lookups, and cleared by the clock hand. Readers only hold the partition
+        // lock in shared mode, so this is atomic.
+        mutable AtomicUInt32 referenced;
+    };
+
+    typedef std::unordered_map<K, Slot, Hash> Map;
+
+    struct Partition {
+        Partition() : hand(clock.end()) {}
+
+        /**
+         * Removes the entry at 'it' from the map and the clock.
+         */
+        void erase(typename Map::iterator it) {
+            if (hand == it->second.pos) {
+                hand = clock.erase(it->second.pos);
+            } else {
+                clock.erase(it->second.pos);
+            }
+            map.erase(it);
+        }
+
+        /**
+         * Evicts the first entry the clock hand finds unreferenced, other than the one keyed by
+         * '*keep', into 'evicted'. Every entry is unreferenced after the hand passes it, so this
+         * takes at most two turns of the clock. Returns false if there is no other entry.
+         */
+        bool evictOne(const K* keep, std::unique_ptr<V>* evicted) {
+            const size_t maxSteps = 2 * clock.size() + 1;
+            for (size_t steps = 0; steps < maxSteps; ++steps) {
+                if (hand == clock.end()) {
+                    hand = clock.begin();
+                    if (hand == clock.end()) {
+                        return false;
+                    }
+                }
+
+                if (keep && *hand == *keep) {
+                    ++hand;
+                    continue;
+                }
+
+                auto it = map.find(*hand);
+                invariant(it != map.end());
+                if (it->second.referenced.load()) {
+                    it->second.referenced.store(0);
+                    ++hand;
+                    continue;
+                }
+
+                *evicted = std::move(it->second.value);
+                erase(it);
+                return true;
+            }
+            return false;
+        }
+
+        // Protects the members below, except for the referenced bits of the slots.
+        mutable SimpleRWLock lock;
+
+        Map map;
+
+        // The keys of the partition in insertion order, swept circularly by 'hand'.
+        Clock clock;
+        typename Clock::iterator hand;
+    };
+
+    size_t partitionIndex(const K& key) const {
+        return Hash()(key) % _numPartitions;
+    }
+
+    // The maximum allowable number of entries in the store.
+    const size_t _maxSize;
+
+    const size_t _numPartitions;
+
+    std::unique_ptr<Partition[]> _partitions;
+
+    // The number of entries currently in the store, over all partitions.
+    AtomicInt64 _size;
+};
+
+}  // namespace mongo
@@ -0,0 +1,220 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/partitioned_clock_key_value.h"
+
+#include <vector>
+
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+typedef PartitionedClockKeyValue<int, int> IntCache;
+
+//
+// Convenience functions
+//
+
+void assertInKVStore(const IntCache& cache, int key, int value) {
+    ASSERT_TRUE(cache.hasKey(key));
+    int cachedValue = -1;
+    ASSERT_OK(cache.get(key, [&](const int& v) { cachedValue = v; }));
+    ASSERT_EQUALS(cachedValue, value);
+}
+
+void assertNotInKVStore(const IntCache& cache, int key) {
+    ASSERT_FALSE(cache.hasKey(key));
+    bool called = false;
+    ASSERT_NOT_OK(cache.get(key, [&](const int& v) { called = true; }));
+    ASSERT_FALSE(called);
+}
+
+TEST(PartitionedClockKeyValueTest, BasicAddGet) {
+    IntCache cache(100);
+    ASSERT_FALSE(cache.add(1, new int(2)));
+    assertInKVStore(cache, 1, 2);
+    ASSERT_EQUALS(cache.size(), 1U);
+}
+
+TEST(PartitionedClockKeyValueTest, SizeZeroCache) {
+    IntCache cache(0);
+    std::unique_ptr<int> evicted = cache.add(1, new int(2));
+    ASSERT_TRUE(evicted);
+    ASSERT_EQUALS(*evicted, 2);
+    assertNotInKVStore(cache, 1);
+    ASSERT_EQUALS(cache.size(), 0U);
+}
+
+TEST(PartitionedClockKeyValueTest, AddReplacesExistingEntry) {
+    IntCache cache(10);
+    cache.add(1, new int(2));
+    ASSERT_FALSE(cache.add(1, new int(3)));
+    assertInKVStore(cache, 1, 3);
+    ASSERT_EQUALS(cache.size(), 1U);
+}
+
+TEST(PartitionedClockKeyValueTest, UpdateModifiesEntry) {
+    IntCache cache(10);
+    cache.add(1, new int(2));
+    ASSERT_OK(cache.update(1, [](int* v) { *v += 5; }));
+    assertInKVStore(cache, 1, 7);
+    ASSERT_NOT_OK(cache.update(2, [](int* v) { FAIL("no entry for key 2"); }));
+}
+
+TEST(PartitionedClockKeyValueTest, RemoveAndClear) {
+    IntCache cache(10);
+    for (int i = 0; i < 10; ++i) {
+        cache.add(i, new int(i));
+    }
+    ASSERT_EQUALS(cache.size(), 10U);
+
+    ASSERT_OK(cache.remove(3));
+    ASSERT_NOT_OK(cache.remove(3));
+    assertNotInKVStore(cache, 3);
+    ASSERT_EQUALS(cache.size(), 9U);
+
+    cache.clear();
+    ASSERT_EQUALS(cache.size(), 0U);
+    for (int i = 0; i < 10; ++i) {
+        assertNotInKVStore(cache, i);
+    }
+}
+
+/**
+ * With a single partition, eviction follows the clock: the oldest entry which was not looked up
+ * since it was added goes first.
+ */
+TEST(PartitionedClockKeyValueTest, EvictsUnreferencedEntryFirst) {
+    IntCache cache(3, 1);
+    cache.add(1, new int(1));
+    cache.add(2, new int(2));
+    cache.add(3, new int(3));
+    assertInKVStore(cache, 1, 1);
+
+    std::unique_ptr<int> evicted = cache.add(4, new int(4));
+    ASSERT_TRUE(evicted);
+    ASSERT_EQUALS(*evicted, 2);
+    assertInKVStore(cache, 1, 1);
+    assertNotInKVStore(cache, 2);
+    assertInKVStore(cache, 3, 3);
+    assertInKVStore(cache, 4, 4);
+    ASSERT_EQUALS(cache.size(), 3U);
+}
+
+/**
+ * When every entry was looked up, the clock clears their referenced bits and evicts the first
+ * one it passed.
+ */
+TEST(PartitionedClockKeyValueTest, EvictsWhenAllReferenced) {
+    IntCache cache(2, 1);
+    cache.add(1, new int(1));
+    cache.add(2, new int(2));
+    assertInKVStore(cache, 1, 1);
+    assertInKVStore(cache, 2, 2);
+
+    std::unique_ptr<int> evicted = cache.add(3, new int(3));
+    ASSERT_TRUE(evicted);
+    ASSERT_EQUALS(*evicted, 1);
+    assertInKVStore(cache, 3, 3);
+    ASSERT_EQUALS(cache.size(), 2U);
+}
+
+/**
+ * The size limit holds over all partitions, so a full store evicts from another partition when
+ * the partition of the new key has no other entry.
+ */
+TEST(PartitionedClockKeyValueTest, EvictsFromAnotherPartition) {
+    IntCache cache(1, 4);
+    cache.add(1, new int(1));
+    std::unique_ptr<int> evicted = cache.add(2, new int(2));
+    ASSERT_TRUE(evicted);
+    ASSERT_EQUALS(*evicted, 1);
+    assertNotInKVStore(cache, 1);
+    assertInKVStore(cache, 2, 2);
+    ASSERT_EQUALS(cache.size(), 1U);
+}
+
+TEST(PartitionedClockKeyValueTest, ForEachVisitsAllEntries) {
+    IntCache cache(100);
+    for (int i = 0; i < 50; ++i) {
+        cache.add(i, new int(i * 2));
+    }
+    assertInKVStore(cache, 7, 14);
+
+    std::vector<bool> seen(50, false);
+    size_t numReferenced = 0;
+    cache.forEach([&](const int& key, const int& value, bool referenced) {
+        ASSERT_EQUALS(value, key * 2);
+        ASSERT_FALSE(seen[key]);
+        seen[key] = true;
+        if (referenced) {
+            ASSERT_EQUALS(key, 7);
+            ++numReferenced;
+        }
+    });
+    ASSERT_EQUALS(numReferenced, 1U);
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_TRUE(seen[i]);
+    }
+}
+
+TEST(PartitionedClockKeyValueTest, ConcurrentAddGetRemove) {
+    const size_t maxSize = 64;
+    IntCache cache(maxSize);
+
+    std::vector<stdx::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&cache, t] {
+            for (int i = 0; i < 10000; ++i) {
+                const int key = (i * 7 + t) % 200;
+                if (i % 5 == 0) {
+                    cache.add(key, new int(key));
+                } else if (i % 17 == 0) {
+                    cache.remove(key);
+                } else {
+                    cache.get(key, [key](const int& v) { ASSERT_EQUALS(v, key); });
+                }
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_LESS_THAN_OR_EQUALS(cache.size(), maxSize);
+    size_t count = 0;
+    cache.forEach([&](const int& key, const int& value, bool referenced) { ++count; });
+    ASSERT_EQUALS(count, cache.size());
+}
+
+}  // namespace
@@ -42,6 +42,7 @@
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/query_knobs.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -58,6 +59,120 @@ const char kEncodeChildrenSeparator = ',';
 const char kEncodeSortSection = '~';
 const char kEncodeProjectionSection = '|';
 
+// Stage name of the stand-in ranking stats of entries added by PlanCache::warmStart().
+const char kWarmStartStageType[] = "WARM_START";
+
+void appendIndexTree(const PlanCacheIndexTree& tree, BSONObjBuilder* bob) {
+    if (tree.entry) {
+        bob->append("indexName", tree.entry->name);
+        bob->append("keyPattern", tree.entry->keyPattern);
+        bob->appendNumber("pos", static_cast<long long>(tree.index_pos));
+    }
+
+    BSONArrayBuilder childrenBob(bob->subarrayStart("children"));
+    for (auto&& child : tree.children) {
+        BSONObjBuilder childBob(childrenBob.subobjStart());
+        appendIndexTree(*child, &childBob);
+    }
+}
+
+/**
+ * Rebuilds a tree written by appendIndexTree(), resolving each index it names to one of
+ * 'indexes'. Fails if an index no longer exists.
+ */
+StatusWith<std::unique_ptr<PlanCacheIndexTree>> parseIndexTree(
+    const BSONObj& obj, const std::vector<IndexEntry>& indexes) {
+    auto tree = stdx::make_unique<PlanCacheIndexTree>();
+
+    BSONElement indexName = obj["indexName"];
+    if (indexName.type() == String) {
+        BSONElement keyPattern = obj["keyPattern"];
+        if (keyPattern.type() != Object) {
+            return {ErrorCodes::BadValue, str::stream() << "missing index key pattern: " << obj};
+        }
+
+        auto index = std::find_if(indexes.begin(), indexes.end(), [&](const IndexEntry& ie) {
+            return ie.name == indexName.valueStringData() &&
+                ie.keyPattern.binaryEqual(keyPattern.Obj());
+        });
+        if (index == indexes.end()) {
+            return {ErrorCodes::IndexNotFound,
+                    str::stream() << "index " << indexName.valueStringData() << " "
+                                  << keyPattern.Obj() << " no longer exists"};
+        }
+        tree->setIndexEntry(*index);
+        tree->index_pos = obj["pos"].numberLong();
+    }
+
+    BSONElement children = obj["children"];
+    if (children.type() != Array) {
+        return {ErrorCodes::BadValue, str::stream() << "missing index tree children: " << obj};
+    }
+    for (auto&& child : children.Obj()) {
+        if (child.type() != Object) {
+            return {ErrorCodes::BadValue, str::stream() << "bad index tree child: " << child};
+        }
+        auto childTree = parseIndexTree(child.Obj(), indexes);
+        if (!childTree.isOK()) {
+            return childTree.getStatus();
+        }
+        tree->children.push_back(childTree.getValue().release());
+    }
+
+    return {std::move(tree)};
+}
+
+/**
+ * Rebuilds the cache entry described by an element of PlanCache::getWarmStartEntries(), storing
+ * its key in 'keyOut'.
+ */
+StatusWith<std::unique_ptr<PlanCacheEntry>> parseWarmStartEntry(
+    const BSONObj& obj, const std::vector<IndexEntry>& indexes, PlanCacheKey* keyOut) {
+    BSONElement key = obj["key"];
+    BSONElement solnType = obj["solnType"];
+    if (key.type() != String || !solnType.isNumber() ||
+        solnType.numberInt() < SolutionCacheData::WHOLE_IXSCAN_SOLN ||
+        solnType.numberInt() > SolutionCacheData::USE_INDEX_TAGS_SOLN) {
+        return {ErrorCodes::BadValue, str::stream() << "malformed plan cache entry: " << obj};
+    }
+
+    auto cacheData = stdx::make_unique<SolutionCacheData>();
+    cacheData->solnType = static_cast<SolutionCacheData::SolutionType>(solnType.numberInt());
+    cacheData->wholeIXSolnDir = obj["wholeIXSolnDir"].numberInt();
+    if (cacheData->solnType != SolutionCacheData::COLLSCAN_SOLN) {
+        BSONElement tree = obj["tree"];
+        if (tree.type() != Object) {
+            return {ErrorCodes::BadValue, str::stream() << "missing index tree: " << obj};
+        }
+        auto indexTree = parseIndexTree(tree.Obj(), indexes);
+        if (!indexTree.isOK()) {
+            return indexTree.getStatus();
+        }
+        cacheData->tree = std::move(indexTree.getValue());
+    }
+
+    // The entry was not ranked in this process; its trial period is represented only by the
+    // number of works it took to win, which CachedPlanStage compares against when deciding
+    // whether to replan.
+    auto decision = stdx::make_unique<PlanRankingDecision>();
+    auto stats = stdx::make_unique<PlanStageStats>(CommonStats(kWarmStartStageType), STAGE_UNKNOWN);
+    stats->common.works = obj["decisionWorks"].numberLong();
+    decision->stats.mutableVector().push_back(stats.release());
+    decision->scores.push_back(0);
+    decision->candidateOrder.push_back(0);
+
+    QuerySolution solution;
+    solution.cacheData = std::move(cacheData);
+    auto entry = stdx::make_unique<PlanCacheEntry>(std::vector<QuerySolution*>{&solution},
+                                                   decision.release());
+    entry->query = obj["query"].Obj().getOwned();
+    entry->sort = obj["sort"].Obj().getOwned();
+    entry->projection = obj["projection"].Obj().getOwned();
+
+    *keyOut = key.str();
+    return {std::move(entry)};
+}
+
 /**
  * Encode user-provided string. Cache key delimiters seen in the
  * user string are escaped with a backslash.
@@ -393,6 +508,11 @@ std::string CachedSolution::toString() const {
     return str::stream() << "key: " << key << '\n';
 }
 
+Counter64 planCacheHits;
+Counter64 planCacheMisses;
+Counter64 planCacheReplans;
+Counter64 planCacheWarmStartEntries;
+
 //
 // PlanCacheIndexTree
 //
@@ -652,7 +772,6 @@ Status PlanCache::add(const CanonicalQuery& query,
     }
     entry->projection = projBuilder.obj();
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
 
     if (NULL != evictedEntry.get()) {
@@ -667,17 +786,9 @@ Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const
     PlanCacheKey key = computeKey(query);
     verify(crOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
-    if (!cacheStatus.isOK()) {
-        return cacheStatus;
-    }
-    invariant(entry);
-
-    *crOut = new CachedSolution(key, *entry);
-
-    return Status::OK();
+    return _cache.get(key, [&](const PlanCacheEntry& entry) {
+        *crOut = new CachedSolution(key, entry);
+    });
 }
 
 Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback) {
@@ -687,29 +798,28 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
     std::unique_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
     PlanCacheKey ck = computeKey(cq);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
-    if (!cacheStatus.isOK()) {
+    // We store up to a constant number of feedback entries. Once an entry has all of them, which
+    // is the common case, only take the partition lock in shared mode.
+    const size_t maxFeedback = internalQueryCacheFeedbacksStored;
+    bool full = false;
+    Status cacheStatus = _cache.get(
+        ck, [&](const PlanCacheEntry& entry) { full = entry.feedback.size() >= maxFeedback; });
+    if (!cacheStatus.isOK() || full) {
         return cacheStatus;
     }
-    invariant(entry);
-
-    // We store up to a constant number of feedback entries.
-    if (entry->feedback.size() < size_t(internalQueryCacheFeedbacksStored)) {
-        entry->feedback.push_back(autoFeedback.release());
-    }
 
-    return Status::OK();
+    return _cache.update(ck, [&](PlanCacheEntry* entry) {
+        if (entry->feedback.size() < maxFeedback) {
+            entry->feedback.push_back(autoFeedback.release());
+        }
+    });
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     return _cache.remove(computeKey(canonicalQuery));
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     _cache.clear();
     _writeOperations.store(0);
 }
@@ -726,43 +836,89 @@ Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOu
     PlanCacheKey key = computeKey(query);
     verify(entryOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
-    if (!cacheStatus.isOK()) {
-        return cacheStatus;
-    }
-    invariant(entry);
-
-    *entryOut = entry->clone();
-
-    return Status::OK();
+    return _cache.get(key, [&](const PlanCacheEntry& entry) { *entryOut = entry.clone(); });
 }
 
 std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::vector<PlanCacheEntry*> entries;
-    typedef std::list<std::pair<PlanCacheKey, PlanCacheEntry*>>::const_iterator ConstIterator;
-    for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-        PlanCacheEntry* entry = i->second;
-        entries.push_back(entry->clone());
-    }
+    _cache.forEach([&](const PlanCacheKey& key, const PlanCacheEntry& entry, bool referenced) {
+        entries.push_back(entry.clone());
+    });
 
     return entries;
 }
 
 bool PlanCache::contains(const CanonicalQuery& cq) const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     return _cache.hasKey(computeKey(cq));
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     return _cache.size();
 }
 
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
     _indexabilityState.updateDiscriminators(indexEntries);
+    _indexEntries = indexEntries;
+}
+
+std::vector<BSONObj> PlanCache::getWarmStartEntries() const {
+    std::vector<BSONObj> entries;
+    size_t numReferenced = 0;
+    _cache.forEach([&](const PlanCacheKey& key, const PlanCacheEntry& entry, bool referenced) {
+        // The winning plan is the first one.
+        const SolutionCacheData& winner = *entry.plannerData[0];
+        if (winner.indexFilterApplied) {
+            return;
+        }
+
+        BSONObjBuilder bob;
+        bob.append("key", key);
+        bob.append("query", entry.query);
+        bob.append("sort", entry.sort);
+        bob.append("projection", entry.projection);
+        bob.appendNumber("decisionWorks",
+                         static_cast<long long>(entry.decision->stats[0]->common.works));
+        bob.append("solnType", static_cast<int>(winner.solnType));
+        bob.append("wholeIXSolnDir", winner.wholeIXSolnDir);
+        if (winner.tree) {
+            BSONObjBuilder treeBob(bob.subobjStart("tree"));
+            appendIndexTree(*winner.tree, &treeBob);
+        }
+
+        // Recency is only known as whether an entry was used since the clock last passed it.
+        entries.push_back(bob.obj());
+        if (referenced) {
+            std::swap(entries[numReferenced++], entries.back());
+        }
+    });
+    return entries;
+}
+
+size_t PlanCache::warmStart(const std::vector<BSONObj>& entries) {
+    size_t added = 0;
+
+    // Add the recently used entries last, so that they are the last ones the clock evicts.
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        PlanCacheKey key;
+        auto entry = parseWarmStartEntry(*it, _indexEntries, &key);
+        if (!entry.isOK()) {
+            LOG(2) << _ns << ": not restoring plan cache entry " << *it << ": "
+                   << entry.getStatus();
+            continue;
+        }
+
+        if (_cache.hasKey(key)) {
+            continue;
+        }
+        std::unique_ptr<PlanCacheEntry> evictedEntry =
+            _cache.add(key, entry.getValue().release());
+        ++added;
+    }
+
+    planCacheWarmStartEntries.increment(added);
+    LOG(1) << _ns << ": restored " << added << " of " << entries.size()
+           << " plan cache entries";
+    return added;
 }
 
 }  // namespace mongo
@@ -31,17 +31,24 @@
 #include <set>
 #include <boost/optional/optional.hpp>
 
+#include "mongo/base/counter.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
-#include "mongo/db/query/lru_key_value.h"
+#include "mongo/db/query/partitioned_clock_key_value.h"
 #include "mongo/db/query/plan_cache_indexability.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
-#include "mongo/stdx/mutex.h"
 
 namespace mongo {
 
+// Process-wide counts of plan cache lookups by cacheable queries, of cached plans abandoned for
+// replanning, and of entries restored by PlanCache::warmStart(). Reported by serverStatus.
+extern Counter64 planCacheHits;
+extern Counter64 planCacheMisses;
+extern Counter64 planCacheReplans;
+extern Counter64 planCacheWarmStartEntries;
+
 // A PlanCacheKey is a string-ified version of a query's predicate/projection/sort.
 typedef std::string PlanCacheKey;
 
@@ -370,7 +377,7 @@ public:
 
     /**
      * Returns true if there is an entry in the cache for the 'query'.
-     * Internally calls hasKey() on the LRU cache.
+     * Does not count as a use of the entry.
      */
     bool contains(const CanonicalQuery& cq) const;
 
@@ -388,15 +395,30 @@ public:
      */
     void notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries);
 
+    /**
+     * Returns the key, query shape, and index choices of the winning plan of each entry, recently
+     * used ones first, in the form accepted by warmStart(). Entries created while an index
+     * filter applied are left out, since index filters are not kept across restarts.
+     */
+    std::vector<BSONObj> getWarmStartEntries() const;
+
+    /**
+     * Adds the entries returned by getWarmStartEntries(), possibly in an earlier process, whose
+     * plans only use indexes that still exist with the same name and key pattern. Entries whose
+     * key is already cached are skipped. Returns the number of entries added.
+     *
+     * Callers must hold the collection lock when calling this method.
+     */
+    size_t warmStart(const std::vector<BSONObj>& entries);
+
 private:
     void encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const;
     void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
     void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
-
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    // Partitioned by key, so that lookups of different query shapes don't contend, and lookups
+    // of the same shape only share a lock.
+    PartitionedClockKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
 
     // Counter for write notifications since initialization or last clear() invocation.  Starts
     // at 0.
@@ -411,6 +433,10 @@ private:
     // Concurrent access is synchronized by the collection lock.  Multiple concurrent readers
     // are allowed.
     PlanCacheIndexabilityState _indexabilityState;
+
+    // The collection's indexes, which warm start entries are validated against. Synchronized like
+    // '_indexabilityState'.
+    std::vector<IndexEntry> _indexEntries;
 };
 
 }  // namespace mongo
@@ -388,6 +388,87 @@ TEST(PlanCacheTest, AddValidSolution) {
     ASSERT_EQUALS(planCache.size(), 1U);
 }
 
+/**
+ * Caches an index scan solution over the index {a: 1} named "a_1" for the query {a: 1}.
+ */
+void addIndexedSolution(PlanCache* planCache, const IndexEntry& index) {
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->solnType = SolutionCacheData::USE_INDEX_TAGS_SOLN;
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    PlanCacheIndexTree* child = new PlanCacheIndexTree();
+    child->setIndexEntry(index);
+    child->index_pos = 0;
+    qs.cacheData->tree->children.push_back(child);
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    ASSERT_OK(planCache->add(*cq, solns, createDecision(1U)));
+}
+
+IndexEntry indexA() {
+    return IndexEntry(BSON("a" << 1),
+                      false,    // multikey
+                      false,    // sparse
+                      false,    // unique
+                      "a_1",    // name
+                      nullptr,  // filterExpr
+                      BSONObj());
+}
+
+// Entries saved from one cache can be used to warm start another with the same indexes.
+TEST(PlanCacheTest, WarmStartRoundTrip) {
+    PlanCache planCache;
+    planCache.notifyOfIndexEntries({indexA()});
+    addIndexedSolution(&planCache, indexA());
+
+    std::vector<BSONObj> entries = planCache.getWarmStartEntries();
+    ASSERT_EQUALS(entries.size(), 1U);
+
+    PlanCache restored;
+    restored.notifyOfIndexEntries({indexA()});
+    ASSERT_EQUALS(restored.warmStart(entries), 1U);
+    ASSERT_EQUALS(restored.size(), 1U);
+
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    CachedSolution* rawCachedSoln;
+    ASSERT_OK(restored.get(*cq, &rawCachedSoln));
+    unique_ptr<CachedSolution> cachedSoln(rawCachedSoln);
+    ASSERT_EQUALS(cachedSoln->plannerData.size(), 1U);
+    const SolutionCacheData* data = cachedSoln->plannerData[0];
+    ASSERT_EQUALS(data->solnType, SolutionCacheData::USE_INDEX_TAGS_SOLN);
+    ASSERT_EQUALS(data->tree->children.size(), 1U);
+    ASSERT_EQUALS(data->tree->children[0]->entry->name, "a_1");
+
+    // Warm starting again does not replace the entry.
+    ASSERT_EQUALS(restored.warmStart(entries), 0U);
+    ASSERT_EQUALS(restored.size(), 1U);
+}
+
+// Entries that use an index the collection no longer has are not restored.
+TEST(PlanCacheTest, WarmStartSkipsMissingIndex) {
+    PlanCache planCache;
+    planCache.notifyOfIndexEntries({indexA()});
+    addIndexedSolution(&planCache, indexA());
+    std::vector<BSONObj> entries = planCache.getWarmStartEntries();
+    ASSERT_EQUALS(entries.size(), 1U);
+
+    PlanCache noIndexes;
+    ASSERT_EQUALS(noIndexes.warmStart(entries), 0U);
+    ASSERT_EQUALS(noIndexes.size(), 0U);
+
+    // An index with the same name but a different key pattern is not the same index.
+    PlanCache otherIndex;
+    otherIndex.notifyOfIndexEntries({IndexEntry(BSON("a" << -1),
+                                                false,    // multikey
+                                                false,    // sparse
+                                                false,    // unique
+                                                "a_1",    // name
+                                                nullptr,  // filterExpr
+                                                BSONObj())});
+    ASSERT_EQUALS(otherIndex.warmStart(entries), 0U);
+}
+
 /**
  * Each test in the CachePlanSelectionTest suite goes through
  * the following flow:
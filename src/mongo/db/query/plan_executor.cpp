@@ -314,6 +314,10 @@ void PlanExecutor::invalidate(OperationContext* txn, const RecordId& dl, Invalid
     }
 }
 
+bool PlanExecutor::mayHoldRecordId(const RecordId& dl) const {
+    return !killed() && _root->mayHoldRecordId(dl);
+}
+
 PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, RecordId* dlOut) {
     Snapshotted<BSONObj> snapshotted;
     ExecState state = getNextImpl(objOut ? &snapshotted : NULL, dlOut);
@@ -332,8 +336,22 @@ PlanExecutor::ExecState PlanExecutor::getNextSnapshotted(Snapshotted<BSONObj>* o
     return getNextImpl(objOut, dlOut);
 }
 
-PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut) {
+PlanExecutor::ExecState PlanExecutor::getNextIndexKey(BSONObj* objOut, BSONObj* keyPatternOut) {
+    invariant(objOut && keyPatternOut);
+    Snapshotted<BSONObj> snapshotted;
+    ExecState state = getNextImpl(&snapshotted, NULL, keyPatternOut);
+    *objOut = snapshotted.value();
+    return state;
+}
+
+PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
+                                                  RecordId* dlOut,
+                                                  BSONObj* keyPatternOut) {
     invariant(_currentState == kUsable);
+    if (keyPatternOut) {
+        *keyPatternOut = BSONObj();
+    }
+
     if (killed()) {
         if (NULL != objOut) {
             Status status(ErrorCodes::OperationFailed,
@@ -412,6 +430,9 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
                         // TODO: currently snapshot ids are only associated with documents, and
                         // not with index keys.
                         *objOut = Snapshotted<BSONObj>(SnapshotId(), member->keyData[0].keyData);
+                        if (keyPatternOut) {
+                            *keyPatternOut = member->keyData[0].indexKeyPattern;
+                        }
                     }
                 } else if (member->hasObj()) {
                     *objOut = member->obj;
@@ -289,6 +289,16 @@ public:
     ExecState getNextSnapshotted(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
     ExecState getNext(BSONObj* objOut, RecordId* dlOut);
 
+    /**
+     * Like getNext(), for plans built with QueryPlannerParams::RETURN_INDEX_KEYS. If the next
+     * result is an index key, 'objOut' is set to the key, whose field names are empty, and
+     * 'keyPatternOut' to the key pattern of its index. Otherwise 'objOut' is a document and
+     * 'keyPatternOut' is empty.
+     *
+     * The key pattern may not be owned, and is then only valid until the executor yields.
+     */
+    ExecState getNextIndexKey(BSONObj* objOut, BSONObj* keyPatternOut);
+
     /**
      * Returns 'true' if the plan is done producing results (or writing), 'false' otherwise.
      *
@@ -338,6 +348,11 @@ public:
      */
     void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
 
+    /**
+     * Returns false if invalidate() would change nothing for 'dl', so callers may skip it.
+     */
+    bool mayHoldRecordId(const RecordId& dl) const;
+
     /**
      * Helper method to aid in displaying an ExecState for debug or other recreational purposes.
      */
@@ -370,7 +385,9 @@ public:
     void enqueue(const BSONObj& obj);
 
 private:
-    ExecState getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
+    ExecState getNextImpl(Snapshotted<BSONObj>* objOut,
+                          RecordId* dlOut,
+                          BSONObj* keyPatternOut = nullptr);
 
     /**
      * RAII approach to ensuring that plan executors are deregistered.
@@ -430,7 +447,7 @@ private:
      */
     Status pickBestPlan(YieldPolicy policy);
 
-    bool killed() {
+    bool killed() const {
         return static_cast<bool>(_killReason);
     };
 
@@ -104,6 +104,43 @@ bool scansAreEquivalent(const QuerySolutionNode* lhs, const QuerySolutionNode* r
     return *leftIxscan == *rightIxscan;
 }
 
+/**
+ * Returns true if every node of 'node' may be matched from several threads at once. Other
+ * matchers may build state lazily while matching: $where runs in a single-threaded JavaScript
+ * scope, and a large $geoWithin polygon indexes its edges on first use.
+ */
+bool canMatchConcurrently(const MatchExpression* node) {
+    switch (node->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+        case MatchExpression::SIZE:
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::TYPE_OPERATOR:
+            break;
+        default:
+            return false;
+    }
+
+    for (size_t i = 0; i < node->numChildren(); ++i) {
+        if (!canMatchConcurrently(node->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 }  // namespace
 
 namespace mongo {
@@ -123,6 +160,19 @@ QuerySolutionNode* QueryPlannerAccess::makeCollectionScan(const CanonicalQuery&
     csn->tailable = tailable;
     csn->maxScan = query.getParsed().getMaxScan();
 
+    // The filter is applied on several threads only for a full scan with a non-empty filter that
+    // is safe to share between them.
+    const bool hasFilter = csn->filter &&
+        !(MatchExpression::AND == csn->filter->matchType() && 0 == csn->filter->numChildren());
+    if (params.collscanParallelism > 1 && !tailable && 0 == csn->maxScan && hasFilter &&
+        canMatchConcurrently(csn->filter.get())) {
+        csn->parallelism = params.collscanParallelism;
+    }
+
+    if (!tailable) {
+        csn->batchMatchSize = params.collscanBatchMatchSize;
+    }
+
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
     if (!query.getParsed().getHint().isEmpty()) {
         BSONElement natural = query.getParsed().getHint().getFieldDotted("$natural");
@@ -708,6 +708,7 @@ QuerySolution* QueryPlannerAnalysis::analyzeDataAccess(const CanonicalQuery& que
 
         ProjectionNode::ProjectionType projType = ProjectionNode::DEFAULT;
         BSONObj coveredKeyObj;
+        StageType coveredLeafType = STAGE_UNKNOWN;
 
         if (query.getProj()->requiresDocument()) {
             LOG(5) << "PROJECTION: claims to require doc adding fetch.\n";
@@ -764,6 +765,7 @@ QuerySolution* QueryPlannerAnalysis::analyzeDataAccess(const CanonicalQuery& que
                             projType = ProjectionNode::COVERED_ONE_INDEX;
                             IndexScanNode* ixn = static_cast<IndexScanNode*>(leafNodes[0]);
                             coveredKeyObj = ixn->indexKeyPattern;
+                            coveredLeafType = STAGE_IXSCAN;
                             LOG(5) << "PROJECTION: covered via IXSCAN, using COVERED fast path";
                         } else if (STAGE_DISTINCT_SCAN == leafNodes[0]->getType()) {
                             projType = ProjectionNode::COVERED_ONE_INDEX;
@@ -800,14 +802,23 @@ QuerySolution* QueryPlannerAnalysis::analyzeDataAccess(const CanonicalQuery& que
             solnRoot = keyGenNode;
         }
 
-        // We now know we have whatever data is required for the projection.
-        ProjectionNode* projNode = new ProjectionNode();
-        projNode->children.push_back(solnRoot);
-        projNode->fullExpression = query.root();
-        projNode->projection = lpq.getProj();
-        projNode->projType = projType;
-        projNode->coveredKeyObj = coveredKeyObj;
-        solnRoot = projNode;
+        // A caller that consumes index keys applies a projection covered by an index scan itself,
+        // without building a BSONObj per result.
+        const bool returnIndexKeys = (params.options & QueryPlannerParams::RETURN_INDEX_KEYS) &&
+            ProjectionNode::COVERED_ONE_INDEX == projType && STAGE_IXSCAN == coveredLeafType;
+
+        if (returnIndexKeys) {
+            LOG(5) << "PROJECTION: covered via IXSCAN, returning the index keys";
+        } else {
+            // We now know we have whatever data is required for the projection.
+            ProjectionNode* projNode = new ProjectionNode();
+            projNode->children.push_back(solnRoot);
+            projNode->fullExpression = query.root();
+            projNode->projection = lpq.getProj();
+            projNode->projType = projType;
+            projNode->coveredKeyObj = coveredKeyObj;
+            solnRoot = projNode;
+        }
     } else {
         // If there's no projection, we must fetch, as the user wants the entire doc.
         if (!solnRoot->fetched()) {
@@ -44,6 +44,8 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
 
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(internalQueryCachePersistIntervalSecs, int, 0);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
@@ -66,4 +68,9 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecParallelCollScanWorkers, int, 4);
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecParallelCollScanMinRecords, long long, 1000 * 1000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchMatchSize, int, 256);
+
 }  // namespace mongo
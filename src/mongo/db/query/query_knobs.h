@@ -73,6 +73,10 @@ extern std::atomic<int> internalQueryCacheFeedbacksStored;  // NOLINT
 // and replanning?
 extern AtomicDouble internalQueryCacheEvictionRatio;  // NOLINT
 
+// How often, in seconds, the plan caches are saved so that they can be restored at startup and
+// after an index is dropped. 0 disables saving and restoring them. Only settable at startup.
+extern int internalQueryCachePersistIntervalSecs;
+
 //
 // Planning and enumeration.
 //
@@ -105,6 +109,17 @@ extern std::atomic<int> internalQueryExecYieldIterations;  // NOLINT
 // Yield if it's been at least this many milliseconds since we last yielded.
 extern std::atomic<int> internalQueryExecYieldPeriodMS;  // NOLINT
 
+// How many threads apply the filter of a collection scan over a collection with at least
+// internalQueryExecParallelCollScanMinRecords documents. 1 disables parallel collection scans.
+// Plans that update or delete, and queries whose limit is smaller than a batch, use one thread.
+extern std::atomic<int> internalQueryExecParallelCollScanWorkers;  // NOLINT
+extern std::atomic<long long> internalQueryExecParallelCollScanMinRecords;  // NOLINT
+
+// How many documents a filtered collection scan reads before evaluating its filter over all of
+// them at once. 0 evaluates the filter one document at a time, as do plans that update or delete
+// and queries whose limit is smaller than a block.
+extern std::atomic<int> internalQueryExecBatchMatchSize;  // NOLINT
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
@@ -40,7 +40,9 @@ struct QueryPlannerParams {
     QueryPlannerParams()
         : options(DEFAULT),
           indexFiltersApplied(false),
-          maxIndexedSolutions(internalQueryPlannerMaxIndexedSolutions) {}
+          maxIndexedSolutions(internalQueryPlannerMaxIndexedSolutions),
+          collscanParallelism(1),
+          collscanBatchMatchSize(0) {}
 
     enum Options {
         // You probably want to set this.
@@ -95,6 +97,14 @@ struct QueryPlannerParams {
         // Set this if you don't want any plans with a non-covered projection stage. All projections
         // must be provided/covered by an index.
         NO_UNCOVERED_PROJECTIONS = 1 << 10,
+
+        // Set this if the caller can consume raw index keys. A projection covered by a single index
+        // scan is then left to the caller, and the plan returns the scanned keys as they are.
+        RETURN_INDEX_KEYS = 1 << 11,
+
+        // Nobody should set this above the getExecutor interface.  Internal flag set as a hint
+        // to the planner that the plan feeds an UPDATE or DELETE stage.
+        PRIVATE_IS_WRITE = 1 << 12,
     };
 
     // See Options enum above.
@@ -115,6 +125,13 @@ struct QueryPlannerParams {
     // plans via the MultiPlanStage, and the set of possible plans is very large for certain
     // index+query combinations.
     size_t maxIndexedSolutions;
+
+    // How many threads a collection scan with a filter may apply the filter on.
+    size_t collscanParallelism;
+
+    // How many documents a collection scan with a filter may read before filtering them. 0 filters
+    // one document at a time.
+    size_t collscanBatchMatchSize;
 };
 
 }  // namespace mongo
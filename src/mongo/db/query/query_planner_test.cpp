@@ -1368,6 +1368,29 @@ TEST_F(QueryPlannerTest, ProjNonCovering) {
         "{ixscan: {filter: null, pattern: {x: 1}}}}}}}");
 }
 
+TEST_F(QueryPlannerTest, ReturnIndexKeysCovering) {
+    params.options = QueryPlannerParams::INCLUDE_COLLSCAN | QueryPlannerParams::RETURN_INDEX_KEYS;
+    addIndex(BSON("x" << 1 << "y" << 1));
+    runQuerySortProj(fromjson("{x: {$gt: 1}}"), BSONObj(), fromjson("{_id: 0, x: 1, y: 1}"));
+
+    ASSERT_EQUALS(getNumSolutions(), 2U);
+    assertSolutionExists("{ixscan: {filter: null, pattern: {x: 1, y: 1}}}");
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, x: 1, y: 1}, node: "
+        "{cscan: {dir: 1, filter: {x: {$gt: 1}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ReturnIndexKeysNonCovering) {
+    params.options = QueryPlannerParams::INCLUDE_COLLSCAN | QueryPlannerParams::RETURN_INDEX_KEYS;
+    addIndex(BSON("x" << 1));
+    runQuerySortProj(fromjson("{x: {$gt: 1}}"), BSONObj(), fromjson("{_id: 0, x: 1, y: 1}"));
+
+    ASSERT_EQUALS(getNumSolutions(), 2U);
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, x: 1, y: 1}, node: {fetch: {filter: null, node: "
+        "{ixscan: {filter: null, pattern: {x: 1}}}}}}}");
+}
+
 //
 // Basic sort
 //
@@ -105,7 +105,8 @@ QuerySolutionNode* TextNode::clone() const {
 // CollectionScanNode
 //
 
-CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), maxScan(0) {}
+CollectionScanNode::CollectionScanNode()
+    : tailable(false), direction(1), maxScan(0), parallelism(1), batchMatchSize(0) {}
 
 void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
     addIndent(ss, indent);
@@ -116,6 +117,14 @@ void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent)
         addIndent(ss, indent + 1);
         *ss << "filter = " << filter->toString();
     }
+    if (parallelism > 1) {
+        addIndent(ss, indent + 1);
+        *ss << "parallelism = " << parallelism << '\n';
+    }
+    if (batchMatchSize > 1) {
+        addIndent(ss, indent + 1);
+        *ss << "batchMatchSize = " << batchMatchSize << '\n';
+    }
     addCommon(ss, indent);
 }
 
@@ -128,6 +137,8 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->tailable = this->tailable;
     copy->direction = this->direction;
     copy->maxScan = this->maxScan;
+    copy->parallelism = this->parallelism;
+    copy->batchMatchSize = this->batchMatchSize;
 
     return copy;
 }
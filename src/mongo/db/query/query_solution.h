@@ -290,6 +290,13 @@ struct CollectionScanNode : public QuerySolutionNode {
 
     // maxScan option to .find() limits how many docs we look at.
     int maxScan;
+
+    // If greater than one, the filter is applied on this many threads by an EXCHANGE stage
+    // above an unfiltered COLLSCAN.
+    size_t parallelism;
+
+    // If greater than one, the COLLSCAN filters blocks of this many documents.
+    size_t batchMatchSize;
 };
 
 struct AndHashNode : public QuerySolutionNode {
@@ -39,6 +39,7 @@
 #include "mongo/db/exec/count_scan.h"
 #include "mongo/db/exec/distinct_scan.h"
 #include "mongo/db/exec/ensure_sorted.h"
+#include "mongo/db/exec/exchange.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/geo_near.h"
 #include "mongo/db/exec/index_scan.h"
@@ -78,6 +79,16 @@ PlanStage* buildStages(OperationContext* txn,
         params.direction =
             (csn->direction == 1) ? CollectionScanParams::FORWARD : CollectionScanParams::BACKWARD;
         params.maxScan = csn->maxScan;
+        params.batchMatchSize = csn->batchMatchSize;
+        if (csn->parallelism > 1) {
+            invariant(csn->filter);
+            return new ExchangeStage(txn,
+                                     ws,
+                                     collection,
+                                     csn->filter.get(),
+                                     csn->parallelism,
+                                     new CollectionScan(txn, params, ws, nullptr));
+        }
         return new CollectionScan(txn, params, ws, csn->filter.get());
     } else if (STAGE_IXSCAN == root->getType()) {
         const IndexScanNode* ixn = static_cast<const IndexScanNode*>(root);
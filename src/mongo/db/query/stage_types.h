@@ -61,6 +61,9 @@ enum StageType {
 
     STAGE_EOF,
 
+    // Applies a filter to the results of its child on several threads.
+    STAGE_EXCHANGE,
+
     // This is more of an "internal-only" stage where we try to keep docs that were mutated
     // during query execution.
     STAGE_KEEP_MUTATIONS,
@@ -274,6 +274,8 @@ StatusWith<BSONObj> ReplicationCoordinatorExternalStateImpl::loadLocalConfigDocu
 
 Status ReplicationCoordinatorExternalStateImpl::storeLocalConfigDocument(OperationContext* txn,
                                                                          const BSONObj& config) {
+    // Heartbeats wait for this, so it must not queue behind user operations for a ticket.
+    ScopedAdmissionPriority priority(txn->lockState(), TicketHolder::Priority::kImmediate);
     try {
         MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
             ScopedTransaction transaction(txn, MODE_IX);
@@ -309,6 +311,8 @@ StatusWith<LastVote> ReplicationCoordinatorExternalStateImpl::loadLocalLastVoteD
 
 Status ReplicationCoordinatorExternalStateImpl::storeLocalLastVoteDocument(
     OperationContext* txn, const LastVote& lastVote) {
+    // Elections wait for this, so it must not queue behind user operations for a ticket.
+    ScopedAdmissionPriority priority(txn->lockState(), TicketHolder::Priority::kImmediate);
     BSONObj lastVoteObj = lastVote.toBSON();
     try {
         MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
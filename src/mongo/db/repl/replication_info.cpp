@@ -242,6 +242,10 @@ public:
         result.appendDate("localTime", jsTime());
         result.append("maxWireVersion", WireSpec::instance().maxWireVersionIncoming);
         result.append("minWireVersion", WireSpec::instance().minWireVersionIncoming);
+
+        if (auto port = txn->getClient()->port()) {
+            port->compressorManager().serverNegotiate(cmdObj, &result);
+        }
         return true;
     }
 } cmdismaster;
@@ -50,7 +50,9 @@ OperationContext* StorageInterfaceImpl::createOperationContext() {
         Client::initThreadIfNotAlready();
         AuthorizationSession::get(*ClientBasic::getCurrent())->grantInternalAuthorization();
     }
-    return new OperationContextImpl();
+    auto txn = new OperationContextImpl();
+    txn->lockState()->setAdmissionPriority(TicketHolder::Priority::kHigh);
+    return txn;
 }
 
 StatusWith<size_t> StorageInterfaceImpl::getOplogMaxSize(OperationContext* txn,
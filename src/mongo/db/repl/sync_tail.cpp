@@ -34,6 +34,7 @@
 #include "mongo/db/repl/sync_tail.h"
 
 #include "third_party/murmurhash3/MurmurHash3.h"
+#include <algorithm>
 #include <boost/functional/hash.hpp>
 #include <memory>
 
@@ -53,6 +54,7 @@
 #include "mongo/db/global_timestamp.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/prefetch.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
@@ -61,6 +63,7 @@
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
@@ -102,6 +105,9 @@ public:
 
 } exportedWriterThreadCountParam;
 
+// Whether writer threads apply runs of inserts into the same collection as one batched insert.
+MONGO_EXPORT_SERVER_PARAMETER(replApplyGroupInserts, bool, true);
+
 
 static Counter64 opsAppliedStats;
 
@@ -119,6 +125,22 @@ MONGO_FP_DECLARE(rsSyncApplyStop);
 static TimerStats applyBatchStats;
 static ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches",
                                                                    &applyBatchStats);
+
+// Time spent by the batcher computing writer hashes for each batch, overlapped with application of
+// the previous batch
+static TimerStats prepareBatchStats;
+static ServerStatusMetricField<TimerStats> displayPrepareBatch("repl.apply.prepare",
+                                                               &prepareBatchStats);
+
+// Time spent by the applier assigning the ops of each batch to writer threads
+static TimerStats partitionBatchStats;
+static ServerStatusMetricField<TimerStats> displayPartitionBatch("repl.apply.partition",
+                                                                 &partitionBatchStats);
+
+// Time spent by the applier writing the ops of each batch to the local oplog
+static TimerStats writeOplogStats;
+static ServerStatusMetricField<TimerStats> displayWriteOplog("repl.apply.writeOplog",
+                                                             &writeOplogStats);
 void initializePrefetchThread() {
     if (!ClientBasic::getCurrent()) {
         Client::initThreadIfNotAlready();
@@ -461,8 +483,33 @@ private:
     StringMap<bool> _cache;
 };
 
+SyncTail::WriterHashes computeWriterHashes(const SyncTail::OplogEntry& op) {
+    SyncTail::WriterHashes hashes;
+    hashes.nsHash = StringMapTraits::HashedKey(op.ns).hash();
+    hashes.docHash = hashes.nsHash;
+
+    const char* opType = op.opType.rawData();
+    if (isCrudOpType(opType)) {
+        BSONElement id;
+        switch (opType[0]) {
+            case 'u':
+                id = op.o2.Obj()["_id"];
+                break;
+            case 'd':
+            case 'i':
+                id = op.o.Obj()["_id"];
+                break;
+        }
+
+        const size_t idHash = BSONElement::Hasher()(id);
+        MurmurHash3_x86_32(&idHash, sizeof(idHash), hashes.nsHash, &hashes.docHash);
+    }
+
+    return hashes;
+}
+
 void fillWriterVectors(OperationContext* txn,
-                       const std::deque<SyncTail::OplogEntry>& ops,
+                       const SyncTail::OpQueue& ops,
                        std::vector<std::vector<BSONObj>>* writerVectors) {
     const bool supportsDocLocking =
         getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking();
@@ -472,30 +519,20 @@ void fillWriterVectors(OperationContext* txn,
 
     CachingCappedChecker isCapped;
 
-    for (auto&& op : ops) {
-        StringMapTraits::HashedKey hashedNs(op.ns);
-        uint32_t hash = hashedNs.hash();
-
-        const char* opType = op.opType.rawData();
+    const auto& entries = ops.getDeque();
+    const auto& writerHashes = ops.getWriterHashes();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& op = entries[i];
+        const auto& hashes = writerHashes[i];
+        uint32_t hash = hashes.nsHash;
 
         // For doc locking engines, include the _id of the document in the hash so we get
         // parallelism even if all writes are to a single collection. We can't do this for capped
         // collections because the order of inserts is a guaranteed property, unlike for normal
         // collections.
-        if (supportsDocLocking && isCrudOpType(opType) && !isCapped(txn, hashedNs)) {
-            BSONElement id;
-            switch (opType[0]) {
-                case 'u':
-                    id = op.o2.Obj()["_id"];
-                    break;
-                case 'd':
-                case 'i':
-                    id = op.o.Obj()["_id"];
-                    break;
-            }
-
-            const size_t idHash = BSONElement::Hasher()(id);
-            MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
+        if (supportsDocLocking && isCrudOpType(op.opType.rawData()) &&
+            !isCapped(txn, StringMapTraits::HashedKey(op.ns, hashes.nsHash))) {
+            hash = hashes.docHash;
         }
 
         (*writerVectors)[hash % numWriters].push_back(op.raw);
@@ -504,9 +541,19 @@ void fillWriterVectors(OperationContext* txn,
 
 }  // namespace
 
+void SyncTail::OpQueue::prepare() {
+    // Whether a namespace is capped is only known while holding a lock, so both hashes are
+    // computed here and fillWriterVectors() chooses between them.
+    _writerHashes.clear();
+    _writerHashes.reserve(_deque.size());
+    for (auto&& op : _deque) {
+        _writerHashes.push_back(computeWriterHashes(op));
+    }
+}
+
 // Applies a batch of oplog entries, by using a set of threads to apply the operations and then
 // writes the oplog entries to the local oplog.
-OpTime SyncTail::multiApply(OperationContext* txn, const OpQueue& ops) {
+OpTime SyncTail::multiApply(OperationContext* txn, OpQueue& ops) {
     invariant(_applyFunc);
 
     if (getGlobalServiceContext()->getGlobalStorageEngine()->isMmapV1()) {
@@ -514,9 +561,18 @@ OpTime SyncTail::multiApply(OperationContext* txn, const OpQueue& ops) {
         prefetchOps(ops.getDeque(), &_prefetcherPool);
     }
 
+    // Batches from the OpQueueBatcher have been prepared off this thread already.
+    if (!ops.isPrepared()) {
+        TimerHolder timer(&prepareBatchStats);
+        ops.prepare();
+    }
+
     std::vector<std::vector<BSONObj>> writerVectors(replWriterThreadCount);
 
-    fillWriterVectors(txn, ops.getDeque(), &writerVectors);
+    {
+        TimerHolder timer(&partitionBatchStats);
+        fillWriterVectors(txn, ops, &writerVectors);
+    }
     LOG(2) << "replication batch size is " << ops.getDeque().size() << endl;
     // We must grab this because we're going to grab write locks later.
     // We hold this mutex the entire time we're writing; it doesn't matter
@@ -547,6 +603,7 @@ OpTime SyncTail::multiApply(OperationContext* txn, const OpQueue& ops) {
         for (auto&& op : ops.getDeque()) {
             raws.emplace_back(op.raw);
         }
+        TimerHolder timer(&writeOplogStats);
         lastOpTime = writeOpsToOplog(txn, raws);
     }
 
@@ -681,6 +738,13 @@ private:
                 continue;  // Don't emit empty batches.
             }
 
+            // Hash the batch for partitioning among the writer threads now, while the applier may
+            // still be applying the previous batch.
+            {
+                TimerHolder timer(&prepareBatchStats);
+                ops.prepare();
+            }
+
             stdx::unique_lock<stdx::mutex> lk(_mutex);
             while (!_ops.empty()) {
                 // Block until the previous batch has been taken.
@@ -722,6 +786,7 @@ void SyncTail::oplogApplication(StorageInterface* storageInterface) {
     while (!inShutdown()) {
         OpQueue ops;
         OperationContextImpl txn;
+        txn.lockState()->setAdmissionPriority(TicketHolder::Priority::kHigh);
 
         do {
             if (BackgroundSync::get()->getInitialSyncRequestedFlag()) {
@@ -1006,6 +1071,60 @@ static void initializeWriterThread() {
     }
 }
 
+namespace {
+
+// Bounds on the number of inserts applied together by a writer thread.
+const size_t kMaxInsertGroupSize = 64;
+
+/**
+ * Returns true if 'op' is an insert which may be applied as part of a group of inserts into the
+ * same collection.
+ */
+bool isGroupableInsert(const SyncTail::OplogEntry& op) {
+    return op.opType[0] == 'i' && op.opType[1] == '\0' && op.o.type() == Object &&
+        op.o.Obj().hasField("_id") && nsToCollectionSubstring(op.ns) != "system.indexes";
+}
+
+/**
+ * Applies 'docs', consecutive inserts into 'ns', with a single Collection::insertDocuments()
+ * call in one WriteUnitOfWork. Returns false if this fails for any reason, in which case nothing
+ * has been applied and the caller must apply the inserts one at a time, which also takes care of
+ * creating the collection and converting inserts of existing documents into updates.
+ */
+bool tryApplyInsertGroup(OperationContext* txn, StringData ns, const std::vector<BSONObj>& docs) {
+    if (inShutdown()) {
+        return false;
+    }
+
+    CurOp curOp(txn);
+
+    try {
+        AutoGetCollection autoColl(txn, NamespaceString(ns), MODE_IX);
+        Collection* const collection = autoColl.getCollection();
+        if (!collection) {
+            return false;
+        }
+
+        WriteUnitOfWork wuow(txn);
+        if (!collection->insertDocuments(txn, docs.begin(), docs.end(), true).isOK()) {
+            return false;
+        }
+        wuow.commit();
+    } catch (const DBException& e) {
+        LOG(2) << "failed to apply a group of " << docs.size() << " inserts into " << ns
+               << ", applying them one at a time: " << causedBy(e);
+        return false;
+    }
+
+    for (size_t i = 0; i < docs.size(); ++i) {
+        replOpCounters.gotInsert();
+    }
+    opsAppliedStats.increment(docs.size());
+    return true;
+}
+
+}  // namespace
+
 // This free function is used by the writer threads to apply each op
 void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st) {
     initializeWriterThread();
@@ -1016,27 +1135,80 @@ void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st) {
 
     // allow us to get through the magic barrier
     txn.lockState()->setIsBatchWriter(true);
+    txn.lockState()->setAdmissionPriority(TicketHolder::Priority::kHigh);
 
     // This function is only called in steady state replication.
     bool inSteadyStateReplication = true;
 
-    for (std::vector<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+    std::vector<SyncTail::OplogEntry> entries;
+    entries.reserve(ops.size());
+    for (auto&& op : ops) {
+        entries.emplace_back(op);
+    }
+
+    const bool groupInserts = replApplyGroupInserts.load();
+    if (groupInserts) {
+        // Ops on different namespaces are independent of each other, as commands are applied in
+        // batches of their own. A stable sort by namespace therefore keeps the order of the ops
+        // on each namespace while bringing together the inserts into each collection.
+        std::stable_sort(entries.begin(),
+                         entries.end(),
+                         [](const SyncTail::OplogEntry& l, const SyncTail::OplogEntry& r) {
+                             return l.ns < r.ns;
+                         });
+    }
+
+    auto applyOne = [&](const BSONObj& op) {
         try {
-            const Status s = SyncTail::syncApply(&txn, *it, inSteadyStateReplication);
+            const Status s = SyncTail::syncApply(&txn, op, inSteadyStateReplication);
             if (!s.isOK()) {
-                severe() << "Error applying operation (" << it->toString() << "): " << s;
+                severe() << "Error applying operation (" << op.toString() << "): " << s;
                 fassertFailedNoTrace(16359);
             }
         } catch (const DBException& e) {
             severe() << "writer worker caught exception: " << causedBy(e)
-                     << " on: " << it->toString();
+                     << " on: " << op.toString();
 
             if (inShutdown()) {
-                return;
+                return false;
             }
 
             fassertFailedNoTrace(16360);
         }
+        return true;
+    };
+
+    std::vector<BSONObj> docs;
+    for (auto it = entries.begin(); it != entries.end();) {
+        auto groupEnd = std::next(it);
+        if (groupInserts && isGroupableInsert(*it)) {
+            size_t groupBytes = it->o.Obj().objsize();
+            while (groupEnd != entries.end() && size_t(groupEnd - it) < kMaxInsertGroupSize &&
+                   groupBytes < size_t(insertVectorMaxBytes) && groupEnd->ns == it->ns &&
+                   isGroupableInsert(*groupEnd)) {
+                groupBytes += groupEnd->o.Obj().objsize();
+                ++groupEnd;
+            }
+
+            if (groupEnd - it > 1) {
+                docs.clear();
+                for (auto groupIt = it; groupIt != groupEnd; ++groupIt) {
+                    docs.push_back(groupIt->o.Obj());
+                }
+
+                if (tryApplyInsertGroup(&txn, it->ns, docs)) {
+                    it = groupEnd;
+                    continue;
+                }
+            }
+        }
+
+        // Apply the op, or each op of a group which could not be applied together, on its own.
+        for (; it != groupEnd; ++it) {
+            if (!applyOne(it->raw)) {
+                return;
+            }
+        }
     }
 }
 
@@ -1057,6 +1229,7 @@ Status multiInitialSyncApply_noAbort(OperationContext* txn,
 
     // allow us to get through the magic barrier
     txn->lockState()->setIsBatchWriter(true);
+    txn->lockState()->setAdmissionPriority(TicketHolder::Priority::kHigh);
 
     // This function is only called in initial sync, as its name suggests.
     bool inSteadyStateReplication = false;
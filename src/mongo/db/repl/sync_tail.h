@@ -30,6 +30,7 @@
 
 #include <boost/optional.hpp>
 #include <deque>
+#include <vector>
 
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
@@ -121,6 +122,16 @@ public:
         BSONElement ts;
     };
 
+    /**
+     * The hashes used to assign an op to a writer thread. All ops on a namespace share 'nsHash',
+     * while 'docHash' also includes the _id of the document a CRUD op modifies, so that ops on a
+     * single collection may be spread across writers.
+     */
+    struct WriterHashes {
+        uint32_t nsHash;
+        uint32_t docHash;
+    };
+
     class OpQueue {
     public:
         OpQueue() : _size(0) {}
@@ -134,6 +145,22 @@ public:
             _size += op.raw.objsize();
             _deque.push_back(std::move(op));
         }
+
+        /**
+         * Computes the WriterHashes of every op in the queue. The batcher thread calls this while
+         * the previous batch is being applied, so that only the cheap assignment of ops to writers
+         * is left on the applier thread.
+         */
+        void prepare();
+
+        bool isPrepared() const {
+            return _writerHashes.size() == _deque.size();
+        }
+
+        const std::vector<WriterHashes>& getWriterHashes() const {
+            invariant(isPrepared());
+            return _writerHashes;
+        }
         bool empty() const {
             return _deque.empty();
         }
@@ -150,6 +177,7 @@ public:
 
     private:
         std::deque<OplogEntry> _deque;
+        std::vector<WriterHashes> _writerHashes;
         size_t _size;
     };
 
@@ -199,7 +227,7 @@ protected:
     // Apply a batch of operations, using multiple threads.
     // If boundries is supplied, will update minValid document at begin and end of batch.
     // Returns the last OpTime applied during the apply batch, ops.end["ts"] basically.
-    OpTime multiApply(OperationContext* txn, const OpQueue& ops);
+    OpTime multiApply(OperationContext* txn, OpQueue& ops);
 
 private:
     class OpQueueBatcher;
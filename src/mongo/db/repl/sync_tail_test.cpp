@@ -366,6 +366,58 @@ TEST_F(SyncTailTest, SyncApplyCommandThrowsException) {
     ASSERT_EQUALS(1U, _opsApplied);
 }
 
+TEST_F(SyncTailTest, OpQueuePrepareComputesWriterHashes) {
+    SyncTail::OpQueue ops;
+    ops.push_back(SyncTail::OplogEntry(BSON("op"
+                                            << "i"
+                                            << "ns"
+                                            << "test.t"
+                                            << "o" << BSON("_id" << 1))));
+    ops.push_back(SyncTail::OplogEntry(BSON("op"
+                                            << "u"
+                                            << "ns"
+                                            << "test.t"
+                                            << "o2" << BSON("_id" << 1) << "o"
+                                            << BSON("$set" << BSON("x" << 1)))));
+    ops.push_back(SyncTail::OplogEntry(BSON("op"
+                                            << "d"
+                                            << "ns"
+                                            << "test.t"
+                                            << "o" << BSON("_id" << 2))));
+    ops.push_back(SyncTail::OplogEntry(BSON("op"
+                                            << "c"
+                                            << "ns"
+                                            << "test.$cmd"
+                                            << "o" << BSON("drop"
+                                                           << "t"))));
+    ASSERT_FALSE(ops.isPrepared());
+
+    ops.prepare();
+    ASSERT_TRUE(ops.isPrepared());
+
+    const auto& hashes = ops.getWriterHashes();
+    ASSERT_EQUALS(4U, hashes.size());
+
+    // Every op on a namespace shares the namespace hash.
+    ASSERT_EQUALS(hashes[0].nsHash, hashes[1].nsHash);
+    ASSERT_EQUALS(hashes[0].nsHash, hashes[2].nsHash);
+
+    // CRUD ops on the same document share the document hash, whichever field holds its _id.
+    ASSERT_EQUALS(hashes[0].docHash, hashes[1].docHash);
+    ASSERT_NOT_EQUALS(hashes[0].docHash, hashes[2].docHash);
+
+    // Commands are only partitioned by namespace.
+    ASSERT_EQUALS(hashes[3].nsHash, hashes[3].docHash);
+
+    // Adding an op requires preparing the queue again.
+    ops.push_back(SyncTail::OplogEntry(BSON("op"
+                                            << "n"
+                                            << "ns"
+                                            << ""
+                                            << "o" << BSONObj())));
+    ASSERT_FALSE(ops.isPrepared());
+}
+
 /**
  * Creates a command oplog entry with given optime and namespace.
  */
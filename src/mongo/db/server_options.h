@@ -55,6 +55,8 @@ struct ServerGlobalParams {
           doFork(0),
           socket("/tmp"),
           maxConns(DEFAULT_MAX_CONN),
+          serviceExecutor("synchronous"),
+          serviceExecutorThreads(0),
           unixSocketPermissions(DEFAULT_UNIX_PERMS),
           logAppend(false),
           logRenameOnRotate(true),
@@ -98,6 +100,9 @@ struct ServerGlobalParams {
 
     int maxConns;  // Maximum number of simultaneous open connections.
 
+    std::string serviceExecutor;  // --serviceExecutor, how connections are mapped onto threads
+    int serviceExecutorThreads;   // --serviceExecutorThreads, 0 means one per core
+
     int unixSocketPermissions;  // permissions for the UNIX domain socket
 
     std::string keyFile;  // Path to keyfile, or empty if none.
@@ -53,6 +53,7 @@
 #include "mongo/util/map_util.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/listen.h"  // For DEFAULT_MAX_CONN
+#include "mongo/util/net/message_compressor_registry.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/options_parser/startup_options.h"
 
@@ -206,6 +207,25 @@ Status addGeneralServerOptions(moe::OptionSection* options) {
     options->addOptionChaining(
         "net.maxIncomingConnections", "maxConns", moe::Int, maxConnInfoBuilder.str().c_str());
 
+    options->addOptionChaining("net.serviceExecutor",
+                               "serviceExecutor",
+                               moe::String,
+                               "how client connections are serviced: a dedicated thread per "
+                               "connection (synchronous), or a fixed pool of worker threads "
+                               "servicing connections with ready requests (asio)")
+        .format("(:?synchronous)|(:?asio)", "(synchronous/asio)");
+
+    options->addOptionChaining("net.serviceExecutorThreads",
+                               "serviceExecutorThreads",
+                               moe::Int,
+                               "number of worker threads used by the asio service executor - "
+                               "defaults to the number of cores");
+
+    Status ret = addMessageCompressionOptions(options);
+    if (!ret.isOK()) {
+        return ret;
+    }
+
     options->addOptionChaining(
                  "logpath",
                  "logpath",
@@ -835,6 +855,30 @@ Status storeServerOptions(const moe::Environment& params, const std::vector<std:
         }
     }
 
+    if (params.count("net.serviceExecutor")) {
+        serverGlobalParams.serviceExecutor = params["net.serviceExecutor"].as<std::string>();
+#ifdef _WIN32
+        if (serverGlobalParams.serviceExecutor != "synchronous") {
+            return Status(ErrorCodes::BadValue,
+                          "the asio service executor is not supported on Windows");
+        }
+#endif
+    }
+
+    if (params.count("net.serviceExecutorThreads")) {
+        serverGlobalParams.serviceExecutorThreads =
+            params["net.serviceExecutorThreads"].as<int>();
+
+        if (serverGlobalParams.serviceExecutorThreads < 1) {
+            return Status(ErrorCodes::BadValue, "serviceExecutorThreads has to be at least 1");
+        }
+    }
+
+    ret = storeMessageCompressionOptions(params);
+    if (!ret.isOK()) {
+        return ret;
+    }
+
     if (params.count("net.wireObjectCheck")) {
         serverGlobalParams.objcheck = params["net.wireObjectCheck"].as<bool>();
     }
@@ -48,6 +48,8 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <deque>
+#include <exception>
 #include <snappy.h>
 #include <vector>
 
@@ -59,8 +61,10 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/mongos_options.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
+#include "mongo/util/checksum.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/print.h"
 #include "mongo/util/unowned_ptr.h"
@@ -119,6 +123,11 @@ void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs)
 #endif
 }
 
+// Bounds on how much of a file FileIterator reads at a time. Reading ahead of the block being
+// returned turns the interleaved reads of a merge into fewer, longer sequential ones.
+static const size_t kMinReadAheadBytes = 64 * 1024;
+static const size_t kMaxReadAheadBytes = 8 * 1024 * 1024;
+
 /** Ensures a named file is deleted when this object goes out of scope */
 class FileDeleter {
 public:
@@ -204,6 +213,14 @@ public:
         return out;
     }
 
+    /**
+     * Sets how many bytes to read from the file at a time. This takes effect at the next read, so
+     * it should be called before more() to apply to the whole file.
+     */
+    void setReadAheadBytes(size_t bytes) {
+        _readAheadBytes = bytes;
+    }
+
 private:
     void fillIfNeeded() {
         verify(!_done);
@@ -218,6 +235,10 @@ private:
         if (_done)
             return;
 
+        Checksum expectedChecksum;
+        read(&expectedChecksum, sizeof(expectedChecksum));
+        massert(16816, "file too short?", !_done);
+
         // negative size means compressed
         const bool compressed = rawSize < 0;
         int32_t blockSize = std::abs(rawSize);
@@ -226,6 +247,12 @@ private:
         read(_buffer.get(), blockSize);
         massert(16816, "file too short?", !_done);
 
+        Checksum checksum;
+        checksum.gen(_buffer.get(), blockSize);
+        massert(40504,
+                str::stream() << "checksum mismatch in block of file \"" << _fileName << '"',
+                checksum == expectedChecksum);
+
         auto hooks = WiredTigerCustomizationHooks::get(getGlobalServiceContext());
         if (hooks->enabled()) {
             std::unique_ptr<char[]> out(new char[blockSize]);
@@ -266,30 +293,65 @@ private:
 
     // sets _done to true on EOF - asserts on any other error
     void read(void* out, size_t size) {
-        _file.read(reinterpret_cast<char*>(out), size);
-        if (!_file.good()) {
-            if (_file.eof()) {
-                _done = true;
-                return;
+        char* dest = reinterpret_cast<char*>(out);
+        while (size > 0) {
+            if (_readAheadPos == _readAheadLen) {
+                readAhead();
+                if (_readAheadLen == 0) {
+                    _done = true;
+                    _readAhead.reset();
+                    return;
+                }
             }
 
+            const size_t available = std::min(size, _readAheadLen - _readAheadPos);
+            memcpy(dest, _readAhead.get() + _readAheadPos, available);
+            _readAheadPos += available;
+            dest += available;
+            size -= available;
+        }
+    }
+
+    // Replaces the read-ahead buffer with the next _readAheadBytes of the file, or as many as
+    // remain.
+    void readAhead() {
+        if (_readAheadCapacity != _readAheadBytes) {
+            _readAhead.reset(new char[_readAheadBytes]);
+            _readAheadCapacity = _readAheadBytes;
+        }
+
+        _file.read(_readAhead.get(), _readAheadCapacity);
+        if (!_file.good() && !_file.eof()) {
             msgasserted(16817,
                         str::stream() << "error reading file \"" << _fileName
                                       << "\": " << myErrnoWithDescription());
         }
-        verify(_file.gcount() == static_cast<std::streamsize>(size));
+        _readAheadPos = 0;
+        _readAheadLen = _file.gcount();
     }
 
     const Settings _settings;
     bool _done;
     std::unique_ptr<char[]> _buffer;
     std::unique_ptr<BufReader> _reader;
+    size_t _readAheadBytes = kMinReadAheadBytes;
+    std::unique_ptr<char[]> _readAhead;  // Holds bytes of the file not yet consumed by read().
+    size_t _readAheadCapacity = 0;
+    size_t _readAheadPos = 0;
+    size_t _readAheadLen = 0;
     std::string _fileName;
     std::shared_ptr<FileDeleter> _fileDeleter;  // Must outlive _file
     std::ifstream _file;
 };
 
-/** Merge-sorts results from 0 or more FileIterators */
+/**
+ * Merge-sorts results from 0 or more FileIterators.
+ *
+ * The streams are the leaves of a loser tree: each internal node holds the stream that lost the
+ * match played there and the overall winner is kept on top. Advancing the winner only replays the
+ * matches on its path to the root, so each result costs log2(k) comparisons for k streams, about
+ * half as many as sifting a binary heap.
+ */
 template <typename Key, typename Value, typename Comparator>
 class MergeIterator : public SortIteratorInterface<Key, Value> {
 public:
@@ -303,32 +365,62 @@ public:
         : _opts(opts),
           _remaining(opts.limit ? opts.limit : std::numeric_limits<unsigned long long>::max()),
           _first(true),
-          _greater(comp) {
+          _less(comp) {
+        // The memory limit is no longer needed for unsorted data, so it is spread over the
+        // read-ahead of the files being merged.
+        const size_t readAheadBytes =
+            std::max(kMinReadAheadBytes,
+                     std::min(kMaxReadAheadBytes,
+                              opts.maxMemoryUsageBytes / std::max(iters.size(), size_t(1))));
+        for (auto&& iter : iters) {
+            if (auto file = dynamic_cast<FileIterator<Key, Value>*>(iter.get())) {
+                file->setReadAheadBytes(readAheadBytes);
+            }
+        }
+
         for (size_t i = 0; i < iters.size(); i++) {
             if (iters[i]->more()) {
-                _heap.push_back(std::make_shared<Stream>(i, iters[i]->next(), iters[i]));
+                _streams.push_back(std::make_shared<Stream>(i, iters[i]->next(), iters[i]));
             }
         }
 
-        if (_heap.empty()) {
+        if (_streams.empty()) {
             _remaining = 0;
             return;
         }
 
-        std::make_heap(_heap.begin(), _heap.end(), _greater);
-        std::pop_heap(_heap.begin(), _heap.end(), _greater);
-        _current = _heap.back();
-        _heap.pop_back();
+        // Play the initial tournament bottom-up. Leaf i is node i + k, and the children of node n
+        // are nodes 2n and 2n + 1.
+        const size_t k = _streams.size();
+        std::vector<size_t> winners(2 * k);
+        for (size_t i = 0; i < k; i++) {
+            winners[k + i] = i;
+        }
+
+        _tree.resize(k);
+        for (size_t node = k - 1; node > 0; node--) {
+            const size_t left = winners[2 * node];
+            const size_t right = winners[2 * node + 1];
+            if (beats(right, left)) {
+                winners[node] = right;
+                _tree[node] = left;
+            } else {
+                winners[node] = left;
+                _tree[node] = right;
+            }
+        }
+        _tree[0] = winners[1];
+        _liveStreams = k;
     }
 
     bool more() {
-        if (_remaining > 0 && (_first || !_heap.empty() || _current->more()))
+        if (_remaining > 0 && (_first || _liveStreams > 1 || winner()->more()))
             return true;
 
         // We are done so clean up resources.
         // Can't do this in next() due to lifetime guarantees of unowned Data.
-        _heap.clear();
-        _current.reset();
+        _streams.clear();
+        _tree.clear();
         _remaining = 0;
 
         return false;
@@ -341,22 +433,16 @@ public:
 
         if (_first) {
             _first = false;
-            return _current->current();
+            return winner()->current();
         }
 
-        if (!_current->advance()) {
-            verify(!_heap.empty());
-
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            _current = _heap.back();
-            _heap.pop_back();
-        } else if (!_heap.empty() && _greater(_current, _heap.front())) {
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            std::swap(_current, _heap.back());
-            std::push_heap(_heap.begin(), _heap.end(), _greater);
+        if (!winner()->advance()) {
+            verify(_liveStreams > 1);
+            _liveStreams--;
         }
+        replay();
 
-        return _current->current();
+        return winner()->current();
     }
 
 
@@ -373,44 +459,75 @@ private:
             return _rest->more();
         }
         bool advance() {
-            if (!_rest->more())
+            if (!_rest->more()) {
+                _exhausted = true;
                 return false;
+            }
 
             _current = _rest->next();
             return true;
         }
+        bool exhausted() const {
+            return _exhausted;
+        }
 
         const size_t fileNum;
 
     private:
         Data _current;
         std::shared_ptr<Input> _rest;
+        bool _exhausted = false;
     };
 
-    class STLComparator {  // uses greater rather than less-than to maintain a MinHeap
+    class STLComparator {  // orders streams by their current data
     public:
         explicit STLComparator(const Comparator& comp) : _comp(comp) {}
         bool operator()(unowned_ptr<const Stream> lhs, unowned_ptr<const Stream> rhs) const {
+            // exhausted streams lose every match
+            if (lhs->exhausted() || rhs->exhausted())
+                return !lhs->exhausted();
+
             // first compare data
             dassertCompIsSane(_comp, lhs->current(), rhs->current());
             int ret = _comp(lhs->current(), rhs->current());
             if (ret)
-                return ret > 0;
+                return ret < 0;
 
             // then compare fileNums to ensure stability
-            return lhs->fileNum > rhs->fileNum;
+            return lhs->fileNum < rhs->fileNum;
         }
 
     private:
         const Comparator _comp;
     };
 
+    bool beats(size_t lhs, size_t rhs) const {
+        return _less(_streams[lhs], _streams[rhs]);
+    }
+
+    const std::shared_ptr<Stream>& winner() const {
+        return _streams[_tree[0]];
+    }
+
+    // Replays the matches from the leaf of the previous winner, which has since advanced, to the
+    // root.
+    void replay() {
+        size_t winner = _tree[0];
+        for (size_t node = (winner + _streams.size()) / 2; node > 0; node /= 2) {
+            if (beats(_tree[node], winner)) {
+                std::swap(_tree[node], winner);
+            }
+        }
+        _tree[0] = winner;
+    }
+
     SortOptions _opts;
     unsigned long long _remaining;
     bool _first;
-    std::shared_ptr<Stream> _current;
-    std::vector<std::shared_ptr<Stream>> _heap;  // MinHeap
-    STLComparator _greater;                      // named so calls make sense
+    size_t _liveStreams = 0;
+    std::vector<std::shared_ptr<Stream>> _streams;
+    std::vector<size_t> _tree;  // _tree[0] is the winner; other nodes hold the loser there.
+    STLComparator _less;        // named so calls make sense
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -426,6 +543,18 @@ public:
                   const Settings& settings = Settings())
         : _comp(comp), _settings(settings), _opts(opts), _memUsed(0) {
         verify(_opts.limit == 0);
+
+        // Once data has been spilled, runs being written in the background share the memory
+        // limit with the data being added. Until then a batch may use all of it, so data that fits
+        // in memory is never spilled.
+        _spillThreads = _opts.extSortAllowed ? _opts.spillThreads : 0;
+        _maxBatchMemoryBytes = _opts.maxMemoryUsageBytes / (_spillThreads + 1);
+    }
+
+    ~NoLimitSorter() {
+        for (auto&& spill : _backgroundSpills) {
+            spill->thread.join();
+        }
     }
 
     void add(const Key& key, const Value& val) {
@@ -434,17 +563,18 @@ public:
         _memUsed += key.memUsageForSorter();
         _memUsed += val.memUsageForSorter();
 
-        if (_memUsed > _opts.maxMemoryUsageBytes)
+        if (_memUsed > (_iters.empty() ? _opts.maxMemoryUsageBytes : _maxBatchMemoryBytes))
             spill();
     }
 
     Iterator* done() {
         if (_iters.empty()) {
-            sort();
+            sort(&_data);
             return new InMemIterator<Key, Value>(_data);
         }
 
         spill();
+        waitForSpills(0);
         return Iterator::merge(_iters, _opts, _comp);
     }
 
@@ -456,6 +586,14 @@ public:
         return _memUsed;
     }
 
+    // Runs still being written in the background are counted once they are joined.
+    long long spilledBytes() const {
+        return _spilledBytes;
+    }
+    long long spilledUncompressedBytes() const {
+        return _spilledUncompressedBytes;
+    }
+
 private:
     class STLComparator {
     public:
@@ -469,13 +607,58 @@ private:
         const Comparator& _comp;
     };
 
-    void sort() {
+    /**
+     * A batch of data being sorted and written to a run by its own thread.
+     */
+    struct BackgroundSpill {
+        std::deque<Data> data;
+        size_t runIndex;  // Position of the run in _iters, which keeps runs in the order added.
+        std::shared_ptr<Iterator> run;
+        long long bytesWritten = 0;
+        long long uncompressedBytesWritten = 0;
+        std::exception_ptr error;
+        stdx::thread thread;
+    };
+
+    void sort(std::deque<Data>* data) const {
         STLComparator less(_comp);
-        std::stable_sort(_data.begin(), _data.end(), less);
+        std::stable_sort(data->begin(), data->end(), less);
 
         // Does 2x more compares than stable_sort
         // TODO test on windows
-        // std::sort(_data.begin(), _data.end(), comp);
+        // std::sort(data->begin(), data->end(), comp);
+    }
+
+    std::shared_ptr<Iterator> writeRun(std::deque<Data>* data,
+                                       long long* bytesWritten,
+                                       long long* uncompressedBytesWritten) const {
+        SortedFileWriter<Key, Value> writer(_opts, _settings);
+        for (; !data->empty(); data->pop_front()) {
+            writer.addAlreadySorted(data->front().first, data->front().second);
+        }
+        std::shared_ptr<Iterator> run(writer.done());
+        *bytesWritten += writer.bytesWritten();
+        *uncompressedBytesWritten += writer.uncompressedBytesWritten();
+        return run;
+    }
+
+    /**
+     * Joins the oldest background spills until at most 'maxInProgress' remain, rethrowing any
+     * error they hit.
+     */
+    void waitForSpills(size_t maxInProgress) {
+        while (_backgroundSpills.size() > maxInProgress) {
+            std::unique_ptr<BackgroundSpill> spill = std::move(_backgroundSpills.front());
+            _backgroundSpills.pop_front();
+
+            spill->thread.join();
+            if (spill->error) {
+                std::rethrow_exception(spill->error);
+            }
+            _iters[spill->runIndex] = std::move(spill->run);
+            _spilledBytes += spill->bytesWritten;
+            _spilledUncompressedBytes += spill->uncompressedBytesWritten;
+        }
     }
 
     void spill() {
@@ -494,24 +677,50 @@ private:
                           << " Pass allowDiskUse:true to opt in.");
         }
 
-        sort();
+        _memUsed = 0;
 
-        SortedFileWriter<Key, Value> writer(_opts, _settings);
-        for (; !_data.empty(); _data.pop_front()) {
-            writer.addAlreadySorted(_data.front().first, _data.front().second);
+        // The first batch used the whole memory limit, so there is no room to add data while it
+        // is written.
+        if (_spillThreads == 0 || _iters.empty()) {
+            sort(&_data);
+            _iters.push_back(writeRun(&_data, &_spilledBytes, &_spilledUncompressedBytes));
+            return;
         }
 
-        _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
-
-        _memUsed = 0;
+        // Hand the batch to a new thread once fewer than _spillThreads are still running. The
+        // run takes its place in _iters when the thread is joined.
+        waitForSpills(_spillThreads - 1);
+
+        std::unique_ptr<BackgroundSpill> spill(new BackgroundSpill());
+        spill->data.swap(_data);
+        spill->runIndex = _iters.size();
+        _iters.emplace_back();
+
+        BackgroundSpill* const spillPtr = spill.get();
+        spill->thread = stdx::thread([this, spillPtr] {
+            try {
+                sort(&spillPtr->data);
+                spillPtr->run = writeRun(&spillPtr->data,
+                                         &spillPtr->bytesWritten,
+                                         &spillPtr->uncompressedBytesWritten);
+            } catch (...) {
+                spillPtr->error = std::current_exception();
+            }
+        });
+        _backgroundSpills.push_back(std::move(spill));
     }
 
     const Comparator _comp;
     const Settings _settings;
     SortOptions _opts;
     size_t _memUsed;
+    size_t _spillThreads;
+    size_t _maxBatchMemoryBytes;
+    long long _spilledBytes = 0;
+    long long _spilledUncompressedBytes = 0;
     std::deque<Data> _data;                         // the "current" data
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
+    std::deque<std::unique_ptr<BackgroundSpill>> _backgroundSpills;  // oldest first
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -557,6 +766,13 @@ public:
         return _best.first.memUsageForSorter() + _best.second.memUsageForSorter();
     }
 
+    long long spilledBytes() const {
+        return 0;
+    }
+    long long spilledUncompressedBytes() const {
+        return 0;
+    }
+
 private:
     const Comparator _comp;
     Data _best;
@@ -653,6 +869,13 @@ public:
         return _memUsed;
     }
 
+    long long spilledBytes() const {
+        return _spilledBytes;
+    }
+    long long spilledUncompressedBytes() const {
+        return _spilledUncompressedBytes;
+    }
+
 private:
     class STLComparator {
     public:
@@ -782,6 +1005,8 @@ private:
         std::vector<Data>().swap(_data);
 
         _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+        _spilledBytes += writer.bytesWritten();
+        _spilledUncompressedBytes += writer.uncompressedBytesWritten();
 
         _memUsed = 0;
     }
@@ -790,6 +1015,8 @@ private:
     const Settings _settings;
     SortOptions _opts;
     size_t _memUsed;
+    long long _spilledBytes = 0;
+    long long _spilledUncompressedBytes = 0;
     std::vector<Data> _data;  // the "current" data. Organized as max-heap if size == limit.
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
 
@@ -866,6 +1093,8 @@ void SortedFileWriter<Key, Value>::spill() {
     if (size == 0)
         return;
 
+    _uncompressedBytesWritten += size;
+
     std::string compressed;
     snappy::Compress(outBuffer, size, &compressed);
     verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
@@ -894,11 +1123,16 @@ void SortedFileWriter<Key, Value>::spill() {
         size = resultLen;
     }
 
+    Checksum checksum;
+    checksum.gen(outBuffer, size);
+
     // negative size means compressed
     size = shouldCompress ? -size : size;
     try {
         _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        _file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
         _file.write(outBuffer, std::abs(size));
+        _bytesWritten += sizeof(size) + sizeof(checksum) + std::abs(size);
 
     } catch (const std::exception&) {
         msgasserted(16821,
@@ -97,8 +97,16 @@ struct SortOptions {
     bool extSortAllowed;         /// If false, uassert if more mem needed than allowed.
     std::string tempDir;         /// Directory to directly place files in.
                                  /// Must be explicitly set if extSortAllowed is true.
+    size_t spillThreads;         /// Threads sorting and writing runs in the background while
+                                 /// more data is added. 0 to spill on the adding thread.
+                                 /// Runs after the first get 1/(spillThreads + 1) of the
+                                 /// memory limit each, so the merge reads more of them.
+                                 /// Only used without a limit. Keys and values must be safe to
+                                 /// read on another thread, which lazily loaded Documents
+                                 /// aren't, so aggregation stages leave this at 0.
 
-    SortOptions() : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false) {}
+    SortOptions()
+        : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false), spillThreads(0) {}
 
     /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
 
@@ -121,6 +129,11 @@ struct SortOptions {
         tempDir = newTempDir;
         return *this;
     }
+
+    SortOptions& SpillThreads(size_t newSpillThreads) {
+        spillThreads = newSpillThreads;
+        return *this;
+    }
 };
 
 /// This is the output from the sorting framework
@@ -174,11 +187,20 @@ public:
     virtual int numFiles() const = 0;
     virtual size_t memUsed() const = 0;
 
+    /// Bytes written to temporary files so far, as stored on disk and before compression.
+    virtual long long spilledBytes() const = 0;
+    virtual long long spilledUncompressedBytes() const = 0;
+
 protected:
     Sorter() {}  // can only be constructed as a base
 };
 
-/// Writes pre-sorted data to a sorted file and hands-back an Iterator over that file.
+/**
+ * Writes pre-sorted data to a sorted file and hands-back an Iterator over that file.
+ *
+ * The file is a sequence of blocks of about 64KB of serialized data, each snappy-compressed unless
+ * that saves too little, and stored with its size and a checksum that is verified when it is read.
+ */
 template <typename Key, typename Value>
 class SortedFileWriter {
     MONGO_DISALLOW_COPYING(SortedFileWriter);
@@ -193,10 +215,22 @@ public:
     void addAlreadySorted(const Key&, const Value&);
     Iterator* done();  /// Can't add more data after calling done()
 
+    /// Bytes written to the file so far, which includes everything added once done() is called.
+    long long bytesWritten() const {
+        return _bytesWritten;
+    }
+
+    /// Like bytesWritten(), but counting the data as it was before compression.
+    long long uncompressedBytesWritten() const {
+        return _uncompressedBytesWritten;
+    }
+
 private:
     void spill();
 
     const Settings _settings;
+    long long _bytesWritten = 0;
+    long long _uncompressedBytesWritten = 0;
     std::string _fileName;
     std::shared_ptr<sorter::FileDeleter> _fileDeleter;  // Must outlive _file
     std::ofstream _file;
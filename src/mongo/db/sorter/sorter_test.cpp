@@ -198,6 +198,10 @@ std::shared_ptr<IWIterator> makeInMemIterator(const int(&array)[N]) {
     return std::make_shared<sorter::InMemIterator<IntWrapper, IntWrapper>>(vec);
 }
 
+std::shared_ptr<IWIterator> makeInMemIterator(const std::vector<IWPair>& vec) {
+    return std::make_shared<sorter::InMemIterator<IntWrapper, IntWrapper>>(vec);
+}
+
 template <typename IteratorPtr, int N>
 std::shared_ptr<IWIterator> mergeIterators(IteratorPtr(&array)[N],
                                            Direction Dir = ASC,
@@ -269,8 +273,39 @@ public:
             for (int i = 0; i < 10 * 1000 * 1000; i++)
                 sorter.addAlreadySorted(i, -i);
 
-            ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter.done()),
-                                        make_shared<IntIterator>(0, 10 * 1000 * 1000));
+            std::shared_ptr<IWIterator> iter(sorter.done());
+            ASSERT_EQUALS(sorter.uncompressedBytesWritten(),
+                          static_cast<long long>(10 * 1000 * 1000 * 2 * sizeof(int)));
+            ASSERT_ITERATORS_EQUIVALENT(iter, make_shared<IntIterator>(0, 10 * 1000 * 1000));
+        }
+        {  // compressible
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(opts);
+            for (int i = 0; i < 100 * 1000; i++)
+                sorter.addAlreadySorted(0, 0);
+
+            std::shared_ptr<IWIterator> iter(sorter.done());
+            ASSERT_LESS_THAN(sorter.bytesWritten(), sorter.uncompressedBytesWritten() / 10);
+            ASSERT_ITERATORS_EQUIVALENT(
+                iter, make_shared<LimitIterator>(100 * 1000, make_shared<IntIterator>(0, 1, 0)));
+        }
+        {  // corrupt
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(opts);
+            for (int i = 0; i < 1000; i++)
+                sorter.addAlreadySorted(i, -i);
+            std::shared_ptr<IWIterator> iter(sorter.done());
+
+            // Flip a byte past the block's size and checksum.
+            const boost::filesystem::path file =
+                boost::filesystem::directory_iterator(tempDir.path())->path();
+            std::fstream stream(file.string().c_str(),
+                                std::ios::in | std::ios::out | std::ios::binary);
+            stream.seekg(100);
+            const char byte = stream.get();
+            stream.seekp(100);
+            stream.put(~byte);
+            stream.close();
+
+            ASSERT_THROWS_CODE(iter->more(), MsgAssertionException, 40504);
         }
 
         ASSERT(boost::filesystem::is_empty(tempDir.path()));
@@ -331,6 +366,44 @@ public:
                 mergeIterators(iterators, ASC, SortOptions().Limit(10)),
                 make_shared<LimitIterator>(10, make_shared<IntIterator>(0, 20, 1)));
         }
+        {  // test a number of sources that is not a power of two, some of them short
+            std::shared_ptr<IWIterator> iterators[] = {make_shared<IntIterator>(0, 70, 7),
+                                                       make_shared<IntIterator>(1, 70, 7),
+                                                       make_shared<IntIterator>(2, 10, 7),
+                                                       make_shared<IntIterator>(3, 70, 7),
+                                                       make_shared<EmptyIterator>(),
+                                                       make_shared<IntIterator>(4, 70, 7),
+                                                       make_shared<IntIterator>(5, 70, 7),
+                                                       make_shared<IntIterator>(6, 70, 7)};
+
+            std::vector<IWPair> expected;
+            for (int i = 0; i < 70; i++) {
+                if (i % 7 != 2 || i < 10)
+                    expected.push_back(IWPair(i, -i));
+            }
+
+            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC),
+                                        makeInMemIterator(expected));
+        }
+        {  // test that equal keys come out in the order of their sources
+            const int numSources = 5;
+            std::vector<std::shared_ptr<IWIterator>> iterators;
+            std::vector<IWPair> expected;
+            for (int source = 0; source < numSources; source++) {
+                std::vector<IWPair> data;
+                for (int key = 0; key < 4; key++)
+                    data.push_back(IWPair(key, source));
+                iterators.push_back(makeInMemIterator(data));
+            }
+            for (int key = 0; key < 4; key++) {
+                for (int source = 0; source < numSources; source++)
+                    expected.push_back(IWPair(key, source));
+            }
+
+            std::shared_ptr<IWIterator> mergeIter(
+                IWIterator::merge(iterators, SortOptions(), IWComparator(ASC)));
+            ASSERT_ITERATORS_EQUIVALENT(mergeIter, makeInMemIterator(expected));
+        }
     }
 };
 
@@ -503,6 +576,8 @@ public:
             // don't do this check in subclasses since they may set a limit
             ASSERT_GREATER_THAN_OR_EQUALS(static_cast<size_t>(sorter->numFiles()),
                                           (NUM_ITEMS * sizeof(IWPair)) / MEM_LIMIT);
+            ASSERT_GREATER_THAN(sorter->spilledBytes(), 0);
+            ASSERT_GREATER_THAN(sorter->spilledUncompressedBytes(), 0);
         }
     }
 
@@ -521,6 +596,40 @@ public:
 };
 
 
+template <bool Random = true>
+class LotsOfDataSpilledInBackground : public LotsOfDataLittleMemory<Random> {
+    typedef LotsOfDataLittleMemory<Random> Parent;
+    SortOptions adjustSortOptions(SortOptions opts) {
+        return Parent::adjustSortOptions(opts).SpillThreads(4);
+    }
+    void addData(unowned_ptr<IWSorter> sorter) {
+        Parent::addData(sorter);
+
+        // Each batch after the first only gets a share of the memory limit, since others may be
+        // being spilled.
+        const size_t filesWithoutBackgroundSpills =
+            (Parent::NUM_ITEMS * sizeof(IWPair)) / Parent::MEM_LIMIT;
+        ASSERT_GREATER_THAN_OR_EQUALS(static_cast<size_t>(sorter->numFiles()),
+                                      filesWithoutBackgroundSpills * 4);
+    }
+};
+
+template <bool Random = true>
+class LotsOfDataFitsWithSpillThreads : public LotsOfDataLittleMemory<Random> {
+    typedef LotsOfDataLittleMemory<Random> Parent;
+    SortOptions adjustSortOptions(SortOptions opts) {
+        // The data fits in the memory limit, but not in a share of it.
+        return Parent::adjustSortOptions(opts)
+            .MaxMemoryUsageBytes(Parent::NUM_ITEMS * sizeof(IWPair) * 2)
+            .SpillThreads(4);
+    }
+    void addData(unowned_ptr<IWSorter> sorter) {
+        Parent::addData(sorter);
+        ASSERT_EQUALS(sorter->numFiles(), 0);
+        ASSERT_EQUALS(sorter->spilledBytes(), 0);
+    }
+};
+
 template <long long Limit, bool Random = true>
 class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
     typedef LotsOfDataLittleMemory<Random> Parent;
@@ -563,6 +672,9 @@ public:
         add<SorterTests::Dupes>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/false>>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/true>>();
+        add<SorterTests::LotsOfDataSpilledInBackground</*random=*/false>>();
+        add<SorterTests::LotsOfDataSpilledInBackground</*random=*/true>>();
+        add<SorterTests::LotsOfDataFitsWithSpillThreads</*random=*/true>>();
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/false>>();     // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/true>>();      // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<100, /*random=*/false>>();   // fits in mem
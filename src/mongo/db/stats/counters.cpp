@@ -158,8 +158,54 @@ void NetworkCounter::append(BSONObjBuilder& b) {
     b.append("numRequests", static_cast<long long>(_requests.loadRelaxed()));
 }
 
+void ServiceExecutorCounter::startWaiting() {
+    _waiting.fetchAndAdd(1);
+}
+
+void ServiceExecutorCounter::stopWaiting(bool wasQueued) {
+    if (wasQueued) {
+        _queued.fetchAndSubtract(1);
+    } else {
+        _waiting.fetchAndSubtract(1);
+    }
+}
+
+void ServiceExecutorCounter::requestQueued() {
+    _waiting.fetchAndSubtract(1);
+    _queued.fetchAndAdd(1);
+}
+
+void ServiceExecutorCounter::requestStarted(bool wasQueued) {
+    if (wasQueued) {
+        _queued.fetchAndSubtract(1);
+    } else {
+        _waiting.fetchAndSubtract(1);
+    }
+    _inProgress.fetchAndAdd(1);
+}
+
+void ServiceExecutorCounter::requestFinished() {
+    _inProgress.fetchAndSubtract(1);
+    _completed.fetchAndAdd(1);
+}
+
+void ServiceExecutorCounter::setExecutor(const char* name) {
+    _executor.store(name);
+}
+
+void ServiceExecutorCounter::append(BSONObjBuilder& b) {
+    if (const char* executor = _executor.load()) {
+        b.append("executor", executor);
+    }
+    b.append("waiting", static_cast<long long>(_waiting.loadRelaxed()));
+    b.append("queued", static_cast<long long>(_queued.loadRelaxed()));
+    b.append("inProgress", static_cast<long long>(_inProgress.loadRelaxed()));
+    b.append("completed", static_cast<long long>(_completed.loadRelaxed()));
+}
+
 
 OpCounters globalOpCounters;
 OpCounters replOpCounters;
 NetworkCounter networkCounter;
+ServiceExecutorCounter serviceExecutorCounter;
 }
@@ -30,6 +30,9 @@
 #pragma once
 
 #include "mongo/platform/basic.h"
+
+#include <atomic>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/net/message.h"
@@ -106,4 +109,45 @@ private:
 };
 
 extern NetworkCounter networkCounter;
+
+/**
+ * Tracks how client requests flow through the service executor which maps connections onto the
+ * threads servicing them. A connection is either waiting for its client to send a request, has a
+ * request queued for a worker thread (only with pooled executors), or has one in progress.
+ */
+class ServiceExecutorCounter {
+public:
+    ServiceExecutorCounter() : _waiting(0), _queued(0), _inProgress(0), _completed(0) {}
+
+    // The connection is waiting for its client to send the next request.
+    void startWaiting();
+
+    // The connection was closed before a request was received from it, while either waiting or
+    // queued as indicated by "wasQueued".
+    void stopWaiting(bool wasQueued);
+
+    // The waiting connection's next request is ready and queued for a worker thread.
+    void requestQueued();
+
+    // A thread began processing a request, which was previously queued if "wasQueued" is true,
+    // or received by a waiting connection otherwise.
+    void requestStarted(bool wasQueued);
+
+    void requestFinished();
+
+    // Records the name of the executor servicing connections, once the server has chosen it.
+    // "name" must be a string literal.
+    void setExecutor(const char* name);
+
+    void append(BSONObjBuilder& b);
+
+private:
+    std::atomic<const char*> _executor{nullptr};  // NOLINT
+    AtomicInt64 _waiting;
+    AtomicInt64 _queued;
+    AtomicInt64 _inProgress;
+    AtomicInt64 _completed;
+};
+
+extern ServiceExecutorCounter serviceExecutorCounter;
 }
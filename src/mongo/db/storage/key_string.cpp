@@ -1133,13 +1133,11 @@ std::string KeyString::toString() const {
     return toHex(getBuffer(), getSize());
 }
 
-int KeyString::compare(const KeyString& other) const {
-    int a = getSize();
-    int b = other.getSize();
-
+namespace {
+int compareKeyStringBuffers(const char* leftBuf, int a, const char* rightBuf, int b) {
     int min = std::min(a, b);
 
-    int cmp = memcmp(getBuffer(), other.getBuffer(), min);
+    int cmp = memcmp(leftBuf, rightBuf, min);
 
     if (cmp) {
         if (cmp < 0)
@@ -1154,6 +1152,47 @@ int KeyString::compare(const KeyString& other) const {
 
     return a < b ? -1 : 1;
 }
+}  // namespace
+
+int KeyString::compare(const KeyString& other) const {
+    return compareKeyStringBuffers(getBuffer(), getSize(), other.getBuffer(), other.getSize());
+}
+
+KeyString::Value::Value(const KeyString& ks) : _ksSize(ks.getSize()), _bufSize(ks.getSize()) {
+    const TypeBits& typeBits = ks.getTypeBits();
+    if (!typeBits.isAllZeros())
+        _bufSize += typeBits.getSize();
+
+    _buffer = SharedBuffer::allocate(_bufSize);
+    memcpy(_buffer.get(), ks.getBuffer(), _ksSize);
+    if (_bufSize > _ksSize)
+        memcpy(_buffer.get() + _ksSize, typeBits.getBuffer(), _bufSize - _ksSize);
+}
+
+KeyString::TypeBits KeyString::Value::getTypeBits() const {
+    // An empty buffer decodes as AllZeros.
+    BufReader reader(getBuffer() + _ksSize, _bufSize - _ksSize);
+    return TypeBits::fromBuffer(&reader);
+}
+
+int KeyString::Value::compare(const Value& other) const {
+    return compareKeyStringBuffers(getBuffer(), getSize(), other.getBuffer(), other.getSize());
+}
+
+void KeyString::Value::serializeForSorter(BufBuilder& buf) const {
+    buf.appendNum(_ksSize);
+    buf.appendNum(_bufSize);
+    buf.appendBuf(getBuffer(), _bufSize);
+}
+
+KeyString::Value KeyString::Value::deserializeForSorter(BufReader& buf,
+                                                        const SorterDeserializeSettings&) {
+    const int32_t ksSize = buf.read<int32_t>();
+    const int32_t bufSize = buf.read<int32_t>();
+    SharedBuffer buffer = SharedBuffer::allocate(bufSize);
+    memcpy(buffer.get(), buf.skip(bufSize), bufSize);
+    return Value(std::move(buffer), ksSize, bufSize);
+}
 
 void KeyString::TypeBits::resetFromBuffer(BufReader* reader) {
     if (!reader->remaining()) {
@@ -36,6 +36,7 @@
 #include "mongo/bson/timestamp.h"
 #include "mongo/bson/ordering.h"
 #include "mongo/db/record_id.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -205,6 +206,55 @@ public:
         uint8_t _buf[1 /*size*/ + kMaxBytesNeeded];
     };
 
+    /**
+     * An owned, immutable copy of the bytes and TypeBits of a KeyString, sized to fit them.
+     * Copies share the same buffer, so this is cheap to hold and move around in bulk, such as
+     * when sorting the keys of an index build.
+     */
+    class Value {
+    public:
+        Value() : _ksSize(0), _bufSize(0) {}
+        explicit Value(const KeyString& ks);
+
+        const char* getBuffer() const {
+            return _buffer.get();
+        }
+        size_t getSize() const {
+            return _ksSize;
+        }
+
+        TypeBits getTypeBits() const;
+
+        /**
+         * Compares the encoded keys, ignoring TypeBits, with the same result as
+         * KeyString::compare().
+         */
+        int compare(const Value& other) const;
+
+        BSONObj toBson(Ordering ord) const {
+            return KeyString::toBson(getBuffer(), getSize(), ord, getTypeBits());
+        }
+
+        /// members for Sorter
+        struct SorterDeserializeSettings {};  // unused
+        void serializeForSorter(BufBuilder& buf) const;
+        static Value deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
+        int memUsageForSorter() const {
+            return sizeof(Value) + sizeof(SharedBuffer::Holder) + _bufSize;
+        }
+        Value getOwned() const {
+            return *this;
+        }
+
+    private:
+        Value(SharedBuffer buffer, int32_t ksSize, int32_t bufSize)
+            : _ksSize(ksSize), _bufSize(bufSize), _buffer(std::move(buffer)) {}
+
+        int32_t _ksSize;   // The encoded key, followed in _buffer by its TypeBits unless they
+        int32_t _bufSize;  // are AllZeros.
+        SharedBuffer _buffer;
+    };
+
     enum Discriminator {
         kInclusive,  // Anything to be stored in an index must use this.
         kExclusiveBefore,
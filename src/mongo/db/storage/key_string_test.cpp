@@ -852,3 +852,33 @@ TEST(KeyStringTest, RecordIds) {
         }
     }
 }
+
+TEST(KeyStringTest, ValueSerializesForSorter) {
+    for (BSONObj key : {BSON("" << 5), BSON("" << 5.0 << "" << "abc"), BSON("" << BSONObj())}) {
+        const KeyString ks(key, ONE_DESCENDING);
+        const KeyString::Value value(ks);
+        ASSERT_EQ(value.getSize(), ks.getSize());
+        ASSERT_EQ(memcmp(value.getBuffer(), ks.getBuffer(), ks.getSize()), 0);
+
+        BufBuilder buf;
+        value.serializeForSorter(buf);
+        BufReader reader(buf.buf(), buf.len());
+        const KeyString::Value copy = KeyString::Value::deserializeForSorter(reader, {});
+        ASSERT(reader.atEof());
+
+        ASSERT_EQ(copy.compare(value), 0);
+        ASSERT_EQ(copy.getTypeBits().isAllZeros(), ks.getTypeBits().isAllZeros());
+        ASSERT(copy.toBson(ONE_DESCENDING).binaryEqual(key));
+    }
+}
+
+TEST(KeyStringTest, ValueComparesLikeKeyString) {
+    const BSONObj keys[] = {BSON("" << 1), BSON("" << 1.0), BSON("" << 2), BSON("" << "a")};
+    for (const BSONObj& a : keys) {
+        for (const BSONObj& b : keys) {
+            const KeyString ksA(a, ALL_ASCENDING);
+            const KeyString ksB(b, ALL_ASCENDING);
+            ASSERT_EQ(KeyString::Value(ksA).compare(KeyString::Value(ksB)), ksA.compare(ksB));
+        }
+    }
+}
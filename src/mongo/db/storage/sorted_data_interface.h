@@ -34,6 +34,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/db/storage/key_string.h"
 
 #pragma once
 
@@ -82,6 +83,26 @@ public:
      */
     virtual SortedDataBuilderInterface* getBulkBuilder(OperationContext* txn, bool dupsAllowed) = 0;
 
+    /**
+     * Return true if bulk builders for 'this' index take keys already encoded as KeyStrings with
+     * this index's Ordering, through SortedDataBuilderInterface::addKeyString(). Index builds can
+     * then sort keys by their encoding and never decode them back to BSON.
+     */
+    virtual bool bulkBuildsFromKeyStrings() const {
+        return false;
+    }
+
+    /**
+     * Return ErrorCodes::KeyTooLong if 'key' is too large to be stored in 'this' index, and
+     * Status::OK() otherwise.
+     *
+     * Bulk builders cannot check the size of keys given to them as KeyStrings, so index builds
+     * call this on each key before encoding it. Only used if bulkBuildsFromKeyStrings() is true.
+     */
+    virtual Status checkKeySizeForBulkBuild(const BSONObj& key) const {
+        return Status::OK();
+    }
+
     /**
      * Insert an entry into the index with the specified key and RecordId.
      *
@@ -395,6 +416,16 @@ public:
      */
     virtual Status addKey(const BSONObj& key, const RecordId& loc) = 0;
 
+    /**
+     * Adds 'key', encoded as a KeyString with this index's Ordering and without its RecordId.
+     * Ordering requirements are the same as for addKey(), but the size of the key is not checked.
+     *
+     * Only called if SortedDataInterface::bulkBuildsFromKeyStrings() is true for the index.
+     */
+    virtual Status addKeyString(const KeyString::Value& key, const RecordId& loc) {
+        MONGO_UNREACHABLE;
+    }
+
     /**
      * Do any necessary work to finish building the tree.
      *
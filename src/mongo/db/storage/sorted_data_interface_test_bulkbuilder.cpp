@@ -198,4 +198,70 @@ TEST(SortedDataInterface, BuilderAddMultipleCompoundKeys) {
     }
 }
 
+// Add keys already encoded as KeyStrings using a bulk builder, if the index takes them that way,
+// and verify that they read back as the keys they were encoded from.
+TEST(SortedDataInterface, BuilderAddKeyStrings) {
+    const std::unique_ptr<HarnessHelper> harnessHelper(newHarnessHelper());
+    const std::unique_ptr<SortedDataInterface> sorted(harnessHelper->newSortedDataInterface(false));
+    if (!sorted->bulkBuildsFromKeyStrings()) {
+        return;
+    }
+
+    const Ordering ordering = Ordering::make(BSONObj());
+    const BSONObj doubleKey = BSON("" << 2.5);
+
+    {
+        const std::unique_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        const std::unique_ptr<SortedDataBuilderInterface> builder(
+            sorted->getBulkBuilder(opCtx.get(), true));
+
+        ASSERT_OK(builder->addKeyString(KeyString::Value(KeyString(key1, ordering)), loc1));
+        ASSERT_OK(builder->addKeyString(KeyString::Value(KeyString(key1, ordering)), loc2));
+        ASSERT_OK(builder->addKeyString(KeyString::Value(KeyString(doubleKey, ordering)), loc3));
+        builder->commit(false);
+    }
+
+    {
+        const std::unique_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        const std::unique_ptr<SortedDataInterface::Cursor> cursor(sorted->newCursor(opCtx.get()));
+
+        ASSERT_EQ(cursor->seek(key1, true), IndexKeyEntry(key1, loc1));
+        ASSERT_EQ(cursor->next(), IndexKeyEntry(key1, loc2));
+        auto entry = cursor->next();
+        ASSERT_EQ(entry, IndexKeyEntry(doubleKey, loc3));
+        ASSERT_EQ(entry->key.firstElement().type(), NumberDouble);
+        ASSERT_EQ(cursor->next(), boost::none);
+    }
+}
+
+// Add the same key twice as a KeyString using a bulk builder for a unique index, and verify that
+// the second one is rejected as a duplicate.
+TEST(SortedDataInterface, BuilderAddSameKeyString) {
+    const std::unique_ptr<HarnessHelper> harnessHelper(newHarnessHelper());
+    const std::unique_ptr<SortedDataInterface> sorted(harnessHelper->newSortedDataInterface(true));
+    if (!sorted->bulkBuildsFromKeyStrings()) {
+        return;
+    }
+
+    const Ordering ordering = Ordering::make(BSONObj());
+
+    {
+        const std::unique_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        const std::unique_ptr<SortedDataBuilderInterface> builder(
+            sorted->getBulkBuilder(opCtx.get(), false));
+
+        ASSERT_OK(builder->addKeyString(KeyString::Value(KeyString(key1, ordering)), loc1));
+        ASSERT_EQUALS(
+            ErrorCodes::DuplicateKey,
+            builder->addKeyString(KeyString::Value(KeyString(key1, ordering)), loc2).code());
+        ASSERT_OK(builder->addKeyString(KeyString::Value(KeyString(key2, ordering)), loc3));
+        builder->commit(false);
+    }
+
+    {
+        const std::unique_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        ASSERT_EQUALS(2, sorted->numEntries(opCtx.get()));
+    }
+}
+
 }  // namespace mongo
@@ -0,0 +1,212 @@
+// wiredtiger_capped_visibility.cpp
+
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_capped_visibility.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+WiredTigerCappedVisibility::WiredTigerCappedVisibility(bool deferUntilDurable)
+    : _deferUntilDurable(deferUntilDurable) {}
+
+WiredTigerCappedVisibility::Slot* WiredTigerCappedVisibility::registerId(const RecordId& id) {
+    invariant(id.isNormal());
+
+    Slot* slot;
+    uint64_t numFinishedSeen;
+    bool changed;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        numFinishedSeen = _numFinished.load();
+        changed = _advance_inlock();
+
+        dassert(_slots.empty() || _slots.back().id() < id);
+        _slots.emplace_back(id);
+        slot = &_slots.back();
+
+        // Publish the lowest hidden id before the highest seen one, so that oplogReadTill() never
+        // sees this id as the highest while it isn't hidden yet.
+        if (_slots.size() == 1) {
+            _lowestHidden.store(id.repr());
+        }
+        _highestSeen.store(id.repr());
+    }
+
+    if (changed) {
+        _notifyBecameVisible();
+    }
+    // Slots finished while the mutex was held here may not have been advanced past.
+    if (_numFinished.load() != numFinishedSeen) {
+        _advance();
+    }
+    return slot;
+}
+
+void WiredTigerCappedVisibility::commit(Slot* slot) {
+    // Defer visibility until durable only if new ops were registered while this one was pending.
+    // This makes single-threaded w>1 workloads faster and is safe because durability follows
+    // commit order for commits that are fully sequenced (B doesn't call commit until after A's
+    // commit call returns).
+    if (!_deferUntilDurable || slot->id() == highestSeen()) {
+        _finish(slot);
+        _advance();
+        return;
+    }
+
+    Slot* head = _awaitingDurability.load();
+    do {
+        slot->_nextAwaitingDurability = head;
+    } while (!_awaitingDurability.compare_exchange_weak(head, slot));
+
+    if (!head) {
+        stdx::lock_guard<stdx::mutex> lk(_durabilityMutex);
+        _durabilityCV.notify_one();
+    }
+}
+
+void WiredTigerCappedVisibility::rollback(Slot* slot) {
+    // Ops that didn't commit won't become durable, so there is nothing to wait for.
+    _finish(slot);
+    _advance();
+}
+
+void WiredTigerCappedVisibility::raiseHighestSeen(const RecordId& id) {
+    int64_t current = _highestSeen.load();
+    while (current < id.repr()) {
+        const int64_t previous = _highestSeen.compareAndSwap(current, id.repr());
+        if (previous == current) {
+            return;
+        }
+        current = previous;
+    }
+}
+
+RecordId WiredTigerCappedVisibility::oplogReadTill() const {
+    // Load the highest seen id first. If nothing is hidden afterwards, it and every id before it
+    // have finished.
+    const RecordId highest = highestSeen();
+    const RecordId lowest = lowestHidden();
+    return lowest.isNull() ? highest : lowest;
+}
+
+bool WiredTigerCappedVisibility::waitUntilVisible(const RecordId& id, Milliseconds timeout) const {
+    if (!isHidden(id)) {
+        return true;
+    }
+
+    _numVisibilityWaiters.fetchAndAdd(1);
+    stdx::unique_lock<stdx::mutex> lk(_becameVisibleMutex);
+    const bool visible = _becameVisibleCV.wait_for(lk, timeout, [&] { return !isHidden(id); });
+    _numVisibilityWaiters.fetchAndSubtract(1);
+    return visible;
+}
+
+WiredTigerCappedVisibility::Slot* WiredTigerCappedVisibility::waitForCommitsAwaitingDurability() {
+    stdx::unique_lock<stdx::mutex> lk(_durabilityMutex);
+    _durabilityCV.wait(lk, [&] { return _shuttingDown || _awaitingDurability.load(); });
+    if (_shuttingDown) {
+        return nullptr;
+    }
+    return _awaitingDurability.exchange(nullptr);
+}
+
+void WiredTigerCappedVisibility::markDurable(Slot* commits) {
+    while (commits) {
+        // The slot may be freed as soon as it is finished.
+        Slot* next = commits->_nextAwaitingDurability;
+        _finish(commits);
+        commits = next;
+    }
+    _advance();
+}
+
+void WiredTigerCappedVisibility::shutdown() {
+    stdx::lock_guard<stdx::mutex> lk(_durabilityMutex);
+    _shuttingDown = true;
+    _durabilityCV.notify_all();
+}
+
+bool WiredTigerCappedVisibility::isShuttingDown() const {
+    stdx::lock_guard<stdx::mutex> lk(_durabilityMutex);
+    return _shuttingDown;
+}
+
+void WiredTigerCappedVisibility::_finish(Slot* slot) {
+    slot->_finished.store(true);
+    _numFinished.fetchAndAdd(1);
+}
+
+void WiredTigerCappedVisibility::_advance() {
+    while (true) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex, stdx::try_to_lock);
+        if (!lk.owns_lock()) {
+            // The thread holding the mutex will see that a slot finished once it releases it.
+            return;
+        }
+
+        const uint64_t numFinishedSeen = _numFinished.load();
+        const bool changed = _advance_inlock();
+        lk.unlock();
+
+        if (changed) {
+            _notifyBecameVisible();
+        }
+        if (_numFinished.load() == numFinishedSeen) {
+            return;
+        }
+    }
+}
+
+bool WiredTigerCappedVisibility::_advance_inlock() {
+    if (_slots.empty() || !_slots.front()._finished.load()) {
+        return false;
+    }
+
+    do {
+        _slots.pop_front();
+    } while (!_slots.empty() && _slots.front()._finished.load());
+
+    _lowestHidden.store(_slots.empty() ? RecordId().repr() : _slots.front().id().repr());
+    return true;
+}
+
+void WiredTigerCappedVisibility::_notifyBecameVisible() {
+    if (_numVisibilityWaiters.load() == 0) {
+        return;
+    }
+    stdx::lock_guard<stdx::mutex> lk(_becameVisibleMutex);
+    _becameVisibleCV.notify_all();
+}
+
+}  // namespace mongo
@@ -0,0 +1,198 @@
+// wiredtiger_capped_visibility.h
+
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+/**
+ * Tracks which RecordIds of a capped collection (and of the oplog in particular) are visible to
+ * forward readers. An id is registered before it is inserted and stays hidden, together with
+ * every id after it, until the transaction that inserted it commits or rolls back. Readers must
+ * not see a later id while an earlier one could still appear.
+ *
+ * Every registered id gets a Slot. Committing or rolling back marks the slot finished without
+ * blocking. Whoever then manages to take the internal mutex, without waiting for it, drops the
+ * finished slots at the front and publishes the lowest id still hidden. The other threads rely on
+ * that thread to look again before it returns. Readers only load the published ids, so neither
+ * writers nor readers serialize on a single lock.
+ *
+ * When constructed with 'deferUntilDurable' (the oplog), a commit that is not for the highest id
+ * seen stays hidden until the journal thread has made it durable. See
+ * waitForCommitsAwaitingDurability() and markDurable().
+ */
+class WiredTigerCappedVisibility {
+    MONGO_DISALLOW_COPYING(WiredTigerCappedVisibility);
+
+public:
+    class Slot {
+        MONGO_DISALLOW_COPYING(Slot);
+
+    public:
+        explicit Slot(const RecordId& id) : _id(id) {}
+
+        const RecordId& id() const {
+            return _id;
+        }
+
+    private:
+        friend class WiredTigerCappedVisibility;
+
+        const RecordId _id;
+        AtomicWord<bool> _finished;
+        Slot* _nextAwaitingDurability = nullptr;
+    };
+
+    explicit WiredTigerCappedVisibility(bool deferUntilDurable);
+
+    /**
+     * Hides 'id' until commit() or rollback() is called with the returned slot, which stays owned
+     * by this object. Ids must be registered in increasing order.
+     */
+    Slot* registerId(const RecordId& id);
+
+    void commit(Slot* slot);
+    void rollback(Slot* slot);
+
+    /**
+     * Returns true if 'id' is at or after the lowest id that is still hidden.
+     */
+    bool isHidden(const RecordId& id) const {
+        const RecordId lowest = lowestHidden();
+        return !lowest.isNull() && lowest <= id;
+    }
+
+    /**
+     * Returns the lowest id that is still hidden, or a null RecordId if every id is visible.
+     */
+    RecordId lowestHidden() const {
+        return RecordId(_lowestHidden.load());
+    }
+
+    RecordId highestSeen() const {
+        return RecordId(_highestSeen.load());
+    }
+
+    void setHighestSeen(const RecordId& id) {
+        _highestSeen.store(id.repr());
+    }
+
+    /**
+     * Sets the highest id seen to 'id' unless a higher one has been seen already.
+     */
+    void raiseHighestSeen(const RecordId& id);
+
+    /**
+     * Returns the id an oplog reader may read up to: the lowest hidden id, or the highest id
+     * seen if nothing is hidden. The reader must still check whether that id itself is hidden.
+     */
+    RecordId oplogReadTill() const;
+
+    /**
+     * Waits until 'id' is visible or 'timeout' elapses. Returns whether 'id' is visible.
+     */
+    bool waitUntilVisible(const RecordId& id, Milliseconds timeout) const;
+
+    /**
+     * Blocks until some commits are waiting for the journal, then returns them as a list linked
+     * through the slots. Returns nullptr once shutdown() has been called.
+     */
+    Slot* waitForCommitsAwaitingDurability();
+
+    /**
+     * Makes visible the commits returned by waitForCommitsAwaitingDurability(), once the
+     * journal has been flushed past them.
+     */
+    void markDurable(Slot* commits);
+
+    /**
+     * Wakes up and stops waitForCommitsAwaitingDurability().
+     */
+    void shutdown();
+
+    /**
+     * Returns whether shutdown() has been called.
+     */
+    bool isShuttingDown() const;
+
+private:
+    void _finish(Slot* slot);
+
+    /**
+     * Drops the finished slots at the front if the mutex can be taken without waiting. Repeats
+     * while slots were finished in the meantime, since their threads gave up on the mutex.
+     */
+    void _advance();
+
+    /**
+     * Returns true if the lowest hidden id changed.
+     */
+    bool _advance_inlock();
+
+    void _notifyBecameVisible();
+
+    const bool _deferUntilDurable;
+
+    // Guards _slots. Registration appends to it and advancing pops finished slots off its front.
+    // std::deque keeps the other slots in place, so threads can finish theirs without the mutex.
+    stdx::mutex _mutex;
+    std::deque<Slot> _slots;
+
+    // RecordId::repr() values, or the null repr while nothing is hidden or nothing was seen.
+    AtomicInt64 _lowestHidden;
+    AtomicInt64 _highestSeen;
+
+    // Counts finished slots, so that the thread that advanced can tell it has to look again.
+    AtomicUInt64 _numFinished;
+
+    // Stack of committed slots waiting for the journal, pushed without a lock and taken whole.
+    std::atomic<Slot*> _awaitingDurability{nullptr};  // NOLINT
+    mutable stdx::mutex _durabilityMutex;
+    stdx::condition_variable _durabilityCV;
+    bool _shuttingDown = false;  // Guarded by _durabilityMutex.
+
+    // Waiters on _becameVisibleCV, so that advancing only takes _becameVisibleMutex if needed.
+    mutable AtomicInt32 _numVisibilityWaiters;
+    mutable stdx::mutex _becameVisibleMutex;
+    mutable stdx::condition_variable _becameVisibleCV;
+};
+
+}  // namespace mongo
@@ -0,0 +1,172 @@
+// wiredtiger_capped_visibility_test.cpp
+
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_capped_visibility.h"
+
+#include <vector>
+
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(WiredTigerCappedVisibilityTest, HidesEverythingFromLowestUnfinishedId) {
+    WiredTigerCappedVisibility visibility(/*deferUntilDurable=*/false);
+    ASSERT_TRUE(visibility.lowestHidden().isNull());
+
+    auto slot1 = visibility.registerId(RecordId(1));
+    auto slot2 = visibility.registerId(RecordId(2));
+    auto slot3 = visibility.registerId(RecordId(3));
+    ASSERT_EQUALS(RecordId(1), visibility.lowestHidden());
+    ASSERT_EQUALS(RecordId(3), visibility.highestSeen());
+
+    visibility.commit(slot2);
+    ASSERT_EQUALS(RecordId(1), visibility.lowestHidden());
+    ASSERT_TRUE(visibility.isHidden(RecordId(2)));
+
+    visibility.rollback(slot1);
+    ASSERT_EQUALS(RecordId(3), visibility.lowestHidden());
+    ASSERT_FALSE(visibility.isHidden(RecordId(2)));
+    ASSERT_TRUE(visibility.isHidden(RecordId(3)));
+
+    visibility.commit(slot3);
+    ASSERT_TRUE(visibility.lowestHidden().isNull());
+    ASSERT_FALSE(visibility.isHidden(RecordId(3)));
+}
+
+TEST(WiredTigerCappedVisibilityTest, OplogReadTill) {
+    WiredTigerCappedVisibility visibility(/*deferUntilDurable=*/false);
+    visibility.setHighestSeen(RecordId(5));
+    ASSERT_EQUALS(RecordId(5), visibility.oplogReadTill());
+
+    auto slot6 = visibility.registerId(RecordId(6));
+    auto slot7 = visibility.registerId(RecordId(7));
+    ASSERT_EQUALS(RecordId(6), visibility.oplogReadTill());
+
+    visibility.commit(slot6);
+    ASSERT_EQUALS(RecordId(7), visibility.oplogReadTill());
+
+    visibility.commit(slot7);
+    ASSERT_EQUALS(RecordId(7), visibility.oplogReadTill());
+}
+
+TEST(WiredTigerCappedVisibilityTest, RaiseHighestSeenNeverLowersIt) {
+    WiredTigerCappedVisibility visibility(/*deferUntilDurable=*/false);
+    visibility.raiseHighestSeen(RecordId(10));
+    ASSERT_EQUALS(RecordId(10), visibility.highestSeen());
+    visibility.raiseHighestSeen(RecordId(4));
+    ASSERT_EQUALS(RecordId(10), visibility.highestSeen());
+
+    visibility.setHighestSeen(RecordId(4));
+    ASSERT_EQUALS(RecordId(4), visibility.highestSeen());
+}
+
+TEST(WiredTigerCappedVisibilityTest, DefersCommitsUntilDurable) {
+    WiredTigerCappedVisibility visibility(/*deferUntilDurable=*/true);
+    auto slot1 = visibility.registerId(RecordId(1));
+    auto slot2 = visibility.registerId(RecordId(2));
+
+    // 1 isn't the highest id seen, so it waits for the journal. 2 is, so it finishes right away
+    // but stays hidden behind 1.
+    visibility.commit(slot1);
+    visibility.commit(slot2);
+    ASSERT_EQUALS(RecordId(1), visibility.lowestHidden());
+
+    auto commits = visibility.waitForCommitsAwaitingDurability();
+    ASSERT_TRUE(commits == slot1);
+    visibility.markDurable(commits);
+    ASSERT_TRUE(visibility.lowestHidden().isNull());
+}
+
+TEST(WiredTigerCappedVisibilityTest, ShutdownStopsWaitingForCommits) {
+    WiredTigerCappedVisibility visibility(/*deferUntilDurable=*/true);
+    stdx::thread journal(
+        [&] { ASSERT_TRUE(visibility.waitForCommitsAwaitingDurability() == nullptr); });
+    ASSERT_FALSE(visibility.isShuttingDown());
+    visibility.shutdown();
+    ASSERT_TRUE(visibility.isShuttingDown());
+    journal.join();
+}
+
+TEST(WiredTigerCappedVisibilityTest, WaitUntilVisible) {
+    WiredTigerCappedVisibility visibility(/*deferUntilDurable=*/false);
+    ASSERT_TRUE(visibility.waitUntilVisible(RecordId(1), Milliseconds(0)));
+
+    auto slot = visibility.registerId(RecordId(1));
+    ASSERT_FALSE(visibility.waitUntilVisible(RecordId(1), Milliseconds(1)));
+
+    stdx::thread waiter(
+        [&] { ASSERT_TRUE(visibility.waitUntilVisible(RecordId(1), Milliseconds(60 * 1000))); });
+    visibility.commit(slot);
+    waiter.join();
+}
+
+TEST(WiredTigerCappedVisibilityTest, ConcurrentCommitsMakeEverythingVisible) {
+    const int kThreads = 8;
+    const int kIdsPerThread = 10000;
+
+    WiredTigerCappedVisibility visibility(/*deferUntilDurable=*/false);
+    stdx::mutex registerMutex;
+    int64_t nextId = 1;
+
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kIdsPerThread; j++) {
+                WiredTigerCappedVisibility::Slot* slot;
+                {
+                    stdx::lock_guard<stdx::mutex> lk(registerMutex);
+                    slot = visibility.registerId(RecordId(nextId++));
+                }
+                const RecordId id = slot->id();
+                ASSERT_TRUE(visibility.isHidden(id));
+                if (j % 3) {
+                    visibility.commit(slot);
+                } else {
+                    visibility.rollback(slot);
+                }
+                ASSERT_TRUE(visibility.waitUntilVisible(id, Milliseconds(60 * 1000)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_TRUE(visibility.lowestHidden().isNull());
+    ASSERT_EQUALS(RecordId(kThreads * kIdsPerThread), visibility.highestSeen());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -254,6 +254,10 @@ Status WiredTigerIndex::insert(OperationContext* txn,
     return _insert(c, key, id, dupsAllowed);
 }
 
+Status WiredTigerIndex::checkKeySizeForBulkBuild(const BSONObj& key) const {
+    return checkKeySize(key);
+}
+
 void WiredTigerIndex::unindex(OperationContext* txn,
                               const BSONObj& key,
                               const RecordId& id,
@@ -533,18 +537,15 @@ public:
         }
 
         KeyString data(key, _idx->_ordering, id);
+        doInsert(data, data.getTypeBits());
 
-        // Can't use WiredTigerCursor since we aren't using the cache.
-        WiredTigerItem item(data.getBuffer(), data.getSize());
-        _cursor->set_key(_cursor, item.Get());
-
-        WiredTigerItem valueItem = data.getTypeBits().isAllZeros()
-            ? emptyItem
-            : WiredTigerItem(data.getTypeBits().getBuffer(), data.getTypeBits().getSize());
-
-        _cursor->set_value(_cursor, valueItem.Get());
+        return Status::OK();
+    }
 
-        invariantWTOK(_cursor->insert(_cursor));
+    Status addKeyString(const KeyString::Value& key, const RecordId& id) {
+        _keyString.resetFromBuffer(key.getBuffer(), key.getSize());
+        _keyString.appendRecordId(id);
+        doInsert(_keyString, key.getTypeBits());
 
         return Status::OK();
     }
@@ -557,7 +558,22 @@ public:
     }
 
 private:
+    void doInsert(const KeyString& data, const KeyString::TypeBits& typeBits) {
+        // Can't use WiredTigerCursor since we aren't using the cache.
+        WiredTigerItem item(data.getBuffer(), data.getSize());
+        _cursor->set_key(_cursor, item.Get());
+
+        WiredTigerItem valueItem = typeBits.isAllZeros()
+            ? emptyItem
+            : WiredTigerItem(typeBits.getBuffer(), typeBits.getSize());
+
+        _cursor->set_value(_cursor, valueItem.Get());
+
+        invariantWTOK(_cursor->insert(_cursor));
+    }
+
     WiredTigerIndex* _idx;
+    KeyString _keyString;
 };
 
 /**
@@ -580,9 +596,15 @@ public:
                 return s;
         }
 
-        const int cmp = newKey.woCompare(_key, _ordering);
+        const KeyString keyString(newKey, _idx->ordering());
+        return addKeyString(KeyString::Value(keyString), id);
+    }
+
+    Status addKeyString(const KeyString::Value& newKey, const RecordId& id) {
+        // _key.getSize() is only 0 on the first call, since encoded keys are never empty.
+        const int cmp = _key.getSize() ? newKey.compare(_key) : 1;
         if (cmp != 0) {
-            if (!_key.isEmpty()) {   // _key.isEmpty() is only true on the first call to addKey().
+            if (_key.getSize()) {
                 invariant(cmp > 0);  // newKey must be > the last key
                 // We are done with dups of the last key so we can insert it now.
                 doInsert();
@@ -591,7 +613,7 @@ public:
         } else {
             // Dup found!
             if (!_dupsAllowed) {
-                return _idx->dupKeyError(newKey);
+                return _idx->dupKeyError(newKey.toBson(_ordering));
             }
 
             // If we get here, we are in the weird mode where dups are allowed on a unique
@@ -599,9 +621,8 @@ public:
             // _key which is correct since any dups seen later are likely to be newer.
         }
 
-        _key = newKey.getOwned();
-        _keyString.resetToKey(_key, _idx->ordering());
-        _records.push_back(std::make_pair(id, _keyString.getTypeBits()));
+        _key = newKey;
+        _records.push_back(std::make_pair(id, newKey.getTypeBits()));
 
         return Status::OK();
     }
@@ -629,7 +650,7 @@ private:
             }
         }
 
-        WiredTigerItem keyItem(_keyString.getBuffer(), _keyString.getSize());
+        WiredTigerItem keyItem(_key.getBuffer(), _key.getSize());
         WiredTigerItem valueItem(value.getBuffer(), value.getSize());
 
         _cursor->set_key(_cursor, keyItem.Get());
@@ -642,8 +663,7 @@ private:
 
     WiredTigerIndex* _idx;
     const bool _dupsAllowed;
-    BSONObj _key;
-    KeyString _keyString;
+    KeyString::Value _key;
     std::vector<std::pair<RecordId, KeyString::TypeBits>> _records;
 };
 
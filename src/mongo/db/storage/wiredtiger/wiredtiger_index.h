@@ -98,6 +98,12 @@ public:
                                    double scale) const;
     virtual Status dupKeyCheck(OperationContext* txn, const BSONObj& key, const RecordId& id);
 
+    bool bulkBuildsFromKeyStrings() const override {
+        return true;
+    }
+
+    Status checkKeySizeForBulkBuild(const BSONObj& key) const override;
+
     virtual bool isEmpty(OperationContext* txn);
 
     virtual Status touch(OperationContext* txn) const;
@@ -59,6 +59,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_sizer.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/util/log.h"
@@ -68,6 +69,7 @@
 #include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 #if !defined(__has_feature)
 #define __has_feature(x) 0
@@ -126,10 +128,12 @@ class TicketServerParameter : public ServerParameter {
 
 public:
     TicketServerParameter(TicketHolder* holder, const std::string& name)
-        : ServerParameter(ServerParameterSet::getGlobal(), name, true, true), _holder(holder) {}
+        : ServerParameter(ServerParameterSet::getGlobal(), name, true, true),
+          _holder(holder),
+          _maxTickets(holder->outof()) {}
 
     virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
-        b.append(name, _holder->outof());
+        b.append(name, _maxTickets.load());
     }
 
     virtual Status set(const BSONElement& newValueElement) {
@@ -151,11 +155,34 @@ public:
             return Status(ErrorCodes::BadValue, str::stream() << name() << " has to be > 0");
         }
 
-        return _holder->resize(newNum);
+        stdx::lock_guard<stdx::mutex> lk(_resizeMutex);
+        Status status = _holder->resize(newNum);
+        if (status.isOK()) {
+            _maxTickets.store(newNum);
+        }
+        return status;
+    }
+
+    /**
+     * The configured number of tickets. While wiredTigerAdaptiveConcurrentTransactions is enabled
+     * the pool may be resized below this, but never above it.
+     */
+    int maxTickets() const {
+        return _maxTickets.load();
+    }
+
+    /**
+     * Held by set() while it resizes the pool and stores the new maxTickets(). Anything else that
+     * resizes the pool to a size derived from maxTickets() must hold it too, or it may undo set().
+     */
+    stdx::mutex& resizeMutex() const {
+        return _resizeMutex;
     }
 
 private:
     TicketHolder* _holder;
+    AtomicInt32 _maxTickets;
+    mutable stdx::mutex _resizeMutex;
 };
 
 TicketHolder openWriteTransaction(128);
@@ -166,8 +193,248 @@ TicketHolder openReadTransaction(128);
 TicketServerParameter openReadTransactionParam(&openReadTransaction,
                                                "wiredTigerConcurrentReadTransactions");
 
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerAdaptiveConcurrentTransactions, bool, true);
+
+// How often the ticket adjuster samples the ticket pools, and how often it resizes them.
+const int kTicketSampleMillis = 10;
+const int kTicketAdjustMillis = 1000;
+
+// The write pool is shrunk while the cache is under eviction pressure. Pressure starts once the
+// cache reaches either threshold at which WiredTiger makes application threads evict (see the
+// eviction_dirty_trigger and eviction_trigger defaults), and ends once it is back below both
+// lower thresholds, so that the decision doesn't flip on every interval.
+const double kCacheDirtyPressureStart = 0.20;
+const double kCacheDirtyPressureEnd = 0.15;
+const double kCacheUsedPressureStart = 0.95;
+const double kCacheUsedPressureEnd = 0.90;
+
+/**
+ * The last decision of the ticket adjuster for a pool, reported in serverStatus.
+ */
+struct TicketAdjustmentStats {
+    double latencyMicros = 0;
+    double baselineLatencyMicros = 0;
+    std::string lastDecision;
+    long long increases = 0;
+    long long decreases = 0;
+};
+
+// Protects everything the ticket adjuster reports in serverStatus.
+stdx::mutex ticketAdjustmentMutex;
+TicketAdjustmentStats writeTicketAdjustment;
+TicketAdjustmentStats readTicketAdjustment;
+bool cachePressure = false;
+double cacheDirtyRatio = 0;
+double cacheUsedRatio = 0;
+
+void appendTicketAdjustment(const TicketAdjustmentStats& stats,
+                            const TicketServerParameter& param,
+                            BSONObjBuilder* b) {
+    b->append("maxTickets", param.maxTickets());
+    b->append("latencyMicros", stats.latencyMicros);
+    b->append("baselineLatencyMicros", stats.baselineLatencyMicros);
+    b->append("lastDecision", stats.lastDecision);
+    b->append("increases", stats.increases);
+    b->append("decreases", stats.decreases);
+}
+
+void appendTicketWaitStats(const TicketHolder& holder, BSONObjBuilder* b) {
+    const std::pair<TicketHolder::Priority, const char*> priorities[] = {
+        {TicketHolder::Priority::kNormal, "normal"},
+        {TicketHolder::Priority::kHigh, "high"},
+        {TicketHolder::Priority::kImmediate, "immediate"},
+    };
+
+    BSONObjBuilder waits(b->subobjStart("waits"));
+    for (const auto& priority : priorities) {
+        const TicketHolder::WaitStats stats = holder.getWaitStats(priority.first);
+        BSONObjBuilder waitsBuilder(waits.subobjStart(priority.second));
+        waitsBuilder.append("count", stats.count);
+        waitsBuilder.append("totalMicros", stats.totalMicros);
+
+        // Only the buckets that counted any waits are reported, each by its lower bound.
+        BSONArrayBuilder histogram(waitsBuilder.subarrayStart("histogram"));
+        for (int i = 0; i < TicketHolder::WaitStats::kNumBuckets; i++) {
+            if (stats.buckets[i] == 0) {
+                continue;
+            }
+            histogram.append(BSON("micros" << TicketHolder::WaitStats::bucketLowerBoundMicros(i)
+                                           << "count" << stats.buckets[i]));
+        }
+        histogram.done();
+        waitsBuilder.done();
+    }
+    waits.done();
+}
+
 }  // namespace
 
+/**
+ * Resizes the read and write ticket pools within the configured number of tickets, from the
+ * latency and queueing observed on them and from the cache eviction pressure.
+ * See WiredTigerTicketSizer for how the sizes are chosen.
+ */
+class WiredTigerKVEngine::WiredTigerTicketAdjuster : public BackgroundJob {
+public:
+    explicit WiredTigerTicketAdjuster(WT_CONNECTION* conn)
+        : BackgroundJob(false /* deleteSelf */), _conn(conn) {}
+
+    virtual string name() const {
+        return "WTTicketAdjuster";
+    }
+
+    virtual void run() {
+        Client::initThread(name().c_str());
+
+        LOG(1) << "starting " << name() << " thread";
+
+        WiredTigerSession session(_conn);
+        TicketPool writePool(
+            "write", &openWriteTransaction, &openWriteTransactionParam, &writeTicketAdjustment);
+        TicketPool readPool(
+            "read", &openReadTransaction, &openReadTransactionParam, &readTicketAdjustment);
+
+        Timer timer;
+        while (!_shuttingDown.load()) {
+            sleepmillis(kTicketSampleMillis);
+
+            writePool.sample();
+            readPool.sample();
+            if (timer.millis() < kTicketAdjustMillis) {
+                continue;
+            }
+
+            const long long intervalMicros = timer.micros();
+            timer.reset();
+
+            // Only writers add dirty data, so reads are not throttled for cache pressure.
+            const bool pressure = _updateCachePressure(session.getSession());
+            writePool.adjust(intervalMicros, pressure);
+            readPool.adjust(intervalMicros, false);
+        }
+        LOG(1) << "stopping " << name() << " thread";
+    }
+
+    void shutdown() {
+        _shuttingDown.store(true);
+        wait();
+    }
+
+private:
+    class TicketPool {
+    public:
+        TicketPool(const char* name,
+                   TicketHolder* holder,
+                   const TicketServerParameter* param,
+                   TicketAdjustmentStats* stats)
+            : _name(name),
+              _holder(holder),
+              _param(param),
+              _stats(stats),
+              _lastAcquired(holder->acquired()) {}
+
+        void sample() {
+            _samples++;
+            _usedSum += _holder->used();
+            _queuedSum += _holder->waiting();
+        }
+
+        void adjust(long long intervalMicros, bool cachePressure) {
+            stdx::lock_guard<stdx::mutex> resizeLock(_param->resizeMutex());
+
+            WiredTigerTicketSizer::Observation obs;
+            obs.size = _holder->outof();
+            if (_samples) {
+                obs.avgUsed = static_cast<double>(_usedSum) / _samples;
+                obs.avgQueued = static_cast<double>(_queuedSum) / _samples;
+            }
+            const long long acquired = _holder->acquired();
+            obs.acquired = acquired - _lastAcquired;
+            obs.intervalMicros = intervalMicros;
+            obs.cachePressure = cachePressure;
+
+            _lastAcquired = acquired;
+            _samples = 0;
+            _usedSum = 0;
+            _queuedSum = 0;
+
+            const int maxSize = _param->maxTickets();
+            WiredTigerTicketSizer::Decision decision{maxSize, "disabled"};
+            if (wiredTigerAdaptiveConcurrentTransactions.load()) {
+                decision = _sizer.decide(obs, maxSize);
+            }
+
+            if (decision.size != obs.size) {
+                Status status = _holder->resize(decision.size);
+                if (!status.isOK()) {
+                    LOG(1) << "failed to resize WiredTiger " << _name << " tickets to "
+                           << decision.size << ": " << status;
+                    return;
+                }
+                LOG(1) << "resized WiredTiger " << _name << " tickets from " << obs.size
+                       << " to " << decision.size << " (" << decision.reason
+                       << ", ticket latency " << _sizer.latencyMicros() << "us, baseline "
+                       << _sizer.baselineLatencyMicros() << "us)";
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(ticketAdjustmentMutex);
+            _stats->latencyMicros = _sizer.latencyMicros();
+            _stats->baselineLatencyMicros = _sizer.baselineLatencyMicros();
+            _stats->lastDecision = decision.reason;
+            if (decision.size > obs.size) {
+                _stats->increases++;
+            } else if (decision.size < obs.size) {
+                _stats->decreases++;
+            }
+        }
+
+    private:
+        const char* _name;
+        TicketHolder* _holder;
+        const TicketServerParameter* _param;
+        TicketAdjustmentStats* _stats;
+        WiredTigerTicketSizer _sizer;
+
+        long long _lastAcquired;
+        long long _samples = 0;
+        long long _usedSum = 0;
+        long long _queuedSum = 0;
+    };
+
+    /**
+     * Reads the cache usage and returns whether the cache is under eviction pressure. If the
+     * statistics can't be read, the previous answer is kept.
+     */
+    bool _updateCachePressure(WT_SESSION* session) {
+        auto stat = [session](int key) {
+            return WiredTigerUtil::getStatisticsValueAs<int64_t>(
+                session, "statistics:", "statistics=(fast)", key);
+        };
+        auto max = stat(WT_STAT_CONN_CACHE_BYTES_MAX);
+        auto inUse = stat(WT_STAT_CONN_CACHE_BYTES_INUSE);
+        auto dirty = stat(WT_STAT_CONN_CACHE_BYTES_DIRTY);
+
+        stdx::lock_guard<stdx::mutex> lk(ticketAdjustmentMutex);
+        if (!max.isOK() || !inUse.isOK() || !dirty.isOK() || max.getValue() <= 0) {
+            return cachePressure;
+        }
+
+        cacheUsedRatio = static_cast<double>(inUse.getValue()) / max.getValue();
+        cacheDirtyRatio = static_cast<double>(dirty.getValue()) / max.getValue();
+        if (cachePressure) {
+            cachePressure = cacheDirtyRatio >= kCacheDirtyPressureEnd ||
+                cacheUsedRatio >= kCacheUsedPressureEnd;
+        } else {
+            cachePressure = cacheDirtyRatio >= kCacheDirtyPressureStart ||
+                cacheUsedRatio >= kCacheUsedPressureStart;
+        }
+        return cachePressure;
+    }
+
+    WT_CONNECTION* _conn;
+    std::atomic<bool> _shuttingDown{false};  // NOLINT
+};
+
 WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
                                        const std::string& path,
                                        const std::string& extraOpenOptions,
@@ -266,6 +533,9 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
     }
 
     Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
+
+    _ticketAdjuster = stdx::make_unique<WiredTigerTicketAdjuster>(_conn);
+    _ticketAdjuster->go();
 }
 
 
@@ -284,6 +554,8 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
         bbb.append("out", openWriteTransaction.used());
         bbb.append("available", openWriteTransaction.available());
         bbb.append("totalTickets", openWriteTransaction.outof());
+        bbb.append("queued", openWriteTransaction.waiting());
+        appendTicketWaitStats(openWriteTransaction, &bbb);
         bbb.done();
     }
     {
@@ -291,6 +563,27 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
         bbb.append("out", openReadTransaction.used());
         bbb.append("available", openReadTransaction.available());
         bbb.append("totalTickets", openReadTransaction.outof());
+        bbb.append("queued", openReadTransaction.waiting());
+        appendTicketWaitStats(openReadTransaction, &bbb);
+        bbb.done();
+    }
+    {
+        BSONObjBuilder bbb(bb.subobjStart("adjustment"));
+        stdx::lock_guard<stdx::mutex> lk(ticketAdjustmentMutex);
+        bbb.append("enabled", wiredTigerAdaptiveConcurrentTransactions.load());
+        bbb.append("cachePressure", cachePressure);
+        bbb.append("cacheDirtyRatio", cacheDirtyRatio);
+        bbb.append("cacheUsedRatio", cacheUsedRatio);
+        {
+            BSONObjBuilder pool(bbb.subobjStart("write"));
+            appendTicketAdjustment(writeTicketAdjustment, openWriteTransactionParam, &pool);
+            pool.done();
+        }
+        {
+            BSONObjBuilder pool(bbb.subobjStart("read"));
+            appendTicketAdjustment(readTicketAdjustment, openReadTransactionParam, &pool);
+            pool.done();
+        }
         bbb.done();
     }
     bb.done();
@@ -303,6 +596,8 @@ void WiredTigerKVEngine::cleanShutdown() {
         // these must be the last things we do before _conn->close();
         if (_journalFlusher)
             _journalFlusher->shutdown();
+        if (_ticketAdjuster)
+            _ticketAdjuster->shutdown();
         _sizeStorer.reset();
         _sessionCache->shuttingDown();
 
@@ -151,6 +151,7 @@ public:
 
 private:
     class WiredTigerJournalFlusher;
+    class WiredTigerTicketAdjuster;
 
     Status _salvageIfNeeded(const char* uri);
     void _checkIdentPath(StringData ident);
@@ -173,6 +174,7 @@ private:
     bool _durable;
     bool _ephemeral;
     std::unique_ptr<WiredTigerJournalFlusher> _journalFlusher;  // Depends on _sizeStorer
+    std::unique_ptr<WiredTigerTicketAdjuster> _ticketAdjuster;
 
     std::string _rsOptions;
     std::string _indexOptions;
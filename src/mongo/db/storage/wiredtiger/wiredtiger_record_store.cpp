@@ -782,6 +782,7 @@ WiredTigerRecordStore::WiredTigerRecordStore(OperationContext* ctx,
       _cappedCallback(cappedCallback),
       _cappedDeleteCheckCount(0),
       _useOplogHack(shouldUseOplogHack(ctx, _uri)),
+      _cappedVisibility(_isOplog),
       _sizeStorer(sizeStorer),
       _sizeStorerCounter(0),
       _shuttingDown(false) {
@@ -807,7 +808,7 @@ WiredTigerRecordStore::WiredTigerRecordStore(OperationContext* ctx,
     Cursor cursor(ctx, *this, /*forward=*/false);
     if (auto record = cursor.next()) {
         int64_t max = _makeKey(record->id);
-        _oplog_highestSeen = record->id;
+        _cappedVisibility.setHighestSeen(record->id);
         _nextIdNum.store(1 + max);
 
         if (_sizeStorer) {
@@ -851,7 +852,6 @@ WiredTigerRecordStore::WiredTigerRecordStore(OperationContext* ctx,
 WiredTigerRecordStore::~WiredTigerRecordStore() {
     {
         stdx::lock_guard<boost::timed_mutex> lk(_cappedDeleterMutex);  // NOLINT
-        stdx::lock_guard<stdx::mutex> lk2(_uncommittedRecordIdsMutex);
         _shuttingDown = true;
     }
 
@@ -865,7 +865,7 @@ WiredTigerRecordStore::~WiredTigerRecordStore() {
     }
 
     if (_oplogJournalThread.joinable()) {
-        _opsWaitingForJournalCV.notify_one();
+        _cappedVisibility.shutdown();
         _oplogJournalThread.join();
     }
 }
@@ -1275,9 +1275,9 @@ Status WiredTigerRecordStore::insertRecords(OperationContext* txn,
                 return status.getStatus();
             record.id = status.getValue();
         } else if (_isCapped) {
-            stdx::lock_guard<stdx::mutex> lk(_uncommittedRecordIdsMutex);
+            stdx::lock_guard<stdx::mutex> lk(_cappedIdMutex);
             record.id = _nextId();
-            _addUncommittedRecordId_inlock(txn, record.id);
+            _registerCappedId(txn, record.id);
         } else {
             record.id = _nextId();
         }
@@ -1285,10 +1285,8 @@ Status WiredTigerRecordStore::insertRecords(OperationContext* txn,
         highestId = record.id;
     }
 
-    if (_useOplogHack && (highestId > _oplog_highestSeen)) {
-        stdx::lock_guard<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-        if (highestId > _oplog_highestSeen)
-            _oplog_highestSeen = highestId;
+    if (_useOplogHack) {
+        _cappedVisibility.raiseHighestSeen(highestId);
     }
 
     for (auto& record : *records) {
@@ -1326,38 +1324,12 @@ StatusWith<RecordId> WiredTigerRecordStore::insertRecord(OperationContext* txn,
     return StatusWith<RecordId>(records[0].id);
 }
 
-void WiredTigerRecordStore::_dealtWithCappedId(SortedRecordIds::iterator it, bool didCommit) {
-    invariant(it->isNormal());
-    stdx::lock_guard<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-    if (didCommit && _isOplog && *it != _oplog_highestSeen) {
-        // Defer removal from _uncommittedRecordIds until it is durable. We don't need to wait for
-        // durability of ops that didn't commit because they won't become durable.
-        // As an optimization, we only defer visibility until durable if new ops were created while
-        // we were pending. This makes single-threaded w>1 workloads faster and is safe because
-        // durability follows commit order for commits that are fully sequenced (B doesn't call
-        // commit until after A's commit call returns).
-        const bool wasEmpty = _opsWaitingForJournal.empty();
-        _opsWaitingForJournal.push_back(it);
-        if (wasEmpty) {
-            _opsWaitingForJournalCV.notify_one();
-        }
-    } else {
-        _uncommittedRecordIds.erase(it);
-        _opsBecameVisibleCV.notify_all();
-    }
-}
-
 bool WiredTigerRecordStore::isCappedHidden(const RecordId& id) const {
-    stdx::lock_guard<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-    if (_uncommittedRecordIds.empty()) {
-        return false;
-    }
-    return _uncommittedRecordIds.front() <= id;
+    return _cappedVisibility.isHidden(id);
 }
 
 RecordId WiredTigerRecordStore::lowestCappedHiddenRecord() const {
-    stdx::lock_guard<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-    return _uncommittedRecordIds.empty() ? RecordId() : _uncommittedRecordIds.front();
+    return _cappedVisibility.lowestHidden();
 }
 
 StatusWith<RecordId> WiredTigerRecordStore::insertRecord(OperationContext* txn,
@@ -1423,12 +1395,7 @@ StatusWith<RecordData> WiredTigerRecordStore::updateWithDamages(
 }
 
 void WiredTigerRecordStore::_oplogSetStartHack(WiredTigerRecoveryUnit* wru) const {
-    stdx::lock_guard<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-    if (_uncommittedRecordIds.empty()) {
-        wru->setOplogReadTill(_oplog_highestSeen);
-    } else {
-        wru->setOplogReadTill(_uncommittedRecordIds.front());
-    }
+    wru->setOplogReadTill(_cappedVisibility.oplogReadTill());
 }
 
 std::unique_ptr<SeekableRecordCursor> WiredTigerRecordStore::getCursor(OperationContext* txn,
@@ -1623,24 +1590,23 @@ Status WiredTigerRecordStore::oplogDiskLocRegister(OperationContext* txn, const
     if (!id.isOK())
         return id.getStatus();
 
-    stdx::lock_guard<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-    _addUncommittedRecordId_inlock(txn, id.getValue());
+    _registerCappedId(txn, id.getValue());
     return Status::OK();
 }
 
 class WiredTigerRecordStore::CappedInsertChange : public RecoveryUnit::Change {
 public:
-    CappedInsertChange(WiredTigerRecordStore* rs, SortedRecordIds::iterator it)
-        : _rs(rs), _it(it) {}
+    CappedInsertChange(WiredTigerRecordStore* rs, WiredTigerCappedVisibility::Slot* slot)
+        : _rs(rs), _slot(slot) {}
 
     virtual void commit() {
-        _rs->_dealtWithCappedId(_it, true);
+        _rs->_cappedVisibility.commit(_slot);
         // Do not notify here because all committed inserts notify, always.
     }
 
     virtual void rollback() {
         // Notify on rollback since it might make later commits visible.
-        _rs->_dealtWithCappedId(_it, false);
+        _rs->_cappedVisibility.rollback(_slot);
         stdx::lock_guard<stdx::mutex> lk(_rs->_cappedCallbackMutex);
         if (_rs->_cappedCallback)
             _rs->_cappedCallback->notifyCappedWaitersIfNeeded();
@@ -1648,38 +1614,21 @@ public:
 
 private:
     WiredTigerRecordStore* const _rs;
-    const SortedRecordIds::iterator _it;
+    WiredTigerCappedVisibility::Slot* const _slot;
 };
 
 void WiredTigerRecordStore::_oplogJournalThreadLoop(WiredTigerSessionCache* sessionCache) try {
     Client::initThread("WTOplogJournalThread");
-    while (true) {
-        stdx::unique_lock<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-        _opsWaitingForJournalCV.wait(
-            lk, [&] { return _shuttingDown || !_opsWaitingForJournal.empty(); });
-
-        while (!_shuttingDown && MONGO_FAIL_POINT(WTPausePrimaryOplogDurabilityLoop)) {
-            lk.unlock();
+    while (auto commits = _cappedVisibility.waitForCommitsAwaitingDurability()) {
+        while (MONGO_FAIL_POINT(WTPausePrimaryOplogDurabilityLoop)) {
+            // The record store may be destroyed while the failpoint is on, not only the server.
+            if (inShutdown() || _cappedVisibility.isShuttingDown())
+                return;
             sleepmillis(10);
-            lk.lock();
         }
 
-        if (_shuttingDown)
-            return;
-
-        decltype(_opsWaitingForJournal) opsAboutToBeJournaled = {};
-        _opsWaitingForJournal.swap(opsAboutToBeJournaled);
-
-        lk.unlock();
         sessionCache->waitUntilDurable(/*forceCheckpoint=*/false);
-        lk.lock();
-
-        for (auto&& op : opsAboutToBeJournaled) {
-            _uncommittedRecordIds.erase(op);
-        }
-
-        _opsBecameVisibleCV.notify_all();
-        lk.unlock();
+        _cappedVisibility.markDurable(commits);
 
         stdx::lock_guard<stdx::mutex> cappedCallbackLock(_cappedCallbackMutex);
         if (_cappedCallback) {
@@ -1696,22 +1645,18 @@ void WiredTigerRecordStore::waitForAllEarlierOplogWritesToBeVisible(OperationCon
     // This function must not start a WT transaction, otherwise we will get stuck in an infinite
     // loop of WCE handling when the getCursor() is called.
 
-    stdx::unique_lock<stdx::mutex> lk(_uncommittedRecordIdsMutex);
-    const auto waitingFor = _oplog_highestSeen;
-    while (!_uncommittedRecordIds.empty() && _uncommittedRecordIds.front() <= waitingFor) {
+    const auto waitingFor = _cappedVisibility.highestSeen();
+    while (_cappedVisibility.isHidden(waitingFor)) {
         // We can't use a simple wait() here because we need to wake up periodically to check for
         // interrupt and OperationContext::waitForConditionOrInterrupt doesn't exist on this branch.
         txn->checkForInterrupt();
-        _opsBecameVisibleCV.wait_for(lk, Microseconds(Seconds(10)));
+        _cappedVisibility.waitUntilVisible(waitingFor, Seconds(10));
     }
 }
 
-void WiredTigerRecordStore::_addUncommittedRecordId_inlock(OperationContext* txn, RecordId id) {
-    dassert(_uncommittedRecordIds.empty() || _uncommittedRecordIds.back() < id);
-    SortedRecordIds::iterator it = _uncommittedRecordIds.insert(_uncommittedRecordIds.end(), id);
-    invariant(it->isNormal());
-    txn->recoveryUnit()->registerChange(new CappedInsertChange(this, it));
-    _oplog_highestSeen = id;
+void WiredTigerRecordStore::_registerCappedId(OperationContext* txn, const RecordId& id) {
+    WiredTigerCappedVisibility::Slot* slot = _cappedVisibility.registerId(id);
+    txn->recoveryUnit()->registerChange(new CappedInsertChange(this, slot));
 }
 
 boost::optional<RecordId> WiredTigerRecordStore::oplogStartHack(
@@ -1876,7 +1821,7 @@ void WiredTigerRecordStore::temp_cappedTruncateAfter(OperationContext* txn,
 
     if (_useOplogHack) {
         // Forget that we've ever seen a higher timestamp than we now have.
-        _oplog_highestSeen = lastKeptId;
+        _cappedVisibility.setHighestSeen(lastKeptId);
     }
 
     if (_oplogStones) {
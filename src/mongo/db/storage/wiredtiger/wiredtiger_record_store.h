@@ -38,6 +38,7 @@
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/storage/capped_callback.h"
 #include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_capped_visibility.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
@@ -67,7 +68,6 @@ class WiredTigerRecoveryUnit;
 class WiredTigerSizeStorer;
 
 extern const std::string kWiredTigerEngineName;
-typedef std::list<RecordId> SortedRecordIds;
 
 class WiredTigerRecordStore : public RecordStore {
 public:
@@ -270,8 +270,7 @@ private:
     static int64_t _makeKey(const RecordId& id);
     static RecordId _fromKey(int64_t k);
 
-    void _dealtWithCappedId(SortedRecordIds::iterator it, bool didCommit);
-    void _addUncommittedRecordId_inlock(OperationContext* txn, RecordId id);
+    void _registerCappedId(OperationContext* txn, const RecordId& id);
 
     RecordId _nextId();
     void _setId(RecordId id);
@@ -308,9 +307,10 @@ private:
 
     const bool _useOplogHack;
 
-    SortedRecordIds _uncommittedRecordIds;
-    RecordId _oplog_highestSeen;
-    mutable stdx::mutex _uncommittedRecordIdsMutex;
+    // Ids of capped inserts that haven't committed yet, and the highest id seen on the oplog.
+    WiredTigerCappedVisibility _cappedVisibility;
+    // Makes non-oplog capped inserts register their ids in the order they were assigned.
+    stdx::mutex _cappedIdMutex;
 
     AtomicInt64 _nextIdNum;
     AtomicInt64 _dataSize;
@@ -324,10 +324,7 @@ private:
     // Non-null if this record store is underlying the active oplog.
     std::shared_ptr<OplogStones> _oplogStones;
 
-    // These use the _uncommittedRecordIdsMutex and are only used when _isOplog is true.
-    stdx::condition_variable _opsWaitingForJournalCV;
-    mutable stdx::condition_variable _opsBecameVisibleCV;
-    std::vector<SortedRecordIds::iterator> _opsWaitingForJournal;
+    // Makes oplog commits visible once durable. Only used when _isOplog is true.
     stdx::thread _oplogJournalThread;
 };
 
@@ -178,6 +178,14 @@ WiredTigerSession* WiredTigerRecoveryUnit::getSession(OperationContext* opCtx) {
     return _session;
 }
 
+WiredTigerSession* WiredTigerRecoveryUnit::getSessionForTable(OperationContext* opCtx,
+                                                              uint64_t tableId) {
+    if (!_session) {
+        _session = _sessionCache->getSession(tableId);
+    }
+    return getSession(opCtx);
+}
+
 WiredTigerSession* WiredTigerRecoveryUnit::getSessionNoTxn(OperationContext* opCtx) {
     _ensureSession();
     return _session;
@@ -272,7 +280,7 @@ WiredTigerCursor::WiredTigerCursor(const std::string& uri,
                                    OperationContext* txn) {
     _tableID = tableId;
     _ru = WiredTigerRecoveryUnit::get(txn);
-    _session = _ru->getSession(txn);
+    _session = _ru->getSessionForTable(txn, tableId);
     _cursor = _session->getCursor(uri, tableId, forRecordStore);
     if (!_cursor) {
         error() << "no cursor for uri: " << uri;
@@ -83,6 +83,12 @@ public:
 
     WiredTigerSession* getSession(OperationContext* opCtx);
 
+    /**
+     * Like getSession(), but if this recovery unit doesn't have a session yet, prefers a cached
+     * one that already has a cursor open on 'tableId'.
+     */
+    WiredTigerSession* getSessionForTable(OperationContext* opCtx, uint64_t tableId);
+
     /**
      * Enter a period of wait or computation during which there are no WT calls.
      * Any non-relevant cached handles can be closed.
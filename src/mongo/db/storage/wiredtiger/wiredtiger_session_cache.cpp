@@ -33,6 +33,13 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <functional>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/db/storage/journal_listener.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
@@ -106,6 +113,15 @@ void WiredTigerSession::releaseCursor(uint64_t id, WT_CURSOR* cursor) {
     }
 }
 
+bool WiredTigerSession::hasCachedCursor(uint64_t id) const {
+    for (const auto& cached : _cursors) {
+        if (cached._id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void WiredTigerSession::closeAllCursors(const std::string& uri) {
     invariant(_session);
 
@@ -136,7 +152,44 @@ void WiredTigerSession::closeCursorsForQueuedDrops(uint64_t cursorEpoch,
 
 namespace {
 AtomicUInt64 nextTableId(1);
+
+// How many of the most recently used sessions of a partition getSession() looks through for one
+// with a cursor on the table it was given.
+const size_t kMaxSessionsScannedForCursor = 8;
+
+size_t numSessionPartitions() {
+    const unsigned cores = stdx::thread::hardware_concurrency();
+    return cores ? cores : 1;
 }
+
+/**
+ * Removes and returns the most recently used session from 'sessions', or the most recent one
+ * with a cursor on 'tableIdHint' cached if there is one among the last few.
+ */
+WiredTigerSession* takeSession(std::vector<WiredTigerSession*>* sessions, uint64_t tableIdHint) {
+    invariant(!sessions->empty());
+
+    // Get the most recently used session so that if we discard sessions, we're discarding older
+    // ones.
+    auto chosen = sessions->end() - 1;
+    if (tableIdHint != WiredTigerSessionCache::kNoTableIdHint) {
+        const size_t toScan = std::min(sessions->size(), kMaxSessionsScannedForCursor);
+        for (size_t i = 0; i < toScan; i++) {
+            auto it = sessions->end() - 1 - i;
+            if ((*it)->hasCachedCursor(tableIdHint)) {
+                chosen = it;
+                break;
+            }
+        }
+    }
+
+    WiredTigerSession* session = *chosen;
+    sessions->erase(chosen);
+    return session;
+}
+}  // namespace
+
+const uint64_t WiredTigerSessionCache::kNoTableIdHint;
 // static
 uint64_t WiredTigerSession::genTableId() {
     return nextTableId.fetchAndAdd(1);
@@ -145,10 +198,20 @@ uint64_t WiredTigerSession::genTableId() {
 // -----------------------
 
 WiredTigerSessionCache::WiredTigerSessionCache(WiredTigerKVEngine* engine)
-    : _engine(engine), _conn(engine->getConnection()), _snapshotManager(_conn), _shuttingDown(0) {}
+    : _engine(engine),
+      _conn(engine->getConnection()),
+      _snapshotManager(_conn),
+      _shuttingDown(0),
+      _numPartitions(numSessionPartitions()),
+      _partitions(new SessionPartition[_numPartitions]) {}
 
 WiredTigerSessionCache::WiredTigerSessionCache(WT_CONNECTION* conn)
-    : _engine(NULL), _conn(conn), _snapshotManager(_conn), _shuttingDown(0) {}
+    : _engine(NULL),
+      _conn(conn),
+      _snapshotManager(_conn),
+      _shuttingDown(0),
+      _numPartitions(numSessionPartitions()),
+      _partitions(new SessionPartition[_numPartitions]) {}
 
 WiredTigerSessionCache::~WiredTigerSessionCache() {
     shuttingDown();
@@ -238,9 +301,14 @@ void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint) {
 }
 
 void WiredTigerSessionCache::closeAllCursors(const std::string& uri) {
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeAllCursors(uri);
+    for (size_t i = 0; i < _numPartitions; i++) {
+        SessionPartition& partition = _partitions[i];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
+        for (SessionCache::iterator it = partition.sessions.begin();
+             it != partition.sessions.end();
+             it++) {
+            (*it)->closeAllCursors(uri);
+        }
     }
 }
 
@@ -248,20 +316,29 @@ void WiredTigerSessionCache::closeCursorsForQueuedDrops() {
     // Increment the cursor epoch so that all cursors from this epoch are closed.
     uint64_t cursorEpoch = _cursorEpoch.addAndFetch(1);
 
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeCursorsForQueuedDrops(cursorEpoch, _engine);
+    for (size_t i = 0; i < _numPartitions; i++) {
+        SessionPartition& partition = _partitions[i];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
+        for (SessionCache::iterator it = partition.sessions.begin();
+             it != partition.sessions.end();
+             it++) {
+            (*it)->closeCursorsForQueuedDrops(cursorEpoch, _engine);
+        }
     }
 }
 
 void WiredTigerSessionCache::closeAll() {
-    // Increment the epoch as we are now closing all sessions with this epoch.
-    SessionCache swap;
+    // Increment the epoch as we are now closing all sessions with this epoch. This must happen
+    // before the partitions are emptied: a session released to a partition after it was emptied
+    // then sees the new epoch under the partition lock and is deleted instead of cached.
+    _epoch.fetchAndAdd(1);
 
-    {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        _epoch.fetchAndAdd(1);
-        _sessions.swap(swap);
+    SessionCache swap;
+    for (size_t i = 0; i < _numPartitions; i++) {
+        SessionPartition& partition = _partitions[i];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
+        swap.insert(swap.end(), partition.sessions.begin(), partition.sessions.end());
+        partition.sessions.clear();
     }
 
     for (SessionCache::iterator i = swap.begin(); i != swap.end(); i++) {
@@ -269,23 +346,41 @@ void WiredTigerSessionCache::closeAll() {
     }
 }
 
+size_t WiredTigerSessionCache::_partitionForCurrentThread() const {
+#if defined(__linux__)
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        return static_cast<size_t>(cpu) % _numPartitions;
+    }
+#endif
+    return std::hash<stdx::thread::id>()(stdx::this_thread::get_id()) % _numPartitions;
+}
+
 bool WiredTigerSessionCache::isEphemeral() {
     return _engine && _engine->isEphemeral();
 }
 
-WiredTigerSession* WiredTigerSessionCache::getSession() {
+WiredTigerSession* WiredTigerSessionCache::getSession(uint64_t tableIdHint) {
     // We should never be able to get here after _shuttingDown is set, because no new
     // operations should be allowed to start.
     invariant(!(_shuttingDown.loadRelaxed() & kShuttingDownMask));
 
+    const size_t home = _partitionForCurrentThread();
     {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        if (!_sessions.empty()) {
-            // Get the most recently used session so that if we discard sessions, we're
-            // discarding older ones
-            WiredTigerSession* cachedSession = _sessions.back();
-            _sessions.pop_back();
-            return cachedSession;
+        SessionPartition& partition = _partitions[home];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
+        if (!partition.sessions.empty()) {
+            return takeSession(&partition.sessions, tableIdHint);
+        }
+    }
+
+    // Rather than open a new session, take one released on another core. Partitions that are
+    // busy are skipped instead of waited for.
+    for (size_t i = 1; i < _numPartitions; i++) {
+        SessionPartition& partition = _partitions[(home + i) % _numPartitions];
+        stdx::unique_lock<stdx::mutex> lock(partition.lock, stdx::try_to_lock);
+        if (lock.owns_lock() && !partition.sessions.empty()) {
+            return takeSession(&partition.sessions, tableIdHint);
         }
     }
 
@@ -332,10 +427,11 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
     uint64_t currentEpoch = _epoch.load();
 
     if (session->_getEpoch() == currentEpoch) {  // check outside of lock to reduce contention
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
+        SessionPartition& partition = _partitions[_partitionForCurrentThread()];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
         if (session->_getEpoch() == _epoch.load()) {  // recheck inside the lock for correctness
             returnedToCache = true;
-            _sessions.push_back(session);
+            partition.sessions.push_back(session);
         }
     } else
         invariant(session->_getEpoch() < currentEpoch);
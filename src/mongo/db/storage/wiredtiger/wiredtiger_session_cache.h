@@ -31,8 +31,11 @@
 
 #pragma once
 
+#include <limits>
 #include <list>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/thread/shared_mutex.hpp>
 #include <wiredtiger.h>
@@ -95,6 +98,11 @@ public:
         return _cursorsOut;
     }
 
+    /**
+     * Returns true if a released cursor for the table 'id' is cached in this session.
+     */
+    bool hasCachedCursor(uint64_t id) const;
+
     static uint64_t genTableId();
 
     /**
@@ -129,19 +137,27 @@ private:
 /**
  *  This cache implements a shared pool of WiredTiger sessions with the goal to amortize the
  *  cost of session creation and destruction over multiple uses.
+ *
+ *  Released sessions are kept in one partition per core, so that threads running on different
+ *  cores don't contend on a single lock. Threads get and release sessions through the partition
+ *  of the core they run on, and only take sessions from other partitions when that is empty.
  */
 class WiredTigerSessionCache {
 public:
+    static const uint64_t kNoTableIdHint = std::numeric_limits<uint64_t>::max();
+
     WiredTigerSessionCache(WiredTigerKVEngine* engine);
     WiredTigerSessionCache(WT_CONNECTION* conn);
     ~WiredTigerSessionCache();
 
     /**
-     * Returns a previously released session for reuse, or creates a new session.
+     * Returns a previously released session for reuse, or creates a new session. If
+     * 'tableIdHint' is given, a recently used session with a cached cursor on that table is
+     * preferred, so that the caller doesn't have to open a new one.
      * This method must only be called while holding the global lock to avoid races with
      * shuttingDown, but otherwise is thread safe.
      */
-    WiredTigerSession* getSession();
+    WiredTigerSession* getSession(uint64_t tableIdHint = kNoTableIdHint);
 
     /**
      * Returns a session to the cache for later reuse. If closeAll was called between getting this
@@ -195,6 +211,18 @@ public:
     void setJournalListener(JournalListener* jl);
 
 private:
+    typedef std::vector<WiredTigerSession*> SessionCache;
+
+    struct SessionPartition {
+        stdx::mutex lock;
+        SessionCache sessions;
+
+        // Keeps the locks of neighboring partitions on separate cache lines.
+        char padding[64];
+    };
+
+    size_t _partitionForCurrentThread() const;
+
     WiredTigerKVEngine* _engine;  // not owned, might be NULL
     WT_CONNECTION* _conn;         // not owned
     WiredTigerSnapshotManager _snapshotManager;
@@ -205,15 +233,14 @@ private:
     AtomicUInt32 _shuttingDown;
     static const uint32_t kShuttingDownMask = 1 << 31;
 
-    stdx::mutex _cacheLock;
-    typedef std::vector<WiredTigerSession*> SessionCache;
-    SessionCache _sessions;
+    const size_t _numPartitions;
+    std::unique_ptr<SessionPartition[]> _partitions;
 
     // Bumped when all open sessions need to be closed
-    AtomicUInt64 _epoch;  // atomic so we can check it outside of the lock
+    AtomicUInt64 _epoch;  // atomic so we can check it outside of the partition locks
 
     // Bumped when all open cursors need to be closed
-    AtomicUInt64 _cursorEpoch;  // atomic so we can check it outside of the lock
+    AtomicUInt64 _cursorEpoch;  // atomic so we can check it outside of the partition locks
 
     // Counter and critical section mutex for waitUntilDurable
     AtomicUInt32 _lastSyncTime;
@@ -0,0 +1,117 @@
+// wiredtiger_ticket_sizer.cpp
+
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_sizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace mongo {
+
+namespace {
+
+// The baseline latency follows new minimums immediately but only rises this much per interval,
+// so it tracks a workload that legitimately gets slower without forgetting what fast looks like.
+const double kBaselineDrift = 1.02;
+
+// A pool is saturated once on average at least this many operations wait for a ticket.
+const double kSaturatedQueue = 0.5;
+
+// Never shrink by more than this in one interval because of latency alone.
+const double kMinGradient = 0.5;
+
+// How much a write pool shrinks per interval while the cache is under eviction pressure.
+const double kCachePressureFactor = 0.75;
+
+// Largest change of the pool size in one interval, as a fraction of its size.
+const double kMaxStep = 0.25;
+
+// Changes smaller than this fraction of the pool size (or 2 tickets) are not worth making.
+const double kHysteresis = 0.05;
+
+}  // namespace
+
+const int WiredTigerTicketSizer::kMinTickets;
+
+WiredTigerTicketSizer::Decision WiredTigerTicketSizer::decide(const Observation& obs,
+                                                              int maxSize) {
+    const int minSize = std::min(kMinTickets, maxSize);
+
+    _latencyMicros = 0;
+    if (obs.acquired > 0 && obs.intervalMicros > 0) {
+        _latencyMicros = obs.avgUsed * obs.intervalMicros / obs.acquired;
+    }
+    if (_latencyMicros > 0) {
+        _baselineMicros = _baselineMicros > 0
+            ? std::min(_baselineMicros * kBaselineDrift, _latencyMicros)
+            : _latencyMicros;
+    }
+
+    double target = obs.size;
+    const char* reason;
+    if (obs.cachePressure) {
+        target = obs.size * kCachePressureFactor;
+        reason = "cachePressure";
+    } else if (obs.avgQueued < kSaturatedQueue) {
+        // Nobody waits for a ticket, so the pool size isn't limiting anything. Let it recover.
+        target = maxSize;
+        reason = "unsaturated";
+    } else if (_latencyMicros > 0) {
+        const double gradient =
+            std::max(kMinGradient, std::min(1.0, _baselineMicros / _latencyMicros));
+        target = obs.size * gradient + std::sqrt(static_cast<double>(obs.size));
+        reason = "latency";
+    } else {
+        // Operations are queued but none completed, so there is nothing to learn from.
+        reason = "noProgress";
+    }
+
+    target = std::max(target, obs.size * (1 - kMaxStep));
+    target = std::min(target, obs.size * (1 + kMaxStep));
+
+    int newSize = static_cast<int>(std::lround(target));
+    newSize = std::max(minSize, std::min(maxSize, newSize));
+
+    // Reaching a bound is always allowed, otherwise the pool could stop just short of it.
+    const bool inBounds = obs.size >= minSize && obs.size <= maxSize;
+    const bool atBound = newSize == minSize || newSize == maxSize;
+    if (inBounds && !atBound &&
+        std::abs(newSize - obs.size) < std::max(2.0, obs.size * kHysteresis)) {
+        newSize = obs.size;
+    }
+
+    return {newSize, reason};
+}
+
+}  // namespace mongo
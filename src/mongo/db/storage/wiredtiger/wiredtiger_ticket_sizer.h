@@ -0,0 +1,88 @@
+// wiredtiger_ticket_sizer.h
+
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+/**
+ * Decides how many tickets one of the WiredTiger ticket pools (concurrent read or write
+ * transactions) should have, from what was observed about the pool over the last interval.
+ *
+ * The time an operation holds a ticket is estimated with Little's law, as the average number of
+ * tickets in use divided by the rate at which tickets were acquired. While operations queue for
+ * tickets, the pool is resized by the ratio of the lowest recently seen latency to the current
+ * one, plus a small allowance to probe for more concurrency. It therefore keeps growing while
+ * more concurrency doesn't cost latency, and shrinks once it does. Write pools also shrink while
+ * the cache is under eviction pressure, since more writers only add dirty data. Small changes are
+ * skipped and each step is limited, so that noise doesn't make the size oscillate.
+ */
+class WiredTigerTicketSizer {
+public:
+    struct Observation {
+        int size = 0;               // Tickets in the pool during the interval.
+        double avgUsed = 0;         // Time-averaged number of tickets in use.
+        double avgQueued = 0;       // Time-averaged number of operations waiting for a ticket.
+        long long acquired = 0;     // Tickets acquired during the interval.
+        long long intervalMicros = 0;
+        bool cachePressure = false;
+    };
+
+    struct Decision {
+        int size;
+        const char* reason;
+    };
+
+    static const int kMinTickets = 16;
+
+    /**
+     * Returns the size the pool should have for the next interval, which is never above
+     * 'maxSize' nor below kMinTickets (or 'maxSize' if that is lower).
+     */
+    Decision decide(const Observation& obs, int maxSize);
+
+    /**
+     * Ticket hold time estimated for the last interval, or 0 if no ticket was acquired in it.
+     */
+    double latencyMicros() const {
+        return _latencyMicros;
+    }
+
+    double baselineLatencyMicros() const {
+        return _baselineMicros;
+    }
+
+private:
+    double _latencyMicros = 0;
+    double _baselineMicros = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,140 @@
+// wiredtiger_ticket_sizer_test.cpp
+
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_sizer.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const long long kIntervalMicros = 1000 * 1000;
+
+/**
+ * Observation of a saturated pool in which each operation holds its ticket for 'latencyMicros'.
+ */
+WiredTigerTicketSizer::Observation saturated(int size, double latencyMicros) {
+    WiredTigerTicketSizer::Observation obs;
+    obs.size = size;
+    obs.avgUsed = size;
+    obs.avgQueued = size;
+    obs.acquired = static_cast<long long>(size * kIntervalMicros / latencyMicros);
+    obs.intervalMicros = kIntervalMicros;
+    return obs;
+}
+
+TEST(WiredTigerTicketSizerTest, GrowsBackToMaxWhenNotSaturated) {
+    WiredTigerTicketSizer sizer;
+    WiredTigerTicketSizer::Observation obs;
+    obs.size = 32;
+    obs.avgUsed = 3;
+    obs.acquired = 1000;
+    obs.intervalMicros = kIntervalMicros;
+
+    auto decision = sizer.decide(obs, 128);
+    ASSERT_EQUALS(40, decision.size);
+    ASSERT_EQUALS(std::string("unsaturated"), decision.reason);
+
+    obs.size = 120;
+    ASSERT_EQUALS(128, sizer.decide(obs, 128).size);
+}
+
+TEST(WiredTigerTicketSizerTest, ProbesUpWhileLatencyHolds) {
+    WiredTigerTicketSizer sizer;
+    auto decision = sizer.decide(saturated(64, 1000), 128);
+    ASSERT_EQUALS(72, decision.size);
+    ASSERT_EQUALS(std::string("latency"), decision.reason);
+    ASSERT_EQUALS(1000, sizer.latencyMicros());
+    ASSERT_EQUALS(1000, sizer.baselineLatencyMicros());
+}
+
+TEST(WiredTigerTicketSizerTest, ShrinksWhenLatencyRises) {
+    WiredTigerTicketSizer sizer;
+    sizer.decide(saturated(64, 1000), 128);
+
+    // Twice the baseline latency would nearly halve the pool, but a step is limited to 25%.
+    ASSERT_EQUALS(48, sizer.decide(saturated(64, 2000), 128).size);
+    ASSERT_EQUALS(1000 * 1.02, sizer.baselineLatencyMicros());
+
+    // A smaller increase moves the size proportionally to the drifted baseline.
+    ASSERT_APPROX_EQUAL(
+        64 * (1000 * 1.02 * 1.02) / 1500 + 8, sizer.decide(saturated(64, 1500), 128).size, 1);
+}
+
+TEST(WiredTigerTicketSizerTest, HoldsWithinHysteresisBand) {
+    WiredTigerTicketSizer sizer;
+    sizer.decide(saturated(100, 1000), 128);
+
+    // 100 * (1020 / 1100) + 10 is within 5% of 100.
+    auto decision = sizer.decide(saturated(100, 1100), 128);
+    ASSERT_EQUALS(100, decision.size);
+    ASSERT_EQUALS(std::string("latency"), decision.reason);
+}
+
+TEST(WiredTigerTicketSizerTest, ShrinksUnderCachePressureDownToMinimum) {
+    WiredTigerTicketSizer sizer;
+    auto obs = saturated(128, 1000);
+    obs.cachePressure = true;
+
+    auto decision = sizer.decide(obs, 128);
+    ASSERT_EQUALS(96, decision.size);
+    ASSERT_EQUALS(std::string("cachePressure"), decision.reason);
+
+    obs.size = 18;
+    ASSERT_EQUALS(WiredTigerTicketSizer::kMinTickets, sizer.decide(obs, 128).size);
+    obs.size = WiredTigerTicketSizer::kMinTickets;
+    ASSERT_EQUALS(WiredTigerTicketSizer::kMinTickets, sizer.decide(obs, 128).size);
+}
+
+TEST(WiredTigerTicketSizerTest, HoldsWhenNothingCompletes) {
+    WiredTigerTicketSizer sizer;
+    auto obs = saturated(64, 1000);
+    obs.acquired = 0;
+
+    auto decision = sizer.decide(obs, 128);
+    ASSERT_EQUALS(64, decision.size);
+    ASSERT_EQUALS(0, sizer.latencyMicros());
+}
+
+TEST(WiredTigerTicketSizerTest, StaysWithinConfiguredMaximum) {
+    WiredTigerTicketSizer sizer;
+    ASSERT_EQUALS(32, sizer.decide(saturated(64, 1000), 32).size);
+    ASSERT_EQUALS(8, sizer.decide(saturated(8, 1000), 8).size);
+
+    auto obs = saturated(8, 1000);
+    obs.cachePressure = true;
+    ASSERT_EQUALS(8, sizer.decide(obs, 8).size);
+}
+
+}  // namespace
+}  // namespace mongo
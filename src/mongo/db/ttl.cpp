@@ -121,6 +121,7 @@ private:
     void doTTLPass() {
         // Count it as active from the moment the TTL thread wakes up
         OperationContextImpl txn;
+        txn.lockState()->setAdmissionPriority(TicketHolder::Priority::kHigh);
 
         // if part of replSet but not in a readable state (e.g. during initial sync), skip.
         if (repl::getGlobalReplicationCoordinator()->getReplicationMode() ==
@@ -236,6 +236,45 @@ public:
     }
 };
 
+/**
+ * Reads a few of 200 fields from wide documents, as a pipeline with narrow dependencies does.
+ */
+class NarrowAccess : public Base {
+public:
+    static const int kNumDocs = 200;
+    static const int kNumFields = 200;
+
+    void run() {
+        vector<BSONObj> docs;
+        for (int i = 0; i < kNumDocs; i++) {
+            BSONObjBuilder bob;
+            bob.append("_id", i);
+            for (int j = 0; j < kNumFields; j++) {
+                const std::string name = str::stream() << "f" << j;
+                if (j % 10 == 5) {
+                    bob.append(name, BSON("x" << j << "y" << BSON_ARRAY(j << j)));
+                } else if (j % 2) {
+                    bob.append(name, str::stream() << "a string longer than sixteen bytes " << j);
+                } else {
+                    bob.append(name, j);
+                }
+            }
+            docs.push_back(bob.obj());
+        }
+        client.insert(nss.ns(), docs);
+
+        createSource();
+        int numDocs = 0;
+        while (boost::optional<Document> next = source()->getNext()) {
+            ASSERT_EQUALS(Value(0), next->getField("f0"));
+            ASSERT_EQUALS(Value(150), next->getField("f150"));
+            ASSERT_EQUALS(Value(15), next->getNestedField(FieldPath("f15.x")));
+            numDocs++;
+        }
+        ASSERT_EQUALS(kNumDocs, numDocs);
+    }
+};
+
 }  // namespace DocumentSourceCursor
 
 class All : public Suite {
@@ -247,6 +286,7 @@ public:
         add<DocumentSourceCursor::Dispose>();
         add<DocumentSourceCursor::IterateDispose>();
         add<DocumentSourceCursor::LimitCoalesce>();
+        add<DocumentSourceCursor::NarrowAccess>();
     }
 };
 
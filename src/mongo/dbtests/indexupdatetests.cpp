@@ -42,6 +42,12 @@
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/dbtests/dbtests.h"
 
+namespace mongo {
+extern std::atomic<bool> failIndexKeyTooLong;                       // NOLINT
+extern std::atomic<int> internalIndexBuildKeyGenerationThreads;      // NOLINT
+extern std::atomic<long long> internalIndexBuildParallelMinRecords;  // NOLINT
+}  // namespace mongo
+
 namespace IndexUpdateTests {
 
 using std::unique_ptr;
@@ -470,6 +476,69 @@ public:
     }
 };
 
+/**
+ * A foreground index build that generates keys on several threads fails on a key that is too long,
+ * unless failIndexKeyTooLong is off, in which case the key is left out.
+ */
+template <bool failOnKeyTooLong>
+class InsertBuildParallelKeyTooLong : public IndexBuildBase {
+public:
+    InsertBuildParallelKeyTooLong()
+        : _oldFailIndexKeyTooLong(failIndexKeyTooLong.load()),
+          _oldKeyGenerationThreads(internalIndexBuildKeyGenerationThreads.load()),
+          _oldParallelMinRecords(internalIndexBuildParallelMinRecords.load()) {
+        failIndexKeyTooLong.store(failOnKeyTooLong);
+        internalIndexBuildKeyGenerationThreads.store(4);
+        internalIndexBuildParallelMinRecords.store(0);
+    }
+
+    ~InsertBuildParallelKeyTooLong() {
+        failIndexKeyTooLong.store(_oldFailIndexKeyTooLong);
+        internalIndexBuildKeyGenerationThreads.store(_oldKeyGenerationThreads);
+        internalIndexBuildParallelMinRecords.store(_oldParallelMinRecords);
+    }
+
+    void run() {
+        // Create a new collection.
+        Database* db = _ctx.db();
+        Collection* coll;
+        {
+            WriteUnitOfWork wunit(&_txn);
+            db->dropCollection(&_txn, _ns);
+            coll = db->createCollection(&_txn, _ns);
+
+            for (int i = 0; i < 1000; ++i) {
+                ASSERT_OK(coll->insertDocument(&_txn, BSON("_id" << i << "a" << i), true));
+            }
+            ASSERT_OK(coll->insertDocument(
+                &_txn, BSON("_id" << 1000 << "a" << std::string(2000, 'x')), true));
+            wunit.commit();
+        }
+
+        MultiIndexBlock indexer(&_txn, coll);
+        const BSONObj spec = BSON("name"
+                                  << "a"
+                                  << "ns" << coll->ns().ns() << "key" << BSON("a" << 1));
+        ASSERT_OK(indexer.init(spec));
+
+        const Status status = indexer.insertAllDocumentsInCollection();
+        if (failOnKeyTooLong) {
+            ASSERT_EQUALS(ErrorCodes::KeyTooLong, status.code());
+            return;
+        }
+
+        ASSERT_OK(status);
+        WriteUnitOfWork wunit(&_txn);
+        indexer.commit();
+        wunit.commit();
+    }
+
+private:
+    const bool _oldFailIndexKeyTooLong;
+    const int _oldKeyGenerationThreads;
+    const long long _oldParallelMinRecords;
+};
+
 /** Index creation is killed if mayInterrupt is true. */
 class InsertBuildIndexInterrupt : public IndexBuildBase {
 public:
@@ -901,6 +970,8 @@ public:
         add<InsertBuildEnforceUnique<false>>();
         add<InsertBuildFillDups<true>>();
         add<InsertBuildFillDups<false>>();
+        add<InsertBuildParallelKeyTooLong<true>>();
+        add<InsertBuildParallelKeyTooLong<false>>();
         add<InsertBuildIndexInterrupt>();
         add<InsertBuildIndexInterruptDisallowed>();
         add<InsertBuildIdIndexInterrupt>();
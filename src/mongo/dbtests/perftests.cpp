@@ -45,24 +45,43 @@
 #include <iomanip>
 #include <iostream>
 #include <mutex>
+#include <random>
 
+#include "mongo/bson/bson_validate.h"
 #include "mongo/config.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/db/repl/sync_tail.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/mmap_v1/mmap.h"
 #include "mongo/db/storage/storage_options.h"
+#ifdef MONGO_CONFIG_WIREDTIGER_ENABLED
+#include "mongo/db/storage/wiredtiger/wiredtiger_capped_visibility.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#endif
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/dbtests/framework_options.h"
 #include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/old_thread_pool.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/log.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/version.h"
 
+#include "mongo/db/sorter/sorter.cpp"
+
 namespace PerfTests {
 
 using std::cout;
@@ -254,6 +273,11 @@ public:
         return false;
     }
 
+    /** Numbers of threads to run timed2() with if testThreaded(), each reported separately. */
+    virtual vector<int> threadCounts() {
+        return {8};
+    }
+
     int howLong() {
         int hlm = howLongMillis();
         DEV {
@@ -311,11 +335,16 @@ public:
         }
 
         if (testThreaded()) {
-            const int nThreads = 8;
-            // cout << "testThreaded nThreads:" << nThreads << endl;
-            mongo::Timer t;
-            const unsigned long long result = launchThreads(nThreads);
-            say(result / nThreads, t.micros(), test2name + "-threaded");
+            const vector<int> counts = threadCounts();
+            for (int nThreads : counts) {
+                // cout << "testThreaded nThreads:" << nThreads << endl;
+                mongo::Timer t;
+                const unsigned long long result = launchThreads(nThreads);
+                const string threadedName = counts.size() == 1
+                    ? test2name + "-threaded"
+                    : str::stream() << test2name << "-threaded-" << nThreads;
+                say(result / nThreads, t.micros(), threadedName);
+            }
         }
     }
 
@@ -444,6 +473,758 @@ public:
     }
 };
 
+/**
+ * Applies batches of inserts into one collection through the repl writer threads, as a secondary
+ * does, with and without the writers grouping runs of inserts into a single batched insert. Each
+ * timed() call applies one batch, so ops/sec is the reported rate times kBatchSize.
+ */
+class ReplApplyInsertsBase : public B {
+public:
+    static const int kBatchSize = 1000;
+    static const int kWriters = 4;
+
+    explicit ReplApplyInsertsBase(bool groupInserts)
+        : _groupInserts(groupInserts), _writerPool(kWriters, "perfReplWriter") {}
+
+    virtual int howLongMillis() {
+        return 2000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1;
+    }
+
+    void prep() {
+        ASSERT(client()->createCollection(ns()));
+        _setGroupInserts(_groupInserts);
+    }
+
+    void timed() {
+        // Partition the inserts by _id as fillWriterVectors() does for doc-locking engines.
+        std::vector<std::vector<BSONObj>> writerVectors(kWriters);
+        for (int i = 0; i < kBatchSize; i++) {
+            const int id = _nextId++;
+            writerVectors[id % kWriters].push_back(BSON("ts" << Timestamp(1, id) << "h" << 1LL
+                                                             << "v" << 2 << "op"
+                                                             << "i"
+                                                             << "ns" << ns() << "o"
+                                                             << BSON("_id" << id << "x"
+                                                                           << "abcdefghijkl")));
+        }
+
+        for (auto&& ops : writerVectors) {
+            _writerPool.schedule(&repl::multiSyncApply, stdx::cref(ops), nullptr);
+        }
+        _writerPool.join();
+    }
+
+    void post() {
+        ASSERT_EQUALS(static_cast<unsigned long long>(_nextId), client()->count(ns()));
+        _setGroupInserts(true);
+    }
+
+private:
+    static void _setGroupInserts(bool groupInserts) {
+        auto param = ServerParameterSet::getGlobal()->getMap().find("replApplyGroupInserts");
+        invariant(param != ServerParameterSet::getGlobal()->getMap().end());
+        ASSERT_OK(param->second->setFromString(groupInserts ? "true" : "false"));
+    }
+
+    const bool _groupInserts;
+    OldThreadPool _writerPool;
+    int _nextId = 0;
+};
+
+class ReplApplyInsertsSingle : public ReplApplyInsertsBase {
+public:
+    ReplApplyInsertsSingle() : ReplApplyInsertsBase(false) {}
+    string name() {
+        return "repl-apply-inserts-x1000";
+    }
+};
+
+class ReplApplyInsertsGrouped : public ReplApplyInsertsBase {
+public:
+    ReplApplyInsertsGrouped() : ReplApplyInsertsBase(true) {}
+    string name() {
+        return "repl-apply-inserts-x1000-grouped";
+    }
+};
+
+/**
+ * Validates one document per timed() call, as objcheck does for every incoming document, for
+ * documents of several shapes.
+ */
+class ValidateBSONBase : public B {
+public:
+    virtual int howLongMillis() {
+        return 1000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1000;
+    }
+
+    void prep() {
+        _doc = makeDocument();
+    }
+
+    void timed() {
+        ASSERT_OK(validateBSON(_doc.objdata(), _doc.objsize()));
+    }
+
+protected:
+    virtual BSONObj makeDocument() = 0;
+
+private:
+    BSONObj _doc;
+};
+
+class ValidateBSONFlat : public ValidateBSONBase {
+public:
+    string name() {
+        return "validate-bson-flat";
+    }
+    BSONObj makeDocument() {
+        BSONObjBuilder b;
+        b.append("_id", OID::gen());
+        for (int i = 0; i < 20; i++) {
+            const string field = str::stream() << "f" << i;
+            switch (i % 4) {
+                case 0:
+                    b.append(field, i);
+                    break;
+                case 1:
+                    b.append(field, i * 1.5);
+                    break;
+                case 2:
+                    b.append(field, "value");
+                    break;
+                case 3:
+                    b.appendDate(field, Date_t::fromMillisSinceEpoch(i));
+                    break;
+            }
+        }
+        return b.obj();
+    }
+};
+
+class ValidateBSONDeepNesting : public ValidateBSONBase {
+public:
+    string name() {
+        return "validate-bson-deep-nesting";
+    }
+    BSONObj makeDocument() {
+        BSONObj doc = BSON("leaf" << 1);
+        for (int i = 0; i < 90; i++) {
+            doc = BSON("level" << i << "child" << doc);
+        }
+        return doc;
+    }
+};
+
+class ValidateBSONBigArray : public ValidateBSONBase {
+public:
+    string name() {
+        return "validate-bson-big-array";
+    }
+    BSONObj makeDocument() {
+        BSONArrayBuilder arr;
+        for (int i = 0; i < 1000; i++) {
+            arr.append(i);
+        }
+        return BSON("_id" << 1 << "values" << arr.arr());
+    }
+};
+
+class ValidateBSONLongStrings : public ValidateBSONBase {
+public:
+    string name() {
+        return "validate-bson-long-strings";
+    }
+    BSONObj makeDocument() {
+        BSONObjBuilder b;
+        b.append("_id", 1);
+        for (int i = 0; i < 10; i++) {
+            const string field = str::stream() << "description_of_item_" << i;
+            b.append(field, string(1024, 'x'));
+        }
+        return b.obj();
+    }
+};
+
+/**
+ * Looks up cached plans, as every find of a cacheable query shape does, from one thread and then
+ * from several at once to measure contention on the plan cache.
+ */
+class PlanCacheGetBase : public B {
+public:
+    virtual int howLongMillis() {
+        return 1000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1000;
+    }
+    virtual bool testThreaded() {
+        return true;
+    }
+
+    void prep() {
+        _planCache.reset(new PlanCache());
+        _queries.clear();
+        for (int i = 0; i < numShapes(); i++) {
+            // Each field name makes a distinct query shape.
+            const string field = str::stream() << "f" << i;
+            auto statusWithCQ =
+                CanonicalQuery::canonicalize(NamespaceString(ns()), BSON(field << 1 << "x" << 1));
+            ASSERT_OK(statusWithCQ.getStatus());
+            _queries.push_back(std::move(statusWithCQ.getValue()));
+
+            QuerySolution qs;
+            qs.cacheData.reset(new SolutionCacheData());
+            qs.cacheData->solnType = SolutionCacheData::COLLSCAN_SOLN;
+            qs.cacheData->tree.reset(new PlanCacheIndexTree());
+            std::vector<QuerySolution*> solns{&qs};
+            ASSERT_OK(_planCache->add(*_queries.back(), solns, makeDecision()));
+        }
+    }
+
+    void timed() {
+        lookUp();
+    }
+
+    void timed2(DBClientBase*) {
+        lookUp();
+    }
+
+    string name2() {
+        return name() + "-2";
+    }
+
+protected:
+    virtual int numShapes() = 0;
+
+private:
+    static PlanRankingDecision* makeDecision() {
+        std::unique_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        std::unique_ptr<PlanStageStats> stats(
+            new PlanStageStats(CommonStats("COLLSCAN"), STAGE_COLLSCAN));
+        stats->specific.reset(new CollectionScanStats());
+        why->stats.mutableVector().push_back(stats.release());
+        why->scores.push_back(0U);
+        why->candidateOrder.push_back(0U);
+        return why.release();
+    }
+
+    void lookUp() {
+        // Each thread cycles through the shapes on its own, without sharing a counter.
+        static MONGO_TRIVIALLY_CONSTRUCTIBLE_THREAD_LOCAL unsigned next;
+        const CanonicalQuery& cq = *_queries[next++ % _queries.size()];
+
+        CachedSolution* rawCachedSoln;
+        ASSERT_OK(_planCache->get(cq, &rawCachedSoln));
+        delete rawCachedSoln;
+    }
+
+    std::unique_ptr<PlanCache> _planCache;
+    vector<std::unique_ptr<CanonicalQuery>> _queries;
+};
+
+class PlanCacheGetManyShapes : public PlanCacheGetBase {
+public:
+    string name() {
+        return "plan-cache-get-many-shapes";
+    }
+    int numShapes() {
+        return 200;
+    }
+};
+
+/** All threads look up the same entry, so they share one partition of the cache. */
+class PlanCacheGetOneShape : public PlanCacheGetBase {
+public:
+    string name() {
+        return "plan-cache-get-one-shape";
+    }
+    int numShapes() {
+        return 1;
+    }
+};
+
+#ifdef MONGO_CONFIG_WIREDTIGER_ENABLED
+/**
+ * Gets a session from the WiredTiger session cache and releases it again, as every operation does,
+ * from 1 up to 128 threads at once. The rates are per thread. Does nothing unless the storage
+ * engine is WiredTiger.
+ */
+class WiredTigerSessionCacheGetRelease : public B {
+public:
+    virtual int howLongMillis() {
+        return 1000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1000;
+    }
+    virtual bool testThreaded() {
+        return true;
+    }
+    virtual vector<int> threadCounts() {
+        return {1, 2, 4, 8, 16, 32, 64, 128};
+    }
+
+    string name() {
+        return "wt-session-cache-get-release";
+    }
+    string name2() {
+        return name() + "-2";
+    }
+
+    void prep() {
+        _sessionCache = nullptr;
+        if (storageGlobalParams.engine == "wiredTiger") {
+            _sessionCache = WiredTigerRecoveryUnit::get(txn())->getSessionCache();
+        }
+    }
+
+    void timed() {
+        getAndRelease();
+    }
+
+    void timed2(DBClientBase*) {
+        getAndRelease();
+    }
+
+private:
+    void getAndRelease() {
+        if (!_sessionCache) {
+            return;
+        }
+        WiredTigerSession* session = _sessionCache->getSession();
+        _sessionCache->releaseSession(session);
+    }
+
+    WiredTigerSessionCache* _sessionCache = nullptr;
+};
+
+/**
+ * Registers an oplog entry, commits it and computes the visibility bound of a few oplog readers,
+ * from 1 up to 128 threads at once. Registration is serialized here as it is by the caller in
+ * production. The rates are per thread.
+ */
+class WiredTigerOplogVisibility : public B {
+public:
+    virtual int howLongMillis() {
+        return 1000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1000;
+    }
+    virtual bool testThreaded() {
+        return true;
+    }
+    virtual vector<int> threadCounts() {
+        return {1, 2, 4, 8, 16, 32, 64, 128};
+    }
+
+    string name() {
+        return "wt-oplog-visibility";
+    }
+    string name2() {
+        return name() + "-2";
+    }
+
+    void prep() {
+        _visibility.reset(new WiredTigerCappedVisibility(/*deferUntilDurable=*/false));
+        _nextId = 1;
+    }
+
+    void timed() {
+        insertAndRead();
+    }
+
+    void timed2(DBClientBase*) {
+        insertAndRead();
+    }
+
+private:
+    void insertAndRead() {
+        WiredTigerCappedVisibility::Slot* slot;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_registerMutex);
+            slot = _visibility->registerId(RecordId(_nextId++));
+        }
+        _visibility->commit(slot);
+
+        for (int i = 0; i < 4; i++) {
+            const RecordId readTill = _visibility->oplogReadTill();
+            _visibility->isHidden(readTill);
+        }
+    }
+
+    std::unique_ptr<WiredTigerCappedVisibility> _visibility;
+    stdx::mutex _registerMutex;
+    int64_t _nextId = 1;
+};
+#endif
+
+/**
+ * Counts the documents of a collection per value of an indexed field with an aggregation whose
+ * $match and $group are covered by the index. Each timed() call groups all kNumDocs documents, so
+ * documents/sec is the reported rate times kNumDocs.
+ */
+class AggGroupByCountBase : public B {
+public:
+    static const int kNumDocs = 100 * 1000;
+    static const int kNumGroups = 100;
+
+    virtual int howLongMillis() {
+        return 5000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1;
+    }
+
+    void prep() {
+        vector<BSONObj> docs;
+        for (int i = 0; i < kNumDocs; i++) {
+            docs.push_back(BSON("_id" << i << "a" << i % kNumGroups << "b"
+                                      << "abcdefghijklmnopqrstuvwxyz"));
+            if (docs.size() == 1000) {
+                client()->insert(ns(), docs);
+                docs.clear();
+            }
+        }
+        ASSERT_OK(dbtests::createIndex(txn(), ns(), BSON("a" << 1)));
+    }
+
+    void timed() {
+        const BSONObj match = BSON("a" << BSON("$gte" << 0));
+        const BSONObj cmd = BSON("aggregate" << nsToCollectionSubstring(ns()) << "pipeline"
+                                             << BSON_ARRAY(BSON("$match" << match)
+                                                           << BSON("$group" << group()))
+                                             << "cursor" << BSONObj());
+        BSONObj result;
+        ASSERT(client()->runCommand(nsToDatabase(ns()), cmd, result));
+
+        // All the groups fit in the first batch.
+        long long count = 0;
+        BSONObj cursor = result["cursor"].Obj();
+        ASSERT_EQUALS(0LL, cursor["id"].numberLong());
+        BSONForEach(group, cursor["firstBatch"].Obj()) {
+            count += group.Obj()["n"].numberLong();
+        }
+        ASSERT_EQUALS(kNumDocs, count);
+    }
+
+protected:
+    virtual BSONObj group() = 0;
+};
+
+/** The $group reads the index keys that the covered index scan returns. */
+class AggGroupByCountIndexKeys : public AggGroupByCountBase {
+public:
+    string name() {
+        return "agg-group-count-index-keys-x100k";
+    }
+    BSONObj group() {
+        return BSON("_id"
+                    << "$a"
+                    << "n" << BSON("$sum" << 1));
+    }
+};
+
+/**
+ * The same grouping through an expression that can't read index keys, so each key is made into a
+ * Document first.
+ */
+class AggGroupByCountDocuments : public AggGroupByCountBase {
+public:
+    string name() {
+        return "agg-group-count-documents-x100k";
+    }
+    BSONObj group() {
+        return BSON("_id" << BSON("$add" << BSON_ARRAY("$a" << 0)) << "n" << BSON("$sum" << 1));
+    }
+};
+
+/**
+ * Sorts kNumDocs unindexed documents and returns the first few that pass a $match placed after a
+ * $project. Once the $match moves ahead of the $project, the $limit reaches the $sort, which then
+ * keeps only the top documents instead of sorting the whole collection in memory.
+ */
+class AggSortProjectMatchLimit : public B {
+public:
+    static const int kNumDocs = 100 * 1000;
+    static const int kLimit = 10;
+
+    string name() {
+        return "agg-sort-project-match-limit-x100k";
+    }
+    virtual int howLongMillis() {
+        return 5000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1;
+    }
+
+    void prep() {
+        vector<BSONObj> docs;
+        for (int i = 0; i < kNumDocs; i++) {
+            docs.push_back(BSON("_id" << i << "a" << (i * 7919) % kNumDocs << "b"
+                                      << "abcdefghijklmnopqrstuvwxyz"));
+            if (docs.size() == 1000) {
+                client()->insert(ns(), docs);
+                docs.clear();
+            }
+        }
+    }
+
+    void timed() {
+        const BSONObj cmd =
+            BSON("aggregate" << nsToCollectionSubstring(ns()) << "pipeline"
+                             << BSON_ARRAY(BSON("$sort" << BSON("a" << 1))
+                                           << BSON("$project" << BSON("a" << 1 << "b" << 1))
+                                           << BSON("$match" << BSON("b" << BSON("$ne"
+                                                                                << "")))
+                                           << BSON("$limit" << kLimit))
+                             << "cursor" << BSONObj());
+        BSONObj result;
+        ASSERT(client()->runCommand(nsToDatabase(ns()), cmd, result));
+
+        BSONObj cursor = result["cursor"].Obj();
+        ASSERT_EQUALS(0LL, cursor["id"].numberLong());
+        ASSERT_EQUALS(kLimit, cursor["firstBatch"].Obj().nFields());
+    }
+};
+
+/**
+ * Makes a Document from a wide BSON document and reads two of its 200 fields, as a pipeline with
+ * narrow dependencies does for every document it reads.
+ */
+class DocumentNarrowAccessBase : public B {
+public:
+    static const int kNumFields = 200;
+
+    virtual int howLongMillis() {
+        return 1000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 100;
+    }
+
+    void prep() {
+        BSONObjBuilder bob;
+        bob.append("_id", 1);
+        for (int i = 0; i < kNumFields; i++) {
+            const string name = str::stream() << "f" << i;
+            if (i % 10 == 5) {
+                bob.append(name, BSON("x" << i << "y" << BSON_ARRAY(i << i)));
+            } else if (i % 2) {
+                bob.append(name, str::stream() << "a string longer than sixteen bytes " << i);
+            } else {
+                bob.append(name, i);
+            }
+        }
+        _doc = bob.obj();
+    }
+
+    void timed() {
+        const Document doc = makeDocument(_doc);
+        ASSERT_EQUALS(Value(0), doc["f0"]);
+        ASSERT_EQUALS(Value(150), doc["f150"]);
+    }
+
+protected:
+    virtual Document makeDocument(const BSONObj& bson) = 0;
+
+private:
+    BSONObj _doc;
+};
+
+/** Fields are loaded from the BSON as they are accessed. */
+class DocumentNarrowAccessLazy : public DocumentNarrowAccessBase {
+public:
+    string name() {
+        return "document-narrow-access-lazy";
+    }
+    Document makeDocument(const BSONObj& bson) {
+        return Document::fromBsonWithMetaData(bson);
+    }
+};
+
+/** Every field is converted up front. */
+class DocumentNarrowAccessEager : public DocumentNarrowAccessBase {
+public:
+    string name() {
+        return "document-narrow-access-eager";
+    }
+    Document makeDocument(const BSONObj& bson) {
+        return Document(bson);
+    }
+};
+
+/** A key and value for the Sorter benchmarks. */
+class SorterInt {
+public:
+    SorterInt(long long i = 0) : _i(i) {}
+    operator const long long&() const {
+        return _i;
+    }
+
+    struct SorterDeserializeSettings {};  // unused
+    void serializeForSorter(BufBuilder& buf) const {
+        buf.appendNum(_i);
+    }
+    static SorterInt deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
+        return buf.read<long long>();
+    }
+    int memUsageForSorter() const {
+        return sizeof(SorterInt);
+    }
+    SorterInt getOwned() const {
+        return *this;
+    }
+
+private:
+    long long _i;
+};
+
+typedef std::pair<SorterInt, SorterInt> SorterPair;
+typedef SortIteratorInterface<SorterInt, SorterInt> SorterIterator;
+
+class SorterIntComparator {
+public:
+    int operator()(const SorterPair& lhs, const SorterPair& rhs) const {
+        if (lhs.first == rhs.first)
+            return 0;
+        return lhs.first < rhs.first ? -1 : 1;
+    }
+};
+
+const int kSorterNumItems = 1000 * 1000;
+
+/**
+ * Sorts shuffled data four times the memory limit, spilling runs on the adding thread or on
+ * 'SpillThreads' background threads. Each timed() call sorts and reads back all of the data.
+ */
+template <size_t SpillThreads>
+class SorterSpill : public B {
+public:
+    static const size_t kMemoryLimitBytes = kSorterNumItems * sizeof(SorterPair) / 4;
+
+    string name() {
+        return "sorter-spill-1m-threads" + std::to_string(SpillThreads);
+    }
+    virtual int howLongMillis() {
+        return 2000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1;
+    }
+
+    void prep() {
+        _input.resize(kSorterNumItems);
+        for (int i = 0; i < kSorterNumItems; i++) {
+            _input[i] = i;
+        }
+        std::mt19937 rng(0);
+        std::shuffle(_input.begin(), _input.end(), rng);
+    }
+
+    void timed() {
+        const SortOptions opts = SortOptions()
+                                     .TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                     .ExtSortAllowed()
+                                     .MaxMemoryUsageBytes(kMemoryLimitBytes)
+                                     .SpillThreads(SpillThreads);
+        std::unique_ptr<Sorter<SorterInt, SorterInt>> sorter(
+            Sorter<SorterInt, SorterInt>::make(opts, SorterIntComparator()));
+        for (long long i : _input) {
+            sorter->add(i, -i);
+        }
+
+        std::unique_ptr<SorterIterator> it(sorter->done());
+        long long expected = 0;
+        while (it->more()) {
+            ASSERT_EQUALS(expected++, static_cast<long long>(it->next().first));
+        }
+        ASSERT_EQUALS(kSorterNumItems, expected);
+    }
+
+private:
+    std::vector<long long> _input;
+};
+
+/**
+ * Merges 'NumRuns' sorted in-memory runs. Each timed() call copies the runs into iterators and
+ * merges all of them.
+ */
+template <int NumRuns>
+class SorterMerge : public B {
+public:
+    string name() {
+        return "sorter-merge-1m-runs" + std::to_string(NumRuns);
+    }
+    virtual int howLongMillis() {
+        return 2000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    virtual unsigned batchSize() {
+        return 1;
+    }
+
+    void prep() {
+        _runs.resize(NumRuns);
+        for (int i = 0; i < kSorterNumItems; i++) {
+            _runs[i % NumRuns].push_back(SorterPair(i, -i));
+        }
+    }
+
+    void timed() {
+        std::vector<std::shared_ptr<SorterIterator>> iters;
+        for (auto&& run : _runs) {
+            iters.push_back(std::make_shared<sorter::InMemIterator<SorterInt, SorterInt>>(run));
+        }
+
+        std::unique_ptr<SorterIterator> merged(
+            SorterIterator::merge(iters, SortOptions(), SorterIntComparator()));
+        long long expected = 0;
+        while (merged->more()) {
+            ASSERT_EQUALS(expected++, static_cast<long long>(merged->next().first));
+        }
+        ASSERT_EQUALS(kSorterNumItems, expected);
+    }
+
+private:
+    std::vector<std::vector<SorterPair>> _runs;
+};
 
 class All : public Suite {
 public:
@@ -457,6 +1238,30 @@ public:
         add<boosttimed_mutexspeed>();
         add<stdmutexspeed>();
         add<stdtimed_mutexspeed>();
+        add<ReplApplyInsertsSingle>();
+        add<ReplApplyInsertsGrouped>();
+        add<ValidateBSONFlat>();
+        add<ValidateBSONDeepNesting>();
+        add<ValidateBSONBigArray>();
+        add<ValidateBSONLongStrings>();
+        add<PlanCacheGetManyShapes>();
+        add<PlanCacheGetOneShape>();
+#ifdef MONGO_CONFIG_WIREDTIGER_ENABLED
+        add<WiredTigerSessionCacheGetRelease>();
+        add<WiredTigerOplogVisibility>();
+#endif
+        add<AggGroupByCountIndexKeys>();
+        add<AggGroupByCountDocuments>();
+        add<AggSortProjectMatchLimit>();
+        add<DocumentNarrowAccessLazy>();
+        add<DocumentNarrowAccessEager>();
+        add<SorterSpill<0>>();
+        add<SorterSpill<2>>();
+        add<SorterSpill<4>>();
+        add<SorterMerge<2>>();
+        add<SorterMerge<16>>();
+        add<SorterMerge<100>>();
+        add<SorterMerge<1000>>();
     }
 } myall;
 }
@@ -78,7 +78,9 @@ public:
         _client.remove(ns(), obj);
     }
 
-    int countResults(CollectionScanParams::Direction direction, const BSONObj& filterObj) {
+    int countResults(CollectionScanParams::Direction direction,
+                     const BSONObj& filterObj,
+                     size_t batchMatchSize = 0) {
         AutoGetCollectionForRead ctx(&_txn, ns());
 
         // Configure the scan.
@@ -86,6 +88,7 @@ public:
         params.collection = ctx.getCollection();
         params.direction = direction;
         params.tailable = false;
+        params.batchMatchSize = batchMatchSize;
 
         // Make the filter.
         StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(filterObj);
@@ -391,6 +394,215 @@ public:
     }
 };
 
+//
+// Filter blocks of documents smaller than the collection, in both directions.
+//
+
+class QueryStageCollscanBatchMatchSmallBlocks : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        BSONObj obj = BSON("foo" << BSON("$gte" << 10 << "$lt" << 35));
+        ASSERT_EQUALS(25, countResults(CollectionScanParams::FORWARD, obj, 8));
+        ASSERT_EQUALS(25, countResults(CollectionScanParams::BACKWARD, obj, 8));
+
+        // Only part of this filter is evaluated by column.
+        obj = fromjson("{foo: {$lt: 25}, $or: [{foo: {$lt: 5}}, {foo: {$gt: 20}}]}");
+        ASSERT_EQUALS(9, countResults(CollectionScanParams::FORWARD, obj, 8));
+    }
+};
+
+//
+// Delete a document that was read and matched but not yet returned. It is still returned, without
+// its RecordId.
+//
+
+class QueryStageCollscanBatchMatchInvalidateBufferedObject : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_txn, ns());
+
+        Collection* coll = ctx.getCollection();
+
+        // Get the RecordIds that would be returned by an in-order scan.
+        vector<RecordId> locs;
+        getLocs(coll, CollectionScanParams::FORWARD, &locs);
+
+        // Configure the scan.
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+        params.batchMatchSize = 8;
+
+        BSONObj filterObj = BSON("foo" << BSON("$gte" << 0));
+        StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(filterObj);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan(new CollectionScan(&_txn, params, &ws, filterExpr.get()));
+
+        // The first result comes once the first block is filtered.
+        int count = 0;
+        while (count < 1) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan->work(&id);
+            if (PlanStage::ADVANCED == state) {
+                ASSERT_EQUALS(locs[count], ws.get(id)->loc);
+                ++count;
+            }
+        }
+
+        // Remove locs[3], which is waiting to be returned.
+        const BSONObj removed = coll->docFor(&_txn, locs[3]).value().getOwned();
+        scan->saveState();
+        {
+            WriteUnitOfWork wunit(&_txn);
+            scan->invalidate(&_txn, locs[3], INVALIDATION_DELETION);
+            wunit.commit();  // to avoid rollback of the invalidate
+        }
+        remove(removed);
+        scan->restoreState();
+
+        while (!scan->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan->work(&id);
+            if (PlanStage::ADVANCED == state) {
+                WorkingSetMember* member = ws.get(id);
+                if (3 == count) {
+                    ASSERT_FALSE(member->hasLoc());
+                    ASSERT_EQUALS(removed, member->obj.value());
+                } else {
+                    ASSERT_EQUALS(locs[count], member->loc);
+                }
+                ++count;
+            }
+        }
+
+        ASSERT_EQUALS(numObj(), count);
+    }
+};
+
+//
+// Mutate a document that was read but not yet filtered. It keeps its RecordId.
+//
+
+class QueryStageCollscanBatchMatchMutateUnfilteredObject : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_txn, ns());
+
+        Collection* coll = ctx.getCollection();
+
+        // Get the RecordIds that would be returned by an in-order scan.
+        vector<RecordId> locs;
+        getLocs(coll, CollectionScanParams::FORWARD, &locs);
+
+        // Configure the scan.
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+        params.batchMatchSize = 8;
+
+        BSONObj filterObj = BSON("foo" << BSON("$gte" << 0));
+        StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(filterObj);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan(new CollectionScan(&_txn, params, &ws, filterExpr.get()));
+
+        // Return the whole first block, then read the first few documents of the second one.
+        int count = 0;
+        while (count < 8) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan->work(&id);
+            if (PlanStage::ADVANCED == state) {
+                ASSERT_EQUALS(locs[count], ws.get(id)->loc);
+                ++count;
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            ASSERT_EQUALS(PlanStage::NEED_TIME, scan->work(&id));
+        }
+
+        // Mutate locs[9], which is waiting for the filter.
+        scan->saveState();
+        {
+            WriteUnitOfWork wunit(&_txn);
+            scan->invalidate(&_txn, locs[9], INVALIDATION_MUTATION);
+            wunit.commit();  // to avoid rollback of the invalidate
+        }
+        scan->restoreState();
+
+        while (!scan->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan->work(&id);
+            if (PlanStage::ADVANCED == state) {
+                ASSERT_EQUALS(locs[count], ws.get(id)->loc);
+                ++count;
+            }
+        }
+
+        ASSERT_EQUALS(numObj(), count);
+    }
+};
+
+//
+// A tailable scan waiting at EOF holds only the last RecordId it returned, so invalidating any
+// other document can skip it.
+//
+class QueryStageCollscanTailableMayHoldRecordId : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_txn, ns());
+
+        Collection* coll = ctx.getCollection();
+
+        vector<RecordId> locs;
+        getLocs(coll, CollectionScanParams::FORWARD, &locs);
+
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = true;
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan(new CollectionScan(&_txn, params, &ws, NULL));
+
+        // Part way through, the open cursor may be positioned on any document.
+        int count = 0;
+        while (count < 10) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == scan->work(&id)) {
+                ++count;
+            }
+        }
+        scan->saveState();
+        ASSERT_TRUE(scan->mayHoldRecordId(locs[0]));
+        ASSERT_TRUE(scan->mayHoldRecordId(locs[numObj() - 1]));
+        scan->restoreState();
+
+        // Run to EOF, which drops the cursor and leaves only the last RecordId returned.
+        for (PlanStage::StageState state = PlanStage::NEED_TIME; PlanStage::IS_EOF != state;) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            state = scan->work(&id);
+            if (PlanStage::ADVANCED == state) {
+                ++count;
+            }
+        }
+        ASSERT_EQUALS(numObj(), count);
+
+        scan->saveState();
+        ASSERT_FALSE(scan->mayHoldRecordId(locs[0]));
+        ASSERT_FALSE(scan->mayHoldRecordId(locs[numObj() - 2]));
+        ASSERT_TRUE(scan->mayHoldRecordId(locs[numObj() - 1]));
+        scan->restoreState();
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("QueryStageCollectionScan") {}
@@ -405,6 +617,10 @@ public:
         add<QueryStageCollscanObjectsInOrderBackward>();
         add<QueryStageCollscanInvalidateUpcomingObject>();
         add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+        add<QueryStageCollscanBatchMatchSmallBlocks>();
+        add<QueryStageCollscanBatchMatchInvalidateBufferedObject>();
+        add<QueryStageCollscanBatchMatchMutateUnfilteredObject>();
+        add<QueryStageCollscanTailableMayHoldRecordId>();
     }
 };
 
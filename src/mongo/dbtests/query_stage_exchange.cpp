@@ -0,0 +1,404 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file tests db/exec/exchange.cpp.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cmath>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/exchange.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/stdx/memory.h"
+
+namespace QueryStageExchange {
+
+using std::unique_ptr;
+using std::vector;
+using stdx::make_unique;
+
+class QueryStageExchangeBase {
+public:
+    QueryStageExchangeBase() : _client(&_txn) {
+        OldClientWriteContext ctx(&_txn, ns());
+        for (int i = 0; i < numObj(); ++i) {
+            _client.insert(ns(), BSON("foo" << i));
+        }
+    }
+
+    virtual ~QueryStageExchangeBase() {
+        OldClientWriteContext ctx(&_txn, ns());
+        _client.dropCollection(ns());
+    }
+
+    unique_ptr<MatchExpression> parseFilter(const BSONObj& filterObj) {
+        StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(filterObj);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        return std::move(statusWithMatcher.getValue());
+    }
+
+    CollectionScanParams scanParams(Collection* collection) {
+        CollectionScanParams params;
+        params.collection = collection;
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+        return params;
+    }
+
+    static int numObj() {
+        return 3 * ExchangeStage::kBatchSize + 100;
+    }
+
+    static const char* ns() {
+        return "unittests.QueryStageExchange";
+    }
+
+protected:
+    OperationContextImpl _txn;
+    DBDirectClient _client;
+};
+
+//
+// The documents matching the filter are returned in the order the collection scan found them, and
+// every worker reports the documents it tested.
+//
+
+class QueryStageExchangeMatchesInOrder : public QueryStageExchangeBase {
+public:
+    void run() {
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        unique_ptr<MatchExpression> filter = parseFilter(fromjson("{foo: {$mod: [3, 0]}}"));
+
+        const size_t numWorkers = 4;
+        unique_ptr<WorkingSet> ws = make_unique<WorkingSet>();
+        unique_ptr<PlanStage> scan =
+            make_unique<CollectionScan>(&_txn, scanParams(ctx.getCollection()), ws.get(), nullptr);
+        unique_ptr<PlanStage> ps = make_unique<ExchangeStage>(
+            &_txn, ws.get(), ctx.getCollection(), filter.get(), numWorkers, scan.release());
+        ExchangeStage* exchange = static_cast<ExchangeStage*>(ps.get());
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_txn, std::move(ws), std::move(ps), ctx.getCollection(), PlanExecutor::YIELD_MANUAL);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        unique_ptr<PlanExecutor> exec = std::move(statusWithPlanExecutor.getValue());
+
+        int expected = 0;
+        for (BSONObj obj; PlanExecutor::ADVANCED == exec->getNext(&obj, NULL);) {
+            ASSERT_EQUALS(expected, obj["foo"].numberInt());
+            expected += 3;
+        }
+        ASSERT_GTE(expected, numObj());
+
+        const ExchangeStats* stats =
+            static_cast<const ExchangeStats*>(exchange->getSpecificStats());
+        ASSERT_EQUALS(4, stats->batches);
+        ASSERT_EQUALS(numWorkers, stats->workers.size());
+
+        long long docsTested = 0;
+        long long docsPassed = 0;
+        for (auto&& worker : stats->workers) {
+            ASSERT_GT(worker.docsTested, 0);
+            docsTested += worker.docsTested;
+            docsPassed += worker.docsPassed;
+        }
+        ASSERT_EQUALS(numObj(), docsTested);
+        ASSERT_EQUALS(expected / 3, docsPassed);
+    }
+};
+
+//
+// A document deleted while it waits in a batch is still returned, without its RecordId.
+//
+
+class QueryStageExchangeInvalidateBufferedObject : public QueryStageExchangeBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+        unique_ptr<MatchExpression> filter = parseFilter(fromjson("{foo: {$lt: 20}}"));
+
+        WorkingSet ws;
+        ExchangeStage exchange(&_txn,
+                               &ws,
+                               coll,
+                               filter.get(),
+                               2,
+                               new CollectionScan(&_txn, scanParams(coll), &ws, nullptr));
+
+        // Buffer a few documents without filling a batch.
+        RecordId deletedLoc;
+        for (int i = 0; i < 20; ++i) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            ASSERT_EQUALS(PlanStage::NEED_TIME, exchange.work(&id));
+        }
+
+        WorkingSet scratch;
+        CollectionScan locFinder(&_txn, scanParams(coll), &scratch, nullptr);
+        while (deletedLoc.isNull()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == locFinder.work(&id) &&
+                scratch.get(id)->obj.value()["foo"].numberInt() == 5) {
+                deletedLoc = scratch.get(id)->loc;
+            }
+        }
+
+        exchange.saveState();
+        {
+            WriteUnitOfWork wunit(&_txn);
+            exchange.invalidate(&_txn, deletedLoc, INVALIDATION_DELETION);
+            wunit.commit();
+        }
+        _client.remove(ns(), BSON("foo" << 5));
+        exchange.restoreState();
+
+        int count = 0;
+        while (!exchange.isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == exchange.work(&id)) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(count, member->obj.value()["foo"].numberInt());
+                ASSERT_EQUALS(count != 5, member->hasLoc());
+                ++count;
+            }
+        }
+        ASSERT_EQUALS(20, count);
+    }
+};
+
+//
+// A document mutated while it waits in a batch keeps its RecordId.
+//
+
+class QueryStageExchangeMutateBufferedObject : public QueryStageExchangeBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+        unique_ptr<MatchExpression> filter = parseFilter(fromjson("{foo: {$lt: 20}}"));
+
+        WorkingSet ws;
+        ExchangeStage exchange(&_txn,
+                               &ws,
+                               coll,
+                               filter.get(),
+                               2,
+                               new CollectionScan(&_txn, scanParams(coll), &ws, nullptr));
+
+        // Buffer a few documents without filling a batch.
+        RecordId mutatedLoc;
+        for (int i = 0; i < 20; ++i) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            ASSERT_EQUALS(PlanStage::NEED_TIME, exchange.work(&id));
+        }
+
+        WorkingSet scratch;
+        CollectionScan locFinder(&_txn, scanParams(coll), &scratch, nullptr);
+        while (mutatedLoc.isNull()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == locFinder.work(&id) &&
+                scratch.get(id)->obj.value()["foo"].numberInt() == 5) {
+                mutatedLoc = scratch.get(id)->loc;
+            }
+        }
+
+        exchange.saveState();
+        {
+            WriteUnitOfWork wunit(&_txn);
+            exchange.invalidate(&_txn, mutatedLoc, INVALIDATION_MUTATION);
+            wunit.commit();
+        }
+        exchange.restoreState();
+
+        int count = 0;
+        while (!exchange.isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == exchange.work(&id)) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(count, member->obj.value()["foo"].numberInt());
+                ASSERT_TRUE(member->hasLoc());
+                ++count;
+            }
+        }
+        ASSERT_EQUALS(20, count);
+    }
+};
+
+//
+// Large documents fill a batch before kBatchSize of them are read.
+//
+
+class QueryStageExchangeBatchBoundedByBytes : public QueryStageExchangeBase {
+public:
+    void run() {
+        const std::string big(1024 * 1024, 'x');
+        for (int i = 0; i < 20; ++i) {
+            _client.insert(ns(), BSON("foo" << numObj() + i << "big" << big));
+        }
+
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        unique_ptr<MatchExpression> filter = parseFilter(fromjson("{foo: {$gte: 0}}"));
+
+        unique_ptr<WorkingSet> ws = make_unique<WorkingSet>();
+        unique_ptr<PlanStage> scan =
+            make_unique<CollectionScan>(&_txn, scanParams(ctx.getCollection()), ws.get(), nullptr);
+        unique_ptr<PlanStage> ps = make_unique<ExchangeStage>(
+            &_txn, ws.get(), ctx.getCollection(), filter.get(), 2, scan.release());
+        ExchangeStage* exchange = static_cast<ExchangeStage*>(ps.get());
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_txn, std::move(ws), std::move(ps), ctx.getCollection(), PlanExecutor::YIELD_MANUAL);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        unique_ptr<PlanExecutor> exec = std::move(statusWithPlanExecutor.getValue());
+
+        int count = 0;
+        for (BSONObj obj; PlanExecutor::ADVANCED == exec->getNext(&obj, NULL);) {
+            ASSERT_EQUALS(count, obj["foo"].numberInt());
+            ++count;
+        }
+        ASSERT_EQUALS(numObj() + 20, count);
+
+        // Three full batches of small documents, then the remaining small documents with the first
+        // 16 large ones, then the last 4 large ones.
+        const ExchangeStats* stats =
+            static_cast<const ExchangeStats*>(exchange->getSpecificStats());
+        ASSERT_EQUALS(5, stats->batches);
+    }
+};
+
+//
+// The planner chooses EXCHANGE for filters that are safe to match on several threads at once, but
+// not for a $geoWithin polygon large enough that S2 indexes its edges lazily on first use.
+//
+
+class QueryStageExchangePlannedBase : public QueryStageExchangeBase {
+public:
+    QueryStageExchangePlannedBase()
+        : _workers(internalQueryExecParallelCollScanWorkers.load()),
+          _minRecords(internalQueryExecParallelCollScanMinRecords.load()) {
+        internalQueryExecParallelCollScanWorkers.store(4);
+        internalQueryExecParallelCollScanMinRecords.store(0);
+    }
+
+    virtual ~QueryStageExchangePlannedBase() {
+        internalQueryExecParallelCollScanWorkers.store(_workers);
+        internalQueryExecParallelCollScanMinRecords.store(_minRecords);
+    }
+
+    /**
+     * Runs 'query' as planned, returning the number of matching documents and whether the plan is
+     * an EXCHANGE.
+     */
+    int countPlanned(const BSONObj& query, bool* usedExchange) {
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        auto cq = uassertStatusOK(CanonicalQuery::canonicalize(NamespaceString(ns()), query));
+        unique_ptr<PlanExecutor> exec = uassertStatusOK(
+            getExecutor(&_txn, ctx.getCollection(), std::move(cq), PlanExecutor::YIELD_MANUAL));
+        *usedExchange = STAGE_EXCHANGE == exec->getRootStage()->stageType();
+
+        int count = 0;
+        for (BSONObj obj; PlanExecutor::ADVANCED == exec->getNext(&obj, NULL);) {
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    const int _workers;
+    const long long _minRecords;
+};
+
+class QueryStageExchangePlannedForStatelessFilter : public QueryStageExchangePlannedBase {
+public:
+    void run() {
+        bool usedExchange = false;
+        const int count = countPlanned(
+            fromjson("{$or: [{foo: {$mod: [3, 0]}}, {foo: {$in: [1, /x/]}}]}"), &usedExchange);
+        ASSERT_TRUE(usedExchange);
+        ASSERT_EQUALS((numObj() + 2) / 3 + 1, count);
+    }
+};
+
+class QueryStageExchangeNotPlannedForLargePolygon : public QueryStageExchangePlannedBase {
+public:
+    void run() {
+        for (int i = 0; i < 100; ++i) {
+            _client.insert(ns(), BSON("loc" << BSON_ARRAY(0.0 << 0.0)));
+            _client.insert(ns(), BSON("loc" << BSON_ARRAY(50.0 << 50.0)));
+        }
+
+        // A circle of radius 10 around the first point, closed on its first vertex.
+        const int numVertices = 2500;
+        const double pi = std::acos(-1.0);
+        BSONArrayBuilder ring;
+        for (int i = 0; i < numVertices; ++i) {
+            const double angle = 2 * pi * i / numVertices;
+            ring.append(BSON_ARRAY(10 * std::cos(angle) << 10 * std::sin(angle)));
+        }
+        ring.append(BSON_ARRAY(10.0 << 0.0));
+        const BSONObj polygon = BSON("type"
+                                     << "Polygon"
+                                     << "coordinates" << BSON_ARRAY(ring.arr()));
+
+        bool usedExchange = true;
+        const int count = countPlanned(
+            BSON("loc" << BSON("$geoWithin" << BSON("$geometry" << polygon))), &usedExchange);
+        ASSERT_FALSE(usedExchange);
+        ASSERT_EQUALS(100, count);
+    }
+};
+
+class All : public Suite {
+public:
+    All() : Suite("query_stage_exchange") {}
+
+    void setupTests() {
+        add<QueryStageExchangeMatchesInOrder>();
+        add<QueryStageExchangeInvalidateBufferedObject>();
+        add<QueryStageExchangeMutateBufferedObject>();
+        add<QueryStageExchangeBatchBoundedByBytes>();
+        add<QueryStageExchangePlannedForStatelessFilter>();
+        add<QueryStageExchangeNotPlannedForLargePolygon>();
+    }
+};
+
+SuiteInstance<All> queryStageExchangeAll;
+
+}  // namespace QueryStageExchange
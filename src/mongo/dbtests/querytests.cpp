@@ -281,6 +281,60 @@ public:
     }
 };
 
+/**
+ * Many open cursors on one collection, which the CursorManager spreads over its partitions, can
+ * each be found, continued and killed by id.
+ */
+class ManyOpenCursors : public ClientBase {
+public:
+    ~ManyOpenCursors() {
+        _client.dropCollection("unittests.querytests.ManyOpenCursors");
+    }
+    void run() {
+        const char* ns = "unittests.querytests.ManyOpenCursors";
+        for (int i = 0; i < 3; ++i) {
+            insert(ns, BSON("a" << i));
+        }
+
+        const size_t numCursors = 200;
+        std::vector<CursorId> cursorIds;
+        for (size_t i = 0; i < numCursors; ++i) {
+            unique_ptr<DBClientCursor> cursor = _client.query(ns, BSONObj(), 2);
+            cursorIds.push_back(cursor->getCursorId());
+            cursor->decouple();
+        }
+
+        {
+            AutoGetCollectionForRead ctx(&_txn, ns);
+            CursorManager* cursorManager = ctx.getCollection()->getCursorManager();
+            ASSERT_EQUALS(numCursors, cursorManager->numCursors());
+
+            std::set<CursorId> openCursors;
+            cursorManager->getCursorIds(&openCursors);
+            ASSERT_EQUALS(numCursors, openCursors.size());
+            for (CursorId id : cursorIds) {
+                ASSERT(cursorManager->ownsCursorId(id));
+                ASSERT_EQUALS(1U, openCursors.count(id));
+            }
+        }
+
+        // Finish every other cursor, and kill the rest.
+        for (size_t i = 0; i < numCursors; ++i) {
+            if (i % 2 == 0) {
+                unique_ptr<DBClientCursor> cursor = _client.getMore(ns, cursorIds[i]);
+                ASSERT(cursor->more());
+                ASSERT_EQUALS(2, cursor->next().getIntField("a"));
+                ASSERT(!cursor->more());
+            } else {
+                ASSERT(CursorManager::eraseCursorGlobal(&_txn, cursorIds[i]));
+            }
+        }
+
+        AutoGetCollectionForRead ctx(&_txn, ns);
+        ASSERT_EQUALS(0U, ctx.getCollection()->getCursorManager()->numCursors());
+    }
+};
+
 /**
  * An exception triggered during a get more request destroys the ClientCursor used by the get
  * more, preventing further iteration of the cursor in subsequent get mores.
@@ -1743,6 +1797,7 @@ public:
         add<FindOneEmptyObj>();
         add<BoundedKey>();
         add<GetMore>();
+        add<ManyOpenCursors>();
         add<GetMoreKillOp>();
         add<GetMoreInvalidRequest>();
         add<PositiveLimit>();
@@ -56,6 +56,7 @@
 #include "mongo/stdx/mutex.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor_manager.h"
 
 namespace mongo {
 
@@ -147,6 +148,8 @@ private:
         rpc::ProtocolSet clientProtocols() const;
         void setServerProtocols(rpc::ProtocolSet protocols);
 
+        MessageCompressorManager& compressorManager();
+
 // Explicit move construction and assignment to support MSVC
 #if defined(_MSC_VER) && _MSC_VER < 1900
         AsyncConnection(AsyncConnection&&);
@@ -164,6 +167,8 @@ private:
         // Dynamically initialized from [min max]WireVersionOutgoing.
         // Its expected that isMaster response is checked only on the caller.
         rpc::ProtocolSet _clientProtocols{rpc::supports::kNone};
+
+        MessageCompressorManager _compressorManager;
     };
 
     /**
@@ -200,6 +205,7 @@ private:
         NetworkInterfaceASIO::AsyncConnection& conn();
 
         Message& toSend();
+        Message& toSendCompressed();
         Message& toRecv();
         MSGHEADER::Value& header();
 
@@ -213,6 +219,8 @@ private:
         const CommandType _type;
 
         Message _toSend;
+        // Holds the wire form of _toSend when it is sent compressed.
+        Message _toSendCompressed;
         Message _toRecv;
 
         // TODO: Investigate efficiency of storing header separately.
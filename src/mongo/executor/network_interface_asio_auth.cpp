@@ -71,6 +71,8 @@ void NetworkInterfaceASIO::_runIsMaster(AsyncOp* op) {
         bob.append("hostInfo", sb.str());
     }
 
+    op->connection().compressorManager().clientBegin(&bob);
+
     requestBuilder.setCommandArgs(bob.done());
     requestBuilder.setMetadata(rpc::makeEmptyMetadata());
 
@@ -102,6 +104,7 @@ void NetworkInterfaceASIO::_runIsMaster(AsyncOp* op) {
             return _completeOperation(op, protocolSet.getStatus());
 
         op->connection().setServerProtocols(protocolSet.getValue());
+        op->connection().compressorManager().clientFinish(commandReply.data);
 
         invariant(op->connection().clientProtocols() != rpc::supports::kNone);
         // Set the operation protocol
@@ -79,8 +79,6 @@ template <typename Handler>
 void asyncSendMessage(AsyncStreamInterface& stream, Message* m, Handler&& handler) {
     static_assert(IsNetworkHandler<Handler>::value,
                   "Handler passed to asyncSendMessage does not conform to NetworkHandler concept");
-    m->header().setResponseTo(0);
-    m->header().setId(nextMessageId());
     // TODO: Some day we may need to support vector messages.
     fassert(28708, m->buf() != 0);
     stream.write(asio::buffer(m->buf(), m->size()), std::forward<Handler>(handler));
@@ -189,6 +187,10 @@ Message& NetworkInterfaceASIO::AsyncCommand::toSend() {
     return _toSend;
 }
 
+Message& NetworkInterfaceASIO::AsyncCommand::toSendCompressed() {
+    return _toSendCompressed;
+}
+
 Message& NetworkInterfaceASIO::AsyncCommand::toRecv() {
     return _toRecv;
 }
@@ -372,6 +374,20 @@ void NetworkInterfaceASIO::_asyncRunCommand(AsyncOp* op, NetworkOpHandler handle
 
     // Step 4
     auto recvMessageCallback = [this, cmd, handler, op](std::error_code ec, size_t bytes) {
+        if (!ec && cmd->toRecv().operation() == dbCompressed) {
+            MessageCompressorId compressorId;
+            Message decompressed;
+            auto status = cmd->conn().compressorManager().decompressMessage(
+                cmd->toRecv(), &decompressed, &compressorId);
+            if (!status.isOK()) {
+                LOG(1) << "failed to decompress response from "
+                       << op->request().target.toString() << ": " << status;
+                ec = make_error_code(status.code());
+            } else {
+                cmd->toRecv() = std::move(decompressed);
+            }
+        }
+
         // We don't call _validateAndRun here as we assume the caller will.
         handler(ec, bytes);
     };
@@ -416,7 +432,26 @@ void NetworkInterfaceASIO::_asyncRunCommand(AsyncOp* op, NetworkOpHandler handle
         };
 
     // Step 1
-    asyncSendMessage(cmd->conn().stream(), &cmd->toSend(), std::move(sendMessageCallback));
+    auto& toSend = cmd->toSend();
+    toSend.header().setResponseTo(0);
+    toSend.header().setId(nextMessageId());
+
+    // The response is matched against the id of the uncompressed message, which the compressed
+    // message shares.
+    Message* wireMessage = &toSend;
+    auto& compressorManager = cmd->conn().compressorManager();
+    if (compressorManager.isCompressionEnabled() &&
+        MessageCompressorManager::isMessageCompressible(toSend)) {
+        auto status = compressorManager.compressMessage(&toSend, &cmd->toSendCompressed());
+        if (status.isOK()) {
+            wireMessage = &cmd->toSendCompressed();
+        } else {
+            LOG(1) << "failed to compress command for " << op->request().target.toString()
+                   << ", sending uncompressed: " << status;
+        }
+    }
+
+    asyncSendMessage(cmd->conn().stream(), wireMessage, std::move(sendMessageCallback));
 }
 
 void NetworkInterfaceASIO::_runConnectionHook(AsyncOp* op) {
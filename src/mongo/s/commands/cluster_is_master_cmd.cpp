@@ -81,6 +81,10 @@ public:
         result.append("maxWireVersion", WireSpec::instance().maxWireVersionIncoming);
         result.append("minWireVersion", WireSpec::instance().minWireVersionIncoming);
 
+        if (auto port = txn->getClient()->port()) {
+            port->compressorManager().serverNegotiate(cmdObj, &result);
+        }
+
         return true;
     }
 
@@ -127,12 +127,21 @@ public:
             return false;
         }
 
+        // Collections read by $lookup may be sharded: the pipeline stages that read them run on
+        // the primary shard, which targets the shards owning the documents it needs itself. Tell
+        // it, so that it fails rather than reads its own chunks if it can't target the others.
+        bool readsShardedCollections = false;
         for (auto&& ns : pipeline->getInvolvedCollections()) {
-            uassert(
-                28769, str::stream() << ns.ns() << " cannot be sharded", !conf->isSharded(ns.ns()));
+            readsShardedCollections = readsShardedCollections || conf->isSharded(ns.ns());
         }
 
         if (!conf->isSharded(fullns)) {
+            if (readsShardedCollections) {
+                BSONObjBuilder passthroughCmd;
+                passthroughCmd.appendElements(cmdObj);
+                passthroughCmd.append("readsShardedCollections", true);
+                return aggPassthrough(txn, conf, passthroughCmd.obj(), result, options);
+            }
             return aggPassthrough(txn, conf, cmdObj, result, options);
         }
 
@@ -219,6 +228,10 @@ public:
         MutableDocument mergeCmd(pipeline->serialize());
         mergeCmd["cursor"] = Value(cmdObj["cursor"]);
 
+        if (readsShardedCollections) {
+            mergeCmd["readsShardedCollections"] = Value(true);
+        }
+
         if (cmdObj.hasField("$queryOptions")) {
             mergeCmd["$queryOptions"] = Value(cmdObj["$queryOptions"]);
         }
@@ -98,6 +98,7 @@ public:
              BSONObjBuilder& result) {
         const MigrationSessionId migrationSessionid(
             uassertStatusOK(MigrationSessionId::extractFromBSON(cmdObj)));
+        ScopedAdmissionPriority priority(txn->lockState(), TicketHolder::Priority::kHigh);
         return ShardingState::get(txn)->migrationSourceManager()->transferMods(
             txn, migrationSessionid, errmsg, result);
     }
@@ -140,6 +141,7 @@ public:
              BSONObjBuilder& result) {
         const MigrationSessionId migrationSessionid(
             uassertStatusOK(MigrationSessionId::extractFromBSON(cmdObj)));
+        ScopedAdmissionPriority priority(txn->lockState(), TicketHolder::Priority::kHigh);
         return ShardingState::get(txn)->migrationSourceManager()->clone(
             txn, migrationSessionid, errmsg, result);
     }
@@ -32,6 +32,7 @@
 
 #include "mongo/s/server.h"
 
+#include "mongo/base/checked_cast.h"
 #include "mongo/base/init.h"
 #include "mongo/base/initializer.h"
 #include "mongo/base/status.h"
@@ -232,6 +233,25 @@ public:
     virtual void close() {
         Client::destroy();
     }
+
+    virtual bool canSuspend() const {
+        return true;
+    }
+
+    virtual std::unique_ptr<ConnectionState> suspend() {
+        return stdx::make_unique<ClientState>(Client::releaseCurrent());
+    }
+
+    virtual void resume(std::unique_ptr<ConnectionState> state) {
+        Client::setCurrent(std::move(checked_cast<ClientState*>(state.get())->client));
+    }
+
+private:
+    struct ClientState : public ConnectionState {
+        explicit ClientState(ServiceContext::UniqueClient client) : client(std::move(client)) {}
+
+        ServiceContext::UniqueClient client;
+    };
 };
 
 DBClientBase* createDirectClient(OperationContext* txn) {
@@ -349,6 +369,8 @@ static ExitCode runMongosServer() {
     MessageServer::Options opts;
     opts.port = serverGlobalParams.port;
     opts.ipList = serverGlobalParams.bind_ip;
+    opts.serviceExecutor = serverGlobalParams.serviceExecutor;
+    opts.serviceExecutorThreads = serverGlobalParams.serviceExecutorThreads;
 
     auto handler = std::make_shared<ShardedMessageHandler>();
     MessageServer* server = createServer(opts, std::move(handler));
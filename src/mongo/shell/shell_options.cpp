@@ -41,6 +41,7 @@
 #include "mongo/rpc/protocol.h"
 #include "mongo/shell/shell_utils.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message_compressor_registry.h"
 #include "mongo/util/net/sock.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/options_parser/startup_options.h"
@@ -137,6 +138,11 @@ Status addMongoShellOptions(moe::OptionSection* options) {
     }
 #endif
 
+    ret = addMessageCompressionOptions(options);
+    if (!ret.isOK()) {
+        return ret;
+    }
+
     options->addOptionChaining("dbaddress", "dbaddress", moe::String, "dbaddress")
         .hidden()
         .positional(1, 1);
@@ -215,6 +221,11 @@ Status storeMongoShellOptions(const moe::Environment& params,
         return ret;
     }
 #endif
+    Status compressionStatus = storeMessageCompressionOptions(params);
+    if (!compressionStatus.isOK()) {
+        return compressionStatus;
+    }
+
     if (params.count("ipv6")) {
         mongo::enableIPv6();
     }
@@ -25,177 +25,154 @@
  *    then also delete it in the license file.
  */
 
-#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
-
 #include "mongo/platform/basic.h"
 
 #include "mongo/util/concurrency/ticketholder.h"
 
-#include <iostream>
+#include <algorithm>
 
-#include "mongo/util/log.h"
+#include "mongo/stdx/chrono.h"
+#include "mongo/util/assert_util.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
-#if defined(__linux__)
 namespace {
-void _check(int ret) {
-    if (ret == 0)
-        return;
-    int err = errno;
-    severe() << "error in Ticketholder: " << errnoWithDescription(err);
-    fassertFailed(28604);
-}
-}
 
-TicketHolder::TicketHolder(int num) : _outof(num) {
-    _check(sem_init(&_sem, 0, num));
-}
-
-TicketHolder::~TicketHolder() {
-    _check(sem_destroy(&_sem));
-}
-
-bool TicketHolder::tryAcquire() {
-    while (0 != sem_trywait(&_sem)) {
-        switch (errno) {
-            case EAGAIN:
-                return false;
-            case EINTR:
-                break;
-            default:
-                _check(-1);
-        }
+int waitBucket(long long micros) {
+    int bucket = 0;
+    while (bucket + 1 < TicketHolder::WaitStats::kNumBuckets &&
+           micros >= TicketHolder::WaitStats::bucketLowerBoundMicros(bucket + 1)) {
+        bucket++;
     }
-    return true;
+    return bucket;
 }
 
-void TicketHolder::waitForTicket() {
-    while (0 != sem_wait(&_sem)) {
-        switch (errno) {
-            case EINTR:
-                break;
-            default:
-                _check(-1);
-        }
-    }
-}
+}  // namespace
 
-void TicketHolder::release() {
-    _check(sem_post(&_sem));
-}
+const int TicketHolder::kNumPriorities;
+const int TicketHolder::WaitStats::kNumBuckets;
 
-Status TicketHolder::resize(int newSize) {
-    stdx::lock_guard<stdx::mutex> lk(_resizeMutex);
+TicketHolder::TicketHolder(int num) : _outof(num) {}
 
-    if (newSize < 5)
-        return Status(ErrorCodes::BadValue,
-                      str::stream() << "Minimum value for semaphore is 5; given " << newSize);
+TicketHolder::~TicketHolder() = default;
 
-    if (newSize > SEM_VALUE_MAX)
-        return Status(ErrorCodes::BadValue,
-                      str::stream() << "Maximum value for semaphore is " << SEM_VALUE_MAX
-                                    << "; given " << newSize);
+bool TicketHolder::tryAcquire() {
+    // Queued threads come first. A ticket returned while they wait is about to be handed to them.
+    return _waiting.load() == 0 && _tryTakeTicket();
+}
+
+void TicketHolder::waitForTicket(Priority priority) {
+    const int index = static_cast<int>(priority);
 
-    while (_outof.load() < newSize) {
-        release();
-        _outof.fetchAndAdd(1);
+    if (priority == Priority::kImmediate) {
+        _used.fetchAndAdd(1);
+        _acquired.fetchAndAdd(1);
+        _immediateCounts[index].fetchAndAdd(1);
+        return;
     }
 
-    while (_outof.load() > newSize) {
-        waitForTicket();
-        _outof.subtractAndFetch(1);
+    if (_waiting.load() == 0 && _tryTakeTicket()) {
+        _immediateCounts[index].fetchAndAdd(1);
+        return;
     }
 
-    invariant(_outof.load() == newSize);
-    return Status::OK();
-}
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
 
-int TicketHolder::available() const {
-    int val = 0;
-    _check(sem_getvalue(&_sem, &val));
-    return val;
-}
+    // Announce ourselves before the last check. A thread returning a ticket either sees us waiting
+    // and hands its ticket on after we have queued, or returned it before this check sees it.
+    // A ticket returned while others are queued belongs to them.
+    _waiting.fetchAndAdd(1);
+    const bool queued = std::any_of(_queues.begin(),
+                                    _queues.end(),
+                                    [](const std::deque<Waiter*>& queue) { return !queue.empty(); });
+    if (!queued && _tryTakeTicket()) {
+        _waiting.subtractAndFetch(1);
+        _immediateCounts[index].fetchAndAdd(1);
+        return;
+    }
 
-int TicketHolder::used() const {
-    return outof() - available();
-}
+    const auto start = stdx::chrono::steady_clock::now();
+    Waiter waiter;
+    _queues[index].push_back(&waiter);
+    waiter.granted.wait(lk, [&waiter] { return waiter.hasTicket; });
 
-int TicketHolder::outof() const {
-    return _outof.load();
+    // The thread that granted the ticket already took us off the queue and counted the ticket.
+    const long long micros = stdx::chrono::duration_cast<stdx::chrono::microseconds>(
+                                 stdx::chrono::steady_clock::now() - start).count();
+    _waitStats[index].count++;
+    _waitStats[index].totalMicros += micros;
+    _waitStats[index].buckets[waitBucket(micros)]++;
 }
 
-#else
-
-TicketHolder::TicketHolder(int num) : _outof(num), _num(num) {}
-
-TicketHolder::~TicketHolder() = default;
+void TicketHolder::release() {
+    const int used = _used.subtractAndFetch(1);
+    invariant(used >= 0);
+    if (_waiting.load() == 0) {
+        return;
+    }
 
-bool TicketHolder::tryAcquire() {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
-    return _tryAcquire();
+    _grantTickets_inlock();
 }
 
-void TicketHolder::waitForTicket() {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+Status TicketHolder::resize(int newSize) {
+    if (newSize < 5)
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "Minimum value for TicketHolder is 5; given " << newSize);
 
-    while (!_tryAcquire()) {
-        _newTicket.wait(lk);
-    }
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _outof.store(newSize);
+    _grantTickets_inlock();
+    return Status::OK();
 }
 
-void TicketHolder::release() {
-    {
-        stdx::lock_guard<stdx::mutex> lk(_mutex);
-        _num++;
+bool TicketHolder::_tryTakeTicket() {
+    int used = _used.load();
+    while (used < _outof.load()) {
+        const int seen = _used.compareAndSwap(used, used + 1);
+        if (seen == used) {
+            _acquired.fetchAndAdd(1);
+            return true;
+        }
+        used = seen;
     }
-    _newTicket.notify_one();
-}
-
-Status TicketHolder::resize(int newSize) {
-    stdx::lock_guard<stdx::mutex> lk(_mutex);
-
-    int used = _outof.load() - _num;
-    if (used > newSize) {
-        std::stringstream ss;
-        ss << "can't resize since we're using (" << used << ") "
-           << "more than newSize(" << newSize << ")";
-
-        std::string errmsg = ss.str();
-        log() << errmsg;
-        return Status(ErrorCodes::BadValue, errmsg);
+    return false;
+}
+
+void TicketHolder::_grantTickets_inlock() {
+    for (int index = kNumPriorities - 1; index >= 0; index--) {
+        auto& queue = _queues[index];
+        while (!queue.empty() && _tryTakeTicket()) {
+            Waiter* waiter = queue.front();
+            queue.pop_front();
+            _waiting.subtractAndFetch(1);
+            waiter->hasTicket = true;
+            waiter->granted.notify_one();
+        }
     }
-
-    _outof.store(newSize);
-    _num = _outof.load() - used;
-
-    // Potentially wasteful, but easier to see is correct
-    _newTicket.notify_all();
-    return Status::OK();
 }
 
 int TicketHolder::available() const {
-    return _num;
+    return std::max(0, _outof.load() - _used.load());
 }
 
 int TicketHolder::used() const {
-    return outof() - _num;
+    return _used.load();
 }
 
 int TicketHolder::outof() const {
     return _outof.load();
 }
 
-bool TicketHolder::_tryAcquire() {
-    if (_num <= 0) {
-        if (_num < 0) {
-            std::cerr << "DISASTER! in TicketHolder" << std::endl;
-        }
-        return false;
-    }
-    _num--;
-    return true;
-}
-#endif
+TicketHolder::WaitStats TicketHolder::getWaitStats(Priority priority) const {
+    const int index = static_cast<int>(priority);
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    WaitStats stats = _waitStats[index];
+    const long long immediate = _immediateCounts[index].load();
+    stats.count += immediate;
+    stats.buckets[0] += immediate;
+    return stats;
 }
+
+}  // namespace mongo
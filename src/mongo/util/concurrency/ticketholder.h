@@ -26,30 +26,68 @@
  */
 #pragma once
 
-#if defined(__linux__)
-#include <semaphore.h>
-#endif
+#include <array>
+#include <deque>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
-#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
+/**
+ * A fixed (but resizable) number of tickets, used to limit how many threads do something at
+ * once. Threads that have to wait for a ticket are queued by priority, and each ticket that is
+ * released or added goes to the longest waiting thread of the highest priority.
+ */
 class TicketHolder {
     MONGO_DISALLOW_COPYING(TicketHolder);
 
 public:
+    enum class Priority {
+        // Operations from clients.
+        kNormal,
+        // Internal operations that must not queue behind clients, like applying the oplog.
+        kHigh,
+        // Operations that must never wait. They get a ticket at once, even if that puts more
+        // tickets out than there are.
+        kImmediate,
+    };
+
+    static const int kNumPriorities = 3;
+
+    /**
+     * How long threads of one priority waited in waitForTicket(). Bucket 0 counts waits shorter
+     * than 2 microseconds, bucket i > 0 those from 2^i up to 2^(i+1) microseconds, and the last
+     * bucket all longer ones.
+     */
+    struct WaitStats {
+        static const int kNumBuckets = 32;
+
+        static long long bucketLowerBoundMicros(int bucket) {
+            return bucket == 0 ? 0 : 1LL << bucket;
+        }
+
+        long long count = 0;
+        long long totalMicros = 0;
+        std::array<long long, kNumBuckets> buckets{};
+    };
+
     explicit TicketHolder(int num);
     ~TicketHolder();
 
     bool tryAcquire();
 
-    void waitForTicket();
+    void waitForTicket(Priority priority = Priority::kNormal);
 
     void release();
 
+    /**
+     * Never blocks. If more tickets are out than 'newSize', no new ticket is given out until
+     * enough of them are released.
+     */
     Status resize(int newSize);
 
     int available() const;
@@ -58,21 +96,54 @@ public:
 
     int outof() const;
 
+    /**
+     * Number of threads blocked in waitForTicket().
+     */
+    int waiting() const {
+        return _waiting.load();
+    }
+
+    /**
+     * Number of tickets acquired since this TicketHolder was constructed.
+     */
+    long long acquired() const {
+        return _acquired.load();
+    }
+
+    WaitStats getWaitStats(Priority priority) const;
+
 private:
-#if defined(__linux__)
-    mutable sem_t _sem;
+    struct Waiter {
+        stdx::condition_variable granted;
+        bool hasTicket = false;
+    };
 
-    // You can read _outof without a lock, but have to hold _resizeMutex to change.
-    AtomicInt32 _outof;
-    stdx::mutex _resizeMutex;
-#else
-    bool _tryAcquire();
+    /**
+     * Takes a ticket if one is free. Doesn't need _mutex.
+     */
+    bool _tryTakeTicket();
+
+    void _grantTickets_inlock();
+
+    // Only needed to queue for a ticket and to hand tickets to queued threads. Tickets are taken
+    // and returned with atomic operations while no thread is queued.
+    mutable stdx::mutex _mutex;
+    std::array<std::deque<Waiter*>, kNumPriorities> _queues;
+    std::array<WaitStats, kNumPriorities> _waitStats;
 
+    // Tickets taken without waiting, which getWaitStats() adds to the first bucket.
+    std::array<AtomicInt64, kNumPriorities> _immediateCounts;
+
+    // Only changed with _mutex held.
     AtomicInt32 _outof;
-    int _num;
-    stdx::mutex _mutex;
-    stdx::condition_variable _newTicket;
-#endif
+
+    AtomicInt32 _used;
+
+    // Incremented with _mutex held before a thread checks for a free ticket one last time and
+    // queues. A thread that returns a ticket and then sees this at 0 doesn't need to hand it on.
+    AtomicInt32 _waiting;
+
+    AtomicInt64 _acquired;
 };
 
 class ScopedTicket {
@@ -0,0 +1,187 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/ticketholder.h"
+
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+using Priority = TicketHolder::Priority;
+
+void waitUntilWaiting(const TicketHolder& holder, int waiting) {
+    while (holder.waiting() < waiting) {
+        sleepmillis(1);
+    }
+}
+
+TEST(TicketHolderTest, TryAcquireUpToSize) {
+    TicketHolder holder(5);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(holder.tryAcquire());
+    }
+    ASSERT_FALSE(holder.tryAcquire());
+    ASSERT_EQUALS(5, holder.used());
+    ASSERT_EQUALS(0, holder.available());
+
+    holder.release();
+    ASSERT_TRUE(holder.tryAcquire());
+    ASSERT_EQUALS(6, holder.acquired());
+}
+
+TEST(TicketHolderTest, ImmediateNeverWaits) {
+    TicketHolder holder(5);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(holder.tryAcquire());
+    }
+
+    holder.waitForTicket(Priority::kImmediate);
+    ASSERT_EQUALS(6, holder.used());
+    ASSERT_EQUALS(0, holder.available());
+    ASSERT_EQUALS(1, holder.getWaitStats(Priority::kImmediate).count);
+
+    // With more tickets out than there are, a release doesn't make one available.
+    holder.release();
+    ASSERT_FALSE(holder.tryAcquire());
+}
+
+TEST(TicketHolderTest, HigherPrioritiesAreGrantedFirst) {
+    TicketHolder holder(5);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(holder.tryAcquire());
+    }
+
+    std::vector<Priority> order;
+    stdx::mutex orderMutex;
+    auto waitFor = [&](Priority priority) {
+        return stdx::thread([&holder, &order, &orderMutex, priority] {
+            holder.waitForTicket(priority);
+            stdx::lock_guard<stdx::mutex> lk(orderMutex);
+            order.push_back(priority);
+        });
+    };
+
+    stdx::thread normal = waitFor(Priority::kNormal);
+    waitUntilWaiting(holder, 1);
+    stdx::thread high = waitFor(Priority::kHigh);
+    waitUntilWaiting(holder, 2);
+
+    holder.release();
+    high.join();
+    ASSERT_EQUALS(1, holder.waiting());
+
+    holder.release();
+    normal.join();
+    ASSERT_EQUALS(0, holder.waiting());
+
+    ASSERT_EQUALS(2U, order.size());
+    ASSERT(order[0] == Priority::kHigh);
+    ASSERT(order[1] == Priority::kNormal);
+    ASSERT_EQUALS(5, holder.used());
+    ASSERT_EQUALS(1, holder.getWaitStats(Priority::kHigh).count);
+    ASSERT_EQUALS(1, holder.getWaitStats(Priority::kNormal).count);
+}
+
+TEST(TicketHolderTest, ResizeGrantsWaitersAndDoesNotBlock) {
+    TicketHolder holder(5);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(holder.tryAcquire());
+    }
+
+    stdx::thread waiter([&holder] { holder.waitForTicket(); });
+    waitUntilWaiting(holder, 1);
+    ASSERT_OK(holder.resize(6));
+    waiter.join();
+    ASSERT_EQUALS(6, holder.used());
+
+    // Shrinking below the number of tickets out just stops handing them out.
+    ASSERT_OK(holder.resize(5));
+    ASSERT_EQUALS(6, holder.used());
+    holder.release();
+    ASSERT_FALSE(holder.tryAcquire());
+    holder.release();
+    ASSERT_TRUE(holder.tryAcquire());
+
+    ASSERT_NOT_OK(holder.resize(4));
+}
+
+TEST(TicketHolderTest, ConcurrentAcquireAndReleaseNeverLosesWaiters) {
+    const int kTickets = 5;
+    const int kThreads = 32;
+    const int kIterations = 2000;
+    TicketHolder holder(kTickets);
+
+    AtomicInt32 inside;
+    AtomicInt32 mostInside;
+    std::vector<stdx::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&holder, &inside, &mostInside, t] {
+            for (int i = 0; i < kIterations; i++) {
+                if (i % 2 == 0 || !holder.tryAcquire()) {
+                    holder.waitForTicket(t % 2 == 0 ? Priority::kNormal : Priority::kHigh);
+                }
+                const int now = inside.addAndFetch(1);
+                for (int most = mostInside.load(); now > most;) {
+                    most = mostInside.compareAndSwap(most, now);
+                }
+                inside.subtractAndFetch(1);
+                holder.release();
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_LTE(mostInside.load(), kTickets);
+    ASSERT_EQUALS(0, holder.used());
+    ASSERT_EQUALS(0, holder.waiting());
+    ASSERT_EQUALS(static_cast<long long>(kThreads) * kIterations, holder.acquired());
+}
+
+TEST(TicketHolderTest, WaitStatsBuckets) {
+    TicketHolder holder(5);
+    holder.waitForTicket();
+
+    auto stats = holder.getWaitStats(Priority::kNormal);
+    ASSERT_EQUALS(1, stats.count);
+    ASSERT_EQUALS(0, stats.totalMicros);
+    ASSERT_EQUALS(1, stats.buckets[0]);
+    ASSERT_EQUALS(0, TicketHolder::WaitStats::bucketLowerBoundMicros(0));
+    ASSERT_EQUALS(1024, TicketHolder::WaitStats::bucketLowerBoundMicros(10));
+}
+
+}  // namespace
+}  // namespace mongo
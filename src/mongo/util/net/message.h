@@ -70,6 +70,7 @@ enum NetworkOp {
     // dbCommandReply_DEPRECATED = 2009, //
     dbCommand = 2010,
     dbCommandReply = 2011,
+    dbCompressed = 2012, /* wraps another opcode, see MessageCompressorManager */
 };
 
 enum class LogicalOp {
@@ -135,6 +136,8 @@ inline const char* networkOpToString(NetworkOp networkOp) {
             return "command";
         case dbCommandReply:
             return "commandReply";
+        case dbCompressed:
+            return "compressed";
         default:
             int op = static_cast<int>(networkOp);
             massert(16141, str::stream() << "cannot translate opcode " << op, !op);
@@ -0,0 +1,124 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "mongo/base/data_range.h"
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Identifies the algorithm used to compress an OP_COMPRESSED message. Sent on the wire, so values
+ * must never be reused.
+ */
+enum class MessageCompressor : uint8_t {
+    kNoop = 0,
+    kSnappy = 1,
+    kZlib = 2,
+};
+
+using MessageCompressorId = uint8_t;
+
+StringData getMessageCompressorName(MessageCompressor id);
+
+/**
+ * Interface implemented by the algorithms available for wire protocol compression.
+ *
+ * Implementations are stateless and shared by every connection, so they must be thread safe. Each
+ * one counts the bytes it has consumed and produced, which serverStatus reports.
+ */
+class MessageCompressorBase {
+    MONGO_DISALLOW_COPYING(MessageCompressorBase);
+
+public:
+    virtual ~MessageCompressorBase() = default;
+
+    const std::string& getName() const {
+        return _name;
+    }
+
+    MessageCompressorId getId() const {
+        return _id;
+    }
+
+    /**
+     * Returns an upper bound on the size of the output of compressData() for an input of
+     * "inputSize" bytes.
+     */
+    virtual std::size_t getMaxCompressedSize(std::size_t inputSize) = 0;
+
+    /**
+     * Compresses "input" into "output", which must be at least getMaxCompressedSize() bytes long.
+     * Returns the number of bytes written to "output".
+     */
+    virtual StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) = 0;
+
+    /**
+     * Decompresses "input" into "output", which must be exactly large enough to hold the
+     * decompressed data. Returns the number of bytes written to "output".
+     */
+    virtual StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) = 0;
+
+    /**
+     * Appends the byte counters of this compressor to "b".
+     */
+    void appendStats(BSONObjBuilder* b) const;
+
+protected:
+    explicit MessageCompressorBase(MessageCompressor id);
+
+    void counterHitCompress(std::size_t bytesIn, std::size_t bytesOut) {
+        _compressBytesIn.fetchAndAdd(bytesIn);
+        _compressBytesOut.fetchAndAdd(bytesOut);
+    }
+
+    void counterHitDecompress(std::size_t bytesIn, std::size_t bytesOut) {
+        _decompressBytesIn.fetchAndAdd(bytesIn);
+        _decompressBytesOut.fetchAndAdd(bytesOut);
+    }
+
+private:
+    const MessageCompressorId _id;
+    const std::string _name;
+
+    AtomicInt64 _compressBytesIn;
+    AtomicInt64 _compressBytesOut;
+    AtomicInt64 _decompressBytesIn;
+    AtomicInt64 _decompressBytesOut;
+};
+
+}  // namespace mongo
@@ -0,0 +1,304 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compressor_manager.h"
+
+#include <cstring>
+
+#include "mongo/base/data_range_cursor.h"
+#include "mongo/base/data_type_endian.h"
+#include "mongo/base/data_type_string_data.h"
+#include "mongo/base/data_type_terminated.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/allocator.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor_registry.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+
+const char kCompressionFieldName[] = "compression";
+
+// Size of the fields following the standard header in an OP_COMPRESSED message.
+const size_t kCompressionHeaderSize = sizeof(int32_t) + sizeof(int32_t) + sizeof(uint8_t);
+
+// Commands which must not be compressed, see isMessageCompressible().
+const char* const kIncompressibleCommands[] = {"ismaster",
+                                               "saslstart",
+                                               "saslcontinue",
+                                               "getnonce",
+                                               "authenticate",
+                                               "createuser",
+                                               "updateuser",
+                                               "copydbsaslstart",
+                                               "copydbgetnonce",
+                                               "copydb"};
+
+bool isIncompressibleCommand(StringData commandName) {
+    for (auto incompressible : kIncompressibleCommands) {
+        if (commandName.equalCaseInsensitive(incompressible)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+MessageCompressorManager::MessageCompressorManager()
+    : MessageCompressorManager(&MessageCompressorRegistry::get()) {}
+
+MessageCompressorManager::MessageCompressorManager(MessageCompressorRegistry* registry)
+    : _registry(registry) {}
+
+void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
+    _negotiated.clear();
+
+    const auto& names = _registry->getCompressorNames();
+    if (names.empty()) {
+        return;
+    }
+
+    BSONArrayBuilder compressors(output->subarrayStart(kCompressionFieldName));
+    for (const auto& name : names) {
+        compressors.append(name);
+    }
+}
+
+void MessageCompressorManager::clientFinish(const BSONObj& input) {
+    _negotiated.clear();
+
+    auto elem = input.getField(kCompressionFieldName);
+    if (elem.type() != Array) {
+        return;
+    }
+
+    for (const auto& nameElem : elem.Obj()) {
+        if (nameElem.type() != String) {
+            continue;
+        }
+
+        // Only accept compressors this process offered.
+        if (auto compressor = _registry->getCompressor(nameElem.valueStringData())) {
+            _negotiated.push_back(compressor);
+        }
+    }
+}
+
+void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuilder* output) {
+    auto elem = input.getField(kCompressionFieldName);
+    if (elem.type() != Array) {
+        return;
+    }
+
+    _negotiated.clear();
+    for (const auto& nameElem : elem.Obj()) {
+        if (nameElem.type() != String) {
+            continue;
+        }
+
+        if (auto compressor = _registry->getCompressor(nameElem.valueStringData())) {
+            _negotiated.push_back(compressor);
+        }
+    }
+
+    BSONArrayBuilder compressors(output->subarrayStart(kCompressionFieldName));
+    for (auto compressor : _negotiated) {
+        compressors.append(compressor->getName());
+    }
+}
+
+Status MessageCompressorManager::compressMessage(Message* msg,
+                                                 Message* out,
+                                                 boost::optional<MessageCompressorId> compressorId) {
+    invariant(isCompressionEnabled());
+
+    MessageCompressorBase* compressor = _negotiated.front();
+    if (compressorId) {
+        compressor = _registry->getCompressor(*compressorId);
+        if (!compressor) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << "unknown network message compressor id "
+                                  << static_cast<int>(*compressorId)};
+        }
+    }
+
+    msg->concat();
+    MsgData::ConstView input = msg->singleData().view2ptr();
+    const size_t inputSize = input.dataLen();
+    const size_t bufferSize = MsgData::MsgDataHeaderSize + kCompressionHeaderSize +
+        compressor->getMaxCompressedSize(inputSize);
+
+    MsgData::View output = reinterpret_cast<char*>(mongoMalloc(bufferSize));
+    ScopeGuard guard = MakeGuard(free, output.view2ptr());
+
+    output.setId(input.getId());
+    output.setResponseTo(input.getResponseTo());
+    output.setOperation(dbCompressed);
+
+    DataRangeCursor cursor(output.data(), output.view2ptr() + bufferSize);
+    invariantOK(cursor.writeAndAdvance<LittleEndian<int32_t>>(input.getNetworkOp()));
+    invariantOK(cursor.writeAndAdvance<LittleEndian<int32_t>>(inputSize));
+    invariantOK(cursor.writeAndAdvance<uint8_t>(compressor->getId()));
+
+    auto swCompressedSize =
+        compressor->compressData(ConstDataRange(input.data(), inputSize), cursor);
+    if (!swCompressedSize.isOK()) {
+        return swCompressedSize.getStatus();
+    }
+
+    output.setLen(MsgData::MsgDataHeaderSize + kCompressionHeaderSize +
+                  swCompressedSize.getValue());
+
+    guard.Dismiss();
+    out->reset();
+    out->setData(output.view2ptr(), true);
+    return Status::OK();
+}
+
+Status MessageCompressorManager::decompressMessage(const Message& msg,
+                                                   Message* out,
+                                                   MessageCompressorId* compressorId) {
+    MsgData::ConstView input = msg.singleData().view2ptr();
+    invariant(input.getNetworkOp() == dbCompressed);
+
+    ConstDataRangeCursor cursor(input.data(), input.data() + input.dataLen());
+
+    auto swOriginalOpCode = cursor.readAndAdvance<LittleEndian<int32_t>>();
+    if (!swOriginalOpCode.isOK()) {
+        return swOriginalOpCode.getStatus();
+    }
+    auto swUncompressedSize = cursor.readAndAdvance<LittleEndian<int32_t>>();
+    if (!swUncompressedSize.isOK()) {
+        return swUncompressedSize.getStatus();
+    }
+    auto swCompressorId = cursor.readAndAdvance<uint8_t>();
+    if (!swCompressorId.isOK()) {
+        return swCompressorId.getStatus();
+    }
+
+    const int32_t originalOpCode = swOriginalOpCode.getValue();
+    const int32_t uncompressedSize = swUncompressedSize.getValue();
+
+    if (originalOpCode == dbCompressed) {
+        return {ErrorCodes::BadValue, "compressed messages may not be nested"};
+    }
+
+    if (uncompressedSize < 0 ||
+        static_cast<size_t>(uncompressedSize) > MaxMessageSizeBytes - MsgData::MsgDataHeaderSize) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "invalid uncompressed message size " << uncompressedSize};
+    }
+
+    MessageCompressorBase* compressor = nullptr;
+    for (auto negotiated : _negotiated) {
+        if (negotiated->getId() == swCompressorId.getValue()) {
+            compressor = negotiated;
+            break;
+        }
+    }
+
+    if (!compressor) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "message compressed with a compressor which was not negotiated: "
+                              << static_cast<int>(swCompressorId.getValue())};
+    }
+
+    const size_t bufferSize = MsgData::MsgDataHeaderSize + uncompressedSize;
+    MsgData::View output = reinterpret_cast<char*>(mongoMalloc(bufferSize));
+    ScopeGuard guard = MakeGuard(free, output.view2ptr());
+
+    auto swDecompressedSize =
+        compressor->decompressData(cursor, DataRange(output.data(), uncompressedSize));
+    if (!swDecompressedSize.isOK()) {
+        return swDecompressedSize.getStatus();
+    }
+
+    output.setLen(bufferSize);
+    output.setId(input.getId());
+    output.setResponseTo(input.getResponseTo());
+    output.setOperation(originalOpCode);
+
+    guard.Dismiss();
+    out->reset();
+    out->setData(output.view2ptr(), true);
+    *compressorId = compressor->getId();
+    return Status::OK();
+}
+
+bool MessageCompressorManager::isMessageCompressible(const Message& msg) {
+    MsgData::ConstView data = msg.header().view2ptr();
+    ConstDataRangeCursor cursor(data.data(), data.data() + data.dataLen());
+
+    StringData commandName;
+    if (data.getNetworkOp() == dbCommand) {
+        // The database name precedes the command name.
+        auto swDatabase = cursor.readAndAdvance<Terminated<'\0', StringData>>();
+        auto swCommandName = cursor.readAndAdvance<Terminated<'\0', StringData>>();
+        if (!swDatabase.isOK() || !swCommandName.isOK()) {
+            return false;
+        }
+        commandName = swCommandName.getValue().value;
+    } else if (data.getNetworkOp() == dbQuery) {
+        auto swFlags = cursor.readAndAdvance<LittleEndian<int32_t>>();
+        auto swNamespace = cursor.readAndAdvance<Terminated<'\0', StringData>>();
+        if (!swFlags.isOK() || !swNamespace.isOK()) {
+            return false;
+        }
+
+        if (!swNamespace.getValue().value.endsWith(".$cmd")) {
+            return true;
+        }
+
+        // Skip nToSkip and nToReturn to get to the command object.
+        if (!cursor.advance(2 * sizeof(int32_t)).isOK() ||
+            cursor.length() < static_cast<size_t>(BSONObj::kMinBSONLength)) {
+            return false;
+        }
+
+        BSONObj command(cursor.data());
+        BSONElement first = command.firstElement();
+        if ((first.fieldNameStringData() == "$query" || first.fieldNameStringData() == "query") &&
+            first.type() == Object) {
+            first = first.Obj().firstElement();
+        }
+        commandName = first.fieldNameStringData();
+    } else {
+        return true;
+    }
+
+    return !isIncompressibleCommand(commandName);
+}
+
+}  // namespace mongo
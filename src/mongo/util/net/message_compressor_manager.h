@@ -0,0 +1,121 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "mongo/base/status.h"
+#include "mongo/util/net/message_compressor_base.h"
+
+namespace mongo {
+
+class BSONObj;
+class BSONObjBuilder;
+class Message;
+class MessageCompressorRegistry;
+
+/**
+ * Negotiates and applies wire protocol compression for a single connection.
+ *
+ * The client lists the compressors it supports in the "compression" field of its isMaster command,
+ * in order of preference, and the server replies with the subset it also supports. The client
+ * then wraps its requests in OP_COMPRESSED messages using the first agreed compressor, and the
+ * server compresses each reply with the compressor of the request it answers.
+ *
+ * An OP_COMPRESSED message is laid out as the standard message header, with opCode dbCompressed,
+ * followed by:
+ *     int32 originalOpcode    // opCode of the wrapped message
+ *     int32 uncompressedSize  // size of the wrapped message, excluding its header
+ *     uint8 compressorId      // see MessageCompressor
+ *     char  compressedMessage[]
+ */
+class MessageCompressorManager {
+public:
+    /**
+     * Uses the compressors configured for this process in the global registry.
+     */
+    MessageCompressorManager();
+
+    explicit MessageCompressorManager(MessageCompressorRegistry* registry);
+
+    /**
+     * Client side of negotiation: appends the compressors to offer to an isMaster command.
+     */
+    void clientBegin(BSONObjBuilder* output);
+
+    /**
+     * Client side of negotiation: enables the compressors the server agreed to in its isMaster
+     * reply.
+     */
+    void clientFinish(const BSONObj& input);
+
+    /**
+     * Server side of negotiation: enables the compressors offered by the isMaster command "input"
+     * which this process also supports, and appends them to the isMaster reply.
+     */
+    void serverNegotiate(const BSONObj& input, BSONObjBuilder* output);
+
+    /**
+     * Returns true if negotiation agreed on at least one compressor.
+     */
+    bool isCompressionEnabled() const {
+        return !_negotiated.empty();
+    }
+
+    /**
+     * Wraps "msg" in an OP_COMPRESSED message stored in "out". Uses the compressor with id
+     * "compressorId" if provided, or else the most preferred negotiated one. Compression must be
+     * enabled.
+     */
+    Status compressMessage(Message* msg,
+                           Message* out,
+                           boost::optional<MessageCompressorId> compressorId = boost::none);
+
+    /**
+     * Unwraps the OP_COMPRESSED message "msg" into "out", and stores the id of the compressor it
+     * was compressed with in "compressorId". Fails if the message is malformed or was compressed
+     * with a compressor which was not negotiated.
+     */
+    Status decompressMessage(const Message& msg, Message* out, MessageCompressorId* compressorId);
+
+    /**
+     * Returns false for messages which must not be compressed: those which run before or during
+     * negotiation and authentication, since compressing credentials could leak them through the
+     * compressed size.
+     */
+    static bool isMessageCompressible(const Message& msg);
+
+private:
+    std::vector<MessageCompressorBase*> _negotiated;
+    MessageCompressorRegistry* _registry;
+};
+
+}  // namespace mongo
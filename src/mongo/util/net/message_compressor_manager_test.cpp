@@ -0,0 +1,232 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor_manager.h"
+#include "mongo/util/net/message_compressor_noop.h"
+#include "mongo/util/net/message_compressor_registry.h"
+#include "mongo/util/net/message_compressor_snappy.h"
+#include "mongo/util/net/message_compressor_zlib.h"
+
+namespace mongo {
+namespace {
+
+class MessageCompressorManagerTest : public unittest::Test {
+protected:
+    void setUp() override {
+        _registry.registerImplementation(stdx::make_unique<NoopMessageCompressor>());
+        _registry.registerImplementation(stdx::make_unique<SnappyMessageCompressor>());
+        _registry.registerImplementation(stdx::make_unique<ZlibMessageCompressor>());
+        ASSERT_OK(_registry.setSupportedCompressors({"snappy", "zlib", "noop"}));
+    }
+
+    /**
+     * Runs an isMaster negotiation between "client" and "server", returning the server's reply.
+     */
+    BSONObj negotiate(MessageCompressorManager* client, MessageCompressorManager* server) {
+        BSONObjBuilder request;
+        request.append("isMaster", 1);
+        client->clientBegin(&request);
+
+        BSONObjBuilder reply;
+        server->serverNegotiate(request.obj(), &reply);
+        auto replyObj = reply.obj();
+        client->clientFinish(replyObj);
+        return replyObj;
+    }
+
+    MessageCompressorRegistry _registry;
+};
+
+Message buildQueryMessage(StringData ns, const BSONObj& query) {
+    BufBuilder b;
+    b.appendNum(0);  // flags
+    b.appendStr(ns);
+    b.appendNum(0);  // nToSkip
+    b.appendNum(1);  // nToReturn
+    query.appendSelfToBufBuilder(b);
+
+    Message msg;
+    msg.setData(dbQuery, b.buf(), b.len());
+    msg.header().setId(1234);
+    msg.header().setResponseTo(5678);
+    return msg;
+}
+
+void checkRoundTrip(MessageCompressorManager* sender,
+                    MessageCompressorManager* receiver,
+                    MessageCompressor expectedCompressor) {
+    BSONObjBuilder bob;
+    for (int i = 0; i < 100; i++) {
+        bob.append(std::to_string(i), "a repetitive string value which compresses well");
+    }
+    auto original = buildQueryMessage("test.coll", bob.obj());
+
+    Message compressed;
+    ASSERT_OK(sender->compressMessage(&original, &compressed));
+    ASSERT_EQUALS(dbCompressed, compressed.operation());
+    ASSERT_EQUALS(original.header().getId(), compressed.header().getId());
+    ASSERT_EQUALS(original.header().getResponseTo(), compressed.header().getResponseTo());
+    if (expectedCompressor != MessageCompressor::kNoop) {
+        ASSERT_LESS_THAN(compressed.size(), original.size());
+    }
+
+    Message decompressed;
+    MessageCompressorId compressorId;
+    ASSERT_OK(receiver->decompressMessage(compressed, &decompressed, &compressorId));
+    ASSERT_EQUALS(static_cast<MessageCompressorId>(expectedCompressor), compressorId);
+    ASSERT_EQUALS(original.operation(), decompressed.operation());
+    ASSERT_EQUALS(original.size(), decompressed.size());
+    ASSERT_EQUALS(0, memcmp(original.buf(), decompressed.buf(), original.size()));
+}
+
+TEST_F(MessageCompressorManagerTest, NegotiationKeepsClientPreferenceOrder) {
+    MessageCompressorManager client(&_registry);
+    MessageCompressorManager server(&_registry);
+
+    auto reply = negotiate(&client, &server);
+    ASSERT_EQUALS(BSON("compression" << BSON_ARRAY("snappy"
+                                                   << "zlib"
+                                                   << "noop")),
+                  reply);
+    ASSERT_TRUE(client.isCompressionEnabled());
+    ASSERT_TRUE(server.isCompressionEnabled());
+}
+
+TEST_F(MessageCompressorManagerTest, NegotiationIgnoresUnsupportedCompressors) {
+    MessageCompressorManager server(&_registry);
+
+    BSONObjBuilder reply;
+    server.serverNegotiate(BSON("isMaster" << 1 << "compression" << BSON_ARRAY("lz4"
+                                                                               << "zlib")),
+                           &reply);
+    ASSERT_EQUALS(BSON("compression" << BSON_ARRAY("zlib")), reply.obj());
+}
+
+TEST_F(MessageCompressorManagerTest, NoNegotiationWithoutCompressors) {
+    MessageCompressorRegistry disabledRegistry;
+    disabledRegistry.registerImplementation(stdx::make_unique<SnappyMessageCompressor>());
+
+    MessageCompressorManager client(&disabledRegistry);
+    MessageCompressorManager server(&_registry);
+
+    auto reply = negotiate(&client, &server);
+    ASSERT_TRUE(reply.isEmpty());
+    ASSERT_FALSE(client.isCompressionEnabled());
+    ASSERT_FALSE(server.isCompressionEnabled());
+}
+
+TEST_F(MessageCompressorManagerTest, RoundTripWithEachCompressor) {
+    for (auto compressor :
+         {MessageCompressor::kNoop, MessageCompressor::kSnappy, MessageCompressor::kZlib}) {
+        MessageCompressorManager client(&_registry);
+        MessageCompressorManager server(&_registry);
+        negotiate(&client, &server);
+
+        auto id = static_cast<MessageCompressorId>(compressor);
+        Message original = buildQueryMessage("test.coll", BSON("x" << 1));
+        Message compressed;
+        ASSERT_OK(client.compressMessage(&original, &compressed, id));
+
+        Message decompressed;
+        MessageCompressorId compressorId;
+        ASSERT_OK(server.decompressMessage(compressed, &decompressed, &compressorId));
+        ASSERT_EQUALS(id, compressorId);
+        ASSERT_EQUALS(original.size(), decompressed.size());
+    }
+}
+
+TEST_F(MessageCompressorManagerTest, RoundTripWithPreferredCompressor) {
+    MessageCompressorManager client(&_registry);
+    MessageCompressorManager server(&_registry);
+    negotiate(&client, &server);
+
+    checkRoundTrip(&client, &server, MessageCompressor::kSnappy);
+    checkRoundTrip(&server, &client, MessageCompressor::kSnappy);
+}
+
+TEST_F(MessageCompressorManagerTest, DecompressRejectsCompressorNotNegotiated) {
+    MessageCompressorRegistry zlibRegistry;
+    zlibRegistry.registerImplementation(stdx::make_unique<ZlibMessageCompressor>());
+    ASSERT_OK(zlibRegistry.setSupportedCompressors({"zlib"}));
+
+    // Only zlib is negotiated, as the server does not support snappy.
+    MessageCompressorManager client(&_registry);
+    MessageCompressorManager server(&zlibRegistry);
+    negotiate(&client, &server);
+
+    Message original = buildQueryMessage("test.coll", BSON("x" << 1));
+    Message compressed;
+    ASSERT_OK(client.compressMessage(
+        &original, &compressed, static_cast<MessageCompressorId>(MessageCompressor::kSnappy)));
+
+    Message decompressed;
+    MessageCompressorId compressorId;
+    ASSERT_NOT_OK(server.decompressMessage(compressed, &decompressed, &compressorId));
+}
+
+TEST_F(MessageCompressorManagerTest, DecompressRejectsTruncatedMessage) {
+    MessageCompressorManager client(&_registry);
+    MessageCompressorManager server(&_registry);
+    negotiate(&client, &server);
+
+    Message original = buildQueryMessage("test.coll", BSON("x" << 1));
+    Message compressed;
+    ASSERT_OK(client.compressMessage(&original, &compressed));
+
+    // Drop the end of the compressed data.
+    compressed.header().setLen(compressed.size() - 4);
+
+    Message decompressed;
+    MessageCompressorId compressorId;
+    ASSERT_NOT_OK(server.decompressMessage(compressed, &decompressed, &compressorId));
+}
+
+TEST(MessageCompressorManager, IsMessageCompressible) {
+    ASSERT_TRUE(MessageCompressorManager::isMessageCompressible(
+        buildQueryMessage("test.coll", BSON("x" << 1))));
+    ASSERT_TRUE(MessageCompressorManager::isMessageCompressible(
+        buildQueryMessage("test.$cmd", BSON("find" << "coll"))));
+
+    ASSERT_FALSE(MessageCompressorManager::isMessageCompressible(
+        buildQueryMessage("admin.$cmd", BSON("isMaster" << 1))));
+    ASSERT_FALSE(MessageCompressorManager::isMessageCompressible(
+        buildQueryMessage("admin.$cmd", BSON("$query" << BSON("ismaster" << 1)))));
+    ASSERT_FALSE(MessageCompressorManager::isMessageCompressible(
+        buildQueryMessage("test.$cmd", BSON("saslStart" << 1))));
+    ASSERT_FALSE(MessageCompressorManager::isMessageCompressible(
+        buildQueryMessage("test.$cmd", BSON("createUser" << "user"))));
+}
+
+}  // namespace
+}  // namespace mongo
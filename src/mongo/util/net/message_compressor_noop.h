@@ -0,0 +1,69 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstring>
+
+#include "mongo/util/net/message_compressor_base.h"
+
+namespace mongo {
+
+/**
+ * Copies messages unchanged. Used to test the OP_COMPRESSED framing.
+ */
+class NoopMessageCompressor final : public MessageCompressorBase {
+public:
+    NoopMessageCompressor() : MessageCompressorBase(MessageCompressor::kNoop) {}
+
+    std::size_t getMaxCompressedSize(std::size_t inputSize) override {
+        return inputSize;
+    }
+
+    StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override {
+        if (output.length() < input.length()) {
+            return {ErrorCodes::BadValue, "output too small"};
+        }
+
+        std::memcpy(const_cast<char*>(output.data()), input.data(), input.length());
+        counterHitCompress(input.length(), input.length());
+        return {input.length()};
+    }
+
+    StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override {
+        if (output.length() != input.length()) {
+            return {ErrorCodes::BadValue, "noop decompression output is the wrong size"};
+        }
+
+        std::memcpy(const_cast<char*>(output.data()), input.data(), input.length());
+        counterHitDecompress(input.length(), input.length());
+        return {input.length()};
+    }
+};
+
+}  // namespace mongo
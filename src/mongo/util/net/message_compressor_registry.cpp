@@ -0,0 +1,140 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compressor_registry.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message_compressor_noop.h"
+#include "mongo/util/net/message_compressor_snappy.h"
+#include "mongo/util/net/message_compressor_zlib.h"
+#include "mongo/util/options_parser/option_section.h"
+#include "mongo/util/options_parser/environment.h"
+#include "mongo/util/stringutils.h"
+
+namespace mongo {
+
+namespace {
+
+const char kDisabledConfigValue[] = "disabled";
+
+}  // namespace
+
+MessageCompressorRegistry& MessageCompressorRegistry::get() {
+    static MessageCompressorRegistry& globalRegistry = *[] {
+        // Never destroyed, so that connections may outlive static destruction at exit.
+        auto registry = new MessageCompressorRegistry();
+        registry->registerImplementation(stdx::make_unique<NoopMessageCompressor>());
+        registry->registerImplementation(stdx::make_unique<SnappyMessageCompressor>());
+        registry->registerImplementation(stdx::make_unique<ZlibMessageCompressor>());
+        return registry;
+    }();
+    return globalRegistry;
+}
+
+void MessageCompressorRegistry::registerImplementation(
+    std::unique_ptr<MessageCompressorBase> impl) {
+    auto& slot = _compressors[impl->getId()];
+    invariant(!slot);
+    invariant(!_getRegistered(impl->getName()));
+    slot = std::move(impl);
+}
+
+Status MessageCompressorRegistry::setSupportedCompressors(std::vector<std::string> names) {
+    for (const auto& name : names) {
+        if (!_getRegistered(name)) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << "Invalid network message compressor specified in "
+                                     "configuration: " << name};
+        }
+    }
+
+    _compressorNames = std::move(names);
+    return Status::OK();
+}
+
+MessageCompressorBase* MessageCompressorRegistry::getCompressor(MessageCompressorId id) const {
+    auto compressor = _compressors[id].get();
+    if (!compressor) {
+        return nullptr;
+    }
+    return getCompressor(compressor->getName());
+}
+
+MessageCompressorBase* MessageCompressorRegistry::getCompressor(StringData name) const {
+    for (const auto& supported : _compressorNames) {
+        if (supported == name) {
+            return _getRegistered(name);
+        }
+    }
+    return nullptr;
+}
+
+void MessageCompressorRegistry::appendStats(BSONObjBuilder* b) const {
+    for (const auto& name : _compressorNames) {
+        BSONObjBuilder compressorStats(b->subobjStart(name));
+        _getRegistered(name)->appendStats(&compressorStats);
+    }
+}
+
+MessageCompressorBase* MessageCompressorRegistry::_getRegistered(StringData name) const {
+    for (const auto& compressor : _compressors) {
+        if (compressor && compressor->getName() == name) {
+            return compressor.get();
+        }
+    }
+    return nullptr;
+}
+
+Status addMessageCompressionOptions(moe::OptionSection* options) {
+    options->addOptionChaining("net.compression.compressors",
+                               "networkMessageCompressors",
+                               moe::String,
+                               "comma-separated list of compressors to use for network messages, "
+                               "in order of preference (snappy/zlib), or disabled")
+        .setDefault(moe::Value(std::string(kDisabledConfigValue)));
+
+    return Status::OK();
+}
+
+Status storeMessageCompressionOptions(const moe::Environment& params) {
+    std::vector<std::string> names;
+    if (params.count("net.compression.compressors")) {
+        auto configValue = params["net.compression.compressors"].as<std::string>();
+        if (configValue != kDisabledConfigValue) {
+            splitStringDelim(configValue, &names, ',');
+        }
+    }
+
+    return MessageCompressorRegistry::get().setSupportedCompressors(std::move(names));
+}
+
+}  // namespace mongo
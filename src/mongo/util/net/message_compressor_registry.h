@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/util/net/message_compressor_base.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+namespace optionenvironment {
+class OptionSection;
+class Environment;
+}  // namespace optionenvironment
+
+namespace moe = mongo::optionenvironment;
+
+/**
+ * Holds the implementations of every compressor available for wire protocol compression, and the
+ * names of those this process is configured to negotiate, in order of preference.
+ *
+ * The compressors are registered before the registry is used concurrently, after which it is only
+ * read.
+ */
+class MessageCompressorRegistry {
+    MONGO_DISALLOW_COPYING(MessageCompressorRegistry);
+
+public:
+    MessageCompressorRegistry() = default;
+
+    /**
+     * Returns the process-wide registry, which has every built-in compressor registered.
+     */
+    static MessageCompressorRegistry& get();
+
+    /**
+     * Adds "impl" to the registry. No other compressor may be registered with the same id.
+     */
+    void registerImplementation(std::unique_ptr<MessageCompressorBase> impl);
+
+    /**
+     * Sets the names of the compressors to negotiate, in order of preference. Fails if any of the
+     * names does not have an implementation registered.
+     */
+    Status setSupportedCompressors(std::vector<std::string> names);
+
+    const std::vector<std::string>& getCompressorNames() const {
+        return _compressorNames;
+    }
+
+    /**
+     * Returns the compressor with the given id or name if it is registered and supported, or
+     * nullptr otherwise.
+     */
+    MessageCompressorBase* getCompressor(MessageCompressorId id) const;
+    MessageCompressorBase* getCompressor(StringData name) const;
+
+    /**
+     * Appends a subdocument of byte counters for every supported compressor to "b".
+     */
+    void appendStats(BSONObjBuilder* b) const;
+
+private:
+    MessageCompressorBase* _getRegistered(StringData name) const;
+
+    std::array<std::unique_ptr<MessageCompressorBase>,
+               std::numeric_limits<MessageCompressorId>::max() + 1> _compressors;
+    std::vector<std::string> _compressorNames;
+};
+
+/**
+ * Adds the option selecting which compressors to negotiate (--networkMessageCompressors), which is
+ * shared by the servers and the shell.
+ */
+Status addMessageCompressionOptions(moe::OptionSection* options);
+
+/**
+ * Configures the global registry from the option added by addMessageCompressionOptions().
+ */
+Status storeMessageCompressionOptions(const moe::Environment& params);
+
+}  // namespace mongo
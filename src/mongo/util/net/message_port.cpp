@@ -212,6 +212,22 @@ bool MessagingPort::recv(Message& m) {
 
         guard.Dismiss();
         m.setData(md.view2ptr(), true);
+
+        _lastRecvCompressorId = boost::none;
+        if (m.operation() == dbCompressed) {
+            MessageCompressorId compressorId;
+            Message decompressed;
+            Status status =
+                compressorManager().decompressMessage(m, &decompressed, &compressorId);
+            if (!status.isOK()) {
+                LOG(0) << "recv(): failed to decompress message from " << remote() << ": "
+                       << status;
+                m.reset();
+                return false;
+            }
+            m = std::move(decompressed);
+            _lastRecvCompressorId = compressorId;
+        }
         return true;
 
     } catch (const SocketException& e) {
@@ -225,11 +241,11 @@ bool MessagingPort::recv(Message& m) {
 }
 
 void MessagingPort::reply(Message& received, Message& response) {
-    say(/*received.from, */ response, received.header().getId());
+    _say(response, received.header().getId(), _lastRecvCompressorId);
 }
 
 void MessagingPort::reply(Message& received, Message& response, MSGID responseTo) {
-    say(/*received.from, */ response, responseTo);
+    _say(response, responseTo, _lastRecvCompressorId);
 }
 
 bool MessagingPort::call(Message& toSend, Message& response) {
@@ -261,10 +277,32 @@ bool MessagingPort::recv(const Message& toSend, Message& response) {
 }
 
 void MessagingPort::say(Message& toSend, int responseTo) {
+    _say(toSend, responseTo, boost::none);
+}
+
+void MessagingPort::_say(Message& toSend,
+                         int responseTo,
+                         boost::optional<MessageCompressorId> compressorId) {
     verify(!toSend.empty());
     mmm(log() << "*  say()  thr:" << GetCurrentThreadId() << endl;)
         toSend.header().setId(nextMessageId());
     toSend.header().setResponseTo(responseTo);
+
+    // Replies to uncompressed requests are never compressed, so that isMaster and authentication
+    // replies reach clients which have not negotiated compression yet.
+    const bool isReply = responseTo != 0;
+    if (compressorManager().isCompressionEnabled() && (!isReply || compressorId) &&
+        MessageCompressorManager::isMessageCompressible(toSend)) {
+        Message compressed;
+        Status status = compressorManager().compressMessage(&toSend, &compressed, compressorId);
+        if (status.isOK()) {
+            compressed.send(*this, "say");
+            return;
+        }
+        LOG(1) << "failed to compress message to " << remote() << ", sending uncompressed: "
+               << status;
+    }
+
     toSend.send(*this, "say");
 }
 
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <vector>
 
 #include "mongo/config.h"
@@ -118,9 +119,15 @@ public:
     }
 
 private:
+    void _say(Message& toSend, int responseTo, boost::optional<MessageCompressorId> compressorId);
+
     // this is the parsed version of remote
     HostAndPort _remoteParsed;
 
+    // The compressor used by the most recently received message, if it was compressed. Replies
+    // are compressed the same way as the request they answer.
+    boost::optional<MessageCompressorId> _lastRecvCompressorId;
+
 public:
     static void closeAllSockets(unsigned tagMask = 0xffffffff);
 };
@@ -36,10 +36,23 @@
 
 #include "mongo/platform/basic.h"
 
+#include <memory>
+
+#include "mongo/util/assert_util.h"
+
 namespace mongo {
 
 class MessageHandler {
 public:
+    /**
+     * Opaque per-connection state which a handler binds to the servicing thread in connected().
+     * See suspend() and resume().
+     */
+    class ConnectionState {
+    public:
+        virtual ~ConnectionState() {}
+    };
+
     virtual ~MessageHandler() {}
 
     /**
@@ -58,17 +71,53 @@ public:
      * connected() method) is no longer valid.
      */
     virtual void close() = 0;
+
+    /**
+     * Returns true if this handler implements suspend() and resume(), and so permits its
+     * connections to be serviced by a pool of threads rather than a dedicated thread each.
+     */
+    virtual bool canSuspend() const {
+        return false;
+    }
+
+    /**
+     * Called on the thread servicing a connection when it stops doing so, between two calls to
+     * process(). Detaches the state established by connected() from the current thread and
+     * returns it.
+     */
+    virtual std::unique_ptr<ConnectionState> suspend() {
+        invariant(false);
+        return nullptr;
+    }
+
+    /**
+     * Called on the thread about to service a connection, with the state previously returned by
+     * suspend() for that connection. This may be a different thread than the one which suspended
+     * the connection.
+     */
+    virtual void resume(std::unique_ptr<ConnectionState> state) {
+        invariant(false);
+    }
 };
 
 class MessageServer {
 public:
     struct Options {
-        int port;            // port to bind to
-        std::string ipList;  // addresses to bind to
+        int port;                     // port to bind to
+        std::string ipList;           // addresses to bind to
+        std::string serviceExecutor;  // how connections are mapped onto threads
+        int serviceExecutorThreads;   // worker threads for pooled executors, 0 for one per core
 
-        Options() : port(0), ipList("") {}
+        Options()
+            : port(0), ipList(""), serviceExecutor(kSynchronousExecutor), serviceExecutorThreads(0) {}
     };
 
+    // Services each connection on its own dedicated thread.
+    static const char kSynchronousExecutor[];
+
+    // Parks idle connections in an ASIO reactor and services ready ones on a fixed thread pool.
+    static const char kASIOExecutor[];
+
     virtual ~MessageServer() {}
     virtual void run() = 0;
     virtual void setAsTimeTracker() = 0;
@@ -31,6 +31,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <memory>
 #include <system_error>
 
@@ -40,6 +41,7 @@
 #include "mongo/db/server_options.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/stdx/functional.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/concurrency/thread_name.h"
@@ -53,12 +55,17 @@
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
 #include <sys/resource.h>
 #endif
 
+#ifndef _WIN32
+#include "mongo/util/net/service_executor_asio.h"
+#endif
+
 #if !defined(__has_feature)
 #define __has_feature(x) 0
 #endif
@@ -91,6 +98,9 @@ private:
 
 }  // namespace
 
+const char MessageServer::kSynchronousExecutor[] = "synchronous";
+const char MessageServer::kASIOExecutor[] = "asio";
+
 class PortMessageServer : public MessageServer, public Listener {
 public:
     /**
@@ -100,7 +110,18 @@ public:
      * @param handler the handler to use.
      */
     PortMessageServer(const MessageServer::Options& opts, std::shared_ptr<MessageHandler> handler)
-        : Listener("", opts.ipList, opts.port), _handler(std::move(handler)) {}
+        : Listener("", opts.ipList, opts.port), _handler(std::move(handler)) {
+        if (opts.serviceExecutor == kASIOExecutor) {
+            _setupServiceExecutor(opts);
+        }
+
+        // Report the executor actually used, which may have fallen back to synchronous.
+#ifndef _WIN32
+        serviceExecutorCounter.setExecutor(_executor ? kASIOExecutor : kSynchronousExecutor);
+#else
+        serviceExecutorCounter.setExecutor(kSynchronousExecutor);
+#endif
+    }
 
     virtual void accepted(std::shared_ptr<Socket> psocket, long long connectionId) {
         ScopeGuard sleepAfterClosingPort = MakeGuard(sleepmillis, 2);
@@ -113,6 +134,14 @@ public:
             return;
         }
 
+#ifndef _WIN32
+        if (_executor) {
+            _executor->addConnection(std::move(portWithHandler));
+            sleepAfterClosingPort.Dismiss();
+            return;
+        }
+#endif
+
         try {
 #ifndef __linux__  // TODO: consider making this ifdef _WIN32
             {
@@ -171,6 +200,11 @@ public:
     }
 
     void run() {
+#ifndef _WIN32
+        if (_executor) {
+            _executor->startup();
+        }
+#endif
         initAndListen();
     }
 
@@ -181,6 +215,45 @@ public:
 private:
     const std::shared_ptr<MessageHandler> _handler;
 
+#ifndef _WIN32
+    // Services connections on a pool of worker threads when set, otherwise each connection gets
+    // a thread of its own.
+    std::unique_ptr<ServiceExecutorASIO> _executor;
+#endif
+
+    void _setupServiceExecutor(const MessageServer::Options& opts) {
+#ifdef _WIN32
+        warning() << "the " << kASIOExecutor << " service executor is not supported on Windows, "
+                  << "using the " << kSynchronousExecutor << " service executor instead";
+#else
+        if (!_handler->canSuspend()) {
+            warning() << "the message handler cannot be serviced by the " << kASIOExecutor
+                      << " service executor, using the " << kSynchronousExecutor
+                      << " service executor instead";
+            return;
+        }
+
+#ifdef MONGO_CONFIG_SSL
+        // SSL connections may hold decrypted data which was already read from the socket, so
+        // readability of the socket does not tell whether another request is ready.
+        if (getSSLManager()) {
+            warning() << "the " << kASIOExecutor << " service executor does not support SSL, "
+                      << "using the " << kSynchronousExecutor << " service executor instead";
+            return;
+        }
+#endif
+
+        size_t numWorkers = opts.serviceExecutorThreads;
+        if (numWorkers == 0) {
+            numWorkers = std::max(1U, ProcessInfo().getNumCores());
+        }
+
+        log() << "servicing connections with the " << kASIOExecutor << " service executor using "
+              << numWorkers << " worker threads";
+        _executor = stdx::make_unique<ServiceExecutorASIO>(_handler, numWorkers);
+#endif
+    }
+
     /**
      * Handles incoming messages from a given socket.
      *
@@ -214,7 +287,17 @@ private:
                 m.reset();
                 portWithHandler->psock->clearCounters();
 
-                if (!portWithHandler->recv(m)) {
+                serviceExecutorCounter.startWaiting();
+                bool received = false;
+                try {
+                    received = portWithHandler->recv(m);
+                } catch (...) {
+                    serviceExecutorCounter.stopWaiting(false);
+                    throw;
+                }
+
+                if (!received) {
+                    serviceExecutorCounter.stopWaiting(false);
                     if (!serverGlobalParams.quiet) {
                         int conns = Listener::globalTicketHolder.used() - 1;
                         const char* word = (conns == 1 ? " connection" : " connections");
@@ -224,7 +307,11 @@ private:
                     break;
                 }
 
-                handler->process(m, portWithHandler.get());
+                serviceExecutorCounter.requestStarted(false);
+                {
+                    ON_BLOCK_EXIT([] { serviceExecutorCounter.requestFinished(); });
+                    handler->process(m, portWithHandler.get());
+                }
                 networkCounter.hit(portWithHandler->psock->getBytesIn(),
                                    portWithHandler->psock->getBytesOut());
 
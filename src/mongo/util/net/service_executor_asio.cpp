@@ -0,0 +1,243 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/service_executor_asio.h"
+
+#include "mongo/db/server_options.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/concurrency/synchronization.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+
+ThreadPool::Options makeWorkerPoolOptions(size_t numWorkers) {
+    ThreadPool::Options options;
+    options.poolName = "ServiceExecutorASIO";
+    options.threadNamePrefix = "serviceWorker";
+    options.minThreads = numWorkers;
+    options.maxThreads = numWorkers;
+    return options;
+}
+
+}  // namespace
+
+/**
+ * A connection serviced by the executor. Owned jointly by whichever of the reactor or the worker
+ * pool currently has it.
+ */
+class ServiceExecutorASIO::Session {
+    MONGO_DISALLOW_COPYING(Session);
+
+public:
+    Session(asio::io_service& ioService, std::unique_ptr<MessagingPort> port)
+        : port(std::move(port)), descriptor(ioService, this->port->psock->rawFD()) {}
+
+    ~Session() {
+        // The socket is owned, and closed, by the port.
+        descriptor.release();
+    }
+
+    const std::unique_ptr<MessagingPort> port;
+
+    // Wraps the port's socket so the reactor can wait for it to become readable. Never used to
+    // read or write data.
+    asio::posix::stream_descriptor descriptor;
+
+    // The handler's per-connection state while no worker is servicing the connection. Null until
+    // the handler has been told about the connection.
+    std::unique_ptr<MessageHandler::ConnectionState> state;
+};
+
+ServiceExecutorASIO::ServiceExecutorASIO(std::shared_ptr<MessageHandler> handler,
+                                         size_t numWorkers)
+    : _handler(std::move(handler)), _workers(makeWorkerPoolOptions(numWorkers)) {
+    invariant(_handler->canSuspend());
+}
+
+ServiceExecutorASIO::~ServiceExecutorASIO() {
+    _work.reset();
+    _ioService.stop();
+    if (_reactorThread.joinable()) {
+        _reactorThread.join();
+    }
+
+    _workers.shutdown();
+    _workers.join();
+}
+
+void ServiceExecutorASIO::startup() {
+    _work = stdx::make_unique<asio::io_service::work>(_ioService);
+    _workers.startup();
+    _reactorThread = stdx::thread([this] {
+        setThreadName("serviceReactor");
+        std::error_code ec;
+        _ioService.run(ec);
+        if (ec) {
+            severe() << "Failure in the service executor reactor: " << ec.message();
+            fassertFailed(40500);
+        }
+    });
+}
+
+void ServiceExecutorASIO::addConnection(std::unique_ptr<MessagingPort> port) {
+    std::shared_ptr<Session> session;
+    try {
+        session = std::make_shared<Session>(_ioService, std::move(port));
+    } catch (const std::system_error& ex) {
+        Listener::globalTicketHolder.release();
+        log() << "failed to register new connection with the service executor, closing "
+                 "connection: " << ex.what();
+        return;
+    }
+
+    // The handler is told about the connection on a worker thread, like every other call into it.
+    Status status = _workers.schedule([this, session] { _serviceRequest(session); });
+    if (!status.isOK()) {
+        log() << "failed to schedule new connection on the service executor, closing "
+                 "connection: " << status;
+        _endSession(std::move(session));
+    }
+}
+
+void ServiceExecutorASIO::_waitForRequest(std::shared_ptr<Session> session) {
+    serviceExecutorCounter.startWaiting();
+
+    auto& descriptor = session->descriptor;
+    descriptor.async_wait(asio::posix::stream_descriptor::wait_read,
+                          [this, session](const std::error_code& ec) {
+                              // Errors such as a reset connection are reported to the worker when
+                              // it reads from the socket.
+                              serviceExecutorCounter.requestQueued();
+                              Status status =
+                                  _workers.schedule([this, session] { _serviceRequest(session); });
+                              if (!status.isOK()) {
+                                  serviceExecutorCounter.stopWaiting(true);
+                                  _endSession(session);
+                              }
+                          });
+}
+
+void ServiceExecutorASIO::_serviceRequest(std::shared_ptr<Session> session) {
+    MessagingPort* const port = session->port.get();
+    bool attached = false;
+    bool keepOpen = false;
+
+    try {
+        if (!session->state) {
+            port->psock->setLogLevel(logger::LogSeverity::Debug(1));
+            _handler->connected(port);
+            attached = true;
+            keepOpen = !inShutdown();
+        } else {
+            _handler->resume(std::move(session->state));
+            attached = true;
+
+            Message m;
+            bool received = false;
+            port->psock->clearCounters();
+            try {
+                received = !inShutdown() && port->recv(m);
+            } catch (...) {
+                serviceExecutorCounter.stopWaiting(true);
+                throw;
+            }
+
+            if (!received) {
+                serviceExecutorCounter.stopWaiting(true);
+                if (!serverGlobalParams.quiet) {
+                    int conns = Listener::globalTicketHolder.used() - 1;
+                    const char* word = (conns == 1 ? " connection" : " connections");
+                    log() << "end connection " << port->psock->remoteString() << " (" << conns
+                          << word << " now open)";
+                }
+            } else {
+                serviceExecutorCounter.requestStarted(true);
+                ON_BLOCK_EXIT([] { serviceExecutorCounter.requestFinished(); });
+
+                _handler->process(m, port);
+                networkCounter.hit(port->psock->getBytesIn(), port->psock->getBytesOut());
+                keepOpen = !inShutdown();
+            }
+        }
+    } catch (AssertionException& e) {
+        log() << "AssertionException handling request, closing client connection: " << e;
+    } catch (SocketException& e) {
+        log() << "SocketException handling request, closing client connection: " << e;
+    } catch (const DBException& e) {  // must be right above std::exception to avoid catching
+                                      // subclasses
+        log() << "DBException handling request, closing client connection: " << e;
+    } catch (std::exception& e) {
+        error() << "Uncaught std::exception: " << e.what() << ", terminating";
+        dbexit(EXIT_UNCAUGHT);
+    }
+
+    if (attached) {
+        session->state = _handler->suspend();
+    }
+
+    if (keepOpen) {
+        _waitForRequest(std::move(session));
+    } else {
+        _endSession(std::move(session));
+    }
+
+    // Occasionally we want to see if we're using too much memory. Workers move between
+    // connections, so this is counted per worker rather than per connection.
+    static MONGO_TRIVIALLY_CONSTRUCTIBLE_THREAD_LOCAL int64_t requestsServiced;
+    if ((requestsServiced++ & 0xf) == 0) {
+        markThreadIdle();
+    }
+}
+
+void ServiceExecutorASIO::_endSession(std::shared_ptr<Session> session) {
+    if (session->state) {
+        _handler->resume(std::move(session->state));
+        _handler->close();
+    }
+
+    session->port->shutdown();
+    Listener::globalTicketHolder.release();
+}
+
+}  // namespace mongo
@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <asio.hpp>
+#include <memory>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
+namespace mongo {
+
+class MessageHandler;
+class MessagingPort;
+
+/**
+ * Services client connections with a fixed pool of worker threads, rather than a dedicated thread
+ * per connection.
+ *
+ * Between requests, a connection is parked in an ASIO reactor, which runs on a single thread and
+ * waits for the connection's socket to become readable. Once it does, the connection is queued for
+ * the worker pool. A worker resumes the handler's per-connection state, receives and processes the
+ * request exactly as a dedicated thread would, suspends the state again and hands the connection
+ * back to the reactor. An idle connection therefore costs a socket and a small session object
+ * instead of a thread and its stack.
+ *
+ * Requests which block for a long time (for example awaitData getMores or exhaust cursors) occupy
+ * a worker for their whole duration, so the pool must be sized with the workload in mind.
+ *
+ * Requires a MessageHandler which supports suspend() and resume(). Not available on Windows.
+ */
+class ServiceExecutorASIO {
+    MONGO_DISALLOW_COPYING(ServiceExecutorASIO);
+
+public:
+    ServiceExecutorASIO(std::shared_ptr<MessageHandler> handler, size_t numWorkers);
+    ~ServiceExecutorASIO();
+
+    /**
+     * Starts the reactor and worker threads. Must be called before addConnection().
+     */
+    void startup();
+
+    /**
+     * Takes over servicing the connection on "port". The caller must have acquired a ticket for
+     * the connection from Listener::globalTicketHolder, which is released once the connection
+     * ends.
+     */
+    void addConnection(std::unique_ptr<MessagingPort> port);
+
+private:
+    class Session;
+
+    /**
+     * Parks "session" in the reactor until its socket becomes readable.
+     */
+    void _waitForRequest(std::shared_ptr<Session> session);
+
+    /**
+     * Runs on a worker thread. Receives and processes the next request on "session", then either
+     * parks it again or ends it.
+     */
+    void _serviceRequest(std::shared_ptr<Session> session);
+
+    void _endSession(std::shared_ptr<Session> session);
+
+    const std::shared_ptr<MessageHandler> _handler;
+
+    asio::io_service _ioService;
+
+    // Keeps _ioService.run() from returning while no connections are parked.
+    std::unique_ptr<asio::io_service::work> _work;
+
+    stdx::thread _reactorThread;
+
+    ThreadPool _workers;
+};
+
+}  // namespace mongo